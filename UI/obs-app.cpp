@@ -91,6 +91,7 @@ bool opt_always_on_top = false;
 bool opt_disable_high_dpi_scaling = false;
 bool opt_disable_updater = false;
 bool opt_disable_missing_files_check = false;
+static bool opt_profiler_timeline = false;
 string opt_starting_collection;
 string opt_starting_profile;
 string opt_starting_scene;
@@ -1958,6 +1959,17 @@ static void SaveProfilerData(const ProfilerSnapshot &snap)
 	if (!profiler_snapshot_dump_csv_gz(snap.get(), path))
 		blog(LOG_WARNING, "Could not save profiler data to '%s'",
 		     static_cast<const char *>(path));
+
+	if (!profiler_timeline_active())
+		return;
+
+	string timeline_path = dst.str();
+	timeline_path.replace(timeline_path.size() - 7, 7, ".json");
+
+	path = GetConfigPathPtr(timeline_path.c_str());
+	if (!profiler_timeline_dump_json(path))
+		blog(LOG_WARNING, "Could not save profiler timeline to '%s'",
+		     static_cast<const char *>(path));
 }
 
 static auto ProfilerFree = [](void *) {
@@ -2755,6 +2767,9 @@ int main(int argc, char *argv[])
 				  nullptr)) {
 			opt_disable_high_dpi_scaling = true;
 
+		} else if (arg_is(argv[i], "--profiler-timeline", nullptr)) {
+			opt_profiler_timeline = true;
+
 		} else if (arg_is(argv[i], "--help", "-h")) {
 			std::string help =
 				"--help, -h: Get list of available commands.\n\n"
@@ -2775,7 +2790,8 @@ int main(int argc, char *argv[])
 				"--unfiltered_log: Make log unfiltered.\n\n"
 				"--disable-updater: Disable built-in updater (Windows/Mac only)\n\n"
 				"--disable-missing-files-check: Disable the missing files dialog which can appear on startup.\n\n"
-				"--disable-high-dpi-scaling: Disable automatic high-DPI scaling\n\n";
+				"--disable-high-dpi-scaling: Disable automatic high-DPI scaling\n\n"
+				"--profiler-timeline: Save a timeline of profiled calls next to the profiler data.\n\n";
 
 #ifdef _WIN32
 			MessageBoxA(NULL, help.c_str(), "Help",
@@ -2793,6 +2809,9 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (opt_profiler_timeline)
+		profiler_timeline_enable(0);
+
 #if !OBS_UNIX_STRUCTURE
 	if (!portable_mode) {
 		portable_mode =
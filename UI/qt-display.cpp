@@ -89,6 +89,9 @@ OBSQTDisplay::OBSQTDisplay(QWidget *parent, Qt::WindowFlags flags)
 	setAttribute(Qt::WA_NativeWindow);
 
 	auto windowVisible = [this](bool visible) {
+		obs_display_set_visible(display,
+					visible && !window()->isMinimized());
+
 		if (!visible) {
 #ifdef ENABLE_WAYLAND
 			if (obs_get_nix_platform() == OBS_NIX_PLATFORM_WAYLAND)
@@ -116,6 +119,8 @@ OBSQTDisplay::OBSQTDisplay(QWidget *parent, Qt::WindowFlags flags)
 	connect(windowHandle(), &QWindow::visibleChanged, windowVisible);
 	connect(windowHandle(), &QWindow::screenChanged, screenChanged);
 
+	WatchTopLevel();
+
 #ifdef ENABLE_WAYLAND
 	if (obs_get_nix_platform() == OBS_NIX_PLATFORM_WAYLAND)
 		windowHandle()->installEventFilter(
@@ -181,6 +186,41 @@ void OBSQTDisplay::resizeEvent(QResizeEvent *event)
 	emit DisplayResized();
 }
 
+/* only top level widgets receive window state changes, so watch the window
+ * the display is in to stop rendering while it's minimized.  the window can
+ * change when the display or a dock around it is reparented or floated,
+ * which always shows it again */
+void OBSQTDisplay::WatchTopLevel()
+{
+	QWidget *top = window();
+	if (top == topLevel)
+		return;
+
+	if (topLevel)
+		topLevel->removeEventFilter(this);
+
+	topLevel = top;
+	topLevel->installEventFilter(this);
+}
+
+void OBSQTDisplay::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+
+	WatchTopLevel();
+	obs_display_set_visible(display, !topLevel->isMinimized());
+}
+
+bool OBSQTDisplay::eventFilter(QObject *obj, QEvent *event)
+{
+	if (obj == topLevel && event->type() == QEvent::WindowStateChange) {
+		bool visible = isVisible() && !topLevel->isMinimized();
+		obs_display_set_visible(display, visible);
+	}
+
+	return QWidget::eventFilter(obj, event);
+}
+
 void OBSQTDisplay::paintEvent(QPaintEvent *event)
 {
 	CreateDisplay();
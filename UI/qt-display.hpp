@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QWidget>
+#include <QPointer>
 #include <obs.hpp>
 
 #define GREY_COLOR_BACKGROUND 0xFF4C4C4C
@@ -12,9 +13,14 @@ class OBSQTDisplay : public QWidget {
 				   SetDisplayBackgroundColor)
 
 	OBSDisplay display;
+	QPointer<QWidget> topLevel;
+
+	void WatchTopLevel();
 
 	void resizeEvent(QResizeEvent *event) override;
+	void showEvent(QShowEvent *event) override;
 	void paintEvent(QPaintEvent *event) override;
+	bool eventFilter(QObject *obj, QEvent *event) override;
 
 signals:
 	void DisplayCreated(OBSQTDisplay *window);
@@ -0,0 +1,362 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <util/platform.h>
+#include <util/crc32.h>
+#include <util/dstr.h>
+#include "gl-subsystem.h"
+
+/*
+ * This is a program binary cache only: effects are still parsed and converted
+ * to GLSL on every start, and the GLSL is what the cache is keyed on.
+ *
+ * Linked programs are stored on disk with GL_ARB_get_program_binary, named
+ * after the checksums of the two GLSL sources.  Each file also stores the
+ * driver and both sources so a checksum collision or a driver update can
+ * never load the wrong binary:
+ *
+ *   struct program_cache_header
+ *   driver string, vertex GLSL, pixel GLSL, program binary
+ *
+ * Shaders that compiled with the current driver are recorded next to them,
+ * named after the checksum of their GLSL source, so that a shader is only
+ * compiled when a program using it misses the cache:
+ *
+ *   struct shader_cache_header
+ *   driver string, GLSL
+ */
+
+#define PROGRAM_CACHE_MAGIC 0x42505347 /* "GSPB" */
+#define PROGRAM_CACHE_VERSION 1
+
+#define SHADER_CACHE_MAGIC 0x53535347 /* "GSSS" */
+#define SHADER_CACHE_VERSION 1
+
+struct program_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t binary_format;
+	uint32_t driver_size;
+	uint32_t vertex_size;
+	uint32_t pixel_size;
+	uint32_t binary_size;
+};
+
+struct shader_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t driver_size;
+	uint32_t source_size;
+};
+
+static bool program_binary_supported(void)
+{
+	GLint formats = 0;
+
+	if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+		return false;
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return gl_success("glGetIntegerv") && formats > 0;
+}
+
+void device_set_shader_cache_path(gs_device_t *device, const char *path)
+{
+	struct dstr driver = {0};
+
+	bfree(device->shader_cache_path);
+	bfree(device->shader_cache_driver);
+	device->shader_cache_path = NULL;
+	device->shader_cache_driver = NULL;
+
+	if (!path || !*path)
+		return;
+
+	if (!program_binary_supported()) {
+		blog(LOG_INFO, "Shader cache disabled: program binaries are "
+			       "not supported by the driver");
+		return;
+	}
+
+	if (os_mkdirs(path) == MKDIR_ERROR) {
+		blog(LOG_WARNING, "Shader cache disabled: could not create "
+				  "'%s'",
+		     path);
+		return;
+	}
+
+	dstr_printf(&driver, "%s\n%s\n%s",
+		    (const char *)glGetString(GL_VENDOR),
+		    (const char *)glGetString(GL_RENDERER),
+		    (const char *)glGetString(GL_VERSION));
+
+	device->shader_cache_path = bstrdup(path);
+	device->shader_cache_driver = driver.array;
+}
+
+static bool get_cache_file(struct gs_program *program, struct dstr *file)
+{
+	gs_device_t *device = program->device;
+	const char *vs = program->vertex_shader->gl_string;
+	const char *ps = program->pixel_shader->gl_string;
+
+	if (!device->shader_cache_path || !vs || !ps)
+		return false;
+
+	dstr_printf(file, "%s/%08x%08x.bin", device->shader_cache_path,
+		    calc_crc32(0, vs, strlen(vs)),
+		    calc_crc32(0, ps, strlen(ps)));
+	return true;
+}
+
+static inline bool read_matches(FILE *f, const char *str, uint32_t size,
+				char *buf)
+{
+	return strlen(str) == size && fread(buf, 1, size, f) == size &&
+	       memcmp(buf, str, size) == 0;
+}
+
+static bool load_binary(struct gs_program *program, FILE *f)
+{
+	gs_device_t *device = program->device;
+	const char *vs = program->vertex_shader->gl_string;
+	const char *ps = program->pixel_shader->gl_string;
+	struct program_cache_header header;
+	int64_t file_size = os_fgetsize(f);
+	GLint linked = false;
+	char *buf = NULL;
+
+	if (fread(&header, 1, sizeof(header), f) != sizeof(header))
+		return false;
+	if (header.magic != PROGRAM_CACHE_MAGIC ||
+	    header.version != PROGRAM_CACHE_VERSION)
+		return false;
+	if ((int64_t)sizeof(header) + header.driver_size + header.vertex_size +
+		    header.pixel_size + header.binary_size !=
+	    file_size)
+		return false;
+
+	buf = bmalloc((size_t)file_size);
+
+	if (!read_matches(f, device->shader_cache_driver, header.driver_size,
+			  buf) ||
+	    !read_matches(f, vs, header.vertex_size, buf) ||
+	    !read_matches(f, ps, header.pixel_size, buf))
+		goto fail;
+
+	if (fread(buf, 1, header.binary_size, f) != header.binary_size)
+		goto fail;
+
+	glProgramBinary(program->obj, header.binary_format, buf,
+			header.binary_size);
+	if (!gl_success("glProgramBinary"))
+		goto fail;
+
+	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
+	if (!gl_success("glGetProgramiv"))
+		linked = false;
+
+fail:
+	bfree(buf);
+	return linked != GL_FALSE;
+}
+
+bool gl_program_cache_load(struct gs_program *program)
+{
+	struct dstr file = {0};
+	bool success = false;
+	FILE *f;
+
+	if (!get_cache_file(program, &file))
+		return false;
+
+	f = os_fopen(file.array, "rb");
+	if (f) {
+		success = load_binary(program, f);
+		fclose(f);
+	}
+
+	/* the program is linked from source next, keep the binary */
+	if (!success) {
+		glProgramParameteri(program->obj,
+				    GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+				    GL_TRUE);
+		gl_success("glProgramParameteri");
+	}
+
+	dstr_free(&file);
+	return success;
+}
+
+static bool write_binary(struct gs_program *program, FILE *f)
+{
+	gs_device_t *device = program->device;
+	const char *vs = program->vertex_shader->gl_string;
+	const char *ps = program->pixel_shader->gl_string;
+	struct program_cache_header header = {0};
+	GLint size = 0;
+	GLsizei binary_size = 0;
+	GLenum format = 0;
+	bool success = false;
+	void *binary;
+
+	glGetProgramiv(program->obj, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (!gl_success("glGetProgramiv") || size <= 0)
+		return false;
+
+	binary = bmalloc(size);
+	glGetProgramBinary(program->obj, size, &binary_size, &format, binary);
+	if (!gl_success("glGetProgramBinary") || binary_size <= 0)
+		goto fail;
+
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.binary_format = format;
+	header.driver_size = (uint32_t)strlen(device->shader_cache_driver);
+	header.vertex_size = (uint32_t)strlen(vs);
+	header.pixel_size = (uint32_t)strlen(ps);
+	header.binary_size = (uint32_t)binary_size;
+
+	success = fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+		  fwrite(device->shader_cache_driver, 1, header.driver_size,
+			 f) == header.driver_size &&
+		  fwrite(vs, 1, header.vertex_size, f) == header.vertex_size &&
+		  fwrite(ps, 1, header.pixel_size, f) == header.pixel_size &&
+		  fwrite(binary, 1, header.binary_size, f) ==
+			  header.binary_size;
+
+fail:
+	bfree(binary);
+	return success;
+}
+
+void gl_program_cache_save(struct gs_program *program)
+{
+	struct dstr file = {0};
+	struct dstr temp = {0};
+	bool success = false;
+	FILE *f;
+
+	if (!get_cache_file(program, &file))
+		return;
+
+	/* written to a temporary file first so that another process never
+	 * reads a partial binary */
+	dstr_printf(&temp, "%s.tmp", file.array);
+
+	f = os_fopen(temp.array, "wb");
+	if (f) {
+		success = write_binary(program, f);
+		fclose(f);
+
+		if (!success || os_rename(temp.array, file.array) != 0) {
+			os_unlink(temp.array);
+			success = false;
+		}
+	}
+
+	if (!success)
+		blog(LOG_DEBUG, "gl_program_cache_save: could not write '%s'",
+		     file.array);
+
+	dstr_free(&temp);
+	dstr_free(&file);
+}
+
+static void get_shader_cache_file(struct gs_shader *shader, struct dstr *file)
+{
+	const char *gl_string = shader->gl_string;
+
+	dstr_printf(file, "%s/%08x.%s", shader->device->shader_cache_path,
+		    calc_crc32(0, gl_string, strlen(gl_string)),
+		    shader->type == GS_SHADER_VERTEX ? "vs" : "ps");
+}
+
+bool gl_shader_cache_load(struct gs_shader *shader)
+{
+	gs_device_t *device = shader->device;
+	struct shader_cache_header header;
+	struct dstr file = {0};
+	bool success = false;
+	char *buf;
+	FILE *f;
+
+	get_shader_cache_file(shader, &file);
+	f = os_fopen(file.array, "rb");
+	dstr_free(&file);
+
+	if (!f)
+		return false;
+
+	if (fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+	    header.magic == SHADER_CACHE_MAGIC &&
+	    header.version == SHADER_CACHE_VERSION &&
+	    (int64_t)sizeof(header) + header.driver_size + header.source_size ==
+		    os_fgetsize(f)) {
+		buf = bmalloc(header.driver_size + header.source_size);
+		success = read_matches(f, device->shader_cache_driver,
+				       header.driver_size, buf) &&
+			  read_matches(f, shader->gl_string, header.source_size,
+				       buf);
+		bfree(buf);
+	}
+
+	fclose(f);
+	return success;
+}
+
+void gl_shader_cache_save(struct gs_shader *shader)
+{
+	gs_device_t *device = shader->device;
+	struct shader_cache_header header = {0};
+	struct dstr file = {0};
+	struct dstr temp = {0};
+	bool success = false;
+	FILE *f;
+
+	get_shader_cache_file(shader, &file);
+	dstr_printf(&temp, "%s.tmp", file.array);
+
+	header.magic = SHADER_CACHE_MAGIC;
+	header.version = SHADER_CACHE_VERSION;
+	header.driver_size = (uint32_t)strlen(device->shader_cache_driver);
+	header.source_size = (uint32_t)strlen(shader->gl_string);
+
+	f = os_fopen(temp.array, "wb");
+	if (f) {
+		success = fwrite(&header, 1, sizeof(header), f) ==
+				  sizeof(header) &&
+			  fwrite(device->shader_cache_driver, 1,
+				 header.driver_size,
+				 f) == header.driver_size &&
+			  fwrite(shader->gl_string, 1, header.source_size,
+				 f) == header.source_size;
+		fclose(f);
+
+		if (!success || os_rename(temp.array, file.array) != 0) {
+			os_unlink(temp.array);
+			success = false;
+		}
+	}
+
+	if (!success)
+		blog(LOG_DEBUG, "gl_shader_cache_save: could not write '%s'",
+		     file.array);
+
+	dstr_free(&temp);
+	dstr_free(&file);
+}
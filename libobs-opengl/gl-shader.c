@@ -189,9 +189,8 @@ static inline bool gl_process_attribs(struct gs_shader *shader,
 	return true;
 }
 
-static bool gl_shader_init(struct gs_shader *shader,
-			   struct gl_shader_parser *glsp, const char *file,
-			   char **error_string)
+static bool compile_shader(struct gs_shader *shader, const char *gl_string,
+			   const char *file, char **error_string)
 {
 	GLenum type = convert_shader_type(shader->type);
 	int compiled = 0;
@@ -201,8 +200,7 @@ static bool gl_shader_init(struct gs_shader *shader,
 	if (!gl_success("glCreateShader") || !shader->obj)
 		return false;
 
-	glShaderSource(shader->obj, 1, (const GLchar **)&glsp->gl_string.array,
-		       0);
+	glShaderSource(shader->obj, 1, (const GLchar **)&gl_string, 0);
 	if (!gl_success("glShaderSource"))
 		return false;
 
@@ -214,7 +212,7 @@ static bool gl_shader_init(struct gs_shader *shader,
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 	blog(LOG_DEBUG, "  GL shader string for: %s", file);
 	blog(LOG_DEBUG, "-----------------------------------");
-	blog(LOG_DEBUG, "%s", glsp->gl_string.array);
+	blog(LOG_DEBUG, "%s", gl_string);
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 #endif
 
@@ -239,6 +237,37 @@ static bool gl_shader_init(struct gs_shader *shader,
 	}
 
 	gl_get_shader_info(shader->obj, file, error_string);
+	return success;
+}
+
+/* compiles a shader that was skipped because it's in the shader cache, once
+ * a program using it has to be linked from source after all */
+static bool gl_shader_compile(struct gs_shader *shader)
+{
+	if (shader->obj)
+		return true;
+
+	return compile_shader(shader, shader->gl_string, "(cached shader)",
+			      NULL);
+}
+
+static bool gl_shader_init(struct gs_shader *shader,
+			   struct gl_shader_parser *glsp, const char *file,
+			   char **error_string)
+{
+	bool success = true;
+
+	if (shader->device->shader_cache_path)
+		shader->gl_string = bstrdup(glsp->gl_string.array);
+
+	/* a shader that compiled before with the same driver only needs to be
+	 * compiled when a program using it is not in the program cache */
+	if (!shader->gl_string || !gl_shader_cache_load(shader)) {
+		success = compile_shader(shader, glsp->gl_string.array, file,
+					 error_string);
+		if (success && shader->gl_string)
+			gl_shader_cache_save(shader);
+	}
 
 	if (success)
 		success = gl_add_params(shader, glsp);
@@ -349,6 +378,7 @@ void gs_shader_destroy(gs_shader_t *shader)
 	da_free(shader->samplers);
 	da_free(shader->params);
 	da_free(shader->attribs);
+	bfree(shader->gl_string);
 	bfree(shader);
 }
 
@@ -634,38 +664,60 @@ static inline bool assign_program_params(struct gs_program *program)
 	return true;
 }
 
-struct gs_program *gs_program_create(struct gs_device *device)
+static bool link_program(struct gs_program *program)
 {
-	struct gs_program *program = bzalloc(sizeof(*program));
 	int linked = false;
 
-	program->device = device;
-	program->vertex_shader = device->cur_vertex_shader;
-	program->pixel_shader = device->cur_pixel_shader;
-
-	program->obj = glCreateProgram();
-	if (!gl_success("glCreateProgram"))
-		goto error_detach_neither;
+	if (!gl_shader_compile(program->vertex_shader) ||
+	    !gl_shader_compile(program->pixel_shader))
+		return false;
 
 	glAttachShader(program->obj, program->vertex_shader->obj);
 	if (!gl_success("glAttachShader (vertex)"))
-		goto error_detach_neither;
+		return false;
 
 	glAttachShader(program->obj, program->pixel_shader->obj);
 	if (!gl_success("glAttachShader (pixel)"))
-		goto error_detach_vertex;
+		goto detach_vertex;
 
 	glLinkProgram(program->obj);
 	if (!gl_success("glLinkProgram"))
-		goto error;
+		goto detach;
 
 	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
 	if (!gl_success("glGetProgramiv"))
-		goto error;
-
-	if (linked == GL_FALSE) {
+		linked = false;
+	else if (linked == GL_FALSE)
 		print_link_errors(program->obj);
+
+detach:
+	glDetachShader(program->obj, program->pixel_shader->obj);
+	gl_success("glDetachShader (pixel)");
+
+detach_vertex:
+	glDetachShader(program->obj, program->vertex_shader->obj);
+	gl_success("glDetachShader (vertex)");
+
+	return linked != GL_FALSE;
+}
+
+struct gs_program *gs_program_create(struct gs_device *device)
+{
+	struct gs_program *program = bzalloc(sizeof(*program));
+
+	program->device = device;
+	program->vertex_shader = device->cur_vertex_shader;
+	program->pixel_shader = device->cur_pixel_shader;
+
+	program->obj = glCreateProgram();
+	if (!gl_success("glCreateProgram"))
 		goto error;
+
+	if (!gl_program_cache_load(program)) {
+		if (!link_program(program))
+			goto error;
+
+		gl_program_cache_save(program);
 	}
 
 	if (!assign_program_attribs(program))
@@ -673,12 +725,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	if (!assign_program_params(program))
 		goto error;
 
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
 	program->next = device->first_program;
 	program->prev_next = &device->first_program;
 	device->first_program = program;
@@ -688,14 +734,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	return program;
 
 error:
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
-error_detach_vertex:
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-error_detach_neither:
 	gs_program_destroy(program);
 	return NULL;
 }
@@ -293,6 +293,8 @@ void device_destroy(gs_device_t *device)
 		gl_delete_vertex_arrays(1, &device->empty_vao);
 
 		da_free(device->proj_stack);
+		bfree(device->shader_cache_path);
+		bfree(device->shader_cache_driver);
 		gl_platform_destroy(device->plat);
 		bfree(device);
 	}
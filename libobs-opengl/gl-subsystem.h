@@ -462,6 +462,10 @@ struct gs_shader {
 	DARRAY(struct shader_attrib) attribs;
 	DARRAY(struct gs_shader_param) params;
 	DARRAY(gs_samplerstate_t *) samplers;
+
+	/* only kept when the shader cache is enabled, obj is 0 until a
+	 * program is linked from source if the shader was in the cache */
+	char *gl_string;
 };
 
 struct program_param {
@@ -486,6 +490,11 @@ extern struct gs_program *gs_program_create(struct gs_device *device);
 extern void gs_program_destroy(struct gs_program *program);
 extern void program_update_params(struct gs_program *shader);
 
+extern bool gl_program_cache_load(struct gs_program *program);
+extern void gl_program_cache_save(struct gs_program *program);
+extern bool gl_shader_cache_load(struct gs_shader *shader);
+extern void gl_shader_cache_save(struct gs_shader *shader);
+
 struct gs_vertex_buffer {
 	GLuint vao;
 	GLuint vertex_buffer;
@@ -641,6 +650,9 @@ struct gs_device {
 	DARRAY(struct matrix4) proj_stack;
 
 	struct fbo_info *cur_fbo;
+
+	char *shader_cache_path;
+	char *shader_cache_driver;
 };
 
 extern struct fbo_info *get_fbo(gs_texture_t *tex, uint32_t width,
@@ -0,0 +1,160 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "sw-subsystem.h"
+
+/* the vertex data is the buffer, so it is kept for the lifetime of the
+ * buffer instead of being freed after the upload like the GL module does */
+
+gs_vertbuffer_t *device_vertexbuffer_create(gs_device_t *device,
+					    struct gs_vb_data *data,
+					    uint32_t flags)
+{
+	struct gs_vertex_buffer *vb = bzalloc(sizeof(struct gs_vertex_buffer));
+	vb->device = device;
+	vb->data = data;
+	vb->num = data->num;
+	vb->dynamic = flags & GS_DYNAMIC;
+	return vb;
+}
+
+void gs_vertexbuffer_destroy(gs_vertbuffer_t *vb)
+{
+	if (!vb)
+		return;
+
+	if (vb->device->cur_vertex_buffer == vb)
+		vb->device->cur_vertex_buffer = NULL;
+
+	gs_vbdata_destroy(vb->data);
+	bfree(vb);
+}
+
+static inline void copy_buffer_data(void *dst, const void *src, size_t size)
+{
+	if (dst && src && dst != src)
+		memcpy(dst, src, size);
+}
+
+void gs_vertexbuffer_flush(gs_vertbuffer_t *vb)
+{
+	if (!vb->dynamic)
+		blog(LOG_ERROR, "vertex buffer is not dynamic");
+}
+
+void gs_vertexbuffer_flush_direct(gs_vertbuffer_t *vb,
+				  const struct gs_vb_data *data)
+{
+	struct gs_vb_data *dst = vb->data;
+	size_t num = data->num < vb->num ? data->num : vb->num;
+	size_t num_tex = data->num_tex < dst->num_tex ? data->num_tex
+						      : dst->num_tex;
+
+	if (!vb->dynamic) {
+		blog(LOG_ERROR, "vertex buffer is not dynamic");
+		return;
+	}
+
+	copy_buffer_data(dst->points, data->points, num * sizeof(struct vec3));
+	copy_buffer_data(dst->normals, data->normals,
+			 num * sizeof(struct vec3));
+	copy_buffer_data(dst->tangents, data->tangents,
+			 num * sizeof(struct vec3));
+	copy_buffer_data(dst->colors, data->colors, num * sizeof(uint32_t));
+
+	for (size_t i = 0; i < num_tex; i++) {
+		struct gs_tvertarray *tv = data->tvarray + i;
+		copy_buffer_data(dst->tvarray[i].array, tv->array,
+				 num * tv->width * sizeof(float));
+	}
+}
+
+struct gs_vb_data *gs_vertexbuffer_get_data(const gs_vertbuffer_t *vb)
+{
+	return vb->data;
+}
+
+void device_load_vertexbuffer(gs_device_t *device, gs_vertbuffer_t *vb)
+{
+	device->cur_vertex_buffer = vb;
+}
+
+gs_indexbuffer_t *device_indexbuffer_create(gs_device_t *device,
+					    enum gs_index_type type,
+					    void *indices, size_t num,
+					    uint32_t flags)
+{
+	struct gs_index_buffer *ib = bzalloc(sizeof(struct gs_index_buffer));
+	size_t width = type == GS_UNSIGNED_LONG ? 4 : 2;
+
+	ib->device = device;
+	ib->data = indices;
+	ib->dynamic = flags & GS_DYNAMIC;
+	ib->num = num;
+	ib->width = width;
+	ib->size = width * num;
+	ib->type = type;
+	return ib;
+}
+
+void gs_indexbuffer_destroy(gs_indexbuffer_t *ib)
+{
+	if (!ib)
+		return;
+
+	if (ib->device->cur_index_buffer == ib)
+		ib->device->cur_index_buffer = NULL;
+
+	bfree(ib->data);
+	bfree(ib);
+}
+
+void gs_indexbuffer_flush(gs_indexbuffer_t *ib)
+{
+	if (!ib->dynamic)
+		blog(LOG_ERROR, "Index buffer is not dynamic");
+}
+
+void gs_indexbuffer_flush_direct(gs_indexbuffer_t *ib, const void *data)
+{
+	if (!ib->dynamic) {
+		blog(LOG_ERROR, "Index buffer is not dynamic");
+		return;
+	}
+
+	copy_buffer_data(ib->data, data, ib->size);
+}
+
+void *gs_indexbuffer_get_data(const gs_indexbuffer_t *ib)
+{
+	return ib->data;
+}
+
+size_t gs_indexbuffer_get_num_indices(const gs_indexbuffer_t *ib)
+{
+	return ib->num;
+}
+
+enum gs_index_type gs_indexbuffer_get_type(const gs_indexbuffer_t *ib)
+{
+	return ib->type;
+}
+
+void device_load_indexbuffer(gs_device_t *device, gs_indexbuffer_t *ib)
+{
+	device->cur_index_buffer = ib;
+}
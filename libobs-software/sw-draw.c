@@ -0,0 +1,483 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <math.h>
+#include <graphics/vec4.h>
+#include "sw-subsystem.h"
+#include <graphics/srgb.h>
+
+struct sw_vertex {
+	float x, y;
+	float u, v;
+	float color[4];
+};
+
+struct draw_state {
+	gs_device_t *device;
+
+	struct gs_texture *target;
+	uint8_t *pixels;
+	uint32_t bpp;
+	int min_x, min_y;
+	int max_x, max_y;
+	bool srgb;
+
+	sw_pixel_shader_t shader;
+	struct sw_pass pass;
+};
+
+static inline void set_white(float *color)
+{
+	color[0] = color[1] = color[2] = color[3] = 1.0f;
+}
+
+static inline struct gs_texture *get_target(const gs_device_t *device)
+{
+	if (device->cur_render_target)
+		return device->cur_render_target;
+	if (device->cur_swap)
+		return device->cur_swap->target;
+	return NULL;
+}
+
+static bool can_render(const gs_device_t *device, uint32_t num_verts)
+{
+	if (!device->cur_vertex_shader) {
+		blog(LOG_ERROR, "No vertex shader specified");
+		return false;
+	}
+
+	if (!device->cur_pixel_shader) {
+		blog(LOG_ERROR, "No pixel shader specified");
+		return false;
+	}
+
+	if (!device->cur_pixel_shader->native) {
+		const char *file = device->cur_pixel_shader->file;
+		blog(LOG_ERROR, "Pixel shader '%s' has no native implementation",
+		     file ? file : "(unnamed)");
+		return false;
+	}
+
+	if (!device->cur_vertex_buffer && (num_verts == 0)) {
+		blog(LOG_ERROR, "No vertex buffer specified");
+		return false;
+	}
+
+	if (!get_target(device)) {
+		blog(LOG_ERROR, "No active swap chain or render target");
+		return false;
+	}
+
+	return true;
+}
+
+static void update_viewproj_matrix(struct gs_device *device)
+{
+	struct gs_shader *vs = device->cur_vertex_shader;
+	struct matrix4 viewproj;
+
+	gs_matrix_get(&device->cur_view);
+	matrix4_mul(&device->cur_viewproj, &device->cur_view,
+		    &device->cur_proj);
+
+	if (vs->viewproj) {
+		matrix4_transpose(&viewproj, &device->cur_viewproj);
+		gs_shader_set_matrix4(vs->viewproj, &viewproj);
+	}
+}
+
+static inline void intersect_rect(struct draw_state *ds, int x, int y, int cx,
+				  int cy)
+{
+	if (ds->min_x < x)
+		ds->min_x = x;
+	if (ds->min_y < y)
+		ds->min_y = y;
+	if (ds->max_x > x + cx)
+		ds->max_x = x + cx;
+	if (ds->max_y > y + cy)
+		ds->max_y = y + cy;
+}
+
+static void init_target(struct draw_state *ds)
+{
+	gs_device_t *device = ds->device;
+	struct gs_texture *target = get_target(device);
+	const struct gs_rect *vp = &device->cur_viewport;
+
+	ds->target = target;
+	ds->pixels = target->data;
+	ds->bpp = gs_get_format_bpp(target->format) / 8;
+
+	if (target->type == GS_TEXTURE_CUBE)
+		ds->pixels += target->slice_size * device->cur_render_side;
+
+	ds->min_x = 0;
+	ds->min_y = 0;
+	ds->max_x = (int)target->width;
+	ds->max_y = (int)target->height;
+	ds->srgb = device->framebuffer_srgb && gs_is_srgb_format(target->format);
+
+	intersect_rect(ds, vp->x, vp->y, vp->cx, vp->cy);
+	if (device->scissor_enabled)
+		intersect_rect(ds, device->cur_scissor.x, device->cur_scissor.y,
+			       device->cur_scissor.cx, device->cur_scissor.cy);
+}
+
+static void init_source(struct draw_state *ds)
+{
+	ds->shader = ds->device->cur_pixel_shader->native;
+	sw_pass_init(&ds->pass, ds->device);
+}
+
+static inline float blend_factor(enum gs_blend_type type, const float *src,
+				 const float *dst, size_t i)
+{
+	switch (type) {
+	case GS_BLEND_ZERO:
+		return 0.0f;
+	case GS_BLEND_ONE:
+		return 1.0f;
+	case GS_BLEND_SRCCOLOR:
+		return src[i];
+	case GS_BLEND_INVSRCCOLOR:
+		return 1.0f - src[i];
+	case GS_BLEND_SRCALPHA:
+		return src[3];
+	case GS_BLEND_INVSRCALPHA:
+		return 1.0f - src[3];
+	case GS_BLEND_DSTCOLOR:
+		return dst[i];
+	case GS_BLEND_INVDSTCOLOR:
+		return 1.0f - dst[i];
+	case GS_BLEND_DSTALPHA:
+		return dst[3];
+	case GS_BLEND_INVDSTALPHA:
+		return 1.0f - dst[3];
+	case GS_BLEND_SRCALPHASAT:
+		if (i == 3)
+			return 1.0f;
+		return src[3] < 1.0f - dst[3] ? src[3] : 1.0f - dst[3];
+	}
+
+	return 0.0f;
+}
+
+static void shade_pixel(const struct draw_state *ds, int x, int y,
+			const struct sw_fragment *frag)
+{
+	gs_device_t *device = ds->device;
+	uint8_t *pixel = ds->pixels + (size_t)y * ds->target->linesize +
+			 (size_t)x * ds->bpp;
+	float src[4];
+	float dst[4];
+
+	ds->shader(&ds->pass, frag, src);
+
+	sw_load_pixel(ds->target->format, pixel, dst);
+	if (ds->srgb)
+		gs_float3_srgb_nonlinear_to_linear(dst);
+
+	for (size_t i = 0; i < 4; i++) {
+		enum gs_blend_type src_type = i < 3 ? device->blend_src_c
+						    : device->blend_src_a;
+		enum gs_blend_type dest_type = i < 3 ? device->blend_dest_c
+						     : device->blend_dest_a;
+
+		if (!device->write_mask[i])
+			continue;
+
+		if (device->blend_enabled)
+			dst[i] = src[i] * blend_factor(src_type, src, dst, i) +
+				 dst[i] * blend_factor(dest_type, src, dst, i);
+		else
+			dst[i] = src[i];
+	}
+
+	if (ds->srgb)
+		gs_float3_srgb_linear_to_nonlinear(dst);
+	sw_store_pixel(ds->target->format, pixel, dst);
+}
+
+/* ------------------------------------------------------------------------- */
+/* rasterization                                                             */
+
+static inline float edge(const struct sw_vertex *a, const struct sw_vertex *b,
+			 float x, float y)
+{
+	return (b->x - a->x) * (y - a->y) - (b->y - a->y) * (x - a->x);
+}
+
+/* pixel centers exactly on an edge belong to only one of the two triangles
+ * sharing it, so blended strips never touch a pixel twice */
+static inline bool inside(float w, const struct sw_vertex *a,
+			  const struct sw_vertex *b)
+{
+	float dx = b->x - a->x;
+	float dy = b->y - a->y;
+
+	if (w != 0.0f)
+		return w > 0.0f;
+	return dy > 0.0f || (dy == 0.0f && dx < 0.0f);
+}
+
+static void draw_triangle(const struct draw_state *ds,
+			  const struct sw_vertex *v0,
+			  const struct sw_vertex *v1,
+			  const struct sw_vertex *v2)
+{
+	float area = edge(v0, v1, v2->x, v2->y);
+	float min_xf, min_yf, max_xf, max_yf;
+	int min_x, min_y, max_x, max_y;
+	struct sw_fragment frag;
+
+	if (area == 0.0f || isnan(area))
+		return;
+
+	if (area < 0.0f) {
+		const struct sw_vertex *temp = v1;
+		v1 = v2;
+		v2 = temp;
+		area = -area;
+	}
+
+	/* texture coordinates are interpolated linearly, so their
+	 * derivatives are the same for every pixel of the triangle */
+	frag.du_dx = ((v1->u - v0->u) * (v2->y - v0->y) -
+		      (v2->u - v0->u) * (v1->y - v0->y)) /
+		     area;
+	frag.dv_dy = ((v2->v - v0->v) * (v1->x - v0->x) -
+		      (v1->v - v0->v) * (v2->x - v0->x)) /
+		     area;
+
+	min_xf = fminf(v0->x, fminf(v1->x, v2->x));
+	min_yf = fminf(v0->y, fminf(v1->y, v2->y));
+	max_xf = fmaxf(v0->x, fmaxf(v1->x, v2->x));
+	max_yf = fmaxf(v0->y, fmaxf(v1->y, v2->y));
+
+	if (!(max_xf > (float)ds->min_x && min_xf < (float)ds->max_x &&
+	      max_yf > (float)ds->min_y && min_yf < (float)ds->max_y))
+		return;
+
+	min_x = min_xf > (float)ds->min_x ? (int)floorf(min_xf) : ds->min_x;
+	min_y = min_yf > (float)ds->min_y ? (int)floorf(min_yf) : ds->min_y;
+	max_x = max_xf < (float)ds->max_x ? (int)ceilf(max_xf) : ds->max_x;
+	max_y = max_yf < (float)ds->max_y ? (int)ceilf(max_yf) : ds->max_y;
+
+	for (int y = min_y; y < max_y; y++) {
+		float py = (float)y + 0.5f;
+
+		for (int x = min_x; x < max_x; x++) {
+			float px = (float)x + 0.5f;
+			float w0 = edge(v1, v2, px, py);
+			float w1 = edge(v2, v0, px, py);
+			float w2 = edge(v0, v1, px, py);
+
+			if (!inside(w0, v1, v2) || !inside(w1, v2, v0) ||
+			    !inside(w2, v0, v1))
+				continue;
+
+			w0 /= area;
+			w1 /= area;
+			w2 /= area;
+
+			frag.x = px;
+			frag.y = py;
+			frag.u = w0 * v0->u + w1 * v1->u + w2 * v2->u;
+			frag.v = w0 * v0->v + w1 * v1->v + w2 * v2->v;
+			for (size_t i = 0; i < 4; i++)
+				frag.color[i] = w0 * v0->color[i] +
+						w1 * v1->color[i] +
+						w2 * v2->color[i];
+
+			shade_pixel(ds, x, y, &frag);
+		}
+	}
+}
+
+/* draws without a vertex buffer generate a triangle covering the viewport in
+ * the vertex shader, which is the same as filling the viewport */
+static void draw_viewport(const struct draw_state *ds)
+{
+	const struct gs_rect *vp = &ds->device->cur_viewport;
+	struct sw_fragment frag;
+
+	if (vp->cx <= 0 || vp->cy <= 0)
+		return;
+
+	frag.du_dx = 1.0f / (float)vp->cx;
+	frag.dv_dy = 1.0f / (float)vp->cy;
+	set_white(frag.color);
+
+	for (int y = ds->min_y; y < ds->max_y; y++) {
+		frag.y = (float)y + 0.5f;
+		frag.v = (frag.y - (float)vp->y) * frag.dv_dy;
+
+		for (int x = ds->min_x; x < ds->max_x; x++) {
+			frag.x = (float)x + 0.5f;
+			frag.u = (frag.x - (float)vp->x) * frag.du_dx;
+			shade_pixel(ds, x, y, &frag);
+		}
+	}
+}
+
+static bool get_vertex(const gs_device_t *device, uint32_t idx,
+		       struct sw_vertex *vert)
+{
+	const struct gs_vertex_buffer *vb = device->cur_vertex_buffer;
+	const struct gs_index_buffer *ib = device->cur_index_buffer;
+	const struct gs_vb_data *data = vb->data;
+	const struct gs_rect *vp = &device->cur_viewport;
+	struct vec4 pos;
+
+	if (ib) {
+		if (idx >= ib->num)
+			return false;
+		idx = ib->type == GS_UNSIGNED_LONG
+			      ? ((const uint32_t *)ib->data)[idx]
+			      : ((const uint16_t *)ib->data)[idx];
+	}
+
+	if (idx >= vb->num)
+		return false;
+
+	vec4_from_vec3(&pos, data->points + idx);
+	vec4_transform(&pos, &pos, &device->cur_viewproj);
+	if (pos.w != 0.0f && pos.w != 1.0f) {
+		pos.x /= pos.w;
+		pos.y /= pos.w;
+	}
+
+	vert->x = (float)vp->x + (pos.x + 1.0f) * 0.5f * (float)vp->cx;
+	vert->y = (float)vp->y + (1.0f - pos.y) * 0.5f * (float)vp->cy;
+	vert->u = 0.0f;
+	vert->v = 0.0f;
+
+	if (data->num_tex && data->tvarray[0].width >= 2) {
+		const float *uv = data->tvarray[0].array;
+		uv += idx * data->tvarray[0].width;
+		vert->u = uv[0];
+		vert->v = uv[1];
+	}
+
+	if (data->colors) {
+		uint32_t color = data->colors[idx];
+		vert->color[0] = (float)(color & 0xFF) / 255.0f;
+		vert->color[1] = (float)((color >> 8) & 0xFF) / 255.0f;
+		vert->color[2] = (float)((color >> 16) & 0xFF) / 255.0f;
+		vert->color[3] = (float)(color >> 24) / 255.0f;
+	} else {
+		set_white(vert->color);
+	}
+
+	return true;
+}
+
+static void draw_primitives(const struct draw_state *ds,
+			    enum gs_draw_mode draw_mode, uint32_t start_vert,
+			    uint32_t num_verts)
+{
+	struct sw_vertex verts[3];
+	size_t count = 0;
+
+	if (draw_mode != GS_TRIS && draw_mode != GS_TRISTRIP)
+		return;
+
+	for (uint32_t i = 0; i < num_verts; i++) {
+		if (!get_vertex(ds->device, start_vert + i, &verts[count % 3]))
+			break;
+
+		if (++count < 3)
+			continue;
+
+		if (draw_mode == GS_TRIS) {
+			draw_triangle(ds, &verts[0], &verts[1], &verts[2]);
+			count = 0;
+		} else {
+			/* the winding of every other triangle flips, which
+			 * does not matter since culling is not emulated */
+			draw_triangle(ds, &verts[(count - 3) % 3],
+				      &verts[(count - 2) % 3],
+				      &verts[(count - 1) % 3]);
+		}
+	}
+}
+
+void device_draw(gs_device_t *device, enum gs_draw_mode draw_mode,
+		 uint32_t start_vert, uint32_t num_verts)
+{
+	struct gs_vertex_buffer *vb = device->cur_vertex_buffer;
+	struct gs_index_buffer *ib = device->cur_index_buffer;
+	gs_effect_t *effect = gs_get_effect();
+	struct draw_state ds = {0};
+
+	if (!can_render(device, num_verts)) {
+		blog(LOG_ERROR, "device_draw (software) failed");
+		return;
+	}
+
+	if (effect)
+		gs_effect_update_params(effect);
+
+	update_viewproj_matrix(device);
+
+	ds.device = device;
+	init_target(&ds);
+	init_source(&ds);
+
+	if (!vb) {
+		draw_viewport(&ds);
+		return;
+	}
+
+	if (num_verts == 0)
+		num_verts = (uint32_t)(ib ? ib->num : vb->num);
+
+	draw_primitives(&ds, draw_mode, start_vert, num_verts);
+}
+
+void device_clear(gs_device_t *device, uint32_t clear_flags,
+		  const struct vec4 *color, float depth, uint8_t stencil)
+{
+	struct gs_texture *target = get_target(device);
+	uint8_t *pixels;
+	uint8_t pixel[16];
+	uint32_t bpp;
+
+	UNUSED_PARAMETER(depth);
+	UNUSED_PARAMETER(stencil);
+
+	if (!(clear_flags & GS_CLEAR_COLOR) || !target)
+		return;
+
+	bpp = gs_get_format_bpp(target->format) / 8;
+	if (!bpp)
+		return;
+
+	pixels = target->data;
+	if (target->type == GS_TEXTURE_CUBE)
+		pixels += target->slice_size * device->cur_render_side;
+
+	sw_store_pixel(target->format, pixel, color->ptr);
+
+	for (uint32_t y = 0; y < target->height; y++) {
+		uint8_t *row = pixels + (size_t)y * target->linesize;
+		for (uint32_t x = 0; x < target->width; x++)
+			memcpy(row + (size_t)x * bpp, pixel, bpp);
+	}
+}
@@ -0,0 +1,1779 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <math.h>
+#include <stddef.h>
+#include "sw-subsystem.h"
+#include <graphics/srgb.h>
+
+/*
+ * Native versions of the pixel shaders in libobs/data and
+ * plugins/obs-filters/data.  Each function computes what its technique's
+ * pass computes on the GPU, including the work the vertex shader does on
+ * texture coordinates, and follows the HLSL semantics: Sample() goes through
+ * the effect's sampler state, Load() reads a texel directly and reads zero
+ * outside of the texture.
+ */
+
+/* ------------------------------------------------------------------------- */
+/* helpers                                                                   */
+
+static inline float saturate(float val)
+{
+	return fminf(fmaxf(val, 0.0f), 1.0f);
+}
+
+static inline float frac(float val)
+{
+	return val - floorf(val);
+}
+
+static inline float lerp(float a, float b, float t)
+{
+	return a + (b - a) * t;
+}
+
+static inline float smoothstep(float min, float max, float val)
+{
+	float t = saturate((val - min) / (max - min));
+	return t * t * (3.0f - 2.0f * t);
+}
+
+static inline float dot3(const float *a, const float *b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static inline float distance2(const float *a, float x, float y)
+{
+	return sqrtf((a[0] - x) * (a[0] - x) + (a[1] - y) * (a[1] - y));
+}
+
+static inline void set4(float *color, float r, float g, float b, float a)
+{
+	color[0] = r;
+	color[1] = g;
+	color[2] = b;
+	color[3] = a;
+}
+
+static inline void mul4(float *color, const float *val)
+{
+	for (size_t i = 0; i < 4; i++)
+		color[i] *= val[i];
+}
+
+/* rgba.rgb = max(float3(0.0, 0.0, 0.0), rgba.rgb / rgba.a) */
+static inline void unpremultiply(float *color)
+{
+	for (size_t i = 0; i < 3; i++)
+		color[i] = fmaxf(0.0f, color[i] / color[3]);
+}
+
+static inline void premultiply(float *color)
+{
+	for (size_t i = 0; i < 3; i++)
+		color[i] *= color[3];
+}
+
+static inline void alpha_divide(float *color)
+{
+	float multiplier = color[3] > 0.0f ? 1.0f / color[3] : 0.0f;
+
+	for (size_t i = 0; i < 3; i++)
+		color[i] *= multiplier;
+}
+
+static inline void sample(const struct sw_texref *ref, float u, float v,
+			  float *color)
+{
+	if (ref->tex)
+		sw_sample(ref->tex, &ref->sampler, ref->srgb, u, v, color);
+	else
+		set4(color, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+static inline void load(const struct sw_texref *ref, int x, int y,
+			float *color)
+{
+	if (ref->tex)
+		sw_load(ref->tex, ref->srgb, x, y, color);
+	else
+		set4(color, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+/* ------------------------------------------------------------------------- */
+/* default.effect, default_rect.effect, opaque.effect, repeat.effect,        */
+/* premultiplied_alpha.effect                                                */
+
+static void draw_bare(const struct sw_pass *pass,
+		      const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u, frag->v, color);
+}
+
+static void draw_alpha_divide(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u, frag->v, color);
+	alpha_divide(color);
+}
+
+static void draw_nonlinear_alpha(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u, frag->v, color);
+	gs_float3_srgb_linear_to_nonlinear(color);
+	premultiply(color);
+	gs_float3_srgb_nonlinear_to_linear(color);
+}
+
+static void draw_srgb_decompress(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u, frag->v, color);
+	gs_float3_srgb_nonlinear_to_linear(color);
+}
+
+static void draw_opaque(const struct sw_pass *pass,
+			const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u, frag->v, color);
+	color[3] = 1.0f;
+}
+
+static void draw_repeat(const struct sw_pass *pass,
+			const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u * pass->u.scale[0],
+	       frag->v * pass->u.scale[1], color);
+}
+
+static void draw_premultiplied(const struct sw_pass *pass,
+			       const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u, frag->v, color);
+	if (color[3] > 0.0f) {
+		for (size_t i = 0; i < 3; i++)
+			color[i] /= color[3];
+	}
+	for (size_t i = 0; i < 4; i++)
+		color[i] = saturate(color[i]);
+}
+
+/* ------------------------------------------------------------------------- */
+/* solid.effect                                                              */
+
+static void draw_solid(const struct sw_pass *pass,
+		       const struct sw_fragment *frag, float *color)
+{
+	UNUSED_PARAMETER(frag);
+	memcpy(color, pass->u.color, sizeof(pass->u.color));
+}
+
+static void draw_solid_colored(const struct sw_pass *pass,
+			       const struct sw_fragment *frag, float *color)
+{
+	memcpy(color, frag->color, sizeof(frag->color));
+	mul4(color, pass->u.color);
+}
+
+static inline float rand_channel(const struct sw_fragment *frag,
+				 const float *rand_vals)
+{
+	float val = frag->x * rand_vals[0] + frag->y * rand_vals[1];
+	return 0.5f + 0.5f * frac(sinf(val) * rand_vals[2]);
+}
+
+static void draw_random(const struct sw_pass *pass,
+			const struct sw_fragment *frag, float *color)
+{
+	set4(color, rand_channel(frag, pass->u.randomvals1),
+	     rand_channel(frag, pass->u.randomvals2),
+	     rand_channel(frag, pass->u.randomvals3), 1.0f);
+}
+
+/* ------------------------------------------------------------------------- */
+/* bicubic_scale.effect, lanczos_scale.effect                                */
+
+static inline float undistort_u(const struct sw_pass *pass, float u)
+{
+	float a = pass->u.undistort_factor;
+	float x = (u - 0.5f) * 2.0f;
+
+	x = (1.0f - a) * (x * x * x * x * x) + a * x;
+	return x * 0.5f + 0.5f;
+}
+
+/* sums taps around the texel centers at pos, which is in texels, with the
+ * given weights.  without undistortion every tap is a texel center, which
+ * the linear sampler returns unfiltered, so the texel is read directly */
+static void draw_taps(const struct sw_pass *pass, const float *pos,
+		      const float *row_taps, const float *col_taps,
+		      int num_taps, bool undistort, float *color)
+{
+	const float *dim_i = pass->u.base_dimension_i;
+	struct gs_sampler_info point = pass->image.sampler;
+	int first = -(num_taps / 2 - 1);
+
+	point.filter = GS_FILTER_POINT;
+	set4(color, 0.0f, 0.0f, 0.0f, 0.0f);
+
+	for (int j = 0; j < num_taps; j++) {
+		float v = (pos[1] + (float)(first + j)) * dim_i[1];
+
+		for (int i = 0; i < num_taps; i++) {
+			float u = (pos[0] + (float)(first + i)) * dim_i[0];
+			float weight = row_taps[i] * col_taps[j];
+			float texel[4];
+
+			if (undistort)
+				sample(&pass->image, undistort_u(pass, u), v,
+				       texel);
+			else if (pass->image.tex)
+				sw_sample(pass->image.tex, &point,
+					  pass->image.srgb, u, v, texel);
+			else
+				set4(texel, 0.0f, 0.0f, 0.0f, 0.0f);
+
+			for (size_t c = 0; c < 4; c++)
+				color[c] += texel[c] * weight;
+		}
+	}
+}
+
+/* Sharper version.  May look better in some cases. B=0, C=0.75 */
+static inline void weight4(float x, float *taps)
+{
+	taps[0] = ((-0.75f * x + 1.5f) * x - 0.75f) * x;
+	taps[1] = (1.25f * x - 2.25f) * x * x + 1.0f;
+	taps[2] = ((-1.25f * x + 1.5f) * x + 0.75f) * x;
+	taps[3] = (0.75f * x - 0.75f) * x * x;
+}
+
+static void bicubic(const struct sw_pass *pass, const struct sw_fragment *frag,
+		    bool undistort, float *color)
+{
+	float pos[2];
+	float pos1[2];
+	float row_taps[4], col_taps[4];
+
+	pos[0] = frag->u * pass->u.base_dimension[0];
+	pos[1] = frag->v * pass->u.base_dimension[1];
+	pos1[0] = floorf(pos[0] - 0.5f) + 0.5f;
+	pos1[1] = floorf(pos[1] - 0.5f) + 0.5f;
+
+	weight4(pos[0] - pos1[0], row_taps);
+	weight4(pos[1] - pos1[1], col_taps);
+
+	draw_taps(pass, pos1, row_taps, col_taps, 4, undistort, color);
+}
+
+static void draw_bicubic(const struct sw_pass *pass,
+			 const struct sw_fragment *frag, float *color)
+{
+	bicubic(pass, frag, false, color);
+}
+
+static void draw_bicubic_alpha_divide(const struct sw_pass *pass,
+				      const struct sw_fragment *frag,
+				      float *color)
+{
+	bicubic(pass, frag, false, color);
+	alpha_divide(color);
+}
+
+static void draw_bicubic_undistort(const struct sw_pass *pass,
+				   const struct sw_fragment *frag, float *color)
+{
+	bicubic(pass, frag, true, color);
+}
+
+static inline float lanczos_weight(float x)
+{
+	float x_pi = x * 3.141592654f;
+	return 3.0f * sinf(x_pi) * sinf(x_pi * (1.0f / 3.0f)) / (x_pi * x_pi);
+}
+
+static inline void weight6(float f_neg, float *taps)
+{
+	float sum = 0.0f;
+
+	for (int i = 0; i < 6; i++)
+		taps[i] = lanczos_weight(f_neg + (float)(i - 2));
+
+	/* replaces the NaN at 0 with 1 */
+	taps[2] = fminf(1.0f, taps[2]);
+
+	for (int i = 0; i < 6; i++)
+		sum += taps[i];
+	for (int i = 0; i < 6; i++)
+		taps[i] /= sum;
+}
+
+static void lanczos(const struct sw_pass *pass, const struct sw_fragment *frag,
+		    bool undistort, float *color)
+{
+	float pos[2];
+	float pos2[2];
+	float row_taps[6], col_taps[6];
+
+	pos[0] = frag->u * pass->u.base_dimension[0];
+	pos[1] = frag->v * pass->u.base_dimension[1];
+	pos2[0] = floorf(pos[0] - 0.5f) + 0.5f;
+	pos2[1] = floorf(pos[1] - 0.5f) + 0.5f;
+
+	weight6(pos2[0] - pos[0], row_taps);
+	weight6(pos2[1] - pos[1], col_taps);
+
+	draw_taps(pass, pos2, row_taps, col_taps, 6, undistort, color);
+}
+
+static void draw_lanczos(const struct sw_pass *pass,
+			 const struct sw_fragment *frag, float *color)
+{
+	lanczos(pass, frag, false, color);
+}
+
+static void draw_lanczos_alpha_divide(const struct sw_pass *pass,
+				      const struct sw_fragment *frag,
+				      float *color)
+{
+	lanczos(pass, frag, false, color);
+	alpha_divide(color);
+}
+
+static void draw_lanczos_undistort(const struct sw_pass *pass,
+				   const struct sw_fragment *frag, float *color)
+{
+	lanczos(pass, frag, true, color);
+}
+
+/* ------------------------------------------------------------------------- */
+/* area.effect, bilinear_lowres_scale.effect                                 */
+
+static void area(const struct sw_pass *pass, const struct sw_fragment *frag,
+		 float *color)
+{
+	const float *dim = pass->u.base_dimension;
+	const float *dim_i = pass->u.base_dimension_i;
+	const float uv[2] = {frag->u, frag->v};
+	const float uv_delta[2] = {frag->du_dx, frag->dv_dy};
+	float begin[2], end[2];
+	float target_min[2], target_max[2];
+	float scale[2];
+	float load_y;
+
+	for (size_t i = 0; i < 2; i++) {
+		float uv_min = uv[i] - 0.5f * uv_delta[i];
+		float uv_max = uv_min + uv_delta[i];
+		float target_dim = 1.0f / uv_delta[i];
+		float target_pos = uv[i] * target_dim;
+
+		begin[i] = floorf(uv_min * dim[i]);
+		end[i] = ceilf(uv_max * dim[i]);
+		target_min[i] = target_pos - 0.5f;
+		target_max[i] = target_pos + 0.5f;
+		scale[i] = dim_i[i] * target_dim;
+	}
+
+	set4(color, 0.0f, 0.0f, 0.0f, 0.0f);
+
+	load_y = begin[1];
+	do {
+		float source_y_min = load_y * scale[1];
+		float source_y_max = source_y_min + scale[1];
+		float y_min = fmaxf(source_y_min, target_min[1]);
+		float y_max = fminf(source_y_max, target_max[1]);
+		float height = y_max - y_min;
+		float load_x = begin[0];
+
+		do {
+			float source_x_min = load_x * scale[0];
+			float source_x_max = source_x_min + scale[0];
+			float x_min = fmaxf(source_x_min, target_min[0]);
+			float x_max = fminf(source_x_max, target_max[0]);
+			float width = x_max - x_min;
+			float texel[4];
+
+			load(&pass->image, (int)load_x, (int)load_y, texel);
+			for (size_t c = 0; c < 4; c++)
+				color[c] += width * height * texel[c];
+
+			++load_x;
+		} while (load_x < end[0]);
+
+		++load_y;
+	} while (load_y < end[1]);
+}
+
+static void draw_area(const struct sw_pass *pass,
+		      const struct sw_fragment *frag, float *color)
+{
+	area(pass, frag, color);
+}
+
+static void draw_area_alpha_divide(const struct sw_pass *pass,
+				   const struct sw_fragment *frag,
+				   float *color)
+{
+	area(pass, frag, color);
+	alpha_divide(color);
+}
+
+static void draw_area_upscale(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, float *color)
+{
+	const float *dim = pass->u.base_dimension;
+	const float *dim_i = pass->u.base_dimension_i;
+	float uv[2] = {frag->u, frag->v};
+	const float uv_delta[2] = {frag->du_dx, frag->dv_dy};
+
+	for (size_t i = 0; i < 2; i++) {
+		float uv_min = uv[i] - 0.5f * uv_delta[i];
+		float uv_max = uv_min + uv_delta[i];
+		float first = floorf(uv_min * dim[i]);
+		float last = ceilf(uv_max * dim[i]) - 1.0f;
+
+		if (first < last) {
+			float boundary = last * dim_i[i];
+			uv[i] = ((uv[i] - boundary) / uv_delta[i]) * dim_i[i] +
+				boundary;
+		} else {
+			uv[i] = (first + 0.5f) * dim_i[i];
+		}
+	}
+
+	sample(&pass->image, uv[0], uv[1], color);
+}
+
+/* simulates the Direct3D 8-sample pattern */
+static void lowres_bilinear(const struct sw_pass *pass,
+			    const struct sw_fragment *frag, float *color)
+{
+	static const float offsets[8][2] = {
+		{0.0625f, -0.1875f}, {-0.0625f, 0.1875f}, {0.3125f, 0.0625f},
+		{-0.1875f, -0.3125f}, {-0.3125f, 0.3125f}, {-0.4375f, -0.0625f},
+		{0.1875f, 0.4375f},  {0.4375f, -0.4375f},
+	};
+
+	set4(color, 0.0f, 0.0f, 0.0f, 0.0f);
+
+	for (size_t i = 0; i < 8; i++) {
+		float texel[4];
+
+		sample(&pass->image, frag->u + offsets[i][0] * frag->du_dx,
+		       frag->v + offsets[i][1] * frag->dv_dy, texel);
+		for (size_t c = 0; c < 4; c++)
+			color[c] += texel[c] * 0.125f;
+	}
+}
+
+static void draw_lowres_bilinear(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	lowres_bilinear(pass, frag, color);
+}
+
+static void draw_lowres_bilinear_alpha_divide(const struct sw_pass *pass,
+					      const struct sw_fragment *frag,
+					      float *color)
+{
+	lowres_bilinear(pass, frag, color);
+	alpha_divide(color);
+}
+
+/* ------------------------------------------------------------------------- */
+/* format_conversion.effect                                                  */
+
+/* these techniques draw a triangle covering the viewport, so the fragment's
+ * texture coordinate is its position in the viewport */
+
+static inline void load_pos(const struct sw_texref *ref,
+			    const struct sw_fragment *frag, float *color)
+{
+	load(ref, (int)frag->x, (int)frag->y, color);
+}
+
+static void sample_wide(const struct sw_pass *pass,
+			const struct sw_fragment *frag, float *rgb)
+{
+	float left[4], right[4];
+
+	sample(&pass->image, frag->u - pass->u.width_i, frag->v, left);
+	sample(&pass->image, frag->u, frag->v, right);
+
+	for (size_t i = 0; i < 3; i++)
+		rgb[i] = (left[i] + right[i]) * 0.5f;
+}
+
+static inline float to_plane(const float *vec, const float *rgb)
+{
+	return dot3(vec, rgb) + vec[3];
+}
+
+static void convert_y(const struct sw_pass *pass,
+		      const struct sw_fragment *frag, float *color)
+{
+	float rgba[4];
+
+	load_pos(&pass->image, frag, rgba);
+	set4(color, to_plane(pass->u.color_vec0, rgba), 0.0f, 0.0f, 1.0f);
+}
+
+static void convert_u(const struct sw_pass *pass,
+		      const struct sw_fragment *frag, float *color)
+{
+	float rgba[4];
+
+	load_pos(&pass->image, frag, rgba);
+	set4(color, to_plane(pass->u.color_vec1, rgba), 0.0f, 0.0f, 1.0f);
+}
+
+static void convert_v(const struct sw_pass *pass,
+		      const struct sw_fragment *frag, float *color)
+{
+	float rgba[4];
+
+	load_pos(&pass->image, frag, rgba);
+	set4(color, to_plane(pass->u.color_vec2, rgba), 0.0f, 0.0f, 1.0f);
+}
+
+static void convert_u_wide(const struct sw_pass *pass,
+			   const struct sw_fragment *frag, float *color)
+{
+	float rgb[3];
+
+	sample_wide(pass, frag, rgb);
+	set4(color, to_plane(pass->u.color_vec1, rgb), 0.0f, 0.0f, 1.0f);
+}
+
+static void convert_v_wide(const struct sw_pass *pass,
+			   const struct sw_fragment *frag, float *color)
+{
+	float rgb[3];
+
+	sample_wide(pass, frag, rgb);
+	set4(color, to_plane(pass->u.color_vec2, rgb), 0.0f, 0.0f, 1.0f);
+}
+
+static void convert_uv_wide(const struct sw_pass *pass,
+			    const struct sw_fragment *frag, float *color)
+{
+	float rgb[3];
+
+	sample_wide(pass, frag, rgb);
+	set4(color, to_plane(pass->u.color_vec1, rgb),
+	     to_plane(pass->u.color_vec2, rgb), 0.0f, 1.0f);
+}
+
+static void yuv_to_rgb(const struct sw_pass *pass, float y, float cb, float cr,
+		       float *color)
+{
+	const float *min = pass->u.color_range_min;
+	const float *max = pass->u.color_range_max;
+	float yuv[3];
+
+	yuv[0] = fminf(fmaxf(y, min[0]), max[0]);
+	yuv[1] = fminf(fmaxf(cb, min[1]), max[1]);
+	yuv[2] = fminf(fmaxf(cr, min[2]), max[2]);
+
+	color[0] = to_plane(pass->u.color_vec0, yuv);
+	color[1] = to_plane(pass->u.color_vec1, yuv);
+	color[2] = to_plane(pass->u.color_vec2, yuv);
+}
+
+/* packed 4:2:2, one texel holds two pixels.  y0, y1, cb and cr are the
+ * texel's channel indices */
+static void packed_reverse(const struct sw_pass *pass,
+			   const struct sw_fragment *frag, int y0, int y1,
+			   int cb, int cr, float *color)
+{
+	float x = pass->u.width_d2 * frag->u;
+	float y = pass->u.height * frag->v;
+	float texel[4];
+
+	load(&pass->image, (int)x, (int)y, texel);
+	yuv_to_rgb(pass, frac(x) < 0.5f ? texel[y0] : texel[y1], texel[cb],
+		   texel[cr], color);
+	color[3] = 1.0f;
+}
+
+static void convert_uyvy_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	packed_reverse(pass, frag, 1, 3, 2, 0, color);
+}
+
+static void convert_yuy2_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	packed_reverse(pass, frag, 2, 0, 1, 3, color);
+}
+
+static void convert_yvyu_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	packed_reverse(pass, frag, 2, 0, 3, 1, color);
+}
+
+/* planar, the chroma planes are loaded at chroma_x and chroma_y */
+static void planar_reverse(const struct sw_pass *pass, int x, int y,
+			   int chroma_x, int chroma_y, bool alpha,
+			   float *color)
+{
+	float luma[4], cb[4], cr[4], a[4];
+
+	load(&pass->image, x, y, luma);
+	load(&pass->image1, chroma_x, chroma_y, cb);
+	load(&pass->image2, chroma_x, chroma_y, cr);
+	yuv_to_rgb(pass, luma[0], cb[0], cr[0], color);
+
+	if (alpha) {
+		load(&pass->image3, x, y, a);
+		color[3] = a[0];
+	} else {
+		color[3] = 1.0f;
+	}
+}
+
+static void planar420_reverse(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, bool alpha,
+			      float *color)
+{
+	planar_reverse(pass, (int)frag->x, (int)frag->y,
+		       (int)(pass->u.width_d2 * frag->u),
+		       (int)(pass->u.height_d2 * frag->v), alpha, color);
+}
+
+static void planar422_reverse(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, bool alpha,
+			      float *color)
+{
+	int y = (int)(pass->u.height * frag->v);
+
+	planar_reverse(pass, (int)(pass->u.width * frag->u), y,
+		       (int)(pass->u.width_d2 * frag->u), y, alpha, color);
+}
+
+static void convert_i420_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	planar420_reverse(pass, frag, false, color);
+}
+
+static void convert_i40a_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	planar420_reverse(pass, frag, true, color);
+}
+
+static void convert_i422_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	planar422_reverse(pass, frag, false, color);
+}
+
+static void convert_i42a_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	planar422_reverse(pass, frag, true, color);
+}
+
+static void convert_i444_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	planar_reverse(pass, (int)frag->x, (int)frag->y, (int)frag->x,
+		       (int)frag->y, false, color);
+}
+
+static void convert_yuva_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	planar_reverse(pass, (int)frag->x, (int)frag->y, (int)frag->x,
+		       (int)frag->y, true, color);
+}
+
+static void convert_ayuv_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	float yuva[4];
+
+	load_pos(&pass->image, frag, yuva);
+	yuv_to_rgb(pass, yuva[0], yuva[1], yuva[2], color);
+	color[3] = yuva[3];
+}
+
+static void convert_nv12_reverse(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	float luma[4], cbcr[4];
+
+	load_pos(&pass->image, frag, luma);
+	load(&pass->image1, (int)(pass->u.width_d2 * frag->u),
+	     (int)(pass->u.height_d2 * frag->v), cbcr);
+	yuv_to_rgb(pass, luma[0], cbcr[0], cbcr[1], color);
+	color[3] = 1.0f;
+}
+
+static inline float limited_to_full(float val)
+{
+	return (255.0f / 219.0f) * val - (16.0f / 219.0f);
+}
+
+static void convert_y800_limited(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	float luma[4];
+	float full;
+
+	load_pos(&pass->image, frag, luma);
+	full = limited_to_full(luma[0]);
+	set4(color, full, full, full, 1.0f);
+}
+
+static void convert_y800_full(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, float *color)
+{
+	float luma[4];
+
+	load_pos(&pass->image, frag, luma);
+	set4(color, luma[0], luma[0], luma[0], 1.0f);
+}
+
+static void convert_rgb_limited(const struct sw_pass *pass,
+				const struct sw_fragment *frag, float *color)
+{
+	load_pos(&pass->image, frag, color);
+	for (size_t i = 0; i < 3; i++)
+		color[i] = limited_to_full(color[i]);
+}
+
+/* three single channel texels per pixel, in BGR order */
+static void bgr3(const struct sw_pass *pass, const struct sw_fragment *frag,
+		 float *color)
+{
+	float x = frag->x * 3.0f;
+	int y = (int)frag->y;
+	float b[4], g[4], r[4];
+
+	load(&pass->image, (int)(x - 1.0f), y, b);
+	load(&pass->image, (int)x, y, g);
+	load(&pass->image, (int)(x + 1.0f), y, r);
+	set4(color, r[0], g[0], b[0], 1.0f);
+}
+
+static void convert_bgr3_limited(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	bgr3(pass, frag, color);
+	for (size_t i = 0; i < 3; i++)
+		color[i] = limited_to_full(color[i]);
+}
+
+static void convert_bgr3_full(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, float *color)
+{
+	bgr3(pass, frag, color);
+}
+
+/* ------------------------------------------------------------------------- */
+/* deinterlace_*.effect                                                      */
+
+struct texel {
+	int x, y;
+};
+
+static inline struct texel pixel_uv(const struct sw_pass *pass,
+				    const struct sw_fragment *frag)
+{
+	struct texel texel = {(int)(frag->u * pass->u.dimensions[0]),
+			      (int)(frag->v * pass->u.dimensions[1])};
+	return texel;
+}
+
+static inline void load_at_image(const struct sw_pass *pass,
+				 struct texel texel, int x, int y, float *color)
+{
+	load(&pass->image, texel.x + x, texel.y + y, color);
+}
+
+static inline void load_at_prev(const struct sw_pass *pass, struct texel texel,
+				int x, int y, float *color)
+{
+	load(&pass->previous_image, texel.x + x, texel.y + y, color);
+}
+
+static inline void load_at(const struct sw_pass *pass, struct texel texel,
+			   int x, int y, int field, float *color)
+{
+	if (field == 0)
+		load_at_image(pass, texel, x, y, color);
+	else
+		load_at_prev(pass, texel, x, y, color);
+}
+
+static inline void average(float *color, const float *a, const float *b)
+{
+	for (size_t i = 0; i < 4; i++)
+		color[i] = (a[i] + b[i]) / 2.0f;
+}
+
+static void yadif_avg(const struct sw_pass *pass, struct texel texel, int x,
+		      int y, float *color)
+{
+	float prev[4], cur[4];
+
+	load_at_prev(pass, texel, x, y, prev);
+	load_at_image(pass, texel, x, y, cur);
+	average(color, prev, cur);
+}
+
+static void yadif_score(const struct sw_pass *pass, struct texel texel,
+			int level, int field, float *score)
+{
+	for (size_t i = 0; i < 4; i++)
+		score[i] = 0.0f;
+
+	for (int offset = -1; offset <= 1; offset++) {
+		float a[4], b[4];
+
+		load_at(pass, texel, offset + level, 1, field, a);
+		load_at(pass, texel, offset - level, -1, field, b);
+		for (size_t i = 0; i < 4; i++)
+			score[i] += fabsf(a[i] - b[i]);
+	}
+}
+
+static inline void yadif_pred(const struct sw_pass *pass, struct texel texel,
+			      int level, int field, float *pred)
+{
+	float a[4], b[4];
+
+	load_at(pass, texel, level, -1, field, a);
+	load_at(pass, texel, -level, 1, field, b);
+	average(pred, a, b);
+}
+
+static void yadif_check(const struct sw_pass *pass, struct texel texel,
+			int level, int field, float *spatial_score,
+			float *spatial_pred)
+{
+	float score[4], score2[4];
+	float pred[4], pred2[4];
+
+	yadif_score(pass, texel, level, field, score);
+	yadif_score(pass, texel, level * 2, field, score2);
+	yadif_pred(pass, texel, level, field, pred);
+	yadif_pred(pass, texel, level * 2, field, pred2);
+
+	for (size_t i = 0; i < 4; i++) {
+		if (score[i] >= spatial_score[i])
+			continue;
+
+		spatial_score[i] = score[i];
+		spatial_pred[i] = pred[i];
+
+		if (score2[i] < spatial_score[i]) {
+			spatial_score[i] = score2[i];
+			spatial_pred[i] = pred2[i];
+		}
+	}
+}
+
+static void yadif(const struct sw_pass *pass, struct texel texel, int field,
+		  float *color)
+{
+	float c[4], d[4], e[4], b[4], f[4];
+	float prev[4], cur[4];
+	float prev_c[4], prev_e[4], cur_c[4], cur_e[4];
+	float ul[4], ll[4], ur[4], lr[4];
+	float diff[4], spatial_score[4];
+
+	if ((texel.y % 2) == field) {
+		load_at(pass, texel, 0, 0, field, color);
+		return;
+	}
+
+	load_at(pass, texel, 0, 1, field, c);
+	load_at(pass, texel, 0, -1, field, e);
+	load_at_prev(pass, texel, 0, 0, prev);
+	load_at_image(pass, texel, 0, 0, cur);
+	load_at_prev(pass, texel, 0, 1, prev_c);
+	load_at_prev(pass, texel, 0, -1, prev_e);
+	load_at_image(pass, texel, 0, 1, cur_c);
+	load_at_image(pass, texel, 0, -1, cur_e);
+	load_at(pass, texel, -1, 1, field, ul);
+	load_at(pass, texel, -1, -1, field, ll);
+	load_at(pass, texel, 1, 1, field, ur);
+	load_at(pass, texel, 1, -1, field, lr);
+	yadif_avg(pass, texel, 0, 2, b);
+	yadif_avg(pass, texel, 0, -2, f);
+	average(d, prev, cur);
+
+	for (size_t i = 0; i < 4; i++) {
+		float temporal_diff0 = fabsf(prev[i] - cur[i]) / 2.0f;
+		float temporal_diff1 = (fabsf(prev_c[i] - c[i]) +
+					fabsf(prev_e[i] - e[i])) /
+				       2.0f;
+		float temporal_diff2 = (fabsf(cur_c[i] - c[i]) +
+					fabsf(cur_e[i] - e[i])) /
+				       2.0f;
+
+		diff[i] = fmaxf(temporal_diff0,
+				fmaxf(temporal_diff1, temporal_diff2));
+		color[i] = (c[i] + e[i]) / 2.0f;
+		spatial_score[i] = fabsf(ul[i] - ll[i]) + fabsf(c[i] - e[i]) +
+				   fabsf(ur[i] - lr[i]) - 1.0f;
+	}
+
+	yadif_check(pass, texel, -1, field, spatial_score, color);
+	yadif_check(pass, texel, 1, field, spatial_score, color);
+
+	/* mode 0, the only one the stock effects use */
+	for (size_t i = 0; i < 4; i++) {
+		float max_ = fmaxf(d[i] - e[i],
+				   fmaxf(d[i] - c[i],
+					 fminf(b[i] - c[i], f[i] - e[i])));
+		float min_ = fminf(d[i] - e[i],
+				   fminf(d[i] - c[i],
+					 fmaxf(b[i] - c[i], f[i] - e[i])));
+
+		diff[i] = fmaxf(diff[i], fmaxf(min_, -max_));
+
+		if (color[i] > d[i] + diff[i])
+			color[i] = d[i] + diff[i];
+		else if (color[i] < d[i] - diff[i])
+			color[i] = d[i] - diff[i];
+	}
+}
+
+static void discard(const struct sw_pass *pass, struct texel texel, int field,
+		    float *color)
+{
+	texel.y = texel.y / 2 * 2;
+	load_at_image(pass, texel, 0, field, color);
+}
+
+static void linear(const struct sw_pass *pass, struct texel texel, int field,
+		   float *color)
+{
+	float above[4], below[4];
+
+	if ((texel.y % 2) == field) {
+		load_at_image(pass, texel, 0, 0, color);
+		return;
+	}
+
+	load_at_image(pass, texel, 0, -1, above);
+	load_at_image(pass, texel, 0, 1, below);
+	average(color, above, below);
+}
+
+static void draw_yadif(const struct sw_pass *pass,
+		       const struct sw_fragment *frag, float *color)
+{
+	yadif(pass, pixel_uv(pass, frag), pass->u.field_order, color);
+}
+
+static void draw_yadif_2x(const struct sw_pass *pass,
+			  const struct sw_fragment *frag, float *color)
+{
+	int field = pass->u.field_order;
+	yadif(pass, pixel_uv(pass, frag), pass->u.frame2 ? 1 - field : field,
+	      color);
+}
+
+static void draw_discard(const struct sw_pass *pass,
+			 const struct sw_fragment *frag, float *color)
+{
+	discard(pass, pixel_uv(pass, frag), pass->u.field_order, color);
+}
+
+static void draw_discard_2x(const struct sw_pass *pass,
+			    const struct sw_fragment *frag, float *color)
+{
+	int field = pass->u.field_order;
+	discard(pass, pixel_uv(pass, frag), pass->u.frame2 ? field : 1 - field,
+		color);
+}
+
+static void draw_linear(const struct sw_pass *pass,
+			const struct sw_fragment *frag, float *color)
+{
+	linear(pass, pixel_uv(pass, frag), pass->u.field_order, color);
+}
+
+static void draw_linear_2x(const struct sw_pass *pass,
+			   const struct sw_fragment *frag, float *color)
+{
+	int field = pass->u.field_order;
+	linear(pass, pixel_uv(pass, frag), pass->u.frame2 ? field : 1 - field,
+	       color);
+}
+
+static void draw_blend(const struct sw_pass *pass,
+		       const struct sw_fragment *frag, float *color)
+{
+	struct texel texel = pixel_uv(pass, frag);
+	float cur[4], below[4];
+
+	load_at_image(pass, texel, 0, 0, cur);
+	load_at_image(pass, texel, 0, 1, below);
+	average(color, cur, below);
+}
+
+static void draw_blend_2x(const struct sw_pass *pass,
+			  const struct sw_fragment *frag, float *color)
+{
+	struct texel texel = pixel_uv(pass, frag);
+	float cur[4], below[4];
+
+	load_at_image(pass, texel, 0, 0, cur);
+	if (!pass->u.frame2)
+		load_at_prev(pass, texel, 0, 1, below);
+	else
+		load_at_image(pass, texel, 0, 1, below);
+	average(color, cur, below);
+}
+
+/* ------------------------------------------------------------------------- */
+/* obs-filters                                                               */
+
+/* the image, unpremultiplied and multiplied by the color parameter, as the
+ * blend and mask filters start */
+static void filter_image(const struct sw_pass *pass,
+			 const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u, frag->v, color);
+	unpremultiply(color);
+	mul4(color, pass->u.color);
+}
+
+static inline void sample_target(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->target, frag->u * pass->u.mul_val[0] + pass->u.add_val[0],
+	       frag->v * pass->u.mul_val[1] + pass->u.add_val[1], color);
+}
+
+static void filter_blend_add(const struct sw_pass *pass,
+			     const struct sw_fragment *frag, float *color)
+{
+	float target[4];
+
+	filter_image(pass, frag, color);
+	sample_target(pass, frag, target);
+	for (size_t i = 0; i < 3; i++)
+		color[i] = saturate(color[i] + target[i]);
+	premultiply(color);
+}
+
+static void filter_blend_mul(const struct sw_pass *pass,
+			     const struct sw_fragment *frag, float *color)
+{
+	float target[4];
+
+	filter_image(pass, frag, color);
+	sample_target(pass, frag, target);
+	for (size_t i = 0; i < 3; i++)
+		color[i] = saturate(color[i] * target[i]);
+	premultiply(color);
+}
+
+static void filter_blend_sub(const struct sw_pass *pass,
+			     const struct sw_fragment *frag, float *color)
+{
+	float target[4];
+
+	filter_image(pass, frag, color);
+	sample_target(pass, frag, target);
+	for (size_t i = 0; i < 3; i++)
+		color[i] = saturate(color[i] - target[i]);
+	premultiply(color);
+}
+
+static void filter_mask_alpha(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, float *color)
+{
+	float target[4];
+
+	filter_image(pass, frag, color);
+	sample_target(pass, frag, target);
+	color[3] *= target[3];
+	premultiply(color);
+}
+
+static void filter_mask_color(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, float *color)
+{
+	float target[4];
+
+	filter_image(pass, frag, color);
+	sample_target(pass, frag, target);
+	color[3] *= (target[0] + target[1] + target[2]) / 3.0f;
+	premultiply(color);
+}
+
+static void filter_crop(const struct sw_pass *pass,
+			const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u * pass->u.mul_val[0] + pass->u.add_val[0],
+	       frag->v * pass->u.mul_val[1] + pass->u.add_val[1], color);
+}
+
+static inline void calc_color(const struct sw_pass *pass, float *color)
+{
+	for (size_t i = 0; i < 3; i++)
+		color[i] = powf(color[i], pass->u.gamma) * pass->u.contrast +
+			   pass->u.brightness;
+}
+
+static inline void nonlinear(float *rgb)
+{
+	gs_float3_srgb_linear_to_nonlinear(rgb);
+}
+
+/* mul(float4(rgb, 1.0), yuv_mat).yz, the matrix rows are the planes */
+static float chroma_dist(const struct sw_pass *pass, const float *rgb,
+			 bool v2)
+{
+	const float *cb_vec = v2 ? pass->u.cb_v4 : pass->u.yuv_mat + 4;
+	const float *cr_vec = v2 ? pass->u.cr_v4 : pass->u.yuv_mat + 8;
+
+	return distance2(pass->u.chroma_key, to_plane(cb_vec, rgb),
+			 to_plane(cr_vec, rgb));
+}
+
+static float box_filtered_chroma_dist(const struct sw_pass *pass,
+				      const struct sw_fragment *frag,
+				      const float *rgb, bool v2)
+{
+	const float *pixel_size = pass->u.pixel_size;
+	const float offsets[4][2] = {
+		{-pixel_size[0], -pixel_size[1] / 2.0f},
+		{pixel_size[0], pixel_size[1] / 2.0f},
+		{-pixel_size[0] / 2.0f, pixel_size[1]},
+		{pixel_size[0] / 2.0f, -pixel_size[1]},
+	};
+	float center[3] = {rgb[0], rgb[1], rgb[2]};
+	float dist = 0.0f;
+
+	for (size_t i = 0; i < 4; i++) {
+		float texel[4];
+
+		sample(&pass->image, frag->u + offsets[i][0],
+		       frag->v + offsets[i][1], texel);
+		if (v2)
+			nonlinear(texel);
+		dist += chroma_dist(pass, texel, v2);
+	}
+
+	if (v2)
+		nonlinear(center);
+
+	dist *= 2.0f;
+	dist += chroma_dist(pass, center, v2);
+	return dist / 9.0f;
+}
+
+static void filter_chroma_key(const struct sw_pass *pass,
+			      const struct sw_fragment *frag, float *color)
+{
+	float base_mask, full_mask, spill_val, desat;
+
+	sample(&pass->image, frag->u, frag->v, color);
+	unpremultiply(color);
+
+	base_mask = box_filtered_chroma_dist(pass, frag, color, false) -
+		    pass->u.similarity;
+	full_mask = powf(saturate(base_mask / pass->u.smoothness), 1.5f);
+	spill_val = powf(saturate(base_mask / pass->u.spill), 1.5f);
+
+	mul4(color, pass->u.color);
+	color[3] *= full_mask;
+
+	desat = saturate(color[0] * 0.2126f + color[1] * 0.7152f +
+			 color[2] * 0.0722f);
+	for (size_t i = 0; i < 3; i++)
+		color[i] = desat * (1.0f - spill_val) + color[i] * spill_val;
+
+	calc_color(pass, color);
+}
+
+static void filter_chroma_key_v2(const struct sw_pass *pass,
+				 const struct sw_fragment *frag, float *color)
+{
+	static const float luma[3] = {0.2126f, 0.7152f, 0.0722f};
+	float base_mask, full_mask, spill_val, desat;
+
+	sample(&pass->image, frag->u, frag->v, color);
+	unpremultiply(color);
+
+	base_mask = box_filtered_chroma_dist(pass, frag, color, true) -
+		    pass->u.similarity;
+	full_mask = powf(saturate(base_mask / pass->u.smoothness), 1.5f);
+	spill_val = powf(saturate(base_mask / pass->u.spill), 1.5f);
+
+	color[3] *= pass->u.opacity;
+	color[3] *= full_mask;
+
+	desat = dot3(color, luma);
+	for (size_t i = 0; i < 3; i++)
+		color[i] = lerp(desat, color[i], spill_val);
+
+	calc_color(pass, color);
+	premultiply(color);
+}
+
+static void filter_color_key(const struct sw_pass *pass,
+			     const struct sw_fragment *frag, float *color)
+{
+	const float *key = pass->u.key_color;
+	float dist;
+
+	sample(&pass->image, frag->u, frag->v, color);
+	unpremultiply(color);
+	mul4(color, pass->u.color);
+
+	dist = sqrtf((key[0] - color[0]) * (key[0] - color[0]) +
+		     (key[1] - color[1]) * (key[1] - color[1]) +
+		     (key[2] - color[2]) * (key[2] - color[2]));
+	color[3] *= saturate(fmaxf(dist - pass->u.similarity, 0.0f) /
+			     pass->u.smoothness);
+
+	calc_color(pass, color);
+}
+
+static void filter_color_key_v2(const struct sw_pass *pass,
+				const struct sw_fragment *frag, float *color)
+{
+	const float *key = pass->u.key_color;
+	float rgb[3];
+	float dist;
+
+	sample(&pass->image, frag->u, frag->v, color);
+	unpremultiply(color);
+	color[3] *= pass->u.opacity;
+
+	memcpy(rgb, color, sizeof(rgb));
+	nonlinear(rgb);
+	dist = sqrtf((key[0] - rgb[0]) * (key[0] - rgb[0]) +
+		     (key[1] - rgb[1]) * (key[1] - rgb[1]) +
+		     (key[2] - rgb[2]) * (key[2] - rgb[2]));
+	color[3] *= saturate(fmaxf(dist - pass->u.similarity, 0.0f) /
+			     pass->u.smoothness);
+
+	calc_color(pass, color);
+	premultiply(color);
+}
+
+static float luma_mask(const struct sw_pass *pass, float luminance)
+{
+	float clo = smoothstep(pass->u.lumaMin,
+			       pass->u.lumaMin + pass->u.lumaMinSmooth,
+			       luminance);
+	float chi = 1.0f - smoothstep(pass->u.lumaMax - pass->u.lumaMaxSmooth,
+				      pass->u.lumaMax, luminance);
+	return clo * chi;
+}
+
+static void filter_luma_key(const struct sw_pass *pass,
+			    const struct sw_fragment *frag, float *color)
+{
+	static const float luma[3] = {0.2989f, 0.5870f, 0.1140f};
+
+	sample(&pass->image, frag->u, frag->v, color);
+	unpremultiply(color);
+	color[3] = luma_mask(pass, dot3(color, luma));
+}
+
+static void filter_luma_key_v2(const struct sw_pass *pass,
+			       const struct sw_fragment *frag, float *color)
+{
+	static const float luma[3] = {0.2126f, 0.7152f, 0.0722f};
+
+	sample(&pass->image, frag->u, frag->v, color);
+	unpremultiply(color);
+	color[3] *= luma_mask(pass, dot3(color, luma));
+	premultiply(color);
+}
+
+/* mul(color_matrix, pixel) */
+static void filter_color_correction(const struct sw_pass *pass,
+				    const struct sw_fragment *frag,
+				    float *color)
+{
+	const float *mat = pass->u.color_matrix;
+	float pixel[4];
+
+	sample(&pass->image, frag->u, frag->v, pixel);
+	unpremultiply(pixel);
+	for (size_t i = 0; i < 3; i++)
+		pixel[i] = powf(pixel[i], pass->u.gamma);
+
+	for (size_t i = 0; i < 4; i++)
+		color[i] = mat[i] * pixel[0] + mat[4 + i] * pixel[1] +
+			   mat[8 + i] * pixel[2] + mat[12 + i] * pixel[3];
+
+	premultiply(color);
+}
+
+static void filter_sharpness(const struct sw_pass *pass,
+			     const struct sw_fragment *frag, float *color)
+{
+	const float dx = 1.0f / pass->u.texture_width;
+	const float dy = 1.0f / pass->u.texture_height;
+	float texels[3][3][4];
+	float sum[4];
+
+	for (int y = 0; y < 3; y++) {
+		for (int x = 0; x < 3; x++)
+			sample(&pass->image, frag->u + (float)(x - 1) * dx,
+			       frag->v + (float)(y - 1) * dy, texels[y][x]);
+	}
+
+	for (size_t i = 0; i < 4; i++) {
+		float e = texels[1][1][i];
+		float b = texels[0][1][i];
+		float d = texels[1][0][i];
+		float f = texels[1][2][i];
+		float h = texels[2][1][i];
+
+		sum[i] = 9.0f * e;
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 3; x++)
+				sum[i] -= texels[y][x][i];
+		}
+
+		if ((e != f && e != d) || (e != b && e != h))
+			color[i] = saturate(e + sum[i] * pass->u.sharpness);
+		else
+			color[i] = e;
+	}
+}
+
+static void lut_begin(const struct sw_pass *pass,
+		      const struct sw_fragment *frag, float *color)
+{
+	sample(&pass->image, frag->u, frag->v, color);
+	unpremultiply(color);
+	gs_float3_srgb_linear_to_nonlinear(color);
+}
+
+static inline bool in_domain(const struct sw_pass *pass, const float *color,
+			     size_t i)
+{
+	return color[i] >= pass->u.domain_min[i] &&
+	       color[i] <= pass->u.domain_max[i];
+}
+
+static void filter_lut_1d(const struct sw_pass *pass,
+			  const struct sw_fragment *frag, float *color)
+{
+	lut_begin(pass, frag, color);
+
+	for (size_t i = 0; i < 3; i++) {
+		float u, texel[4];
+
+		if (!in_domain(pass, color, i))
+			continue;
+
+		u = color[i] * pass->u.clut_scale[i] + pass->u.clut_offset[i];
+		sample(&pass->clut_1d, u, 0.5f, texel);
+		color[i] = lerp(color[i], texel[i], pass->u.clut_amount);
+	}
+
+	gs_float3_srgb_nonlinear_to_linear(color);
+}
+
+static inline void sample_clut_3d(const struct sw_pass *pass, const float *uvw,
+				  float *color)
+{
+	const struct sw_texref *ref = &pass->clut_3d;
+
+	if (ref->tex)
+		sw_sample_volume(ref->tex, &ref->sampler, ref->srgb, uvw[0],
+				 uvw[1], uvw[2], color);
+	else
+		set4(color, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+/* tetrahedral interpolation, the two taps of each edge are collapsed into
+ * one filtered sample */
+static void filter_lut_3d(const struct sw_pass *pass,
+			  const struct sw_fragment *frag, float *color)
+{
+	float frac_rgb[3], uvw0[3], uvw1[3], uvw2[3], uvw3[3];
+	float uvw01[3], uvw23[3];
+	float sample01[4], sample23[4];
+	float frac_l, frac_m, frac_s;
+	float coeff01, coeff23, weight01, weight23;
+	int l, m;
+
+	lut_begin(pass, frag, color);
+
+	if (!in_domain(pass, color, 0) || !in_domain(pass, color, 1) ||
+	    !in_domain(pass, color, 2)) {
+		gs_float3_srgb_nonlinear_to_linear(color);
+		premultiply(color);
+		return;
+	}
+
+	for (size_t i = 0; i < 3; i++) {
+		float pos = color[i] * pass->u.clut_scale[i] +
+			    pass->u.clut_offset[i];
+		float floor_pos = floorf(pos);
+
+		frac_rgb[i] = pos - floor_pos;
+		uvw0[i] = (floor_pos + 0.5f) * pass->u.cube_width_i;
+		uvw3[i] = (floor_pos + 1.5f) * pass->u.cube_width_i;
+	}
+
+	/* l is the channel with the largest fraction, m the middle one */
+	if (frac_rgb[0] < frac_rgb[1]) {
+		if (frac_rgb[0] < frac_rgb[2]) {
+			if (frac_rgb[1] < frac_rgb[2]) {
+				l = 2;
+				m = 1;
+			} else {
+				l = 1;
+				m = 2;
+			}
+		} else {
+			l = 1;
+			m = 0;
+		}
+	} else if (frac_rgb[0] < frac_rgb[2]) {
+		l = 2;
+		m = 0;
+	} else if (frac_rgb[1] < frac_rgb[2]) {
+		l = 0;
+		m = 2;
+	} else {
+		l = 0;
+		m = 1;
+	}
+
+	frac_l = frac_rgb[l];
+	frac_m = frac_rgb[m];
+	frac_s = frac_rgb[3 - l - m];
+
+	memcpy(uvw1, uvw0, sizeof(uvw1));
+	uvw1[l] = uvw3[l];
+	memcpy(uvw2, uvw1, sizeof(uvw2));
+	uvw2[m] = uvw3[m];
+
+	/* max kills a potential zero divide NaN */
+	coeff01 = 1.0f - frac_m;
+	weight01 = fmaxf((frac_l - frac_m) / coeff01, 0.0f);
+	coeff23 = frac_m;
+	weight23 = fmaxf(frac_s / coeff23, 0.0f);
+
+	for (size_t i = 0; i < 3; i++) {
+		uvw01[i] = lerp(uvw0[i], uvw1[i], weight01);
+		uvw23[i] = lerp(uvw2[i], uvw3[i], weight23);
+	}
+
+	sample_clut_3d(pass, uvw01, sample01);
+	sample_clut_3d(pass, uvw23, sample23);
+
+	for (size_t i = 0; i < 3; i++) {
+		float lutted = coeff01 * sample01[i] + coeff23 * sample23[i];
+		color[i] = lerp(color[i], lutted, pass->u.clut_amount);
+	}
+
+	gs_float3_srgb_nonlinear_to_linear(color);
+	premultiply(color);
+}
+
+/* ------------------------------------------------------------------------- */
+/* lookup                                                                    */
+
+static const struct native_shader {
+	const char *file;
+	const char *technique;
+	sw_pixel_shader_t shader;
+} native_shaders[] = {
+	{"default.effect", "Draw", draw_bare},
+	{"default.effect", "DrawAlphaDivide", draw_alpha_divide},
+	{"default.effect", "DrawNonlinearAlpha", draw_nonlinear_alpha},
+	{"default.effect", "DrawSrgbDecompress", draw_srgb_decompress},
+	{"default_rect.effect", "Draw", draw_bare},
+	{"default_rect.effect", "DrawOpaque", draw_opaque},
+	{"default_rect.effect", "DrawSrgbDecompress", draw_srgb_decompress},
+	{"opaque.effect", "Draw", draw_opaque},
+	{"repeat.effect", "Draw", draw_repeat},
+	{"premultiplied_alpha.effect", "Draw", draw_premultiplied},
+	{"solid.effect", "Solid", draw_solid},
+	{"solid.effect", "SolidColored", draw_solid_colored},
+	{"solid.effect", "Random", draw_random},
+
+	{"bicubic_scale.effect", "Draw", draw_bicubic},
+	{"bicubic_scale.effect", "DrawAlphaDivide", draw_bicubic_alpha_divide},
+	{"bicubic_scale.effect", "DrawUndistort", draw_bicubic_undistort},
+	{"lanczos_scale.effect", "Draw", draw_lanczos},
+	{"lanczos_scale.effect", "DrawAlphaDivide", draw_lanczos_alpha_divide},
+	{"lanczos_scale.effect", "DrawUndistort", draw_lanczos_undistort},
+	{"area.effect", "Draw", draw_area},
+	{"area.effect", "DrawAlphaDivide", draw_area_alpha_divide},
+	{"area.effect", "DrawUpscale", draw_area_upscale},
+	{"bilinear_lowres_scale.effect", "Draw", draw_lowres_bilinear},
+	{"bilinear_lowres_scale.effect", "DrawAlphaDivide",
+	 draw_lowres_bilinear_alpha_divide},
+
+	{"format_conversion.effect", "Planar_Y", convert_y},
+	{"format_conversion.effect", "Planar_U", convert_u},
+	{"format_conversion.effect", "Planar_V", convert_v},
+	{"format_conversion.effect", "Planar_U_Left", convert_u_wide},
+	{"format_conversion.effect", "Planar_V_Left", convert_v_wide},
+	{"format_conversion.effect", "NV12_Y", convert_y},
+	{"format_conversion.effect", "NV12_UV", convert_uv_wide},
+	{"format_conversion.effect", "UYVY_Reverse", convert_uyvy_reverse},
+	{"format_conversion.effect", "YUY2_Reverse", convert_yuy2_reverse},
+	{"format_conversion.effect", "YVYU_Reverse", convert_yvyu_reverse},
+	{"format_conversion.effect", "I420_Reverse", convert_i420_reverse},
+	{"format_conversion.effect", "I40A_Reverse", convert_i40a_reverse},
+	{"format_conversion.effect", "I422_Reverse", convert_i422_reverse},
+	{"format_conversion.effect", "I42A_Reverse", convert_i42a_reverse},
+	{"format_conversion.effect", "I444_Reverse", convert_i444_reverse},
+	{"format_conversion.effect", "YUVA_Reverse", convert_yuva_reverse},
+	{"format_conversion.effect", "AYUV_Reverse", convert_ayuv_reverse},
+	{"format_conversion.effect", "NV12_Reverse", convert_nv12_reverse},
+	{"format_conversion.effect", "Y800_Limited", convert_y800_limited},
+	{"format_conversion.effect", "Y800_Full", convert_y800_full},
+	{"format_conversion.effect", "RGB_Limited", convert_rgb_limited},
+	{"format_conversion.effect", "BGR3_Limited", convert_bgr3_limited},
+	{"format_conversion.effect", "BGR3_Full", convert_bgr3_full},
+
+	{"deinterlace_blend.effect", "Draw", draw_blend},
+	{"deinterlace_blend_2x.effect", "Draw", draw_blend_2x},
+	{"deinterlace_discard.effect", "Draw", draw_discard},
+	{"deinterlace_discard_2x.effect", "Draw", draw_discard_2x},
+	{"deinterlace_linear.effect", "Draw", draw_linear},
+	{"deinterlace_linear_2x.effect", "Draw", draw_linear_2x},
+	{"deinterlace_yadif.effect", "Draw", draw_yadif},
+	{"deinterlace_yadif_2x.effect", "Draw", draw_yadif_2x},
+
+	{"blend_add_filter.effect", "Draw", filter_blend_add},
+	{"blend_mul_filter.effect", "Draw", filter_blend_mul},
+	{"blend_sub_filter.effect", "Draw", filter_blend_sub},
+	{"mask_alpha_filter.effect", "Draw", filter_mask_alpha},
+	{"mask_color_filter.effect", "Draw", filter_mask_color},
+	{"crop_filter.effect", "Draw", filter_crop},
+	{"chroma_key_filter.effect", "Draw", filter_chroma_key},
+	{"chroma_key_filter_v2.effect", "Draw", filter_chroma_key_v2},
+	{"color_key_filter.effect", "Draw", filter_color_key},
+	{"color_key_filter_v2.effect", "Draw", filter_color_key_v2},
+	{"luma_key_filter.effect", "Draw", filter_luma_key},
+	{"luma_key_filter_v2.effect", "Draw", filter_luma_key_v2},
+	{"color_correction_filter.effect", "Draw", filter_color_correction},
+	{"color_grade_filter.effect", "Draw1D", filter_lut_1d},
+	{"color_grade_filter.effect", "Draw3D", filter_lut_3d},
+	{"sharpness.effect", "Draw", filter_sharpness},
+};
+
+#define TECHNIQUE_PREFIX " (Pixel shader, technique "
+
+/* the effect parser names a pass's pixel shader
+ * "<effect path> (Pixel shader, technique <name>, pass <index>)" */
+sw_pixel_shader_t sw_find_pixel_shader(const char *file)
+{
+	const char *technique;
+	const char *technique_end;
+	const char *name;
+	size_t name_len, technique_len;
+
+	if (!file)
+		return NULL;
+
+	technique = strstr(file, TECHNIQUE_PREFIX);
+	if (!technique)
+		return NULL;
+
+	name = file;
+	for (const char *ch = file; ch < technique; ch++) {
+		if (*ch == '/' || *ch == '\\')
+			name = ch + 1;
+	}
+	name_len = technique - name;
+
+	technique += sizeof(TECHNIQUE_PREFIX) - 1;
+	technique_end = strchr(technique, ',');
+	if (!technique_end)
+		return NULL;
+	technique_len = technique_end - technique;
+
+	for (size_t i = 0; i < sizeof(native_shaders) / sizeof(*native_shaders);
+	     i++) {
+		const struct native_shader *native = native_shaders + i;
+
+		if (strlen(native->file) == name_len &&
+		    strncmp(native->file, name, name_len) == 0 &&
+		    strlen(native->technique) == technique_len &&
+		    strncmp(native->technique, technique, technique_len) == 0)
+			return native->shader;
+	}
+
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* parameters                                                                */
+
+#define UNIFORM(name)                                      \
+	{                                                  \
+		#name, offsetof(struct sw_uniforms, name), \
+			sizeof(((struct sw_uniforms *)0)->name) \
+	}
+
+static const struct uniform_info {
+	const char *name;
+	size_t offset;
+	size_t size;
+} uniforms[] = {
+	UNIFORM(color),
+	UNIFORM(width),
+	UNIFORM(height),
+	UNIFORM(width_i),
+	UNIFORM(width_d2),
+	UNIFORM(height_d2),
+	UNIFORM(color_vec0),
+	UNIFORM(color_vec1),
+	UNIFORM(color_vec2),
+	UNIFORM(color_range_min),
+	UNIFORM(color_range_max),
+	UNIFORM(base_dimension),
+	UNIFORM(base_dimension_i),
+	UNIFORM(undistort_factor),
+	UNIFORM(scale),
+	UNIFORM(randomvals1),
+	UNIFORM(randomvals2),
+	UNIFORM(randomvals3),
+	UNIFORM(dimensions),
+	UNIFORM(field_order),
+	UNIFORM(frame2),
+	UNIFORM(mul_val),
+	UNIFORM(add_val),
+	UNIFORM(opacity),
+	UNIFORM(contrast),
+	UNIFORM(brightness),
+	UNIFORM(gamma),
+	UNIFORM(yuv_mat),
+	UNIFORM(cb_v4),
+	UNIFORM(cr_v4),
+	UNIFORM(chroma_key),
+	UNIFORM(pixel_size),
+	UNIFORM(key_color),
+	UNIFORM(similarity),
+	UNIFORM(smoothness),
+	UNIFORM(spill),
+	UNIFORM(color_matrix),
+	UNIFORM(lumaMax),
+	UNIFORM(lumaMin),
+	UNIFORM(lumaMaxSmooth),
+	UNIFORM(lumaMinSmooth),
+	UNIFORM(sharpness),
+	UNIFORM(texture_width),
+	UNIFORM(texture_height),
+	UNIFORM(clut_amount),
+	UNIFORM(cube_width_i),
+	UNIFORM(clut_scale),
+	UNIFORM(clut_offset),
+	UNIFORM(domain_min),
+	UNIFORM(domain_max),
+};
+
+#undef UNIFORM
+
+static struct sw_texref *get_texref(struct sw_pass *pass, const char *name)
+{
+	if (strcmp(name, "image") == 0)
+		return &pass->image;
+	if (strcmp(name, "image1") == 0)
+		return &pass->image1;
+	if (strcmp(name, "image2") == 0)
+		return &pass->image2;
+	if (strcmp(name, "image3") == 0)
+		return &pass->image3;
+	if (strcmp(name, "target") == 0)
+		return &pass->target;
+	if (strcmp(name, "previous_image") == 0)
+		return &pass->previous_image;
+	if (strcmp(name, "clut_1d") == 0)
+		return &pass->clut_1d;
+	if (strcmp(name, "clut_3d") == 0)
+		return &pass->clut_3d;
+	return NULL;
+}
+
+static void load_uniform(struct sw_pass *pass,
+			 const struct gs_shader_param *param)
+{
+	for (size_t i = 0; i < sizeof(uniforms) / sizeof(*uniforms); i++) {
+		const struct uniform_info *info = uniforms + i;
+		size_t size = param->cur_value.num;
+
+		if (strcmp(info->name, param->name) != 0)
+			continue;
+
+		if (size > info->size)
+			size = info->size;
+		memcpy((uint8_t *)&pass->u + info->offset,
+		       param->cur_value.array, size);
+		return;
+	}
+}
+
+/* the stock effects have at most one sampler state, which every texture of
+ * the pass is sampled with */
+static void load_params(struct sw_pass *pass, const struct gs_shader *shader,
+			const struct gs_sampler_info *sampler)
+{
+	for (size_t i = 0; i < shader->params.num; i++) {
+		const struct gs_shader_param *param = shader->params.array + i;
+		struct sw_texref *ref;
+
+		if (param->type != GS_SHADER_PARAM_TEXTURE) {
+			load_uniform(pass, param);
+			continue;
+		}
+
+		ref = get_texref(pass, param->name);
+		if (!ref)
+			continue;
+
+		ref->tex = param->texture;
+		ref->srgb = param->srgb;
+		ref->sampler = param->next_sampler ? param->next_sampler->info
+						   : *sampler;
+	}
+}
+
+void sw_pass_init(struct sw_pass *pass, gs_device_t *device)
+{
+	const struct gs_shader *vs = device->cur_vertex_shader;
+	const struct gs_shader *ps = device->cur_pixel_shader;
+	const struct gs_sampler_info *sampler = &device->default_sampler->info;
+
+	if (ps->samplers.num)
+		sampler = &ps->samplers.array[0]->info;
+
+	memset(pass, 0, sizeof(*pass));
+	load_params(pass, vs, sampler);
+	load_params(pass, ps, sampler);
+}
@@ -0,0 +1,297 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <assert.h>
+
+#include <graphics/vec2.h>
+#include <graphics/vec3.h>
+#include <graphics/vec4.h>
+#include <graphics/matrix3.h>
+#include <graphics/shader-parser.h>
+#include "sw-subsystem.h"
+
+static inline void shader_param_free(struct gs_shader_param *param)
+{
+	bfree(param->name);
+	da_free(param->cur_value);
+	da_free(param->def_value);
+}
+
+static void sw_add_param(struct gs_shader *shader, struct shader_var *var)
+{
+	struct gs_shader_param param = {0};
+
+	param.array_count = var->array_count;
+	param.name = bstrdup(var->name);
+	param.shader = shader;
+	param.type = get_shader_param_type(var->type);
+
+	da_move(param.def_value, var->default_val);
+	da_copy(param.cur_value, param.def_value);
+
+	da_push_back(shader->params, &param);
+}
+
+static void sw_shader_init(struct gs_shader *shader, struct shader_parser *sp)
+{
+	for (size_t i = 0; i < sp->params.num; i++)
+		sw_add_param(shader, sp->params.array + i);
+
+	for (size_t i = 0; i < sp->samplers.num; i++) {
+		struct gs_sampler_info info;
+		gs_samplerstate_t *sampler;
+
+		shader_sampler_convert(sp->samplers.array + i, &info);
+		sampler = device_samplerstate_create(shader->device, &info);
+		da_push_back(shader->samplers, &sampler);
+	}
+
+	shader->viewproj = gs_shader_get_param_by_name(shader, "ViewProj");
+	shader->world = gs_shader_get_param_by_name(shader, "World");
+}
+
+static struct gs_shader *shader_create(gs_device_t *device,
+				       enum gs_shader_type type,
+				       const char *shader_str, const char *file,
+				       char **error_string)
+{
+	struct gs_shader *shader = NULL;
+	struct shader_parser sp;
+
+	shader_parser_init(&sp);
+
+	if (shader_parse(&sp, shader_str, file)) {
+		shader = bzalloc(sizeof(struct gs_shader));
+		shader->device = device;
+		shader->type = type;
+		shader->file = bstrdup(file);
+		sw_shader_init(shader, &sp);
+	} else if (error_string) {
+		*error_string = shader_parser_geterrors(&sp);
+	}
+
+	shader_parser_free(&sp);
+	return shader;
+}
+
+gs_shader_t *device_vertexshader_create(gs_device_t *device, const char *shader,
+					const char *file, char **error_string)
+{
+	struct gs_shader *ptr;
+	ptr = shader_create(device, GS_SHADER_VERTEX, shader, file,
+			    error_string);
+	if (!ptr)
+		blog(LOG_ERROR, "device_vertexshader_create (software) failed");
+	return ptr;
+}
+
+gs_shader_t *device_pixelshader_create(gs_device_t *device, const char *shader,
+				       const char *file, char **error_string)
+{
+	struct gs_shader *ptr;
+	ptr = shader_create(device, GS_SHADER_PIXEL, shader, file,
+			    error_string);
+	if (!ptr) {
+		blog(LOG_ERROR, "device_pixelshader_create (software) failed");
+		return NULL;
+	}
+
+	ptr->native = sw_find_pixel_shader(file);
+	if (!ptr->native)
+		blog(LOG_WARNING,
+		     "device_pixelshader_create (software): No native "
+		     "implementation of '%s', draws with it will fail",
+		     file ? file : "(unnamed)");
+	return ptr;
+}
+
+void gs_shader_destroy(gs_shader_t *shader)
+{
+	if (!shader)
+		return;
+
+	if (shader->device->cur_vertex_shader == shader)
+		shader->device->cur_vertex_shader = NULL;
+	if (shader->device->cur_pixel_shader == shader)
+		shader->device->cur_pixel_shader = NULL;
+
+	for (size_t i = 0; i < shader->samplers.num; i++)
+		gs_samplerstate_destroy(shader->samplers.array[i]);
+
+	for (size_t i = 0; i < shader->params.num; i++)
+		shader_param_free(shader->params.array + i);
+
+	da_free(shader->samplers);
+	da_free(shader->params);
+	bfree(shader->file);
+	bfree(shader);
+}
+
+int gs_shader_get_num_params(const gs_shader_t *shader)
+{
+	return (int)shader->params.num;
+}
+
+gs_sparam_t *gs_shader_get_param_by_idx(gs_shader_t *shader, uint32_t param)
+{
+	assert(param < shader->params.num);
+	return shader->params.array + param;
+}
+
+gs_sparam_t *gs_shader_get_param_by_name(gs_shader_t *shader, const char *name)
+{
+	for (size_t i = 0; i < shader->params.num; i++) {
+		struct gs_shader_param *param = shader->params.array + i;
+
+		if (strcmp(param->name, name) == 0)
+			return param;
+	}
+
+	return NULL;
+}
+
+gs_sparam_t *gs_shader_get_viewproj_matrix(const gs_shader_t *shader)
+{
+	return shader->viewproj;
+}
+
+gs_sparam_t *gs_shader_get_world_matrix(const gs_shader_t *shader)
+{
+	return shader->world;
+}
+
+void gs_shader_get_param_info(const gs_sparam_t *param,
+			      struct gs_shader_param_info *info)
+{
+	info->type = param->type;
+	info->name = param->name;
+}
+
+void gs_shader_set_bool(gs_sparam_t *param, bool val)
+{
+	int int_val = val;
+	da_copy_array(param->cur_value, &int_val, sizeof(int_val));
+}
+
+void gs_shader_set_float(gs_sparam_t *param, float val)
+{
+	da_copy_array(param->cur_value, &val, sizeof(val));
+}
+
+void gs_shader_set_int(gs_sparam_t *param, int val)
+{
+	da_copy_array(param->cur_value, &val, sizeof(val));
+}
+
+void gs_shader_set_matrix3(gs_sparam_t *param, const struct matrix3 *val)
+{
+	struct matrix4 mat;
+	matrix4_from_matrix3(&mat, val);
+
+	da_copy_array(param->cur_value, &mat, sizeof(mat));
+}
+
+void gs_shader_set_matrix4(gs_sparam_t *param, const struct matrix4 *val)
+{
+	da_copy_array(param->cur_value, val, sizeof(*val));
+}
+
+void gs_shader_set_vec2(gs_sparam_t *param, const struct vec2 *val)
+{
+	da_copy_array(param->cur_value, val->ptr, sizeof(*val));
+}
+
+void gs_shader_set_vec3(gs_sparam_t *param, const struct vec3 *val)
+{
+	da_copy_array(param->cur_value, val->ptr, sizeof(*val));
+}
+
+void gs_shader_set_vec4(gs_sparam_t *param, const struct vec4 *val)
+{
+	da_copy_array(param->cur_value, val->ptr, sizeof(*val));
+}
+
+void gs_shader_set_texture(gs_sparam_t *param, gs_texture_t *val)
+{
+	param->texture = val;
+}
+
+static size_t get_param_size(enum gs_shader_param_type type)
+{
+	switch ((uint32_t)type) {
+	case GS_SHADER_PARAM_FLOAT:
+		return sizeof(float);
+	case GS_SHADER_PARAM_BOOL:
+	case GS_SHADER_PARAM_INT:
+		return sizeof(int);
+	case GS_SHADER_PARAM_INT2:
+		return sizeof(int) * 2;
+	case GS_SHADER_PARAM_INT3:
+		return sizeof(int) * 3;
+	case GS_SHADER_PARAM_INT4:
+		return sizeof(int) * 4;
+	case GS_SHADER_PARAM_VEC2:
+		return sizeof(float) * 2;
+	case GS_SHADER_PARAM_VEC3:
+		return sizeof(float) * 3;
+	case GS_SHADER_PARAM_VEC4:
+		return sizeof(float) * 4;
+	case GS_SHADER_PARAM_MATRIX4X4:
+		return sizeof(float) * 4 * 4;
+	case GS_SHADER_PARAM_TEXTURE:
+		return sizeof(struct gs_shader_texture);
+	}
+
+	return 0;
+}
+
+void gs_shader_set_val(gs_sparam_t *param, const void *val, size_t size)
+{
+	int count = param->array_count;
+	size_t expected_size;
+	if (!count)
+		count = 1;
+
+	expected_size = get_param_size(param->type) * count;
+	if (!expected_size)
+		return;
+
+	if (expected_size != size) {
+		blog(LOG_ERROR, "gs_shader_set_val (software): Size of shader "
+				"param does not match the size of the input");
+		return;
+	}
+
+	if (param->type == GS_SHADER_PARAM_TEXTURE) {
+		struct gs_shader_texture shader_tex;
+		memcpy(&shader_tex, val, sizeof(shader_tex));
+		gs_shader_set_texture(param, shader_tex.tex);
+		param->srgb = shader_tex.srgb;
+	} else {
+		da_copy_array(param->cur_value, val, size);
+	}
+}
+
+void gs_shader_set_default(gs_sparam_t *param)
+{
+	gs_shader_set_val(param, param->def_value.array, param->def_value.num);
+}
+
+void gs_shader_set_next_sampler(gs_sparam_t *param, gs_samplerstate_t *sampler)
+{
+	param->next_sampler = sampler;
+}
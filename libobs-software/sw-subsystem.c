@@ -0,0 +1,611 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <util/platform.h>
+#include "sw-subsystem.h"
+
+const char *device_get_name(void)
+{
+	return "Software";
+}
+
+int device_get_type(void)
+{
+	return GS_DEVICE_SOFTWARE;
+}
+
+const char *device_preprocessor_name(void)
+{
+	return "_SOFTWARE";
+}
+
+int device_create(gs_device_t **p_device, uint32_t adapter)
+{
+	struct gs_device *device = bzalloc(sizeof(struct gs_device));
+	struct gs_sampler_info info = {0};
+
+	UNUSED_PARAMETER(adapter);
+
+	blog(LOG_INFO, "---------------------------------");
+	blog(LOG_INFO, "Initializing software renderer...");
+
+	info.filter = GS_FILTER_POINT;
+	info.address_u = GS_ADDRESS_CLAMP;
+	info.address_v = GS_ADDRESS_CLAMP;
+	info.address_w = GS_ADDRESS_CLAMP;
+	info.max_anisotropy = 1;
+	device->default_sampler = device_samplerstate_create(device, &info);
+
+	device->cur_cull_mode = GS_NEITHER;
+	device->blend_enabled = true;
+	device->blend_src_c = GS_BLEND_SRCALPHA;
+	device->blend_dest_c = GS_BLEND_INVSRCALPHA;
+	device->blend_src_a = GS_BLEND_ONE;
+	device->blend_dest_a = GS_BLEND_INVSRCALPHA;
+	for (size_t i = 0; i < 4; i++)
+		device->write_mask[i] = true;
+
+	matrix4_identity(&device->cur_proj);
+	matrix4_identity(&device->cur_view);
+	matrix4_identity(&device->cur_viewproj);
+
+	*p_device = device;
+	return GS_SUCCESS;
+}
+
+void device_destroy(gs_device_t *device)
+{
+	if (device) {
+		bfree(device->default_sampler);
+		da_free(device->proj_stack);
+		bfree(device);
+	}
+}
+
+void device_enter_context(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_leave_context(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void *device_get_device_obj(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* swap chains                                                               */
+
+/* a swap chain is only a back buffer that is never shown */
+gs_swapchain_t *device_swapchain_create(gs_device_t *device,
+					const struct gs_init_data *info)
+{
+	struct gs_swap_chain *swap = bzalloc(sizeof(struct gs_swap_chain));
+
+	swap->device = device;
+	swap->info = *info;
+	swap->target = sw_texture_create(device, GS_TEXTURE_2D, info->cx,
+					 info->cy, 1, info->format, 1,
+					 GS_RENDER_TARGET);
+	if (!swap->target) {
+		blog(LOG_ERROR, "device_swapchain_create (software) failed");
+		gs_swapchain_destroy(swap);
+		return NULL;
+	}
+
+	return swap;
+}
+
+void gs_swapchain_destroy(gs_swapchain_t *swapchain)
+{
+	if (!swapchain)
+		return;
+
+	if (swapchain->device->cur_swap == swapchain)
+		device_load_swapchain(swapchain->device, NULL);
+
+	gs_texture_destroy(swapchain->target);
+	bfree(swapchain);
+}
+
+void device_resize(gs_device_t *device, uint32_t cx, uint32_t cy)
+{
+	struct gs_swap_chain *swap = device->cur_swap;
+	struct gs_texture *target;
+
+	if (!swap) {
+		blog(LOG_WARNING, "device_resize (software): No active swap");
+		return;
+	}
+
+	target = sw_texture_create(device, GS_TEXTURE_2D, cx, cy, 1,
+				   swap->info.format, 1, GS_RENDER_TARGET);
+	if (!target) {
+		blog(LOG_ERROR, "device_resize (software) failed");
+		return;
+	}
+
+	gs_texture_destroy(swap->target);
+	swap->target = target;
+	swap->info.cx = cx;
+	swap->info.cy = cy;
+}
+
+void device_get_size(const gs_device_t *device, uint32_t *cx, uint32_t *cy)
+{
+	if (device->cur_swap) {
+		*cx = device->cur_swap->info.cx;
+		*cy = device->cur_swap->info.cy;
+	} else {
+		blog(LOG_ERROR, "device_get_size (software): No active swap");
+		*cx = 0;
+		*cy = 0;
+	}
+}
+
+uint32_t device_get_width(const gs_device_t *device)
+{
+	if (device->cur_swap) {
+		return device->cur_swap->info.cx;
+	} else {
+		blog(LOG_ERROR, "device_get_width (software): No active swap");
+		return 0;
+	}
+}
+
+uint32_t device_get_height(const gs_device_t *device)
+{
+	if (device->cur_swap) {
+		return device->cur_swap->info.cy;
+	} else {
+		blog(LOG_ERROR, "device_get_height (software): No active swap");
+		return 0;
+	}
+}
+
+void device_load_swapchain(gs_device_t *device, gs_swapchain_t *swap)
+{
+	device->cur_swap = swap;
+}
+
+/* ------------------------------------------------------------------------- */
+/* timers                                                                    */
+
+/* draws complete before they return, so CPU time is the GPU time */
+
+gs_timer_t *device_timer_create(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return bzalloc(sizeof(struct gs_timer));
+}
+
+gs_timer_range_t *device_timer_range_create(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return bzalloc(sizeof(struct gs_timer_range));
+}
+
+void gs_timer_destroy(gs_timer_t *timer)
+{
+	bfree(timer);
+}
+
+void gs_timer_begin(gs_timer_t *timer)
+{
+	timer->begin = os_gettime_ns();
+}
+
+void gs_timer_end(gs_timer_t *timer)
+{
+	timer->end = os_gettime_ns();
+}
+
+bool gs_timer_get_data(gs_timer_t *timer, uint64_t *ticks)
+{
+	*ticks = timer->end - timer->begin;
+	return true;
+}
+
+void gs_timer_range_destroy(gs_timer_range_t *range)
+{
+	bfree(range);
+}
+
+void gs_timer_range_begin(gs_timer_range_t *range)
+{
+	range->begin = os_gettime_ns();
+}
+
+void gs_timer_range_end(gs_timer_range_t *range)
+{
+	range->end = os_gettime_ns();
+}
+
+bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint,
+			     uint64_t *frequency)
+{
+	UNUSED_PARAMETER(range);
+
+	*disjoint = false;
+	*frequency = 1000000000;
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* state                                                                     */
+
+void device_load_texture(gs_device_t *device, gs_texture_t *tex, int unit)
+{
+	device->cur_textures[unit] = tex;
+}
+
+void device_load_texture_srgb(gs_device_t *device, gs_texture_t *tex, int unit)
+{
+	device->cur_textures[unit] = tex;
+}
+
+void device_load_samplerstate(gs_device_t *device, gs_samplerstate_t *ss,
+			      int unit)
+{
+	device->cur_samplers[unit] = ss;
+}
+
+void device_load_default_samplerstate(gs_device_t *device, bool b_3d, int unit)
+{
+	UNUSED_PARAMETER(b_3d);
+	device->cur_samplers[unit] = NULL;
+}
+
+void device_load_vertexshader(gs_device_t *device, gs_shader_t *vertshader)
+{
+	if (vertshader && vertshader->type != GS_SHADER_VERTEX) {
+		blog(LOG_ERROR, "device_load_vertexshader (software): "
+				"Specified shader is not a vertex shader");
+		return;
+	}
+
+	device->cur_vertex_shader = vertshader;
+}
+
+void device_load_pixelshader(gs_device_t *device, gs_shader_t *pixelshader)
+{
+	if (pixelshader && pixelshader->type != GS_SHADER_PIXEL) {
+		blog(LOG_ERROR, "device_load_pixelshader (software): "
+				"Specified shader is not a pixel shader");
+		return;
+	}
+
+	device->cur_pixel_shader = pixelshader;
+}
+
+gs_shader_t *device_get_vertex_shader(const gs_device_t *device)
+{
+	return device->cur_vertex_shader;
+}
+
+gs_shader_t *device_get_pixel_shader(const gs_device_t *device)
+{
+	return device->cur_pixel_shader;
+}
+
+gs_texture_t *device_get_render_target(const gs_device_t *device)
+{
+	return device->cur_render_target;
+}
+
+gs_zstencil_t *device_get_zstencil_target(const gs_device_t *device)
+{
+	return device->cur_zstencil_buffer;
+}
+
+void device_set_render_target(gs_device_t *device, gs_texture_t *tex,
+			      gs_zstencil_t *zstencil)
+{
+	if (tex && tex->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "device_set_render_target (software): "
+				"texture is not a 2D texture");
+		return;
+	}
+
+	device->cur_render_target = tex;
+	device->cur_render_side = 0;
+	device->cur_zstencil_buffer = zstencil;
+}
+
+void device_set_cube_render_target(gs_device_t *device, gs_texture_t *cubetex,
+				   int side, gs_zstencil_t *zstencil)
+{
+	if (cubetex && cubetex->type != GS_TEXTURE_CUBE) {
+		blog(LOG_ERROR, "device_set_cube_render_target (software): "
+				"texture is not a cube texture");
+		return;
+	}
+
+	device->cur_render_target = cubetex;
+	device->cur_render_side = side;
+	device->cur_zstencil_buffer = zstencil;
+}
+
+void device_enable_framebuffer_srgb(gs_device_t *device, bool enable)
+{
+	device->framebuffer_srgb = enable;
+}
+
+bool device_framebuffer_srgb_enabled(gs_device_t *device)
+{
+	return device->framebuffer_srgb;
+}
+
+void device_begin_frame(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_begin_scene(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_end_scene(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_present(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_flush(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_set_cull_mode(gs_device_t *device, enum gs_cull_mode mode)
+{
+	device->cur_cull_mode = mode;
+}
+
+enum gs_cull_mode device_get_cull_mode(const gs_device_t *device)
+{
+	return device->cur_cull_mode;
+}
+
+void device_enable_blending(gs_device_t *device, bool enable)
+{
+	device->blend_enabled = enable;
+}
+
+void device_enable_depth_test(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_stencil_test(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_stencil_write(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_color(gs_device_t *device, bool red, bool green, bool blue,
+			 bool alpha)
+{
+	device->write_mask[0] = red;
+	device->write_mask[1] = green;
+	device->write_mask[2] = blue;
+	device->write_mask[3] = alpha;
+}
+
+void device_blend_function(gs_device_t *device, enum gs_blend_type src,
+			   enum gs_blend_type dest)
+{
+	device_blend_function_separate(device, src, dest, src, dest);
+}
+
+void device_blend_function_separate(gs_device_t *device,
+				    enum gs_blend_type src_c,
+				    enum gs_blend_type dest_c,
+				    enum gs_blend_type src_a,
+				    enum gs_blend_type dest_a)
+{
+	device->blend_src_c = src_c;
+	device->blend_dest_c = dest_c;
+	device->blend_src_a = src_a;
+	device->blend_dest_a = dest_a;
+}
+
+void device_depth_function(gs_device_t *device, enum gs_depth_test test)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(test);
+}
+
+void device_stencil_function(gs_device_t *device, enum gs_stencil_side side,
+			     enum gs_depth_test test)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(side);
+	UNUSED_PARAMETER(test);
+}
+
+void device_stencil_op(gs_device_t *device, enum gs_stencil_side side,
+		       enum gs_stencil_op_type fail,
+		       enum gs_stencil_op_type zfail,
+		       enum gs_stencil_op_type zpass)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(side);
+	UNUSED_PARAMETER(fail);
+	UNUSED_PARAMETER(zfail);
+	UNUSED_PARAMETER(zpass);
+}
+
+void device_set_viewport(gs_device_t *device, int x, int y, int width,
+			 int height)
+{
+	device->cur_viewport.x = x;
+	device->cur_viewport.y = y;
+	device->cur_viewport.cx = width;
+	device->cur_viewport.cy = height;
+}
+
+void device_get_viewport(const gs_device_t *device, struct gs_rect *rect)
+{
+	*rect = device->cur_viewport;
+}
+
+void device_set_scissor_rect(gs_device_t *device, const struct gs_rect *rect)
+{
+	device->scissor_enabled = rect != NULL;
+	if (rect)
+		device->cur_scissor = *rect;
+}
+
+void device_ortho(gs_device_t *device, float left, float right, float top,
+		  float bottom, float near, float far)
+{
+	struct matrix4 *dst = &device->cur_proj;
+
+	float rml = right - left;
+	float bmt = bottom - top;
+	float fmn = far - near;
+
+	vec4_zero(&dst->x);
+	vec4_zero(&dst->y);
+	vec4_zero(&dst->z);
+	vec4_zero(&dst->t);
+
+	dst->x.x = 2.0f / rml;
+	dst->t.x = (left + right) / -rml;
+
+	dst->y.y = 2.0f / -bmt;
+	dst->t.y = (bottom + top) / bmt;
+
+	dst->z.z = -2.0f / fmn;
+	dst->t.z = (far + near) / -fmn;
+
+	dst->t.w = 1.0f;
+}
+
+void device_frustum(gs_device_t *device, float left, float right, float top,
+		    float bottom, float near, float far)
+{
+	struct matrix4 *dst = &device->cur_proj;
+
+	float rml = right - left;
+	float tmb = top - bottom;
+	float nmf = near - far;
+	float nearx2 = 2.0f * near;
+
+	vec4_zero(&dst->x);
+	vec4_zero(&dst->y);
+	vec4_zero(&dst->z);
+	vec4_zero(&dst->t);
+
+	dst->x.x = nearx2 / rml;
+	dst->z.x = (left + right) / rml;
+
+	dst->y.y = nearx2 / tmb;
+	dst->z.y = (bottom + top) / tmb;
+
+	dst->z.z = (far + near) / nmf;
+	dst->t.z = 2.0f * (near * far) / nmf;
+
+	dst->z.w = -1.0f;
+}
+
+void device_projection_push(gs_device_t *device)
+{
+	da_push_back(device->proj_stack, &device->cur_proj);
+}
+
+void device_projection_pop(gs_device_t *device)
+{
+	struct matrix4 *end;
+	if (!device->proj_stack.num)
+		return;
+
+	end = da_end(device->proj_stack);
+	device->cur_proj = *end;
+	da_pop_back(device->proj_stack);
+}
+
+void device_debug_marker_begin(gs_device_t *device, const char *markername,
+			       const float color[4])
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(markername);
+	UNUSED_PARAMETER(color);
+}
+
+void device_debug_marker_end(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+/* ------------------------------------------------------------------------- */
+/* platform specific                                                         */
+
+#ifdef __APPLE__
+EXPORT bool device_shared_texture_available(void)
+{
+	return false;
+}
+
+#elif _WIN32
+EXPORT bool device_gdi_texture_available(void)
+{
+	return false;
+}
+
+EXPORT bool device_shared_texture_available(void)
+{
+	return false;
+}
+
+#elif __linux__
+gs_texture_t *device_texture_create_from_dmabuf(
+	gs_device_t *device, unsigned int width, unsigned int height,
+	uint32_t drm_format, enum gs_color_format color_format,
+	uint32_t n_planes, const int *fds, const uint32_t *strides,
+	const uint32_t *offsets, const uint64_t *modifiers)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(width);
+	UNUSED_PARAMETER(height);
+	UNUSED_PARAMETER(drm_format);
+	UNUSED_PARAMETER(color_format);
+	UNUSED_PARAMETER(n_planes);
+	UNUSED_PARAMETER(fds);
+	UNUSED_PARAMETER(strides);
+	UNUSED_PARAMETER(offsets);
+	UNUSED_PARAMETER(modifiers);
+	return NULL;
+}
+#endif
@@ -0,0 +1,265 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <util/darray.h>
+#include <graphics/graphics.h>
+#include <graphics/device-exports.h>
+#include <graphics/matrix4.h>
+
+/*
+ * Software graphics module.  Every resource lives in system memory and every
+ * draw is rasterized on the calling thread, so the video pipeline can run
+ * without a GPU and produce the same output on every machine.
+ *
+ * Shaders are parsed for their parameters but not executed.  Instead, a
+ * pixel shader is matched by effect file and technique to a native
+ * implementation in sw-effects.c when it is created, which covers the
+ * effects that ship with libobs and obs-filters.  Drawing with any other
+ * pixel shader fails.  Positions are transformed by ViewProj, the native
+ * shader computes each pixel, and the result is blended into the render
+ * target.  Depth and stencil tests and culling are not emulated.
+ */
+
+struct sw_pass;
+struct sw_fragment;
+
+typedef void (*sw_pixel_shader_t)(const struct sw_pass *pass,
+				  const struct sw_fragment *frag,
+				  float *color);
+
+struct gs_sampler_state {
+	gs_device_t *device;
+	struct gs_sampler_info info;
+};
+
+struct gs_shader_param {
+	enum gs_shader_param_type type;
+
+	char *name;
+	gs_shader_t *shader;
+	gs_samplerstate_t *next_sampler;
+	int array_count;
+
+	struct gs_texture *texture;
+	bool srgb;
+
+	DARRAY(uint8_t) cur_value;
+	DARRAY(uint8_t) def_value;
+};
+
+struct gs_shader {
+	gs_device_t *device;
+	enum gs_shader_type type;
+	char *file;
+
+	/* pixel shaders only */
+	sw_pixel_shader_t native;
+
+	struct gs_shader_param *viewproj;
+	struct gs_shader_param *world;
+
+	DARRAY(struct gs_shader_param) params;
+	DARRAY(gs_samplerstate_t *) samplers;
+};
+
+struct gs_vertex_buffer {
+	gs_device_t *device;
+	size_t num;
+	bool dynamic;
+	struct gs_vb_data *data;
+};
+
+struct gs_index_buffer {
+	gs_device_t *device;
+	void *data;
+	size_t num;
+	size_t width;
+	size_t size;
+	bool dynamic;
+	enum gs_index_type type;
+};
+
+struct gs_texture {
+	gs_device_t *device;
+	enum gs_texture_type type;
+	enum gs_color_format format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t depth;
+	uint32_t levels;
+	uint32_t flags;
+
+	/* only the first mip level is stored, one slice per cube face or
+	 * volume layer */
+	uint32_t linesize;
+	size_t slice_size;
+	uint8_t *data;
+};
+
+struct gs_stage_surface {
+	gs_device_t *device;
+	enum gs_color_format format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t linesize;
+	uint8_t *data;
+};
+
+struct gs_zstencil_buffer {
+	gs_device_t *device;
+	enum gs_zstencil_format format;
+	uint32_t width;
+	uint32_t height;
+};
+
+struct gs_swap_chain {
+	gs_device_t *device;
+	struct gs_init_data info;
+	struct gs_texture *target;
+};
+
+struct gs_timer {
+	uint64_t begin;
+	uint64_t end;
+};
+
+struct gs_timer_range {
+	uint64_t begin;
+	uint64_t end;
+};
+
+struct gs_device {
+	struct gs_swap_chain *cur_swap;
+
+	struct gs_texture *cur_render_target;
+	struct gs_zstencil_buffer *cur_zstencil_buffer;
+	int cur_render_side;
+
+	struct gs_texture *cur_textures[GS_MAX_TEXTURES];
+	struct gs_sampler_state *cur_samplers[GS_MAX_TEXTURES];
+	struct gs_sampler_state *default_sampler;
+
+	struct gs_vertex_buffer *cur_vertex_buffer;
+	struct gs_index_buffer *cur_index_buffer;
+	struct gs_shader *cur_vertex_shader;
+	struct gs_shader *cur_pixel_shader;
+
+	enum gs_cull_mode cur_cull_mode;
+	struct gs_rect cur_viewport;
+	struct gs_rect cur_scissor;
+	bool scissor_enabled;
+	bool framebuffer_srgb;
+
+	bool blend_enabled;
+	enum gs_blend_type blend_src_c;
+	enum gs_blend_type blend_dest_c;
+	enum gs_blend_type blend_src_a;
+	enum gs_blend_type blend_dest_a;
+	bool write_mask[4];
+
+	struct matrix4 cur_proj;
+	struct matrix4 cur_view;
+	struct matrix4 cur_viewproj;
+	DARRAY(struct matrix4) proj_stack;
+};
+
+/* sw-texture.c */
+extern struct gs_texture *sw_texture_create(gs_device_t *device,
+					    enum gs_texture_type type,
+					    uint32_t width, uint32_t height,
+					    uint32_t depth,
+					    enum gs_color_format format,
+					    uint32_t levels, uint32_t flags);
+extern void sw_load_pixel(enum gs_color_format format, const uint8_t *src,
+			  float *color);
+extern void sw_store_pixel(enum gs_color_format format, uint8_t *dst,
+			   const float *color);
+extern void sw_sample(const struct gs_texture *tex,
+		      const struct gs_sampler_info *info, bool srgb, float u,
+		      float v, float *color);
+extern void sw_sample_volume(const struct gs_texture *tex,
+			     const struct gs_sampler_info *info, bool srgb,
+			     float u, float v, float w, float *color);
+extern void sw_load(const struct gs_texture *tex, bool srgb, int x, int y,
+		    float *color);
+
+/* sw-effects.c */
+struct sw_fragment {
+	/* pixel center in render target coordinates */
+	float x, y;
+
+	/* first texture coordinate and its screen space derivatives */
+	float u, v;
+	float du_dx, dv_dy;
+
+	float color[4];
+};
+
+struct sw_texref {
+	const struct gs_texture *tex;
+	struct gs_sampler_info sampler;
+	bool srgb;
+};
+
+/* every uniform the native shaders read, named as in the effect files */
+struct sw_uniforms {
+	float color[4];
+
+	/* format_conversion.effect */
+	float width, height;
+	float width_i, width_d2, height_d2;
+	float color_vec0[4], color_vec1[4], color_vec2[4];
+	float color_range_min[3], color_range_max[3];
+
+	/* scaling effects and repeat.effect */
+	float base_dimension[2], base_dimension_i[2];
+	float undistort_factor;
+	float scale[2];
+
+	/* solid.effect */
+	float randomvals1[4], randomvals2[4], randomvals3[4];
+
+	/* deinterlacing effects */
+	float dimensions[2];
+	int field_order;
+	int frame2;
+
+	/* obs-filters */
+	float mul_val[2], add_val[2];
+	float opacity, contrast, brightness, gamma;
+	float yuv_mat[16], cb_v4[4], cr_v4[4];
+	float chroma_key[2], pixel_size[2];
+	float key_color[4];
+	float similarity, smoothness, spill;
+	float color_matrix[16];
+	float lumaMax, lumaMin, lumaMaxSmooth, lumaMinSmooth;
+	float sharpness, texture_width, texture_height;
+	float clut_amount, cube_width_i;
+	float clut_scale[3], clut_offset[3];
+	float domain_min[3], domain_max[3];
+};
+
+struct sw_pass {
+	struct sw_uniforms u;
+	struct sw_texref image, image1, image2, image3;
+	struct sw_texref target, previous_image, clut_1d, clut_3d;
+};
+
+extern sw_pixel_shader_t sw_find_pixel_shader(const char *file);
+extern void sw_pass_init(struct sw_pass *pass, gs_device_t *device);
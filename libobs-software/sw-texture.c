@@ -0,0 +1,825 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <math.h>
+#include "sw-subsystem.h"
+#include <graphics/half.h>
+#include <graphics/srgb.h>
+
+/* ------------------------------------------------------------------------- */
+/* pixel formats                                                             */
+
+static float half_to_float(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1F;
+	uint32_t mantissa = h & 0x3FF;
+	uint32_t bits;
+	float f;
+
+	if (exponent == 0x1F) {
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	} else if (exponent != 0) {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	} else if (mantissa != 0) {
+		/* denormal, renormalize it */
+		exponent = 113;
+		while (!(mantissa & 0x400)) {
+			mantissa <<= 1;
+			exponent--;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+	} else {
+		bits = sign;
+	}
+
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static inline float unorm8(uint8_t val)
+{
+	return (float)val / 255.0f;
+}
+
+static inline uint8_t to_unorm8(float val)
+{
+	if (!(val > 0.0f))
+		return 0;
+	if (val >= 1.0f)
+		return 255;
+	return (uint8_t)(val * 255.0f + 0.5f);
+}
+
+static inline float unorm16(uint16_t val)
+{
+	return (float)val / 65535.0f;
+}
+
+static inline uint16_t to_unorm16(float val)
+{
+	if (!(val > 0.0f))
+		return 0;
+	if (val >= 1.0f)
+		return 65535;
+	return (uint16_t)(val * 65535.0f + 0.5f);
+}
+
+static inline uint32_t to_unorm(float val, uint32_t max)
+{
+	if (!(val > 0.0f))
+		return 0;
+	if (val >= 1.0f)
+		return max;
+	return (uint32_t)(val * (float)max + 0.5f);
+}
+
+void sw_load_pixel(enum gs_color_format format, const uint8_t *src,
+		   float *color)
+{
+	const uint16_t *src16 = (const uint16_t *)src;
+	const float *src32 = (const float *)src;
+	uint32_t packed;
+
+	color[0] = 0.0f;
+	color[1] = 0.0f;
+	color[2] = 0.0f;
+	color[3] = 1.0f;
+
+	switch (format) {
+	case GS_A8:
+		color[3] = unorm8(src[0]);
+		break;
+	case GS_R8:
+		color[0] = unorm8(src[0]);
+		break;
+	case GS_R8G8:
+		color[0] = unorm8(src[0]);
+		color[1] = unorm8(src[1]);
+		break;
+	case GS_RGBA:
+	case GS_RGBA_UNORM:
+		color[0] = unorm8(src[0]);
+		color[1] = unorm8(src[1]);
+		color[2] = unorm8(src[2]);
+		color[3] = unorm8(src[3]);
+		break;
+	case GS_BGRA:
+	case GS_BGRA_UNORM:
+		color[3] = unorm8(src[3]);
+		/* fall through */
+	case GS_BGRX:
+	case GS_BGRX_UNORM:
+		color[0] = unorm8(src[2]);
+		color[1] = unorm8(src[1]);
+		color[2] = unorm8(src[0]);
+		break;
+	case GS_R10G10B10A2:
+		memcpy(&packed, src, sizeof(packed));
+		color[0] = (float)(packed & 0x3FF) / 1023.0f;
+		color[1] = (float)((packed >> 10) & 0x3FF) / 1023.0f;
+		color[2] = (float)((packed >> 20) & 0x3FF) / 1023.0f;
+		color[3] = (float)(packed >> 30) / 3.0f;
+		break;
+	case GS_RGBA16:
+		for (size_t i = 0; i < 4; i++)
+			color[i] = unorm16(src16[i]);
+		break;
+	case GS_R16:
+		color[0] = unorm16(src16[0]);
+		break;
+	case GS_RGBA16F:
+		for (size_t i = 0; i < 4; i++)
+			color[i] = half_to_float(src16[i]);
+		break;
+	case GS_RG16F:
+		color[1] = half_to_float(src16[1]);
+		/* fall through */
+	case GS_R16F:
+		color[0] = half_to_float(src16[0]);
+		break;
+	case GS_RGBA32F:
+		memcpy(color, src32, sizeof(float) * 4);
+		break;
+	case GS_RG32F:
+		color[1] = src32[1];
+		/* fall through */
+	case GS_R32F:
+		color[0] = src32[0];
+		break;
+	case GS_DXT1:
+	case GS_DXT3:
+	case GS_DXT5:
+	case GS_UNKNOWN:
+		break;
+	}
+}
+
+void sw_store_pixel(enum gs_color_format format, uint8_t *dst,
+		    const float *color)
+{
+	uint16_t *dst16 = (uint16_t *)dst;
+	float *dst32 = (float *)dst;
+	uint32_t packed;
+
+	switch (format) {
+	case GS_A8:
+		dst[0] = to_unorm8(color[3]);
+		break;
+	case GS_R8:
+		dst[0] = to_unorm8(color[0]);
+		break;
+	case GS_R8G8:
+		dst[0] = to_unorm8(color[0]);
+		dst[1] = to_unorm8(color[1]);
+		break;
+	case GS_RGBA:
+	case GS_RGBA_UNORM:
+		dst[0] = to_unorm8(color[0]);
+		dst[1] = to_unorm8(color[1]);
+		dst[2] = to_unorm8(color[2]);
+		dst[3] = to_unorm8(color[3]);
+		break;
+	case GS_BGRA:
+	case GS_BGRA_UNORM:
+		dst[0] = to_unorm8(color[2]);
+		dst[1] = to_unorm8(color[1]);
+		dst[2] = to_unorm8(color[0]);
+		dst[3] = to_unorm8(color[3]);
+		break;
+	case GS_BGRX:
+	case GS_BGRX_UNORM:
+		dst[0] = to_unorm8(color[2]);
+		dst[1] = to_unorm8(color[1]);
+		dst[2] = to_unorm8(color[0]);
+		dst[3] = 255;
+		break;
+	case GS_R10G10B10A2:
+		packed = to_unorm(color[0], 1023) |
+			 (to_unorm(color[1], 1023) << 10) |
+			 (to_unorm(color[2], 1023) << 20) |
+			 (to_unorm(color[3], 3) << 30);
+		memcpy(dst, &packed, sizeof(packed));
+		break;
+	case GS_RGBA16:
+		for (size_t i = 0; i < 4; i++)
+			dst16[i] = to_unorm16(color[i]);
+		break;
+	case GS_R16:
+		dst16[0] = to_unorm16(color[0]);
+		break;
+	case GS_RGBA16F:
+		for (size_t i = 0; i < 4; i++)
+			dst16[i] = half_from_float(color[i]).u;
+		break;
+	case GS_RG16F:
+		dst16[1] = half_from_float(color[1]).u;
+		/* fall through */
+	case GS_R16F:
+		dst16[0] = half_from_float(color[0]).u;
+		break;
+	case GS_RGBA32F:
+		memcpy(dst32, color, sizeof(float) * 4);
+		break;
+	case GS_RG32F:
+		dst32[1] = color[1];
+		/* fall through */
+	case GS_R32F:
+		dst32[0] = color[0];
+		break;
+	case GS_DXT1:
+	case GS_DXT3:
+	case GS_DXT5:
+	case GS_UNKNOWN:
+		break;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* sampling                                                                  */
+
+static inline bool address(enum gs_address_mode mode, int coord, int size,
+			   int *out)
+{
+	int period;
+
+	switch (mode) {
+	case GS_ADDRESS_WRAP:
+		coord %= size;
+		if (coord < 0)
+			coord += size;
+		break;
+	case GS_ADDRESS_MIRROR:
+		period = size * 2;
+		coord %= period;
+		if (coord < 0)
+			coord += period;
+		if (coord >= size)
+			coord = period - coord - 1;
+		break;
+	case GS_ADDRESS_MIRRORONCE:
+		if (coord < 0)
+			coord = -coord - 1;
+		/* fall through */
+	case GS_ADDRESS_CLAMP:
+		if (coord < 0)
+			coord = 0;
+		else if (coord >= size)
+			coord = size - 1;
+		break;
+	case GS_ADDRESS_BORDER:
+		if (coord < 0 || coord >= size)
+			return false;
+		break;
+	}
+
+	*out = coord;
+	return true;
+}
+
+static inline bool can_sample(const struct gs_texture *tex)
+{
+	return tex->data && !gs_is_compressed_format(tex->format) &&
+	       gs_get_format_bpp(tex->format);
+}
+
+static void fetch(const struct gs_texture *tex,
+		  const struct gs_sampler_info *info, bool srgb, int x, int y,
+		  int z, float *color)
+{
+	const uint32_t bpp = gs_get_format_bpp(tex->format) / 8;
+
+	if (!address(info->address_u, x, (int)tex->width, &x) ||
+	    !address(info->address_v, y, (int)tex->height, &y) ||
+	    !address(info->address_w, z, (int)tex->depth, &z)) {
+		uint32_t border = info->border_color;
+		color[0] = unorm8((uint8_t)(border >> 16));
+		color[1] = unorm8((uint8_t)(border >> 8));
+		color[2] = unorm8((uint8_t)border);
+		color[3] = unorm8((uint8_t)(border >> 24));
+		return;
+	}
+
+	sw_load_pixel(tex->format,
+		      tex->data + tex->slice_size * z +
+			      (size_t)y * tex->linesize + (size_t)x * bpp,
+		      color);
+
+	if (srgb && gs_is_srgb_format(tex->format))
+		gs_float3_srgb_nonlinear_to_linear(color);
+}
+
+static inline void lerp4(float *out, const float *a, const float *b, float t)
+{
+	for (size_t i = 0; i < 4; i++)
+		out[i] = a[i] + (b[i] - a[i]) * t;
+}
+
+void sw_sample(const struct gs_texture *tex,
+	       const struct gs_sampler_info *info, bool srgb, float u, float v,
+	       float *color)
+{
+	float x = u * (float)tex->width;
+	float y = v * (float)tex->height;
+	float c00[4], c10[4], c01[4], c11[4];
+	float top[4], bottom[4];
+	float fx, fy;
+	int x0, y0;
+
+	if (!can_sample(tex)) {
+		color[0] = color[1] = color[2] = color[3] = 0.0f;
+		return;
+	}
+
+	if (info->filter == GS_FILTER_POINT) {
+		fetch(tex, info, srgb, (int)floorf(x), (int)floorf(y), 0,
+		      color);
+		return;
+	}
+
+	x -= 0.5f;
+	y -= 0.5f;
+	x0 = (int)floorf(x);
+	y0 = (int)floorf(y);
+	fx = x - (float)x0;
+	fy = y - (float)y0;
+
+	fetch(tex, info, srgb, x0, y0, 0, c00);
+	fetch(tex, info, srgb, x0 + 1, y0, 0, c10);
+	fetch(tex, info, srgb, x0, y0 + 1, 0, c01);
+	fetch(tex, info, srgb, x0 + 1, y0 + 1, 0, c11);
+
+	lerp4(top, c00, c10, fx);
+	lerp4(bottom, c01, c11, fx);
+	lerp4(color, top, bottom, fy);
+}
+
+void sw_sample_volume(const struct gs_texture *tex,
+		      const struct gs_sampler_info *info, bool srgb, float u,
+		      float v, float w, float *color)
+{
+	float x = u * (float)tex->width - 0.5f;
+	float y = v * (float)tex->height - 0.5f;
+	float z = w * (float)tex->depth - 0.5f;
+	float slices[2][4];
+	float fx, fy, fz;
+	int x0, y0, z0;
+
+	if (!can_sample(tex)) {
+		color[0] = color[1] = color[2] = color[3] = 0.0f;
+		return;
+	}
+
+	if (info->filter == GS_FILTER_POINT) {
+		fetch(tex, info, srgb, (int)floorf(x + 0.5f),
+		      (int)floorf(y + 0.5f), (int)floorf(z + 0.5f), color);
+		return;
+	}
+
+	x0 = (int)floorf(x);
+	y0 = (int)floorf(y);
+	z0 = (int)floorf(z);
+	fx = x - (float)x0;
+	fy = y - (float)y0;
+	fz = z - (float)z0;
+
+	for (int i = 0; i < 2; i++) {
+		float c00[4], c10[4], c01[4], c11[4];
+		float top[4], bottom[4];
+
+		fetch(tex, info, srgb, x0, y0, z0 + i, c00);
+		fetch(tex, info, srgb, x0 + 1, y0, z0 + i, c10);
+		fetch(tex, info, srgb, x0, y0 + 1, z0 + i, c01);
+		fetch(tex, info, srgb, x0 + 1, y0 + 1, z0 + i, c11);
+
+		lerp4(top, c00, c10, fx);
+		lerp4(bottom, c01, c11, fx);
+		lerp4(slices[i], top, bottom, fy);
+	}
+
+	lerp4(color, slices[0], slices[1], fz);
+}
+
+/* texel loads ignore the sampler, and texels outside of the texture read as
+ * zero */
+void sw_load(const struct gs_texture *tex, bool srgb, int x, int y,
+	     float *color)
+{
+	const struct gs_sampler_info info = {
+		.address_u = GS_ADDRESS_BORDER,
+		.address_v = GS_ADDRESS_BORDER,
+		.address_w = GS_ADDRESS_BORDER,
+	};
+
+	if (!can_sample(tex)) {
+		color[0] = color[1] = color[2] = color[3] = 0.0f;
+		return;
+	}
+
+	fetch(tex, &info, srgb, x, y, 0, color);
+}
+
+/* ------------------------------------------------------------------------- */
+/* textures                                                                  */
+
+struct gs_texture *sw_texture_create(gs_device_t *device,
+				     enum gs_texture_type type, uint32_t width,
+				     uint32_t height, uint32_t depth,
+				     enum gs_color_format format,
+				     uint32_t levels, uint32_t flags)
+{
+	struct gs_texture *tex;
+	uint32_t bpp = gs_get_format_bpp(format);
+
+	if (!width || !height || !depth || !bpp)
+		return NULL;
+
+	tex = bzalloc(sizeof(struct gs_texture));
+	tex->device = device;
+	tex->type = type;
+	tex->format = format;
+	tex->width = width;
+	tex->height = height;
+	tex->depth = depth;
+	tex->levels = levels ? levels : gs_get_total_levels(width, height, 1);
+	tex->flags = flags;
+	tex->linesize = width * bpp / 8;
+	tex->slice_size = (size_t)tex->linesize * height;
+	tex->data = bzalloc(tex->slice_size * depth);
+
+	return tex;
+}
+
+gs_texture_t *device_texture_create(gs_device_t *device, uint32_t width,
+				    uint32_t height,
+				    enum gs_color_format color_format,
+				    uint32_t levels, const uint8_t **data,
+				    uint32_t flags)
+{
+	struct gs_texture *tex = sw_texture_create(device, GS_TEXTURE_2D, width,
+						   height, 1, color_format,
+						   levels, flags);
+	if (!tex) {
+		blog(LOG_ERROR, "device_texture_create (software) failed");
+		return NULL;
+	}
+
+	if (data && data[0])
+		memcpy(tex->data, data[0], tex->slice_size);
+
+	return tex;
+}
+
+gs_texture_t *device_cubetexture_create(gs_device_t *device, uint32_t size,
+					enum gs_color_format color_format,
+					uint32_t levels, const uint8_t **data,
+					uint32_t flags)
+{
+	struct gs_texture *tex = sw_texture_create(device, GS_TEXTURE_CUBE,
+						   size, size, 6, color_format,
+						   levels, flags);
+	if (!tex) {
+		blog(LOG_ERROR, "device_cubetexture_create (software) failed");
+		return NULL;
+	}
+
+	/* the data holds every mip level of one face before the next face */
+	if (data) {
+		for (uint32_t i = 0; i < 6; i++) {
+			const uint8_t *face = data[i * tex->levels];
+			if (face)
+				memcpy(tex->data + tex->slice_size * i, face,
+				       tex->slice_size);
+		}
+	}
+
+	return tex;
+}
+
+gs_texture_t *device_voltexture_create(gs_device_t *device, uint32_t width,
+				       uint32_t height, uint32_t depth,
+				       enum gs_color_format color_format,
+				       uint32_t levels,
+				       const uint8_t *const *data,
+				       uint32_t flags)
+{
+	struct gs_texture *tex = sw_texture_create(device, GS_TEXTURE_3D, width,
+						   height, depth, color_format,
+						   levels, flags);
+	if (!tex) {
+		blog(LOG_ERROR, "device_voltexture_create (software) failed");
+		return NULL;
+	}
+
+	if (data && data[0])
+		memcpy(tex->data, data[0], tex->slice_size * depth);
+
+	return tex;
+}
+
+enum gs_texture_type device_get_texture_type(const gs_texture_t *texture)
+{
+	return texture->type;
+}
+
+void gs_texture_destroy(gs_texture_t *tex)
+{
+	if (!tex)
+		return;
+
+	bfree(tex->data);
+	bfree(tex);
+}
+
+uint32_t gs_texture_get_width(const gs_texture_t *tex)
+{
+	return tex->width;
+}
+
+uint32_t gs_texture_get_height(const gs_texture_t *tex)
+{
+	return tex->height;
+}
+
+enum gs_color_format gs_texture_get_color_format(const gs_texture_t *tex)
+{
+	return tex->format;
+}
+
+bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
+{
+	if (tex->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "gs_texture_map (software) failed: "
+				"not a 2D texture");
+		return false;
+	}
+
+	*ptr = tex->data;
+	*linesize = tex->linesize;
+	return true;
+}
+
+void gs_texture_unmap(gs_texture_t *tex)
+{
+	UNUSED_PARAMETER(tex);
+}
+
+/* must be defined: the optional import would otherwise resolve to the libobs
+ * function of the same name */
+bool gs_texture_is_rect(const gs_texture_t *tex)
+{
+	UNUSED_PARAMETER(tex);
+	return false;
+}
+
+void *gs_texture_get_obj(gs_texture_t *tex)
+{
+	return tex->data;
+}
+
+void gs_cubetexture_destroy(gs_texture_t *cubetex)
+{
+	gs_texture_destroy(cubetex);
+}
+
+uint32_t gs_cubetexture_get_size(const gs_texture_t *cubetex)
+{
+	return cubetex->width;
+}
+
+enum gs_color_format
+gs_cubetexture_get_color_format(const gs_texture_t *cubetex)
+{
+	return cubetex->format;
+}
+
+void gs_voltexture_destroy(gs_texture_t *voltex)
+{
+	gs_texture_destroy(voltex);
+}
+
+uint32_t gs_voltexture_get_width(const gs_texture_t *voltex)
+{
+	return voltex->width;
+}
+
+uint32_t gs_voltexture_get_height(const gs_texture_t *voltex)
+{
+	return voltex->height;
+}
+
+uint32_t gs_voltexture_get_depth(const gs_texture_t *voltex)
+{
+	return voltex->depth;
+}
+
+enum gs_color_format gs_voltexture_get_color_format(const gs_texture_t *voltex)
+{
+	return voltex->format;
+}
+
+/* ------------------------------------------------------------------------- */
+/* copies                                                                    */
+
+void device_copy_texture_region(gs_device_t *device, gs_texture_t *dst,
+				uint32_t dst_x, uint32_t dst_y,
+				gs_texture_t *src, uint32_t src_x,
+				uint32_t src_y, uint32_t src_w, uint32_t src_h)
+{
+	uint32_t bpp, nw, nh;
+
+	UNUSED_PARAMETER(device);
+
+	if (!src || !dst) {
+		blog(LOG_ERROR, "device_copy_texture_region (software): "
+				"NULL texture");
+		return;
+	}
+
+	if (src->type != GS_TEXTURE_2D || dst->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "device_copy_texture_region (software): "
+				"Source and destination must be 2D textures");
+		return;
+	}
+
+	if (src->format != dst->format) {
+		blog(LOG_ERROR, "device_copy_texture_region (software): "
+				"Source and destination formats do not match");
+		return;
+	}
+
+	nw = src_w ? src_w : src->width - src_x;
+	nh = src_h ? src_h : src->height - src_y;
+
+	if (src_x + nw > src->width || src_y + nh > src->height ||
+	    dst_x + nw > dst->width || dst_y + nh > dst->height) {
+		blog(LOG_ERROR, "device_copy_texture_region (software): "
+				"Region is out of bounds");
+		return;
+	}
+
+	bpp = gs_get_format_bpp(src->format) / 8;
+
+	for (uint32_t y = 0; y < nh; y++) {
+		const uint8_t *in = src->data +
+				    (size_t)(src_y + y) * src->linesize +
+				    (size_t)src_x * bpp;
+		uint8_t *out = dst->data + (size_t)(dst_y + y) * dst->linesize +
+			       (size_t)dst_x * bpp;
+		memmove(out, in, (size_t)nw * bpp);
+	}
+}
+
+void device_copy_texture(gs_device_t *device, gs_texture_t *dst,
+			 gs_texture_t *src)
+{
+	device_copy_texture_region(device, dst, 0, 0, src, 0, 0, 0, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+/* stage surfaces                                                            */
+
+gs_stagesurf_t *device_stagesurface_create(gs_device_t *device, uint32_t width,
+					   uint32_t height,
+					   enum gs_color_format color_format)
+{
+	struct gs_stage_surface *surf;
+	uint32_t bpp = gs_get_format_bpp(color_format);
+
+	if (!width || !height || !bpp) {
+		blog(LOG_ERROR, "device_stagesurface_create (software) failed");
+		return NULL;
+	}
+
+	surf = bzalloc(sizeof(struct gs_stage_surface));
+	surf->device = device;
+	surf->format = color_format;
+	surf->width = width;
+	surf->height = height;
+	surf->linesize = width * bpp / 8;
+	surf->data = bzalloc((size_t)surf->linesize * height);
+	return surf;
+}
+
+void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf)
+{
+	if (!stagesurf)
+		return;
+
+	bfree(stagesurf->data);
+	bfree(stagesurf);
+}
+
+void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst,
+			  gs_texture_t *src)
+{
+	UNUSED_PARAMETER(device);
+
+	if (!src || src->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "device_stage_texture (software): "
+				"Source texture must be a 2D texture");
+		return;
+	}
+
+	if (src->format != dst->format || src->width != dst->width ||
+	    src->height != dst->height) {
+		blog(LOG_ERROR, "device_stage_texture (software): "
+				"Source and destination do not match");
+		return;
+	}
+
+	memcpy(dst->data, src->data, src->slice_size);
+}
+
+uint32_t gs_stagesurface_get_width(const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->width;
+}
+
+uint32_t gs_stagesurface_get_height(const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->height;
+}
+
+enum gs_color_format
+gs_stagesurface_get_color_format(const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->format;
+}
+
+bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data,
+			 uint32_t *linesize)
+{
+	*data = stagesurf->data;
+	*linesize = stagesurf->linesize;
+	return true;
+}
+
+void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf)
+{
+	UNUSED_PARAMETER(stagesurf);
+}
+
+/* ------------------------------------------------------------------------- */
+/* z-stencil buffers and sampler states                                      */
+
+gs_zstencil_t *device_zstencil_create(gs_device_t *device, uint32_t width,
+				      uint32_t height,
+				      enum gs_zstencil_format format)
+{
+	struct gs_zstencil_buffer *zs;
+
+	zs = bzalloc(sizeof(struct gs_zstencil_buffer));
+	zs->device = device;
+	zs->format = format;
+	zs->width = width;
+	zs->height = height;
+	return zs;
+}
+
+void gs_zstencil_destroy(gs_zstencil_t *zs)
+{
+	bfree(zs);
+}
+
+gs_samplerstate_t *
+device_samplerstate_create(gs_device_t *device,
+			   const struct gs_sampler_info *info)
+{
+	struct gs_sampler_state *sampler;
+
+	sampler = bzalloc(sizeof(struct gs_sampler_state));
+	sampler->device = device;
+	sampler->info = *info;
+	return sampler;
+}
+
+void gs_samplerstate_destroy(gs_samplerstate_t *samplerstate)
+{
+	gs_device_t *device;
+
+	if (!samplerstate)
+		return;
+
+	device = samplerstate->device;
+	for (size_t i = 0; i < GS_MAX_TEXTURES; i++) {
+		if (device->cur_samplers[i] == samplerstate)
+			device->cur_samplers[i] = NULL;
+	}
+
+	bfree(samplerstate);
+}
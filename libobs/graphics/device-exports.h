@@ -169,6 +169,8 @@ EXPORT void device_debug_marker_begin(gs_device_t *device,
 				      const char *markername,
 				      const float color[4]);
 EXPORT void device_debug_marker_end(gs_device_t *device);
+EXPORT void device_set_shader_cache_path(gs_device_t *device,
+					 const char *path);
 
 #if __linux__
 
@@ -1843,6 +1843,7 @@ static void ep_compile_annotations(struct darray *ep_annotations,
 			((struct ep_param *)ep_annotations->array) + i;
 
 		param->name = bstrdup(param_in->name);
+		param->name_hash = effect_hash_name(param->name);
 		param->section = EFFECT_ANNOTATION;
 		param->effect = ep->effect;
 		da_move(param->default_val, param_in->default_val);
@@ -1874,6 +1875,7 @@ static void ep_compile_param(struct effect_parser *ep, size_t idx)
 	param_in->param = param;
 
 	param->name = bstrdup(param_in->name);
+	param->name_hash = effect_hash_name(param->name);
 	param->section = EFFECT_PARAM;
 	param->effect = ep->effect;
 	da_move(param->default_val, param_in->default_val);
@@ -2012,6 +2014,7 @@ static bool ep_compile_pass(struct effect_parser *ep,
 	pass_in = tech_in->passes.array + idx;
 
 	pass->name = bstrdup(pass_in->name);
+	pass->name_hash = effect_hash_name(pass->name);
 	pass->section = EFFECT_PASS;
 
 #if defined(_DEBUG) && defined(_DEBUG_SHADERS)
@@ -2044,6 +2047,7 @@ static inline bool ep_compile_technique(struct effect_parser *ep, size_t idx)
 	tech_in = ep->techniques.array + idx;
 
 	tech->name = bstrdup(tech_in->name);
+	tech->name_hash = effect_hash_name(tech->name);
 	tech->section = EFFECT_TECHNIQUE;
 	tech->effect = ep->effect;
 
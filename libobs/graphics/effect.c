@@ -38,12 +38,14 @@ void gs_effect_destroy(gs_effect_t *effect)
 gs_technique_t *gs_effect_get_technique(const gs_effect_t *effect,
 					const char *name)
 {
-	if (!effect)
+	if (!effect || !name)
 		return NULL;
 
+	uint32_t hash = effect_hash_name(name);
+
 	for (size_t i = 0; i < effect->techniques.num; i++) {
 		struct gs_effect_technique *tech = effect->techniques.array + i;
-		if (strcmp(tech->name, name) == 0)
+		if (tech->name_hash == hash && strcmp(tech->name, name) == 0)
 			return tech;
 	}
 
@@ -218,12 +220,15 @@ bool gs_technique_begin_pass(gs_technique_t *tech, size_t idx)
 
 bool gs_technique_begin_pass_by_name(gs_technique_t *tech, const char *name)
 {
-	if (!tech)
+	if (!tech || !name)
 		return false;
 
+	uint32_t hash = effect_hash_name(name);
+
 	for (size_t i = 0; i < tech->passes.num; i++) {
 		struct gs_effect_pass *pass = tech->passes.array + i;
-		if (strcmp(pass->name, name) == 0) {
+		if (pass->name_hash == hash && pass->name &&
+		    strcmp(pass->name, name) == 0) {
 			gs_technique_begin_pass(tech, i);
 			return true;
 		}
@@ -280,15 +285,16 @@ gs_eparam_t *gs_effect_get_param_by_idx(const gs_effect_t *effect, size_t param)
 gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect,
 					 const char *name)
 {
-	if (!effect)
+	if (!effect || !name)
 		return NULL;
 
 	struct gs_effect_param *params = effect->params.array;
+	uint32_t hash = effect_hash_name(name);
 
 	for (size_t i = 0; i < effect->params.num; i++) {
 		struct gs_effect_param *param = params + i;
 
-		if (strcmp(param->name, name) == 0)
+		if (param->name_hash == hash && strcmp(param->name, name) == 0)
 			return param;
 	}
 
@@ -316,13 +322,15 @@ gs_eparam_t *gs_param_get_annotation_by_idx(const gs_eparam_t *param,
 gs_eparam_t *gs_param_get_annotation_by_name(const gs_eparam_t *param,
 					     const char *name)
 {
-	if (!param)
+	if (!param || !name)
 		return NULL;
 	struct gs_effect_param *params = param->annotations.array;
+	uint32_t hash = effect_hash_name(name);
 
 	for (size_t i = 0; i < param->annotations.num; i++) {
 		struct gs_effect_param *g_param = params + i;
-		if (strcmp(g_param->name, name) == 0)
+		if (g_param->name_hash == hash &&
+		    strcmp(g_param->name, name) == 0)
 			return g_param;
 	}
 	return NULL;
@@ -344,13 +352,15 @@ gs_epass_t *gs_technique_get_pass_by_idx(const gs_technique_t *technique,
 gs_epass_t *gs_technique_get_pass_by_name(const gs_technique_t *technique,
 					  const char *name)
 {
-	if (!technique)
+	if (!technique || !name)
 		return NULL;
 	struct gs_effect_pass *passes = technique->passes.array;
+	uint32_t hash = effect_hash_name(name);
 
 	for (size_t i = 0; i < technique->passes.num; i++) {
 		struct gs_effect_pass *g_pass = passes + i;
-		if (strcmp(g_pass->name, name) == 0)
+		if (g_pass->name_hash == hash && g_pass->name &&
+		    strcmp(g_pass->name, name) == 0)
 			return g_pass;
 	}
 	return NULL;
@@ -47,8 +47,30 @@ enum effect_section {
 
 /* ------------------------------------------------------------------------- */
 
+/* names of params, techniques and passes are hashed when the effect is
+ * compiled, so lookups by name only compare the strings of entries with a
+ * matching hash */
+static inline uint32_t effect_hash_name(const char *name)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
+
+	if (!name)
+		return 0;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/* ------------------------------------------------------------------------- */
+
 struct gs_effect_param {
 	char *name;
+	uint32_t name_hash;
 	enum effect_section section;
 
 	enum gs_shader_param_type type;
@@ -97,6 +119,7 @@ struct pass_shaderparam {
 
 struct gs_effect_pass {
 	char *name;
+	uint32_t name_hash;
 	enum effect_section section;
 
 	gs_shader_t *vertshader;
@@ -124,6 +147,7 @@ static inline void effect_pass_free(struct gs_effect_pass *pass)
 
 struct gs_effect_technique {
 	char *name;
+	uint32_t name_hash;
 	enum effect_section section;
 	struct gs_effect *effect;
 
@@ -270,6 +270,9 @@ struct gs_exports {
 					  const float color[4]);
 	void (*device_debug_marker_end)(gs_device_t *device);
 
+	void (*device_set_shader_cache_path)(gs_device_t *device,
+					     const char *path);
+
 #ifdef __APPLE__
 	/* OSX/Cocoa specific functions */
 	gs_texture_t *(*device_texture_create_from_iosurface)(gs_device_t *dev,
@@ -355,6 +358,7 @@ struct graphics_subsystem {
 	size_t cur_matrix;
 
 	struct matrix4 projection;
+	DARRAY(struct matrix4) projection_stack;
 	struct gs_effect *cur_effect;
 
 	gs_vertbuffer_t *sprite_buffer;
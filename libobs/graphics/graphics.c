@@ -149,6 +149,7 @@ static bool graphics_init(struct graphics_subsystem *graphics)
 
 	matrix4_identity(&top_mat);
 	da_push_back(graphics->matrix_stack, &top_mat);
+	matrix4_identity(&graphics->projection);
 
 	graphics->exports.device_enter_context(graphics->device);
 
@@ -246,6 +247,7 @@ void gs_destroy(graphics_t *graphics)
 	pthread_mutex_destroy(&graphics->effect_mutex);
 	da_free(graphics->matrix_stack);
 	da_free(graphics->viewport_stack);
+	da_free(graphics->projection_stack);
 	da_free(graphics->blend_state_stack);
 	if (graphics->module)
 		os_dlclose(graphics->module);
@@ -2059,6 +2061,56 @@ void gs_set_scissor_rect(const struct gs_rect *rect)
 	graphics->exports.device_set_scissor_rect(graphics->device, rect);
 }
 
+/* the same matrices the devices build, kept for gs_get_projection */
+static void build_ortho(struct matrix4 *dst, float left, float right, float top,
+			float bottom, float znear, float zfar)
+{
+	float rml = right - left;
+	float bmt = bottom - top;
+	float fmn = zfar - znear;
+
+	vec4_zero(&dst->x);
+	vec4_zero(&dst->y);
+	vec4_zero(&dst->z);
+	vec4_zero(&dst->t);
+
+	dst->x.x = 2.0f / rml;
+	dst->t.x = (left + right) / -rml;
+
+	dst->y.y = 2.0f / -bmt;
+	dst->t.y = (bottom + top) / bmt;
+
+	dst->z.z = -2.0f / fmn;
+	dst->t.z = (zfar + znear) / -fmn;
+
+	dst->t.w = 1.0f;
+}
+
+static void build_frustum(struct matrix4 *dst, float left, float right,
+			  float top, float bottom, float znear, float zfar)
+{
+	float rml = right - left;
+	float tmb = top - bottom;
+	float nmf = znear - zfar;
+	float nearx2 = 2.0f * znear;
+
+	vec4_zero(&dst->x);
+	vec4_zero(&dst->y);
+	vec4_zero(&dst->z);
+	vec4_zero(&dst->t);
+
+	dst->x.x = nearx2 / rml;
+	dst->z.x = (left + right) / rml;
+
+	dst->y.y = nearx2 / tmb;
+	dst->z.y = (bottom + top) / tmb;
+
+	dst->z.z = (zfar + znear) / nmf;
+	dst->t.z = 2.0f * (znear * zfar) / nmf;
+
+	dst->z.w = -1.0f;
+}
+
 void gs_ortho(float left, float right, float top, float bottom, float znear,
 	      float zfar)
 {
@@ -2069,6 +2121,8 @@ void gs_ortho(float left, float right, float top, float bottom, float znear,
 
 	graphics->exports.device_ortho(graphics->device, left, right, top,
 				       bottom, znear, zfar);
+	build_ortho(&graphics->projection, left, right, top, bottom, znear,
+		    zfar);
 }
 
 void gs_frustum(float left, float right, float top, float bottom, float znear,
@@ -2081,6 +2135,16 @@ void gs_frustum(float left, float right, float top, float bottom, float znear,
 
 	graphics->exports.device_frustum(graphics->device, left, right, top,
 					 bottom, znear, zfar);
+	build_frustum(&graphics->projection, left, right, top, bottom, znear,
+		      zfar);
+}
+
+void gs_get_projection(struct matrix4 *dst)
+{
+	if (!gs_valid_p("gs_get_projection", dst))
+		return;
+
+	matrix4_copy(dst, &thread_graphics->projection);
 }
 
 void gs_projection_push(void)
@@ -2091,16 +2155,24 @@ void gs_projection_push(void)
 		return;
 
 	graphics->exports.device_projection_push(graphics->device);
+	da_push_back(graphics->projection_stack, &graphics->projection);
 }
 
 void gs_projection_pop(void)
 {
 	graphics_t *graphics = thread_graphics;
+	struct matrix4 *end;
 
 	if (!gs_valid("gs_projection_pop"))
 		return;
 
 	graphics->exports.device_projection_pop(graphics->device);
+
+	if (graphics->projection_stack.num) {
+		end = da_end(graphics->projection_stack);
+		graphics->projection = *end;
+		da_pop_back(graphics->projection_stack);
+	}
 }
 
 void gs_swapchain_destroy(gs_swapchain_t *swapchain)
@@ -2755,6 +2827,18 @@ bool gs_nv12_available(void)
 		thread_graphics->device);
 }
 
+void gs_set_shader_cache_path(const char *path)
+{
+	if (!gs_valid("gs_set_shader_cache_path"))
+		return;
+
+	if (!thread_graphics->exports.device_set_shader_cache_path)
+		return;
+
+	thread_graphics->exports.device_set_shader_cache_path(
+		thread_graphics->device, path);
+}
+
 void gs_debug_marker_begin(const float color[4], const char *markername)
 {
 	if (!gs_valid("gs_debug_marker_begin"))
@@ -377,6 +377,11 @@ struct gs_effect_param_info {
 
 EXPORT void gs_effect_destroy(gs_effect_t *effect);
 
+/*
+ * Technique, pass and param handles stay valid for as long as the effect
+ * exists, so code that renders every frame can look them up by name once
+ * when the effect is created and keep the handles.
+ */
 EXPORT gs_technique_t *gs_effect_get_technique(const gs_effect_t *effect,
 					       const char *name);
 
@@ -501,6 +506,7 @@ struct gs_init_data {
 
 #define GS_DEVICE_OPENGL 1
 #define GS_DEVICE_DIRECT3D_11 2
+#define GS_DEVICE_SOFTWARE 3
 
 EXPORT const char *gs_get_device_name(void);
 EXPORT int gs_get_device_type(void);
@@ -746,6 +752,7 @@ EXPORT void gs_ortho(float left, float right, float top, float bottom,
 EXPORT void gs_frustum(float left, float right, float top, float bottom,
 		       float znear, float zfar);
 
+EXPORT void gs_get_projection(struct matrix4 *dst);
 EXPORT void gs_projection_push(void);
 EXPORT void gs_projection_pop(void);
 
@@ -823,6 +830,13 @@ EXPORT bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint,
 
 EXPORT bool gs_nv12_available(void);
 
+/**
+ * Sets the directory used to cache compiled shader program binaries between
+ * runs, or NULL to disable the cache.  Only affects shaders created
+ * afterwards, so it should be set before loading any effects.
+ */
+EXPORT void gs_set_shader_cache_path(const char *path);
+
 #define GS_USE_DEBUG_MARKERS 0
 #if GS_USE_DEBUG_MARKERS
 static const float GS_DEBUG_COLOR_DEFAULT[] = {0.5f, 0.5f, 0.5f, 1.0f};
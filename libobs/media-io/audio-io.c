@@ -26,6 +26,7 @@
 #include "../util/util_uint64.h"
 
 #include "audio-io.h"
+#include "audio-mixing.h"
 #include "audio-resampler.h"
 
 extern profiler_name_store_t *obs_get_profiler_name_store(void);
@@ -70,6 +71,9 @@ struct audio_output {
 	void *input_param;
 	pthread_mutex_t input_mutex;
 	struct audio_mix mixes[MAX_AUDIO_MIXES];
+
+	volatile long total_ticks;
+	volatile long total_mixes;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -122,7 +126,8 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
 	pthread_mutex_unlock(&audio->input_mutex);
 }
 
-static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
+static inline void clamp_audio_output(struct audio_output *audio, size_t bytes,
+				      uint32_t active_mixes)
 {
 	size_t float_size = bytes / sizeof(float);
 
@@ -130,20 +135,11 @@ static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
 		/* do not process mixing if a specific mix is inactive */
-		if (!mix->inputs.num)
+		if ((active_mixes & (1 << mix_idx)) == 0)
 			continue;
 
-		for (size_t plane = 0; plane < audio->planes; plane++) {
-			float *mix_data = mix->buffer[plane];
-			float *mix_end = &mix_data[float_size];
-
-			while (mix_data < mix_end) {
-				float val = *mix_data;
-				val = (val > 1.0f) ? 1.0f : val;
-				val = (val < -1.0f) ? -1.0f : val;
-				*(mix_data++) = val;
-			}
-		}
+		for (size_t plane = 0; plane < audio->planes; plane++)
+			audio_mix_clamp(mix->buffer[plane], float_size);
 	}
 }
 
@@ -153,6 +149,7 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 	size_t bytes = AUDIO_OUTPUT_FRAMES * audio->block_size;
 	struct audio_output_data data[MAX_AUDIO_MIXES];
 	uint32_t active_mixes = 0;
+	long num_active_mixes = 0;
 	uint64_t new_ts = 0;
 	bool success;
 
@@ -166,19 +163,25 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 	/* get mixers */
 	pthread_mutex_lock(&audio->input_mutex);
 	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
-		if (audio->mixes[i].inputs.num)
+		if (audio->mixes[i].inputs.num) {
 			active_mixes |= (1 << i);
+			num_active_mixes++;
+		}
 	}
 	pthread_mutex_unlock(&audio->input_mutex);
 
-	/* clear mix buffers */
+	/* clear mix buffers (only the planes of active mixes are touched) */
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
-		memset(mix->buffer, 0, sizeof(mix->buffer));
-
 		for (size_t i = 0; i < audio->planes; i++)
 			data[mix_idx].data[i] = mix->buffer[i];
+
+		if ((active_mixes & (1 << mix_idx)) == 0)
+			continue;
+
+		for (size_t i = 0; i < audio->planes; i++)
+			memset(mix->buffer[i], 0, sizeof(mix->buffer[i]));
 	}
 
 	/* get new audio data */
@@ -187,12 +190,20 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 	if (!success)
 		return;
 
+	os_atomic_inc_long(&audio->total_ticks);
+	if (!active_mixes)
+		return;
+
+	os_atomic_add_long(&audio->total_mixes, num_active_mixes);
+
 	/* clamps audio data to -1.0..1.0 */
-	clamp_audio_output(audio, bytes);
+	clamp_audio_output(audio, bytes, active_mixes);
 
 	/* output */
-	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
-		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		if ((active_mixes & (1 << i)) != 0)
+			do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+	}
 }
 
 static void *audio_thread(void *param)
@@ -455,3 +466,13 @@ uint32_t audio_output_get_sample_rate(const audio_t *audio)
 {
 	return audio ? audio->info.samples_per_sec : 0;
 }
+
+uint32_t audio_output_get_total_ticks(const audio_t *audio)
+{
+	return audio ? (uint32_t)os_atomic_load_long(&audio->total_ticks) : 0;
+}
+
+uint32_t audio_output_get_total_mixes(const audio_t *audio)
+{
+	return audio ? (uint32_t)os_atomic_load_long(&audio->total_mixes) : 0;
+}
@@ -229,6 +229,11 @@ EXPORT uint32_t audio_output_get_sample_rate(const audio_t *audio);
 EXPORT const struct audio_output_info *
 audio_output_get_info(const audio_t *audio);
 
+/** Number of audio ticks that produced output */
+EXPORT uint32_t audio_output_get_total_ticks(const audio_t *audio);
+/** Number of mix buffers cleared, clamped and output (active mixes only) */
+EXPORT uint32_t audio_output_get_total_mixes(const audio_t *audio);
+
 #ifdef __cplusplus
 }
 #endif
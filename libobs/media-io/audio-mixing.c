@@ -0,0 +1,280 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "audio-mixing.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+	defined(__i386__)
+#define HAVE_AVX_KERNELS
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX_TARGET
+#else
+#define AVX_TARGET __attribute__((target("avx")))
+#endif
+#else
+#include "../util/sse-intrin.h"
+#endif
+
+/* ------------------------------------------------------------------------- */
+/* scalar                                                                    */
+
+static void add_scalar(float *dst, const float *src, size_t count)
+{
+	register float *out = dst;
+	register const float *in = src;
+	register const float *end = in + count;
+
+	while (in < end)
+		*(out++) += *(in++);
+}
+
+static void add_with_gain_scalar(float *dst, const float *src,
+				 const float *gain, size_t count)
+{
+	register float *out = dst;
+	register const float *mul = gain;
+	register const float *in = src;
+	register const float *end = in + count;
+
+	while (in < end)
+		*(out++) += *(in++) * *(mul++);
+}
+
+static void clamp_scalar(float *data, size_t count)
+{
+	float *end = data + count;
+
+	while (data < end) {
+		float val = *data;
+		val = (val > 1.0f) ? 1.0f : val;
+		val = (val < -1.0f) ? -1.0f : val;
+		*(data++) = val;
+	}
+}
+
+static const struct audio_mix_kernels kernels_scalar = {
+	.name = "scalar",
+	.add = add_scalar,
+	.add_with_gain = add_with_gain_scalar,
+	.clamp = clamp_scalar,
+};
+
+/* ------------------------------------------------------------------------- */
+/* SSE2 (native on x86, SIMDe elsewhere)                                     */
+
+static void add_sse2(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+		__m128 b0 = _mm_loadu_ps(src + i);
+		__m128 b1 = _mm_loadu_ps(src + i + 4);
+		_mm_storeu_ps(dst + i, _mm_add_ps(a0, b0));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(a1, b1));
+	}
+
+	add_scalar(dst + i, src + i, count - i);
+}
+
+static void add_with_gain_sse2(float *dst, const float *src, const float *gain,
+			       size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+		__m128 b0 = _mm_mul_ps(_mm_loadu_ps(src + i),
+				       _mm_loadu_ps(gain + i));
+		__m128 b1 = _mm_mul_ps(_mm_loadu_ps(src + i + 4),
+				       _mm_loadu_ps(gain + i + 4));
+		_mm_storeu_ps(dst + i, _mm_add_ps(a0, b0));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(a1, b1));
+	}
+
+	add_with_gain_scalar(dst + i, src + i, gain + i, count - i);
+}
+
+static void clamp_sse2(float *data, size_t count)
+{
+	const __m128 max_val = _mm_set1_ps(1.0f);
+	const __m128 min_val = _mm_set1_ps(-1.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 v0 = _mm_loadu_ps(data + i);
+		__m128 v1 = _mm_loadu_ps(data + i + 4);
+		v0 = _mm_max_ps(_mm_min_ps(v0, max_val), min_val);
+		v1 = _mm_max_ps(_mm_min_ps(v1, max_val), min_val);
+		_mm_storeu_ps(data + i, v0);
+		_mm_storeu_ps(data + i + 4, v1);
+	}
+
+	clamp_scalar(data + i, count - i);
+}
+
+static const struct audio_mix_kernels kernels_sse2 = {
+	.name = "SSE2",
+	.add = add_sse2,
+	.add_with_gain = add_with_gain_sse2,
+	.clamp = clamp_sse2,
+};
+
+/* ------------------------------------------------------------------------- */
+/* AVX (x86 only, selected at runtime)                                       */
+
+#ifdef HAVE_AVX_KERNELS
+AVX_TARGET static void add_avx(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256 a0 = _mm256_loadu_ps(dst + i);
+		__m256 a1 = _mm256_loadu_ps(dst + i + 8);
+		__m256 b0 = _mm256_loadu_ps(src + i);
+		__m256 b1 = _mm256_loadu_ps(src + i + 8);
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(a0, b0));
+		_mm256_storeu_ps(dst + i + 8, _mm256_add_ps(a1, b1));
+	}
+
+	_mm256_zeroupper();
+	add_sse2(dst + i, src + i, count - i);
+}
+
+AVX_TARGET static void add_with_gain_avx(float *dst, const float *src,
+					 const float *gain, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256 a0 = _mm256_loadu_ps(dst + i);
+		__m256 a1 = _mm256_loadu_ps(dst + i + 8);
+		__m256 b0 = _mm256_mul_ps(_mm256_loadu_ps(src + i),
+					  _mm256_loadu_ps(gain + i));
+		__m256 b1 = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8),
+					  _mm256_loadu_ps(gain + i + 8));
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(a0, b0));
+		_mm256_storeu_ps(dst + i + 8, _mm256_add_ps(a1, b1));
+	}
+
+	_mm256_zeroupper();
+	add_with_gain_sse2(dst + i, src + i, gain + i, count - i);
+}
+
+AVX_TARGET static void clamp_avx(float *data, size_t count)
+{
+	const __m256 max_val = _mm256_set1_ps(1.0f);
+	const __m256 min_val = _mm256_set1_ps(-1.0f);
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256 v0 = _mm256_loadu_ps(data + i);
+		__m256 v1 = _mm256_loadu_ps(data + i + 8);
+		v0 = _mm256_max_ps(_mm256_min_ps(v0, max_val), min_val);
+		v1 = _mm256_max_ps(_mm256_min_ps(v1, max_val), min_val);
+		_mm256_storeu_ps(data + i, v0);
+		_mm256_storeu_ps(data + i + 8, v1);
+	}
+
+	_mm256_zeroupper();
+	clamp_sse2(data + i, count - i);
+}
+
+static const struct audio_mix_kernels kernels_avx = {
+	.name = "AVX",
+	.add = add_avx,
+	.add_with_gain = add_with_gain_avx,
+	.clamp = clamp_avx,
+};
+
+static bool cpu_has_avx(void)
+{
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs, 1);
+
+	/* OSXSAVE and AVX */
+	if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+		return false;
+
+	/* OS saves XMM and YMM state on context switch */
+	return (_xgetbv(0) & 6) == 6;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+const struct audio_mix_kernels *audio_mix_get_kernels(enum audio_mix_impl impl)
+{
+	switch (impl) {
+	case AUDIO_MIX_IMPL_SCALAR:
+		return &kernels_scalar;
+	case AUDIO_MIX_IMPL_SSE2:
+		return &kernels_sse2;
+	case AUDIO_MIX_IMPL_AVX:
+#ifdef HAVE_AVX_KERNELS
+		return cpu_has_avx() ? &kernels_avx : NULL;
+#else
+		return NULL;
+#endif
+	}
+
+	return NULL;
+}
+
+/* every thread resolves to the same table, so a race on the first call is
+ * harmless */
+static const struct audio_mix_kernels *volatile active_kernels = NULL;
+
+const struct audio_mix_kernels *audio_mix_get_active_kernels(void)
+{
+	const struct audio_mix_kernels *kernels = active_kernels;
+
+	if (!kernels) {
+		kernels = audio_mix_get_kernels(AUDIO_MIX_IMPL_AVX);
+		if (!kernels)
+			kernels = &kernels_sse2;
+		active_kernels = kernels;
+	}
+
+	return kernels;
+}
+
+void audio_mix_add(float *dst, const float *src, size_t count)
+{
+	audio_mix_get_active_kernels()->add(dst, src, count);
+}
+
+void audio_mix_add_with_gain(float *dst, const float *src, const float *gain,
+			     size_t count)
+{
+	audio_mix_get_active_kernels()->add_with_gain(dst, src, gain, count);
+}
+
+void audio_mix_clamp(float *data, size_t count)
+{
+	audio_mix_get_active_kernels()->clamp(data, count);
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Audio mixing kernels
+ *
+ *   Inner loops used when summing planar float audio into mix buffers.  The
+ * best implementation for the running CPU is selected on first use (AVX when
+ * supported by both the CPU and the OS, otherwise SSE2, which is emulated via
+ * SIMDe on non-x86 architectures).  Buffers do not need to be aligned.
+ */
+
+enum audio_mix_impl {
+	AUDIO_MIX_IMPL_SCALAR,
+	AUDIO_MIX_IMPL_SSE2,
+	AUDIO_MIX_IMPL_AVX,
+};
+
+struct audio_mix_kernels {
+	const char *name;
+
+	/* dst[i] += src[i] */
+	void (*add)(float *dst, const float *src, size_t count);
+
+	/* dst[i] += src[i] * gain[i] */
+	void (*add_with_gain)(float *dst, const float *src, const float *gain,
+			      size_t count);
+
+	/* data[i] = clamp(data[i], -1.0f, 1.0f) */
+	void (*clamp)(float *data, size_t count);
+};
+
+/**
+ * Returns the kernel set for a specific implementation, or NULL if that
+ * implementation is not supported on the running CPU.  Mostly useful for
+ * testing and benchmarking, regular callers should use the functions below.
+ */
+EXPORT const struct audio_mix_kernels *
+audio_mix_get_kernels(enum audio_mix_impl impl);
+
+/** Returns the kernel set that the dispatching functions below use */
+EXPORT const struct audio_mix_kernels *audio_mix_get_active_kernels(void);
+
+EXPORT void audio_mix_add(float *dst, const float *src, size_t count);
+EXPORT void audio_mix_add_with_gain(float *dst, const float *src,
+				    const float *gain, size_t count);
+EXPORT void audio_mix_clamp(float *data, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,6 +22,7 @@
 #include "../util/profiler.h"
 #include "../util/threading.h"
 #include "../util/darray.h"
+#include "../util/circlebuf.h"
 #include "../util/util_uint64.h"
 
 #include "format-conversion.h"
@@ -38,6 +39,19 @@ struct cached_frame_info {
 	struct video_data frame;
 	int skipped;
 	int count;
+
+	/* set once every copy of the frame was handed to the inputs, the
+	 * frame goes back to the cache when no input thread uses it anymore */
+	bool dispatched;
+	volatile long refs;
+};
+
+/* a cached frame queued for an input thread */
+struct input_frame {
+	struct cached_frame_info *cfi;
+	struct video_data frame;
+	uint64_t queued_ts;
+	int repeats;
 };
 
 struct video_input {
@@ -48,14 +62,22 @@ struct video_input {
 
 	void (*callback)(void *param, struct video_data *frame);
 	void *param;
-};
 
-static inline void video_input_free(struct video_input *input)
-{
-	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
-		video_frame_free(&input->frame[i]);
-	video_scaler_destroy(input->scaler);
-}
+	/* threaded inputs only */
+	struct video_output *video;
+	pthread_t thread;
+	bool thread_active;
+	volatile bool stop;
+	os_sem_t *queue_sem;
+	pthread_mutex_t queue_mutex;
+	struct circlebuf queue;
+	size_t max_queued;
+
+	uint32_t total_frames;
+	uint32_t skipped_frames;
+	uint64_t last_lag_ns;
+	uint64_t max_lag_ns;
+};
 
 struct video_output {
 	struct video_output_info info;
@@ -72,17 +94,33 @@ struct video_output {
 	bool initialized;
 
 	pthread_mutex_t input_mutex;
-	DARRAY(struct video_input) inputs;
+	DARRAY(struct video_input *) inputs;
+
+	/* inputs that disconnected from their own thread */
+	DARRAY(struct video_input *) stopped_inputs;
 
 	size_t available_frames;
 	size_t first_added;
 	size_t last_added;
+	size_t first_used;
 	struct cached_frame_info cache[MAX_CACHE_SIZE];
 
 	volatile bool raw_active;
 	volatile long gpu_refs;
 };
 
+static void video_input_stop_thread(struct video_input *input);
+
+static inline void video_input_free(struct video_input *input)
+{
+	video_input_stop_thread(input);
+
+	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
+		video_frame_free(&input->frame[i]);
+	video_scaler_destroy(input->scaler);
+	bfree(input);
+}
+
 /* ------------------------------------------------------------------------- */
 
 static inline bool scale_video_output(struct video_input *input,
@@ -116,6 +154,203 @@ static inline bool scale_video_output(struct video_input *input,
 	return success;
 }
 
+/* returns dispatched frames that are no longer used by any input to the
+ * cache, in cache order.  data_mutex must be locked. */
+static void release_cached_frames(struct video_output *video)
+{
+	while (video->available_frames < video->info.cache_size) {
+		struct cached_frame_info *cfi;
+
+		cfi = &video->cache[video->first_used];
+
+		if (!cfi->dispatched || os_atomic_load_long(&cfi->refs) != 0)
+			break;
+
+		cfi->dispatched = false;
+
+		if (++video->first_used == video->info.cache_size)
+			video->first_used = 0;
+
+		if (++video->available_frames == video->info.cache_size)
+			video->last_added = video->first_added;
+	}
+}
+
+static void release_cached_frame(struct video_output *video,
+				 struct cached_frame_info *cfi)
+{
+	if (os_atomic_dec_long(&cfi->refs) == 0) {
+		pthread_mutex_lock(&video->data_mutex);
+		release_cached_frames(video);
+		pthread_mutex_unlock(&video->data_mutex);
+	}
+}
+
+static inline void input_output_frame(struct video_input *input,
+				      struct input_frame *item)
+{
+	struct video_data frame = item->frame;
+
+	if (!scale_video_output(input, &frame))
+		return;
+
+	input->callback(input->param, &frame);
+
+	/* the input fell behind, repeat the frame rather than leaving a gap
+	 * in its timestamps, unless it disconnected from its callback */
+	for (int i = 0; i < item->repeats; i++) {
+		struct video_data repeat = frame;
+
+		if (os_atomic_load_bool(&input->stop))
+			break;
+
+		repeat.timestamp += input->video->frame_time * (i + 1);
+		input->callback(input->param, &repeat);
+	}
+}
+
+/* releases the frames still queued for a stopped input */
+static void drain_input_queue(struct video_input *input)
+{
+	for (;;) {
+		struct input_frame item;
+
+		pthread_mutex_lock(&input->queue_mutex);
+		if (!input->queue.size) {
+			pthread_mutex_unlock(&input->queue_mutex);
+			break;
+		}
+		circlebuf_pop_front(&input->queue, &item, sizeof(item));
+		pthread_mutex_unlock(&input->queue_mutex);
+
+		release_cached_frame(input->video, item.cfi);
+	}
+}
+
+static void *input_thread(void *param)
+{
+	struct video_input *input = param;
+	struct video_output *video = input->video;
+
+	os_set_thread_name("video-io: input thread");
+
+	const char *input_thread_name =
+		profile_store_name(obs_get_profiler_name_store(),
+				   "video_input_thread(%s)", video->info.name);
+
+	while (os_sem_wait(input->queue_sem) == 0) {
+		struct input_frame item;
+		uint64_t lag;
+
+		if (os_atomic_load_bool(&input->stop))
+			break;
+
+		pthread_mutex_lock(&input->queue_mutex);
+		if (!input->queue.size) {
+			pthread_mutex_unlock(&input->queue_mutex);
+			continue;
+		}
+		circlebuf_pop_front(&input->queue, &item, sizeof(item));
+		pthread_mutex_unlock(&input->queue_mutex);
+
+		profile_start(input_thread_name);
+		input_output_frame(input, &item);
+		profile_end(input_thread_name);
+
+		lag = os_gettime_ns() - item.queued_ts;
+
+		pthread_mutex_lock(&input->queue_mutex);
+		input->last_lag_ns = lag;
+		if (lag > input->max_lag_ns)
+			input->max_lag_ns = lag;
+		pthread_mutex_unlock(&input->queue_mutex);
+
+		release_cached_frame(video, item.cfi);
+
+		profile_reenable_thread();
+	}
+
+	/* an input that disconnected from its own thread is only joined on a
+	 * later connect or disconnect, its frames must go back to the cache
+	 * now */
+	drain_input_queue(input);
+	return NULL;
+}
+
+static void video_input_stop_thread(struct video_input *input)
+{
+	if (!input->thread_active)
+		return;
+
+	os_atomic_set_bool(&input->stop, true);
+	os_sem_post(input->queue_sem);
+	pthread_join(input->thread, NULL);
+	input->thread_active = false;
+
+	drain_input_queue(input);
+	circlebuf_free(&input->queue);
+	pthread_mutex_destroy(&input->queue_mutex);
+	os_sem_destroy(input->queue_sem);
+}
+
+static bool video_input_start_thread(struct video_input *input,
+				     struct video_output *video)
+{
+	input->video = video;
+	input->max_queued = video->info.cache_size / 2;
+	if (!input->max_queued)
+		input->max_queued = 1;
+
+	if (pthread_mutex_init(&input->queue_mutex, NULL) != 0)
+		return false;
+	if (os_sem_init(&input->queue_sem, 0) != 0)
+		goto fail1;
+	if (pthread_create(&input->thread, NULL, input_thread, input) != 0)
+		goto fail2;
+
+	input->thread_active = true;
+	return true;
+
+fail2:
+	os_sem_destroy(input->queue_sem);
+fail1:
+	pthread_mutex_destroy(&input->queue_mutex);
+	return false;
+}
+
+/* queues the frame for the input thread.  if the input still has too many
+ * frames queued, the frame is repeated from the last queued one instead, so
+ * that a slow input does not hold back the others or the frame cache. */
+static void queue_input_frame(struct video_input *input,
+			      struct cached_frame_info *cfi,
+			      const struct video_data *frame)
+{
+	struct input_frame item = {.cfi = cfi, .frame = *frame};
+	bool queued = false;
+
+	item.queued_ts = os_gettime_ns();
+
+	pthread_mutex_lock(&input->queue_mutex);
+
+	input->total_frames++;
+
+	if (input->queue.size / sizeof(item) < input->max_queued) {
+		os_atomic_inc_long(&cfi->refs);
+		circlebuf_push_back(&input->queue, &item, sizeof(item));
+		queued = true;
+	} else {
+		struct input_frame *last = circlebuf_data(
+			&input->queue, input->queue.size - sizeof(item));
+		last->repeats++;
+		input->skipped_frames++;
+	}
+
+	pthread_mutex_unlock(&input->queue_mutex);
+
+	if (queued)
+		os_sem_post(input->queue_sem);
+}
+
 static inline bool video_output_cur_frame(struct video_output *video)
 {
 	struct cached_frame_info *frame_info;
@@ -135,10 +370,12 @@ static inline bool video_output_cur_frame(struct video_output *video)
 	pthread_mutex_lock(&video->input_mutex);
 
 	for (size_t i = 0; i < video->inputs.num; i++) {
-		struct video_input *input = video->inputs.array + i;
+		struct video_input *input = video->inputs.array[i];
 		struct video_data frame = frame_info->frame;
 
-		if (scale_video_output(input, &frame))
+		if (input->thread_active)
+			queue_input_frame(input, frame_info, &frame);
+		else if (scale_video_output(input, &frame))
 			input->callback(input->param, &frame);
 	}
 
@@ -156,8 +393,8 @@ static inline bool video_output_cur_frame(struct video_output *video)
 		if (++video->first_added == video->info.cache_size)
 			video->first_added = 0;
 
-		if (++video->available_frames == video->info.cache_size)
-			video->last_added = video->first_added;
+		frame_info->dispatched = true;
+		release_cached_frames(video);
 	} else if (skipped) {
 		--frame_info->skipped;
 		os_atomic_inc_long(&video->skipped_frames);
@@ -271,9 +508,8 @@ void video_output_close(video_t *video)
 
 	video_output_stop(video);
 
-	for (size_t i = 0; i < video->inputs.num; i++)
-		video_input_free(&video->inputs.array[i]);
 	da_free(video->inputs);
+	da_free(video->stopped_inputs);
 
 	for (size_t i = 0; i < video->info.cache_size; i++)
 		video_frame_free((struct video_frame *)&video->cache[i]);
@@ -287,7 +523,7 @@ static size_t video_get_input_idx(const video_t *video,
 				  void *param)
 {
 	for (size_t i = 0; i < video->inputs.num; i++) {
-		struct video_input *input = video->inputs.array + i;
+		struct video_input *input = video->inputs.array[i];
 		if (input->callback == callback && input->param == param)
 			return i;
 	}
@@ -332,6 +568,38 @@ static inline bool video_input_init(struct video_input *input,
 	return true;
 }
 
+/* takes the inputs that were disconnected from their own input thread, which
+ * could not join itself at the time.  input_mutex must be locked. */
+static void take_stopped_inputs(video_t *video, struct darray *da)
+{
+	DARRAY(struct video_input *) stopped;
+	da_init(stopped);
+
+	for (size_t i = video->stopped_inputs.num; i > 0; i--) {
+		struct video_input *input = video->stopped_inputs.array[i - 1];
+
+		if (pthread_equal(input->thread, pthread_self()))
+			continue;
+
+		da_push_back(stopped, &input);
+		da_erase(video->stopped_inputs, i - 1);
+	}
+
+	*da = stopped.da;
+}
+
+/* input threads are joined without input_mutex locked, as their callbacks
+ * may disconnect themselves */
+static void free_inputs(struct darray *da)
+{
+	DARRAY(struct video_input *) inputs;
+	inputs.da = *da;
+
+	for (size_t i = 0; i < inputs.num; i++)
+		video_input_free(inputs.array[i]);
+	da_free(inputs);
+}
+
 static inline void reset_frames(video_t *video)
 {
 	os_atomic_set_long(&video->skipped_frames, 0);
@@ -342,6 +610,7 @@ bool video_output_connect(
 	video_t *video, const struct video_scale_info *conversion,
 	void (*callback)(void *param, struct video_data *frame), void *param)
 {
+	struct darray stopped;
 	bool success = false;
 
 	if (!video || !callback)
@@ -349,27 +618,31 @@ bool video_output_connect(
 
 	pthread_mutex_lock(&video->input_mutex);
 
+	take_stopped_inputs(video, &stopped);
+
 	if (video_get_input_idx(video, callback, param) == DARRAY_INVALID) {
-		struct video_input input;
-		memset(&input, 0, sizeof(input));
+		struct video_input *input = bzalloc(sizeof(*input));
 
-		input.callback = callback;
-		input.param = param;
+		input->callback = callback;
+		input->param = param;
 
 		if (conversion) {
-			input.conversion = *conversion;
+			input->conversion = *conversion;
 		} else {
-			input.conversion.format = video->info.format;
-			input.conversion.width = video->info.width;
-			input.conversion.height = video->info.height;
+			input->conversion.format = video->info.format;
+			input->conversion.width = video->info.width;
+			input->conversion.height = video->info.height;
 		}
 
-		if (input.conversion.width == 0)
-			input.conversion.width = video->info.width;
-		if (input.conversion.height == 0)
-			input.conversion.height = video->info.height;
+		if (input->conversion.width == 0)
+			input->conversion.width = video->info.width;
+		if (input->conversion.height == 0)
+			input->conversion.height = video->info.height;
+
+		success = video_input_init(input, video);
+		if (success && video->info.threaded_inputs)
+			success = video_input_start_thread(input, video);
 
-		success = video_input_init(&input, video);
 		if (success) {
 			if (video->inputs.num == 0) {
 				if (!os_atomic_load_long(&video->gpu_refs)) {
@@ -378,11 +651,14 @@ bool video_output_connect(
 				os_atomic_set_bool(&video->raw_active, true);
 			}
 			da_push_back(video->inputs, &input);
+		} else {
+			video_input_free(input);
 		}
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
 
+	free_inputs(&stopped);
 	return success;
 }
 
@@ -408,16 +684,31 @@ void video_output_disconnect(video_t *video,
 					      struct video_data *frame),
 			     void *param)
 {
+	struct video_input *input = NULL;
+	struct darray stopped;
+
 	if (!video || !callback)
 		return;
 
 	pthread_mutex_lock(&video->input_mutex);
 
+	take_stopped_inputs(video, &stopped);
+
 	size_t idx = video_get_input_idx(video, callback, param);
 	if (idx != DARRAY_INVALID) {
-		video_input_free(video->inputs.array + idx);
+		input = video->inputs.array[idx];
 		da_erase(video->inputs, idx);
 
+		/* an input thread can't join itself, e.g. when an encoder
+		 * stops on an encode error */
+		if (input->thread_active &&
+		    pthread_equal(input->thread, pthread_self())) {
+			os_atomic_set_bool(&input->stop, true);
+			os_sem_post(input->queue_sem);
+			da_push_back(video->stopped_inputs, &input);
+			input = NULL;
+		}
+
 		if (video->inputs.num == 0) {
 			os_atomic_set_bool(&video->raw_active, false);
 			if (!os_atomic_load_long(&video->gpu_refs)) {
@@ -427,6 +718,10 @@ void video_output_disconnect(video_t *video,
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
+
+	if (input)
+		video_input_free(input);
+	free_inputs(&stopped);
 }
 
 bool video_output_active(const video_t *video)
@@ -453,10 +748,19 @@ bool video_output_lock_frame(video_t *video, struct video_frame *frame,
 	pthread_mutex_lock(&video->data_mutex);
 
 	if (video->available_frames == 0) {
-		video->cache[video->last_added].count += count;
-		video->cache[video->last_added].skipped += count;
+		cfi = &video->cache[video->last_added];
+		cfi->count += count;
+		cfi->skipped += count;
 		locked = false;
 
+		/* input threads still hold every cached frame, hand the
+		 * last one to the inputs again */
+		if (cfi->dispatched) {
+			cfi->dispatched = false;
+			video->first_added = video->last_added;
+			os_sem_post(video->update_semaphore);
+		}
+
 	} else {
 		if (video->available_frames != video->info.cache_size) {
 			if (++video->last_added == video->info.cache_size)
@@ -508,6 +812,14 @@ void video_output_stop(video_t *video)
 		video->stop = true;
 		os_sem_post(video->update_semaphore);
 		pthread_join(video->thread, &thread_ret);
+
+		for (size_t i = 0; i < video->inputs.num; i++)
+			video_input_free(video->inputs.array[i]);
+		for (size_t i = 0; i < video->stopped_inputs.num; i++)
+			video_input_free(video->stopped_inputs.array[i]);
+		video->inputs.num = 0;
+		video->stopped_inputs.num = 0;
+
 		os_sem_destroy(video->update_semaphore);
 		pthread_mutex_destroy(&video->data_mutex);
 		pthread_mutex_destroy(&video->input_mutex);
@@ -555,6 +867,42 @@ uint32_t video_output_get_total_frames(const video_t *video)
 	return (uint32_t)os_atomic_load_long(&video->total_frames);
 }
 
+bool video_output_get_input_stats(video_t *video,
+				  void (*callback)(void *param,
+						   struct video_data *frame),
+				  void *param, struct video_input_stats *stats)
+{
+	bool found = false;
+
+	if (!video || !callback || !stats)
+		return false;
+
+	pthread_mutex_lock(&video->input_mutex);
+
+	size_t idx = video_get_input_idx(video, callback, param);
+	if (idx != DARRAY_INVALID) {
+		struct video_input *input = video->inputs.array[idx];
+
+		memset(stats, 0, sizeof(*stats));
+
+		if (input->thread_active) {
+			pthread_mutex_lock(&input->queue_mutex);
+			stats->total_frames = input->total_frames;
+			stats->skipped_frames = input->skipped_frames;
+			stats->queued_frames = (uint32_t)(
+				input->queue.size / sizeof(struct input_frame));
+			stats->last_lag_ns = input->last_lag_ns;
+			stats->max_lag_ns = input->max_lag_ns;
+			pthread_mutex_unlock(&input->queue_mutex);
+		}
+
+		found = true;
+	}
+
+	pthread_mutex_unlock(&video->input_mutex);
+	return found;
+}
+
 /* Note: These four functions below are a very slight bit of a hack.  If the
  * texture encoder thread is active while the raw encoder thread is active, the
  * total frame count will just be doubled while they're both active.  Which is
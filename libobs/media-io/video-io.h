@@ -89,6 +89,14 @@ struct video_data {
 	uint64_t timestamp;
 };
 
+struct video_input_stats {
+	uint32_t total_frames;
+	uint32_t skipped_frames;
+	uint32_t queued_frames;
+	uint64_t last_lag_ns;
+	uint64_t max_lag_ns;
+};
+
 struct video_output_info {
 	const char *name;
 
@@ -101,6 +109,9 @@ struct video_output_info {
 
 	enum video_colorspace colorspace;
 	enum video_range_type range;
+
+	/* give each connected input its own thread */
+	bool threaded_inputs;
 };
 
 static inline bool format_is_yuv(enum video_format format)
@@ -261,6 +272,14 @@ EXPORT double video_output_get_frame_rate(const video_t *video);
 EXPORT uint32_t video_output_get_skipped_frames(const video_t *video);
 EXPORT uint32_t video_output_get_total_frames(const video_t *video);
 
+/**
+ * Gets the frame and lag counts of a threaded input, all zero if the output
+ * does not use threaded inputs.  Returns false if the input isn't connected.
+ */
+EXPORT bool video_output_get_input_stats(
+	video_t *video, void (*callback)(void *param, struct video_data *frame),
+	void *param, struct video_input_stats *stats);
+
 extern void video_output_inc_texture_encoders(video_t *video);
 extern void video_output_dec_texture_encoders(video_t *video);
 extern void video_output_inc_texture_frames(video_t *video);
@@ -73,11 +73,23 @@ struct obs_volmeter {
 	DARRAY(struct meter_cb) callbacks;
 
 	enum obs_peak_meter_type peak_meter_type;
+	uint32_t metrics;
 	unsigned int update_ms;
+};
+
+/* levels of a source, computed once per audio block for all the volume meters
+ * attached to it, and only for the metrics that one of them needs.  lives as
+ * long as a meter is attached, protected by the source's audio_cb_mutex */
+struct obs_source_levels {
+	DARRAY(struct obs_volmeter *) meters;
 	float prev_samples[MAX_AUDIO_CHANNELS][4];
 
+	bool has_magnitude;
+	bool has_sample_peak;
+	bool has_true_peak;
 	float magnitude[MAX_AUDIO_CHANNELS];
-	float peak[MAX_AUDIO_CHANNELS];
+	float sample_peak[MAX_AUDIO_CHANNELS];
+	float true_peak[MAX_AUDIO_CHANNELS];
 };
 
 static float cubic_def_to_db(const float def)
@@ -390,9 +402,9 @@ static float get_sample_peak(__m128 previous_samples, const float *samples,
 	return r;
 }
 
-static void volmeter_process_peak_last_samples(obs_volmeter_t *volmeter,
-					       int channel_nr, float *samples,
-					       size_t nr_samples)
+static void levels_process_peak_last_samples(struct obs_source_levels *levels,
+					     int channel_nr, float *samples,
+					     size_t nr_samples)
 {
 	/* Take the last 4 samples that need to be used for the next peak
 	 * calculation. If there are less than 4 samples in total the new
@@ -402,40 +414,39 @@ static void volmeter_process_peak_last_samples(obs_volmeter_t *volmeter,
 	case 0:
 		break;
 	case 1:
-		volmeter->prev_samples[channel_nr][0] =
-			volmeter->prev_samples[channel_nr][1];
-		volmeter->prev_samples[channel_nr][1] =
-			volmeter->prev_samples[channel_nr][2];
-		volmeter->prev_samples[channel_nr][2] =
-			volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		levels->prev_samples[channel_nr][0] =
+			levels->prev_samples[channel_nr][1];
+		levels->prev_samples[channel_nr][1] =
+			levels->prev_samples[channel_nr][2];
+		levels->prev_samples[channel_nr][2] =
+			levels->prev_samples[channel_nr][3];
+		levels->prev_samples[channel_nr][3] = samples[nr_samples - 1];
 		break;
 	case 2:
-		volmeter->prev_samples[channel_nr][0] =
-			volmeter->prev_samples[channel_nr][2];
-		volmeter->prev_samples[channel_nr][1] =
-			volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		levels->prev_samples[channel_nr][0] =
+			levels->prev_samples[channel_nr][2];
+		levels->prev_samples[channel_nr][1] =
+			levels->prev_samples[channel_nr][3];
+		levels->prev_samples[channel_nr][2] = samples[nr_samples - 2];
+		levels->prev_samples[channel_nr][3] = samples[nr_samples - 1];
 		break;
 	case 3:
-		volmeter->prev_samples[channel_nr][0] =
-			volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][1] = samples[nr_samples - 3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		levels->prev_samples[channel_nr][0] =
+			levels->prev_samples[channel_nr][3];
+		levels->prev_samples[channel_nr][1] = samples[nr_samples - 3];
+		levels->prev_samples[channel_nr][2] = samples[nr_samples - 2];
+		levels->prev_samples[channel_nr][3] = samples[nr_samples - 1];
 		break;
 	default:
-		volmeter->prev_samples[channel_nr][0] = samples[nr_samples - 4];
-		volmeter->prev_samples[channel_nr][1] = samples[nr_samples - 3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		levels->prev_samples[channel_nr][0] = samples[nr_samples - 4];
+		levels->prev_samples[channel_nr][1] = samples[nr_samples - 3];
+		levels->prev_samples[channel_nr][2] = samples[nr_samples - 2];
+		levels->prev_samples[channel_nr][3] = samples[nr_samples - 1];
 	}
 }
 
-static void volmeter_process_peak(obs_volmeter_t *volmeter,
-				  const struct audio_data *data,
-				  int nr_channels)
+static void levels_process_peak(struct obs_source_levels *levels,
+				const struct audio_data *data, int nr_channels)
 {
 	int nr_samples = data->frames;
 	int channel_nr = 0;
@@ -448,47 +459,40 @@ static void volmeter_process_peak(obs_volmeter_t *volmeter,
 			printf("Audio plane %i is not aligned %p skipping "
 			       "peak volume measurement.\n",
 			       plane_nr, samples);
-			volmeter->peak[channel_nr] = 1.0;
+			levels->sample_peak[channel_nr] = 1.0;
+			levels->true_peak[channel_nr] = 1.0;
 			channel_nr++;
 			continue;
 		}
 
-		/* volmeter->prev_samples may not be aligned to 16 bytes;
+		/* levels->prev_samples may not be aligned to 16 bytes;
 		 * use unaligned load. */
 		__m128 previous_samples =
-			_mm_loadu_ps(volmeter->prev_samples[channel_nr]);
-
-		float peak;
-		switch (volmeter->peak_meter_type) {
-		case TRUE_PEAK_METER:
-			peak = get_true_peak(previous_samples, samples,
-					     nr_samples);
-			break;
-
-		case SAMPLE_PEAK_METER:
-		default:
-			peak = get_sample_peak(previous_samples, samples,
-					       nr_samples);
-			break;
-		}
+			_mm_loadu_ps(levels->prev_samples[channel_nr]);
 
-		volmeter_process_peak_last_samples(volmeter, channel_nr,
-						   samples, nr_samples);
+		if (levels->has_sample_peak)
+			levels->sample_peak[channel_nr] = get_sample_peak(
+				previous_samples, samples, nr_samples);
+		if (levels->has_true_peak)
+			levels->true_peak[channel_nr] = get_true_peak(
+				previous_samples, samples, nr_samples);
 
-		volmeter->peak[channel_nr] = peak;
+		levels_process_peak_last_samples(levels, channel_nr, samples,
+						 nr_samples);
 
 		channel_nr++;
 	}
 
 	/* Clear the peak of the channels that have not been handled. */
 	for (; channel_nr < MAX_AUDIO_CHANNELS; channel_nr++) {
-		volmeter->peak[channel_nr] = 0.0;
+		levels->sample_peak[channel_nr] = 0.0;
+		levels->true_peak[channel_nr] = 0.0;
 	}
 }
 
-static void volmeter_process_magnitude(obs_volmeter_t *volmeter,
-				       const struct audio_data *data,
-				       int nr_channels)
+static void levels_process_magnitude(struct obs_source_levels *levels,
+				     const struct audio_data *data,
+				     int nr_channels)
 {
 	size_t nr_samples = data->frames;
 
@@ -504,26 +508,51 @@ static void volmeter_process_magnitude(obs_volmeter_t *volmeter,
 			float sample = samples[i];
 			sum += sample * sample;
 		}
-		volmeter->magnitude[channel_nr] = sqrtf(sum / nr_samples);
+		levels->magnitude[channel_nr] = sqrtf(sum / nr_samples);
 
 		channel_nr++;
 	}
+
+	for (; channel_nr < MAX_AUDIO_CHANNELS; channel_nr++)
+		levels->magnitude[channel_nr] = 0.0;
 }
 
-static void volmeter_process_audio_data(obs_volmeter_t *volmeter,
-					const struct audio_data *data)
+/* gets which levels have to be computed for a volume meter, nothing if no
+ * one is listening to it */
+static void volmeter_get_wanted_levels(struct obs_volmeter *volmeter,
+				       struct obs_source_levels *levels)
 {
-	int nr_channels = get_nr_channels_from_audio_data(data);
+	uint32_t metrics;
+	bool listened;
 
-	volmeter_process_peak(volmeter, data, nr_channels);
-	volmeter_process_magnitude(volmeter, data, nr_channels);
+	pthread_mutex_lock(&volmeter->callback_mutex);
+	listened = volmeter->callbacks.num > 0;
+	pthread_mutex_unlock(&volmeter->callback_mutex);
+
+	if (!listened)
+		return;
+
+	pthread_mutex_lock(&volmeter->mutex);
+	metrics = volmeter->metrics;
+
+	if (metrics & OBS_VOLMETER_MAGNITUDE)
+		levels->has_magnitude = true;
+
+	if (metrics & OBS_VOLMETER_PEAK) {
+		if (volmeter->peak_meter_type == TRUE_PEAK_METER)
+			levels->has_true_peak = true;
+		else
+			levels->has_sample_peak = true;
+	}
+	pthread_mutex_unlock(&volmeter->mutex);
 }
 
-static void volmeter_source_data_received(void *vptr, obs_source_t *source,
-					  const struct audio_data *data,
-					  bool muted)
+static void volmeter_levels_updated(struct obs_volmeter *volmeter,
+				    const struct obs_source_levels *levels,
+				    bool muted)
 {
-	struct obs_volmeter *volmeter = (struct obs_volmeter *)vptr;
+	const float *src_peak = NULL;
+	const float *src_magnitude = NULL;
 	float mul;
 	float magnitude[MAX_AUDIO_CHANNELS];
 	float peak[MAX_AUDIO_CHANNELS];
@@ -531,29 +560,114 @@ static void volmeter_source_data_received(void *vptr, obs_source_t *source,
 
 	pthread_mutex_lock(&volmeter->mutex);
 
-	volmeter_process_audio_data(volmeter, data);
+	if ((volmeter->metrics & OBS_VOLMETER_MAGNITUDE) &&
+	    levels->has_magnitude)
+		src_magnitude = levels->magnitude;
+
+	if (volmeter->metrics & OBS_VOLMETER_PEAK) {
+		if (volmeter->peak_meter_type == TRUE_PEAK_METER) {
+			if (levels->has_true_peak)
+				src_peak = levels->true_peak;
+		} else if (levels->has_sample_peak) {
+			src_peak = levels->sample_peak;
+		}
+	}
 
 	// Adjust magnitude/peak based on the volume level set by the user.
 	// And convert to dB.
 	mul = muted ? 0.0f : db_to_mul(volmeter->cur_db);
 	for (int channel_nr = 0; channel_nr < MAX_AUDIO_CHANNELS;
 	     channel_nr++) {
-		magnitude[channel_nr] =
-			mul_to_db(volmeter->magnitude[channel_nr] * mul);
-		peak[channel_nr] = mul_to_db(volmeter->peak[channel_nr] * mul);
+		float channel_magnitude =
+			src_magnitude ? src_magnitude[channel_nr] : 0.0f;
+		float channel_peak = src_peak ? src_peak[channel_nr] : 0.0f;
+
+		magnitude[channel_nr] = mul_to_db(channel_magnitude * mul);
+		peak[channel_nr] = mul_to_db(channel_peak * mul);
 
 		/* The input-peak is NOT adjusted with volume, so that the user
 		 * can check the input-gain. */
-		input_peak[channel_nr] = mul_to_db(volmeter->peak[channel_nr]);
+		input_peak[channel_nr] = mul_to_db(channel_peak);
 	}
 
 	pthread_mutex_unlock(&volmeter->mutex);
 
 	signal_levels_updated(volmeter, magnitude, peak, input_peak);
+}
+
+static void source_levels_data_received(void *vptr, obs_source_t *source,
+					const struct audio_data *data,
+					bool muted)
+{
+	struct obs_source_levels *levels = vptr;
+	int nr_channels = get_nr_channels_from_audio_data(data);
+
+	levels->has_magnitude = false;
+	levels->has_sample_peak = false;
+	levels->has_true_peak = false;
+
+	for (size_t i = 0; i < levels->meters.num; i++)
+		volmeter_get_wanted_levels(levels->meters.array[i], levels);
+
+	/* the last samples are always kept so that a peak meter can start
+	 * at any time */
+	levels_process_peak(levels, data, nr_channels);
+	if (levels->has_magnitude)
+		levels_process_magnitude(levels, data, nr_channels);
+
+	for (size_t i = 0; i < levels->meters.num; i++)
+		volmeter_levels_updated(levels->meters.array[i], levels, muted);
 
 	UNUSED_PARAMETER(source);
 }
 
+static void source_levels_add_meter(obs_source_t *source,
+				    struct obs_volmeter *volmeter)
+{
+	struct obs_source_levels *levels;
+
+	pthread_mutex_lock(&source->audio_cb_mutex);
+
+	levels = source->audio_levels;
+	if (!levels) {
+		levels = bzalloc(sizeof(struct obs_source_levels));
+		source->audio_levels = levels;
+
+		struct audio_cb_info info = {source_levels_data_received,
+					     levels};
+		da_push_back(source->audio_cb_list, &info);
+	}
+
+	da_push_back(levels->meters, &volmeter);
+
+	pthread_mutex_unlock(&source->audio_cb_mutex);
+}
+
+static void source_levels_remove_meter(obs_source_t *source,
+				       struct obs_volmeter *volmeter)
+{
+	struct obs_source_levels *levels;
+
+	pthread_mutex_lock(&source->audio_cb_mutex);
+
+	levels = source->audio_levels;
+	if (levels) {
+		da_erase_item(levels->meters, &volmeter);
+
+		if (!levels->meters.num) {
+			struct audio_cb_info info = {
+				source_levels_data_received, levels};
+			da_erase_item(source->audio_cb_list, &info);
+
+			da_free(levels->meters);
+			bfree(levels);
+			source->audio_levels = NULL;
+		}
+	}
+
+	pthread_mutex_unlock(&source->audio_cb_mutex);
+}
+
 obs_fader_t *obs_fader_create(enum obs_fader_type type)
 {
 	struct obs_fader *fader = bzalloc(sizeof(struct obs_fader));
@@ -782,6 +896,7 @@ obs_volmeter_t *obs_volmeter_create(enum obs_fader_type type)
 		goto fail;
 
 	volmeter->type = type;
+	volmeter->metrics = OBS_VOLMETER_MAGNITUDE | OBS_VOLMETER_PEAK;
 
 	obs_volmeter_set_update_interval(volmeter, 50);
 
@@ -819,8 +934,6 @@ bool obs_volmeter_attach_source(obs_volmeter_t *volmeter, obs_source_t *source)
 			       volmeter);
 	signal_handler_connect(sh, "destroy", volmeter_source_destroyed,
 			       volmeter);
-	obs_source_add_audio_capture_callback(
-		source, volmeter_source_data_received, volmeter);
 	vol = obs_source_get_volume(source);
 
 	pthread_mutex_lock(&volmeter->mutex);
@@ -830,6 +943,8 @@ bool obs_volmeter_attach_source(obs_volmeter_t *volmeter, obs_source_t *source)
 
 	pthread_mutex_unlock(&volmeter->mutex);
 
+	source_levels_add_meter(source, volmeter);
+
 	return true;
 }
 
@@ -854,8 +969,7 @@ void obs_volmeter_detach_source(obs_volmeter_t *volmeter)
 				  volmeter);
 	signal_handler_disconnect(sh, "destroy", volmeter_source_destroyed,
 				  volmeter);
-	obs_source_remove_audio_capture_callback(
-		source, volmeter_source_data_received, volmeter);
+	source_levels_remove_meter(source, volmeter);
 }
 
 void obs_volmeter_set_peak_meter_type(obs_volmeter_t *volmeter,
@@ -877,6 +991,16 @@ void obs_volmeter_set_update_interval(obs_volmeter_t *volmeter,
 	pthread_mutex_unlock(&volmeter->mutex);
 }
 
+void obs_volmeter_set_metrics(obs_volmeter_t *volmeter, uint32_t metrics)
+{
+	if (!volmeter)
+		return;
+
+	pthread_mutex_lock(&volmeter->mutex);
+	volmeter->metrics = metrics;
+	pthread_mutex_unlock(&volmeter->mutex);
+}
+
 unsigned int obs_volmeter_get_update_interval(obs_volmeter_t *volmeter)
 {
 	if (!volmeter)
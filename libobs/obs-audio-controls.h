@@ -226,11 +226,30 @@ EXPORT void obs_volmeter_detach_source(obs_volmeter_t *volmeter);
  * @brief Set the peak meter type for the volume meter
  * @param volmeter pointer to the volume meter object
  * @param peak_meter_type set if true-peak needs to be measured.
+ *
+ * The levels of a source are shared by all volume meters attached to it, the
+ * true-peak is only computed while one of them uses TRUE_PEAK_METER.
  */
 EXPORT void
 obs_volmeter_set_peak_meter_type(obs_volmeter_t *volmeter,
 				 enum obs_peak_meter_type peak_meter_type);
 
+/** Magnitude (RMS) of the audio */
+#define OBS_VOLMETER_MAGNITUDE (1 << 0)
+/** Peak and input peak of the audio */
+#define OBS_VOLMETER_PEAK (1 << 1)
+
+/**
+ * @brief Set which levels the volume meter reports
+ * @param volmeter pointer to the volume meter object
+ * @param metrics OBS_VOLMETER_* flags, both by default
+ *
+ * Levels are only computed while a volume meter with callbacks wants them.
+ * Levels that are not wanted are reported as -inf dB.
+ */
+EXPORT void obs_volmeter_set_metrics(obs_volmeter_t *volmeter,
+				     uint32_t metrics);
+
 /**
  * @brief Set the update interval for the volume meter
  * @param volmeter pointer to the volume meter object
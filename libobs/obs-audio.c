@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include "obs-internal.h"
 #include "util/util_uint64.h"
+#include "media-io/audio-mixing.h"
 
 struct ts_info {
 	uint64_t start;
@@ -46,39 +47,43 @@ static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
 	return (size_t)util_mul_div64(t, sample_rate, 1000000000ULL);
 }
 
-static inline void mix_audio(struct audio_output_data *mixes,
-			     obs_source_t *source, size_t channels,
-			     size_t sample_rate, struct ts_info *ts)
+/* returns the number of channels mixed */
+static inline size_t mix_audio(struct audio_output_data *mixes,
+			       obs_source_t *source, uint32_t mixers,
+			       size_t channels, size_t sample_rate,
+			       struct ts_info *ts)
 {
 	size_t total_floats = AUDIO_OUTPUT_FRAMES;
 	size_t start_point = 0;
+	size_t mixed = 0;
 
 	if (source->audio_ts < ts->start || ts->end <= source->audio_ts)
-		return;
+		return 0;
 
 	if (source->audio_ts != ts->start) {
 		start_point = convert_time_to_frames(
 			sample_rate, source->audio_ts - ts->start);
 		if (start_point == AUDIO_OUTPUT_FRAMES)
-			return;
+			return 0;
 
 		total_floats -= start_point;
 	}
 
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-		for (size_t ch = 0; ch < channels; ch++) {
-			register float *mix = mixes[mix_idx].data[ch];
-			register float *aud =
-				source->audio_output_buf[mix_idx][ch];
-			register float *end;
+		if ((mixers & (1 << mix_idx)) == 0)
+			continue;
 
-			mix += start_point;
-			end = aud + total_floats;
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *mix = mixes[mix_idx].data[ch];
+			float *aud = source->audio_output_buf[mix_idx][ch];
 
-			while (aud < end)
-				*(mix++) += *(aud++);
+			audio_mix_add(mix + start_point, aud, total_floats);
 		}
+
+		mixed += channels;
 	}
+
+	return mixed;
 }
 
 static bool ignore_audio(obs_source_t *source, size_t channels,
@@ -436,6 +441,108 @@ static inline const char *calc_min_ts(struct obs_core_data *data,
 	return buffering_name;
 }
 
+static void render_audio_source(struct obs_core_audio *audio,
+				obs_source_t *source, uint32_t mixers,
+				size_t channels, size_t sample_rate,
+				size_t audio_size, uint64_t start_ts)
+{
+	obs_source_audio_render(source, mixers, channels, sample_rate,
+				audio_size);
+
+	/* if a source has gone backward in time and we can no
+	 * longer buffer, drop some or all of its audio */
+	if (audio->total_buffering_ticks == MAX_BUFFERING_TICKS &&
+	    source->audio_ts < start_ts) {
+		if (source->info.audio_render) {
+			blog(LOG_DEBUG,
+			     "render audio source %s timestamp has "
+			     "gone backwards",
+			     obs_source_get_name(source));
+
+			/* just avoid further damage */
+			source->audio_pending = true;
+#if DEBUG_AUDIO == 1
+			/* this should really be fixed */
+			assert(false);
+#endif
+		} else {
+			pthread_mutex_lock(&source->audio_buf_mutex);
+			bool rerender = ignore_audio(source, channels,
+						     sample_rate, start_ts);
+			pthread_mutex_unlock(&source->audio_buf_mutex);
+
+			/* if we (potentially) recovered, re-render */
+			if (rerender)
+				obs_source_audio_render(source, mixers,
+							channels, sample_rate,
+							audio_size);
+		}
+	}
+}
+
+struct audio_render_task {
+	struct obs_core_audio *audio;
+	uint32_t mixers;
+	size_t channels;
+	size_t sample_rate;
+	size_t audio_size;
+	uint64_t start_ts;
+};
+
+static void render_audio_source_task(void *param, size_t idx)
+{
+	struct audio_render_task *task = param;
+	struct obs_core_audio *audio = task->audio;
+
+	render_audio_source(audio, audio->parallel_render_order.array[idx],
+			    task->mixers, task->channels, task->sample_rate,
+			    task->audio_size, task->start_ts);
+}
+
+/* sources that only render their own audio do not depend on any other
+ * source in the tree.  sources that mix their children (scenes,
+ * transitions) or submix other audio do, so they stay on the audio thread */
+static inline bool audio_render_independent(const obs_source_t *source)
+{
+	return !source->info.audio_render && !source->info.audio_mix;
+}
+
+static void render_audio_sources_parallel(struct obs_core_audio *audio,
+					  uint32_t mixers, size_t channels,
+					  size_t sample_rate, size_t audio_size,
+					  uint64_t start_ts)
+{
+	struct audio_render_task task = {
+		.audio = audio,
+		.mixers = mixers,
+		.channels = channels,
+		.sample_rate = sample_rate,
+		.audio_size = audio_size,
+		.start_ts = start_ts,
+	};
+
+	da_resize(audio->parallel_render_order, 0);
+
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+		if (audio_render_independent(source))
+			da_push_back(audio->parallel_render_order, &source);
+	}
+
+	/* render all independent sources first */
+	os_task_pool_run(audio->render_pool, render_audio_source_task, &task,
+			 audio->parallel_render_order.num);
+
+	/* then everything that depends on them, in the original order so
+	 * children are always rendered before their parents */
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+		if (!audio_render_independent(source))
+			render_audio_source(audio, source, mixers, channels,
+					    sample_rate, audio_size, start_ts);
+	}
+}
+
 static inline void release_audio_sources(struct obs_core_audio *audio)
 {
 	for (size_t i = 0; i < audio->render_order.num; i++)
@@ -494,42 +601,15 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	/* ------------------------------------------------ */
 	/* render audio data */
-	for (size_t i = 0; i < audio->render_order.num; i++) {
-		obs_source_t *source = audio->render_order.array[i];
-		obs_source_audio_render(source, mixers, channels, sample_rate,
-					audio_size);
-
-		/* if a source has gone backward in time and we can no
-		 * longer buffer, drop some or all of its audio */
-		if (audio->total_buffering_ticks == MAX_BUFFERING_TICKS &&
-		    source->audio_ts < ts.start) {
-			if (source->info.audio_render) {
-				blog(LOG_DEBUG,
-				     "render audio source %s timestamp has "
-				     "gone backwards",
-				     obs_source_get_name(source));
-
-				/* just avoid further damage */
-				source->audio_pending = true;
-#if DEBUG_AUDIO == 1
-				/* this should really be fixed */
-				assert(false);
-#endif
-			} else {
-				pthread_mutex_lock(&source->audio_buf_mutex);
-				bool rerender = ignore_audio(source, channels,
-							     sample_rate,
-							     ts.start);
-				pthread_mutex_unlock(&source->audio_buf_mutex);
-
-				/* if we (potentially) recovered, re-render */
-				if (rerender)
-					obs_source_audio_render(source, mixers,
-								channels,
-								sample_rate,
-								audio_size);
-			}
-		}
+	if (audio->render_pool) {
+		render_audio_sources_parallel(audio, mixers, channels,
+					      sample_rate, audio_size,
+					      ts.start);
+	} else {
+		for (size_t i = 0; i < audio->render_order.num; i++)
+			render_audio_source(audio, audio->render_order.array[i],
+					    mixers, channels, sample_rate,
+					    audio_size, ts.start);
 	}
 
 	/* ------------------------------------------------ */
@@ -546,7 +626,9 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	/* ------------------------------------------------ */
 	/* mix audio */
-	if (!audio->buffering_wait_ticks) {
+	if (!audio->buffering_wait_ticks && mixers) {
+		uint64_t mixed = 0;
+
 		for (size_t i = 0; i < audio->root_nodes.num; i++) {
 			obs_source_t *source = audio->root_nodes.array[i];
 
@@ -556,11 +638,15 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 			pthread_mutex_lock(&source->audio_buf_mutex);
 
 			if (source->audio_output_buf[0][0] && source->audio_ts)
-				mix_audio(mixes, source, channels, sample_rate,
-					  &ts);
+				mixed += mix_audio(mixes, source, mixers,
+						   channels, sample_rate, &ts);
 
 			pthread_mutex_unlock(&source->audio_buf_mutex);
 		}
+
+		pthread_mutex_lock(&audio->mixed_channels_mutex);
+		audio->total_mixed_channels += mixed;
+		pthread_mutex_unlock(&audio->mixed_channels_mutex);
 	}
 
 	/* ------------------------------------------------ */
@@ -42,10 +42,14 @@ struct obs_data_item {
 	size_t capacity;
 };
 
+struct obs_data_index;
+
 struct obs_data {
 	volatile long ref;
 	char *json;
 	struct obs_data_item *first_item;
+	size_t num_items;
+	struct obs_data_index *index;
 };
 
 struct obs_data_array {
@@ -302,12 +306,189 @@ static struct obs_data_item *obs_data_item_create(const char *name,
 	return item;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Item index
+ *
+ *   Items are kept in a singly linked list sorted by name, which is fine for
+ * the usual handful of settings but makes every lookup and insertion a linear
+ * walk.  Once an object has more than a few items, an index is built on first
+ * lookup: a hash table for name lookups, and an array of the items in list
+ * order to find list neighbours (insertion points, previous items) with a
+ * binary search.  The list itself stays the source of truth for iteration and
+ * serialization order. */
+
+#define OBS_DATA_INDEX_THRESHOLD 16
+#define INDEX_TOMBSTONE ((struct obs_data_item *)(uintptr_t)1)
+
+struct obs_data_index {
+	DARRAY(struct obs_data_item *) sorted;
+	struct obs_data_item **table;
+	size_t table_size;
+	size_t table_used;
+};
+
+static inline size_t hash_item_name(const char *name)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+
+	return (size_t)hash;
+}
+
+static struct obs_data_item **index_find_slot(struct obs_data_index *index,
+					      const char *name)
+{
+	size_t mask = index->table_size - 1;
+	size_t pos = hash_item_name(name) & mask;
+
+	for (;;) {
+		struct obs_data_item **slot = &index->table[pos];
+
+		if (!*slot)
+			return NULL;
+		if (*slot != INDEX_TOMBSTONE &&
+		    strcmp(get_item_name(*slot), name) == 0)
+			return slot;
+
+		pos = (pos + 1) & mask;
+	}
+}
+
+static void index_table_insert(struct obs_data_index *index,
+			       struct obs_data_item *item)
+{
+	size_t mask = index->table_size - 1;
+	size_t pos = hash_item_name(get_item_name(item)) & mask;
+
+	while (index->table[pos] && index->table[pos] != INDEX_TOMBSTONE)
+		pos = (pos + 1) & mask;
+
+	if (!index->table[pos])
+		index->table_used++;
+	index->table[pos] = item;
+}
+
+/* rebuilds the hash table from the sorted array, dropping tombstones.  the
+ * table is kept at most half full so probe sequences stay short */
+static void index_rehash(struct obs_data_index *index)
+{
+	size_t size = 64;
+
+	while (size < index->sorted.num * 4)
+		size <<= 1;
+
+	bfree(index->table);
+	index->table = bzalloc(size * sizeof(struct obs_data_item *));
+	index->table_size = size;
+	index->table_used = 0;
+
+	for (size_t i = 0; i < index->sorted.num; i++)
+		index_table_insert(index, index->sorted.array[i]);
+}
+
+/* returns the position of the first item with a name >= name */
+static size_t index_lower_bound(struct obs_data_index *index, const char *name)
+{
+	size_t low = 0;
+	size_t high = index->sorted.num;
+
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+
+		if (strcmp(get_item_name(index->sorted.array[mid]), name) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static size_t index_find_pos(struct obs_data_index *index,
+			     struct obs_data_item *item)
+{
+	size_t pos = index_lower_bound(index, get_item_name(item));
+
+	if (pos < index->sorted.num && index->sorted.array[pos] == item)
+		return pos;
+	return DARRAY_INVALID;
+}
+
+static void obs_data_build_index(struct obs_data *data)
+{
+	struct obs_data_index *index = bzalloc(sizeof(struct obs_data_index));
+	struct obs_data_item *item = data->first_item;
+
+	da_reserve(index->sorted, data->num_items);
+
+	while (item) {
+		da_push_back(index->sorted, &item);
+		item = item->next;
+	}
+
+	index_rehash(index);
+	data->index = index;
+}
+
+static void obs_data_free_index(struct obs_data *data)
+{
+	struct obs_data_index *index = data->index;
+
+	if (index) {
+		da_free(index->sorted);
+		bfree(index->table);
+		bfree(index);
+		data->index = NULL;
+	}
+}
+
+static void index_add_item(struct obs_data_index *index, size_t pos,
+			   struct obs_data_item *item)
+{
+	da_insert(index->sorted, pos, &item);
+
+	if ((index->table_used + 1) * 2 > index->table_size)
+		index_rehash(index);
+	else
+		index_table_insert(index, item);
+}
+
+static void index_remove_item(struct obs_data_index *index, size_t pos)
+{
+	struct obs_data_item *item = index->sorted.array[pos];
+	struct obs_data_item **slot =
+		index_find_slot(index, get_item_name(item));
+
+	if (slot && *slot == item)
+		*slot = INDEX_TOMBSTONE;
+
+	da_erase(index->sorted, pos);
+}
+
+/* ------------------------------------------------------------------------- */
+
 static struct obs_data_item **get_item_prev_next(struct obs_data *data,
 						 struct obs_data_item *current)
 {
 	if (!current || !data)
 		return NULL;
 
+	if (data->index) {
+		struct obs_data_index *index = data->index;
+		size_t pos = index_find_pos(index, current);
+
+		if (pos == DARRAY_INVALID)
+			return NULL;
+
+		return pos ? &index->sorted.array[pos - 1]->next
+			   : &data->first_item;
+	}
+
 	struct obs_data_item **prev_next = &data->first_item;
 	struct obs_data_item *item = data->first_item;
 
@@ -324,12 +505,17 @@ static struct obs_data_item **get_item_prev_next(struct obs_data *data,
 
 static inline void obs_data_item_detach(struct obs_data_item *item)
 {
-	struct obs_data_item **prev_next =
-		get_item_prev_next(item->parent, item);
+	struct obs_data *data = item->parent;
+	struct obs_data_item **prev_next = get_item_prev_next(data, item);
 
 	if (prev_next) {
+		if (data->index)
+			index_remove_item(data->index,
+					  index_find_pos(data->index, item));
+
 		*prev_next = item->next;
 		item->next = NULL;
+		data->num_items--;
 	}
 }
 
@@ -348,14 +534,39 @@ obs_data_item_ensure_capacity(struct obs_data_item *item)
 {
 	size_t new_size = obs_data_item_total_size(item);
 	struct obs_data_item *new_item;
+	struct obs_data_index *index;
+	struct obs_data_item **slot = NULL;
+	size_t pos = DARRAY_INVALID;
 
 	if (item->capacity >= new_size)
 		return item;
 
+	/* the index compares names, so find the item before the old
+	 * allocation goes away */
+	index = item->parent ? item->parent->index : NULL;
+	if (index) {
+		pos = index_find_pos(index, item);
+		if (pos != DARRAY_INVALID)
+			slot = index_find_slot(index, get_item_name(item));
+	}
+
 	new_item = brealloc(item, new_size);
 	new_item->capacity = new_size;
 
-	obs_data_item_reattach(item, new_item);
+	if (pos != DARRAY_INVALID) {
+		struct obs_data_item **prev_next =
+			pos ? &index->sorted.array[pos - 1]->next
+			    : &new_item->parent->first_item;
+
+		if (slot && *slot == item)
+			*slot = new_item;
+		index->sorted.array[pos] = new_item;
+		*prev_next = new_item;
+
+	} else if (!index) {
+		obs_data_item_reattach(item, new_item);
+	}
+
 	return new_item;
 }
 
@@ -706,6 +917,10 @@ static inline void obs_data_destroy(struct obs_data *data)
 {
 	struct obs_data_item *item = data->first_item;
 
+	/* items are released from the front of the list, which doesn't need
+	 * the index */
+	obs_data_free_index(data);
+
 	while (item) {
 		struct obs_data_item *next = item->next;
 		obs_data_item_release(&item);
@@ -869,6 +1084,14 @@ static struct obs_data_item *get_item(struct obs_data *data, const char *name)
 	if (!data)
 		return NULL;
 
+	if (!data->index && data->num_items >= OBS_DATA_INDEX_THRESHOLD)
+		obs_data_build_index(data);
+
+	if (data->index) {
+		struct obs_data_item **slot = index_find_slot(data->index, name);
+		return slot ? *slot : NULL;
+	}
+
 	struct obs_data_item *item = data->first_item;
 
 	while (item) {
@@ -888,7 +1111,28 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item,
 {
 	obs_data_item_t *new_item = NULL;
 
-	if ((!item || !*item) && data) {
+	if ((!item || !*item) && data && data->index) {
+		struct obs_data_index *index = data->index;
+		struct obs_data_item **prev_next;
+		size_t pos;
+
+		new_item = obs_data_item_create(name, ptr, size, type,
+						default_data, autoselect_data);
+		if (!new_item)
+			return;
+
+		pos = index_lower_bound(index, name);
+		prev_next = pos ? &index->sorted.array[pos - 1]->next
+				: &data->first_item;
+
+		new_item->parent = data;
+		new_item->next = *prev_next;
+		*prev_next = new_item;
+
+		index_add_item(index, pos, new_item);
+		data->num_items++;
+
+	} else if ((!item || !*item) && data) {
 		new_item = obs_data_item_create(name, ptr, size, type,
 						default_data, autoselect_data);
 
@@ -916,6 +1160,7 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item,
 
 		obs_data_item_release(&prev);
 		obs_data_item_release(&next);
+		data->num_items++;
 
 	} else if (default_data) {
 		obs_data_item_set_default_data(item, ptr, size, type);
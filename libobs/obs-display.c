@@ -47,6 +47,7 @@ bool obs_display_init(struct obs_display *display,
 	}
 
 	display->enabled = true;
+	display->visible = true;
 	return true;
 }
 
@@ -148,6 +149,7 @@ void obs_display_remove_draw_callback(obs_display_t *display,
 
 	pthread_mutex_lock(&display->draw_callbacks_mutex);
 	da_erase_item(display->draw_callbacks, &data);
+	display->cleared = false;
 	pthread_mutex_unlock(&display->draw_callbacks_mutex);
 }
 
@@ -208,10 +210,20 @@ void render_display(struct obs_display *display)
 
 	/* -------------------------------------------- */
 
-	render_display_begin(display, cx, cy, size_changed);
-
 	pthread_mutex_lock(&display->draw_callbacks_mutex);
 
+	/* nothing draws to this display, so once it has been cleared it stays
+	 * unchanged until it's resized or its background changes */
+	if (!display->draw_callbacks.num && display->cleared && !size_changed) {
+		pthread_mutex_unlock(&display->draw_callbacks_mutex);
+		GS_DEBUG_MARKER_END();
+		return;
+	}
+
+	display->cleared = !display->draw_callbacks.num;
+
+	render_display_begin(display, cx, cy, size_changed);
+
 	for (size_t i = 0; i < display->draw_callbacks.num; i++) {
 		struct draw_callback *callback;
 		callback = display->draw_callbacks.array + i;
@@ -228,10 +240,21 @@ void render_display(struct obs_display *display)
 	gs_present();
 }
 
+/* makes the next render clear the display again */
+static inline void reset_cleared(struct obs_display *display)
+{
+	pthread_mutex_lock(&display->draw_callbacks_mutex);
+	display->cleared = false;
+	pthread_mutex_unlock(&display->draw_callbacks_mutex);
+}
+
 void obs_display_set_enabled(obs_display_t *display, bool enable)
 {
-	if (display)
+	if (display) {
+		if (enable)
+			reset_cleared(display);
 		display->enabled = enable;
+	}
 }
 
 bool obs_display_enabled(obs_display_t *display)
@@ -241,8 +264,82 @@ bool obs_display_enabled(obs_display_t *display)
 
 void obs_display_set_background_color(obs_display_t *display, uint32_t color)
 {
-	if (display)
+	if (display) {
 		display->background_color = color;
+		reset_cleared(display);
+	}
+}
+
+void obs_display_set_visible(obs_display_t *display, bool visible)
+{
+	if (!display)
+		return;
+
+	/* window contents may have been lost while it was hidden */
+	if (visible)
+		reset_cleared(display);
+	os_atomic_set_bool(&display->visible, visible);
+}
+
+bool obs_display_visible(obs_display_t *display)
+{
+	return display ? os_atomic_load_bool(&display->visible) : false;
+}
+
+static inline uint64_t fps_to_interval_ns(double fps)
+{
+	return fps > 0.0 ? (uint64_t)(1000000000.0 / fps) : 0;
+}
+
+static inline double interval_ns_to_fps(uint64_t interval_ns)
+{
+	return interval_ns ? 1000000000.0 / (double)interval_ns : 0.0;
+}
+
+void obs_display_set_fps(obs_display_t *display, double fps)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&obs->data.displays_mutex);
+	display->render_interval_ns = fps_to_interval_ns(fps);
+	pthread_mutex_unlock(&obs->data.displays_mutex);
+}
+
+double obs_display_get_fps(obs_display_t *display)
+{
+	double fps;
+
+	if (!display)
+		return 0.0;
+
+	pthread_mutex_lock(&obs->data.displays_mutex);
+	fps = interval_ns_to_fps(display->render_interval_ns);
+	pthread_mutex_unlock(&obs->data.displays_mutex);
+	return fps;
+}
+
+void obs_set_display_fps(double fps)
+{
+	if (!obs)
+		return;
+
+	pthread_mutex_lock(&obs->data.displays_mutex);
+	obs->data.display_interval_ns = fps_to_interval_ns(fps);
+	pthread_mutex_unlock(&obs->data.displays_mutex);
+}
+
+double obs_get_display_fps(void)
+{
+	double fps;
+
+	if (!obs)
+		return 0.0;
+
+	pthread_mutex_lock(&obs->data.displays_mutex);
+	fps = interval_ns_to_fps(obs->data.display_interval_ns);
+	pthread_mutex_unlock(&obs->data.displays_mutex);
+	return fps;
 }
 
 void obs_display_size(obs_display_t *display, uint32_t *width, uint32_t *height)
@@ -48,6 +48,7 @@ static bool init_encoder(struct obs_encoder *encoder, const char *name,
 	pthread_mutex_init_value(&encoder->callbacks_mutex);
 	pthread_mutex_init_value(&encoder->outputs_mutex);
 	pthread_mutex_init_value(&encoder->pause.mutex);
+	pthread_mutex_init_value(&encoder->audio_encode_mutex);
 
 	if (!obs_context_data_init(&encoder->context, OBS_OBJ_TYPE_ENCODER,
 				   settings, name, hotkey_data, false))
@@ -60,6 +61,8 @@ static bool init_encoder(struct obs_encoder *encoder, const char *name,
 		return false;
 	if (pthread_mutex_init(&encoder->pause.mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&encoder->audio_encode_mutex, NULL) != 0)
+		return false;
 
 	if (encoder->orig_info.get_defaults) {
 		encoder->orig_info.get_defaults(encoder->context.settings);
@@ -137,6 +140,7 @@ obs_encoder_t *obs_audio_encoder_create(const char *id, const char *name,
 
 static void receive_video(void *param, struct video_data *frame);
 static void receive_audio(void *param, size_t mix_idx, struct audio_data *data);
+static void *audio_encode_thread(void *param);
 
 static inline void get_audio_info(const struct obs_encoder *encoder,
 				  struct audio_convert_info *info)
@@ -187,7 +191,75 @@ static inline bool has_scaling(const struct obs_encoder *encoder)
 static inline bool gpu_encode_available(const struct obs_encoder *encoder)
 {
 	return (encoder->info.caps & OBS_ENCODER_CAP_PASS_TEXTURE) != 0 &&
-	       obs->video.using_nv12_tex;
+	       obs->video.using_nv12_tex &&
+	       encoder->media == obs->video.video;
+}
+
+static void join_audio_encode_thread(struct obs_encoder *encoder)
+{
+	if (encoder->audio_encode_thread_initialized) {
+		pthread_join(encoder->audio_encode_thread, NULL);
+		encoder->audio_encode_thread_initialized = false;
+	}
+
+	os_sem_destroy(encoder->audio_encode_sem);
+	encoder->audio_encode_sem = NULL;
+}
+
+static bool start_audio_encode(struct obs_encoder *encoder)
+{
+	/* the thread stops itself on encode errors */
+	join_audio_encode_thread(encoder);
+
+	encoder->audio_encode_stop = false;
+
+	pthread_mutex_lock(&encoder->audio_encode_mutex);
+	encoder->audio_frames_queued = 0;
+	encoder->audio_max_frames_queued = 0;
+	encoder->audio_max_encode_lag_ns = 0;
+	circlebuf_free(&encoder->audio_queued_ts);
+	pthread_mutex_unlock(&encoder->audio_encode_mutex);
+
+	if (os_sem_init(&encoder->audio_encode_sem, 0) != 0)
+		return false;
+	if (pthread_create(&encoder->audio_encode_thread, NULL,
+			   audio_encode_thread, encoder) != 0) {
+		os_sem_destroy(encoder->audio_encode_sem);
+		encoder->audio_encode_sem = NULL;
+		return false;
+	}
+
+	encoder->audio_encode_thread_initialized = true;
+	return true;
+}
+
+static void stop_audio_encode(struct obs_encoder *encoder)
+{
+	size_t max_frames_queued;
+	uint64_t max_encode_lag_ns;
+
+	if (!encoder->audio_encode_thread_initialized)
+		return;
+
+	/* the thread encodes the frames still queued before it exits */
+	os_atomic_set_bool(&encoder->audio_encode_stop, true);
+	os_sem_post(encoder->audio_encode_sem);
+
+	/* joined on the next start if stopping from the thread itself */
+	if (!pthread_equal(pthread_self(), encoder->audio_encode_thread))
+		join_audio_encode_thread(encoder);
+
+	pthread_mutex_lock(&encoder->audio_encode_mutex);
+	max_frames_queued = encoder->audio_max_frames_queued;
+	max_encode_lag_ns = encoder->audio_max_encode_lag_ns;
+	pthread_mutex_unlock(&encoder->audio_encode_mutex);
+
+	if (max_frames_queued > 1)
+		blog(LOG_INFO,
+		     "encoder '%s': up to %zu frames queued for encoding, "
+		     "max lag %.1f ms",
+		     encoder->context.name, max_frames_queued,
+		     (double)max_encode_lag_ns / 1000000.0);
 }
 
 static void add_connection(struct obs_encoder *encoder)
@@ -196,6 +268,14 @@ static void add_connection(struct obs_encoder *encoder)
 		struct audio_convert_info audio_info = {0};
 		get_audio_info(encoder, &audio_info);
 
+		if (!start_audio_encode(encoder)) {
+			blog(LOG_ERROR,
+			     "encoder '%s': Failed to start audio "
+			     "encode thread",
+			     encoder->context.name);
+			return;
+		}
+
 		audio_output_connect(encoder->media, encoder->mixer_idx,
 				     &audio_info, receive_audio, encoder);
 	} else {
@@ -213,15 +293,33 @@ static void add_connection(struct obs_encoder *encoder)
 	set_encoder_active(encoder, true);
 }
 
+static void log_input_stats(struct obs_encoder *encoder)
+{
+	struct video_input_stats stats;
+
+	if (!video_output_get_input_stats(encoder->media, receive_video,
+					  encoder, &stats))
+		return;
+
+	if (stats.skipped_frames)
+		blog(LOG_INFO,
+		     "encoder '%s': %u/%u frames repeated due to "
+		     "encoding lag, max lag %.1f ms",
+		     encoder->context.name, stats.skipped_frames,
+		     stats.total_frames, (double)stats.max_lag_ns / 1000000.0);
+}
+
 static void remove_connection(struct obs_encoder *encoder, bool shutdown)
 {
 	if (encoder->info.type == OBS_ENCODER_AUDIO) {
 		audio_output_disconnect(encoder->media, encoder->mixer_idx,
 					receive_audio, encoder);
+		stop_audio_encode(encoder);
 	} else {
 		if (gpu_encode_available(encoder)) {
 			stop_gpu_encode(encoder);
 		} else {
+			log_input_stats(encoder);
 			stop_raw_video(encoder->media, receive_video, encoder);
 		}
 	}
@@ -259,7 +357,9 @@ static void obs_encoder_actually_destroy(obs_encoder_t *encoder)
 		blog(LOG_DEBUG, "encoder '%s' destroyed",
 		     encoder->context.name);
 
+		join_audio_encode_thread(encoder);
 		free_audio_buffers(encoder);
+		circlebuf_free(&encoder->audio_queued_ts);
 
 		if (encoder->context.data)
 			encoder->info.destroy(encoder->context.data);
@@ -268,6 +368,7 @@ static void obs_encoder_actually_destroy(obs_encoder_t *encoder)
 		pthread_mutex_destroy(&encoder->callbacks_mutex);
 		pthread_mutex_destroy(&encoder->outputs_mutex);
 		pthread_mutex_destroy(&encoder->pause.mutex);
+		pthread_mutex_destroy(&encoder->audio_encode_mutex);
 		obs_context_data_free(&encoder->context);
 		if (encoder->owns_info_id)
 			bfree((void *)encoder->info.id);
@@ -600,6 +701,7 @@ static inline bool obs_encoder_stop_internal(
 	void (*new_packet)(void *param, struct encoder_packet *packet),
 	void *param)
 {
+	bool audio = encoder->info.type == OBS_ENCODER_AUDIO;
 	bool last = false;
 	size_t idx;
 
@@ -607,8 +709,12 @@ static inline bool obs_encoder_stop_internal(
 
 	idx = get_callback_idx(encoder, new_packet, param);
 	if (idx != DARRAY_INVALID) {
-		da_erase(encoder->callbacks, idx);
-		last = (encoder->callbacks.num == 0);
+		last = (encoder->callbacks.num == 1);
+
+		/* the audio encode thread encodes the frames still queued
+		 * when it stops, so keep the last callback until then */
+		if (!last || !audio)
+			da_erase(encoder->callbacks, idx);
 	}
 
 	pthread_mutex_unlock(&encoder->callbacks_mutex);
@@ -617,6 +723,14 @@ static inline bool obs_encoder_stop_internal(
 		remove_connection(encoder, true);
 		encoder->initialized = false;
 
+		if (audio) {
+			pthread_mutex_lock(&encoder->callbacks_mutex);
+			idx = get_callback_idx(encoder, new_packet, param);
+			if (idx != DARRAY_INVALID)
+				da_erase(encoder->callbacks, idx);
+			pthread_mutex_unlock(&encoder->callbacks_mutex);
+		}
+
 		if (encoder->destroy_on_stop) {
 			pthread_mutex_unlock(&encoder->init_mutex);
 			obs_encoder_actually_destroy(encoder);
@@ -925,6 +1039,14 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 	if (!success) {
 		blog(LOG_ERROR, "Error encoding with encoder '%s'",
 		     encoder->context.name);
+
+		/* the audio encode thread is encoding what was left in its
+		 * queue on stop, while the stopping thread holds init_mutex
+		 * and waits for it.  the encoder is stopping anyway. */
+		if (encoder->info.type == OBS_ENCODER_AUDIO &&
+		    os_atomic_load_bool(&encoder->audio_encode_stop))
+			return;
+
 		full_stop(encoder);
 		return;
 	}
@@ -1162,17 +1284,36 @@ fail:
 	return success;
 }
 
-static bool send_audio_data(struct obs_encoder *encoder)
+/* takes the next queued frame, returns false if there is none */
+static bool pop_audio_frame(struct obs_encoder *encoder, uint64_t *queued_ts)
 {
-	struct encoder_frame enc_frame;
+	pthread_mutex_lock(&encoder->audio_encode_mutex);
 
-	memset(&enc_frame, 0, sizeof(struct encoder_frame));
+	if (!encoder->audio_frames_queued) {
+		pthread_mutex_unlock(&encoder->audio_encode_mutex);
+		return false;
+	}
 
-	for (size_t i = 0; i < encoder->planes; i++) {
+	for (size_t i = 0; i < encoder->planes; i++)
 		circlebuf_pop_front(&encoder->audio_input_buffer[i],
 				    encoder->audio_output_buffer[i],
 				    encoder->framesize_bytes);
 
+	circlebuf_pop_front(&encoder->audio_queued_ts, queued_ts,
+			    sizeof(*queued_ts));
+	encoder->audio_frames_queued--;
+
+	pthread_mutex_unlock(&encoder->audio_encode_mutex);
+	return true;
+}
+
+static bool send_audio_data(struct obs_encoder *encoder)
+{
+	struct encoder_frame enc_frame;
+
+	memset(&enc_frame, 0, sizeof(struct encoder_frame));
+
+	for (size_t i = 0; i < encoder->planes; i++) {
 		enc_frame.data[i] = encoder->audio_output_buffer[i];
 		enc_frame.linesize[i] = (uint32_t)encoder->framesize_bytes;
 	}
@@ -1266,6 +1407,9 @@ static void receive_audio(void *param, size_t mix_idx, struct audio_data *in)
 
 	struct obs_encoder *encoder = param;
 	struct audio_data audio = *in;
+	uint64_t ts = os_gettime_ns();
+
+	pthread_mutex_lock(&encoder->audio_encode_mutex);
 
 	if (!encoder->first_received) {
 		encoder->first_raw_ts = audio.timestamp;
@@ -1274,24 +1418,88 @@ static void receive_audio(void *param, size_t mix_idx, struct audio_data *in)
 	}
 
 	if (audio_pause_check(&encoder->pause, &audio, encoder->samplerate))
-		goto end;
+		goto unlock;
 
 	if (!buffer_audio(encoder, &audio))
-		goto end;
+		goto unlock;
 
+	/* hand every whole frame to the encode thread */
 	while (encoder->audio_input_buffer[0].size >=
-	       encoder->framesize_bytes) {
-		if (!send_audio_data(encoder)) {
-			break;
-		}
+	       (encoder->audio_frames_queued + 1) * encoder->framesize_bytes) {
+		circlebuf_push_back(&encoder->audio_queued_ts, &ts, sizeof(ts));
+		encoder->audio_frames_queued++;
+		os_sem_post(encoder->audio_encode_sem);
 	}
 
-	UNUSED_PARAMETER(mix_idx);
+	if (encoder->audio_frames_queued > encoder->audio_max_frames_queued)
+		encoder->audio_max_frames_queued = encoder->audio_frames_queued;
 
-end:
+unlock:
+	pthread_mutex_unlock(&encoder->audio_encode_mutex);
+	UNUSED_PARAMETER(mix_idx);
 	profile_end(receive_audio_name);
 }
 
+static bool encode_audio_frame(struct obs_encoder *encoder,
+			       const char *profile_name, uint64_t queued_ts)
+{
+	uint64_t lag;
+	bool success;
+
+	profile_start(profile_name);
+	success = send_audio_data(encoder);
+	profile_end(profile_name);
+
+	profile_reenable_thread();
+
+	lag = os_gettime_ns() - queued_ts;
+
+	pthread_mutex_lock(&encoder->audio_encode_mutex);
+	if (lag > encoder->audio_max_encode_lag_ns)
+		encoder->audio_max_encode_lag_ns = lag;
+	pthread_mutex_unlock(&encoder->audio_encode_mutex);
+
+	return success;
+}
+
+static void *audio_encode_thread(void *param)
+{
+	struct obs_encoder *encoder = param;
+	uint64_t queued_ts;
+
+	os_set_thread_name("obs: audio encode thread");
+
+	const char *audio_encode_thread_name =
+		profile_store_name(obs_get_profiler_name_store(),
+				   "audio_encode_thread(%s, track %d)",
+				   encoder->context.name,
+				   (int)encoder->mixer_idx + 1);
+
+	while (os_sem_wait(encoder->audio_encode_sem) == 0) {
+		/* the encoder is already disconnected from the audio output
+		 * when stopping, so nothing is queued after this */
+		if (os_atomic_load_bool(&encoder->audio_encode_stop)) {
+			while (pop_audio_frame(encoder, &queued_ts)) {
+				if (!encode_audio_frame(encoder,
+							audio_encode_thread_name,
+							queued_ts))
+					break;
+			}
+			break;
+		}
+
+		if (!pop_audio_frame(encoder, &queued_ts))
+			continue;
+
+		/* encode errors fully stop the encoder */
+		if (!encode_audio_frame(encoder, audio_encode_thread_name,
+					queued_ts))
+			break;
+	}
+
+	return NULL;
+}
+
 void obs_encoder_add_output(struct obs_encoder *encoder,
 			    struct obs_output *output)
 {
@@ -0,0 +1,181 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stdlib.h>
+
+#include "util/darray.h"
+#include "obs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Interleave queue
+ *
+ *   Encoder packets of an output ordered by DTS.  A video packet goes in
+ * front of any queued packets with the same DTS, an audio packet after them.
+ *
+ *   Packets live in array[start, num), so removing packets from the front
+ * only moves the start index.  The insert position is found with a binary
+ * search, and only the packets on the shorter side of that position are
+ * moved.  Packets arrive nearly in order, so that side is usually just a
+ * few packets.
+ */
+
+struct interleave_queue {
+	DARRAY(struct encoder_packet) packets;
+	size_t start;
+};
+
+static inline size_t interleave_queue_count(const struct interleave_queue *q)
+{
+	return q->packets.num - q->start;
+}
+
+static inline struct encoder_packet *
+interleave_queue_get(const struct interleave_queue *q, size_t idx)
+{
+	return q->packets.array + q->start + idx;
+}
+
+/** Index the packet would be inserted at */
+static inline size_t
+interleave_queue_insert_idx(const struct interleave_queue *q,
+			    const struct encoder_packet *packet)
+{
+	bool video = packet->type == OBS_ENCODER_VIDEO;
+	size_t lo = 0;
+	size_t hi = interleave_queue_count(q);
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		int64_t dts_usec = interleave_queue_get(q, mid)->dts_usec;
+
+		if (packet->dts_usec < dts_usec ||
+		    (video && packet->dts_usec == dts_usec))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+static inline void interleave_queue_insert(struct interleave_queue *q,
+					   const struct encoder_packet *packet)
+{
+	size_t idx = interleave_queue_insert_idx(q, packet);
+
+	/* reuse the space left by popped packets if fewer packets have to be
+	 * moved towards the front than towards the back */
+	if (q->start && idx < interleave_queue_count(q) - idx) {
+		struct encoder_packet *front = q->packets.array + q->start;
+
+		memmove(front - 1, front, idx * sizeof(*packet));
+		q->start--;
+		*interleave_queue_get(q, idx) = *packet;
+	} else {
+		da_insert(q->packets, q->start + idx, packet);
+	}
+}
+
+/** Removes the first count packets without releasing them */
+static inline void interleave_queue_pop_front(struct interleave_queue *q,
+					      size_t count)
+{
+	q->start += count;
+
+	if (q->start == q->packets.num) {
+		da_resize(q->packets, 0);
+		q->start = 0;
+
+	} else if (q->start >= 1024 && q->start >= q->packets.num / 2) {
+		/* compact once the unused front outgrows the packets */
+		da_erase_range(q->packets, 0, q->start);
+		q->start = 0;
+	}
+}
+
+struct interleave_sort_item {
+	struct encoder_packet packet;
+	size_t order;
+};
+
+static inline int interleave_sort_compare(const void *a, const void *b)
+{
+	const struct interleave_sort_item *item_a = a;
+	const struct interleave_sort_item *item_b = b;
+	const struct encoder_packet *pa = &item_a->packet;
+	const struct encoder_packet *pb = &item_b->packet;
+	bool video_a = pa->type == OBS_ENCODER_VIDEO;
+	bool video_b = pb->type == OBS_ENCODER_VIDEO;
+
+	if (pa->dts_usec != pb->dts_usec)
+		return pa->dts_usec < pb->dts_usec ? -1 : 1;
+	if (video_a != video_b)
+		return video_a ? -1 : 1;
+	if (item_a->order == item_b->order)
+		return 0;
+
+	/* video packets with equal DTS end up in reverse order, audio
+	 * packets in order */
+	if (video_a)
+		return item_a->order < item_b->order ? 1 : -1;
+	return item_a->order < item_b->order ? -1 : 1;
+}
+
+/**
+ * Restores the order after the DTS values of queued packets were changed.
+ * The result is the same as inserting the packets again one by one in their
+ * current order.
+ */
+static inline void interleave_queue_resort(struct interleave_queue *q)
+{
+	size_t count = interleave_queue_count(q);
+	struct interleave_sort_item *items;
+
+	if (count < 2)
+		return;
+
+	items = bmalloc(count * sizeof(*items));
+
+	for (size_t i = 0; i < count; i++) {
+		items[i].packet = *interleave_queue_get(q, i);
+		items[i].order = i;
+	}
+
+	qsort(items, count, sizeof(*items), interleave_sort_compare);
+
+	for (size_t i = 0; i < count; i++)
+		*interleave_queue_get(q, i) = items[i].packet;
+
+	bfree(items);
+}
+
+/** Frees the queue without releasing the packets */
+static inline void interleave_queue_free(struct interleave_queue *q)
+{
+	da_free(q->packets);
+	q->start = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -24,6 +24,8 @@
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/profiler.h"
+#include "util/task-pool.h"
+#include "util/spsc-queue.h"
 #include "callback/signal.h"
 #include "callback/proc.h"
 
@@ -35,8 +37,10 @@
 #include "media-io/audio-io.h"
 
 #include "obs.h"
+#include "obs-interleave.h"
 
 #include <caption/caption.h>
+#include <limits.h>
 
 #define NUM_TEXTURES 2
 #define NUM_CHANNELS 3
@@ -212,6 +216,13 @@ struct obs_display {
 	pthread_mutex_t draw_info_mutex;
 	DARRAY(struct draw_callback) draw_callbacks;
 
+	/* scheduling state, see render_displays */
+	volatile bool visible;
+	uint64_t render_interval_ns;
+	uint64_t last_render_time;
+	uint64_t last_render_ns;
+	bool cleared;
+
 	struct obs_display *next;
 	struct obs_display **prev_next;
 };
@@ -243,6 +254,73 @@ struct obs_task_info {
 	void *param;
 };
 
+/* a scaled, format-converted copy of the main texture with its own video
+ * output, rendered in the same frame as the main output */
+struct obs_video_rung {
+	struct obs_video_rung_info info;
+	video_t *video;
+
+	gs_texture_t *output_texture;
+	gs_texture_t *convert_textures[NUM_CHANNELS];
+	gs_stagesurf_t *copy_surfaces[NUM_TEXTURES][NUM_CHANNELS];
+	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
+	bool textures_copied[NUM_TEXTURES];
+	bool gpu_conversion;
+	const char *conversion_techs[NUM_CHANNELS];
+	float conversion_width_i;
+	float color_matrix[16];
+
+	/* graphics thread only */
+	bool active;
+	bool was_active;
+	bool frame_ready;
+	struct video_data frame;
+	struct circlebuf vframe_info_buffer;
+	uint64_t frame_time_total_ns;
+	uint64_t frame_time_frames;
+	uint64_t avg_frame_time_ns;
+};
+
+extern bool obs_video_rungs_active(void);
+extern void obs_free_video_rungs(void);
+
+extern bool obs_get_conversion_techs(enum video_format format, uint32_t width,
+				     const char **techs, float *width_i);
+extern void obs_get_color_matrix(float *matrix, enum video_format format,
+				 enum video_colorspace colorspace,
+				 enum video_range_type range);
+
+/* params of the conversion effect, resolved once since they are set every
+ * frame for the output and for every async source */
+struct obs_conversion_params {
+	gs_eparam_t *image[4];
+	gs_eparam_t *width;
+	gs_eparam_t *height;
+	gs_eparam_t *width_d2;
+	gs_eparam_t *height_d2;
+	gs_eparam_t *width_x2_i;
+	gs_eparam_t *width_i;
+	gs_eparam_t *color_vec[3];
+	gs_eparam_t *color_range_min;
+	gs_eparam_t *color_range_max;
+};
+
+#define FRAME_STATS_WINDOW 1024
+#define FRAME_STALL_HISTORY 32
+
+struct obs_frame_stats {
+	pthread_mutex_t mutex;
+
+	/* rolling window of phase times of the most recent frames */
+	uint64_t times[OBS_FRAME_PHASE_COUNT][FRAME_STATS_WINDOW];
+	size_t pos;
+	size_t num;
+
+	struct obs_frame_stall stalls[FRAME_STALL_HISTORY];
+	size_t stall_pos;
+	size_t num_stalls;
+};
+
 struct obs_core_video {
 	graphics_t *graphics;
 	gs_stagesurf_t *copy_surfaces[NUM_TEXTURES][NUM_CHANNELS];
@@ -261,6 +339,7 @@ struct obs_core_video {
 	gs_effect_t *solid_effect;
 	gs_effect_t *repeat_effect;
 	gs_effect_t *conversion_effect;
+	struct obs_conversion_params conversion_params;
 	gs_effect_t *bicubic_effect;
 	gs_effect_t *lanczos_effect;
 	gs_effect_t *area_effect;
@@ -318,6 +397,30 @@ struct obs_core_video {
 
 	pthread_mutex_t task_mutex;
 	struct circlebuf tasks;
+
+	pthread_mutex_t rungs_mutex;
+	DARRAY(struct obs_video_rung *) rungs;
+
+	os_task_pool_t *tick_pool;
+	DARRAY(struct obs_source *) parallel_tick_sources;
+	DARRAY(uint64_t) parallel_tick_times;
+
+	struct obs_frame_stats frame_stats;
+
+	/* the frame being rendered, only used by the graphics thread */
+	uint64_t frame_phase_ns[OBS_FRAME_PHASE_COUNT];
+	uint64_t frame_phase_start;
+	enum obs_frame_phase cur_frame_phase;
+	uint64_t render_child_ns;
+	obs_weak_source_t *slowest_source;
+	enum obs_frame_phase slowest_source_phase;
+	uint64_t slowest_source_ns;
+
+	/* incremented for every change to the video output of a source */
+	volatile long content_epoch;
+
+	/* displays due this frame, only used by the graphics thread */
+	DARRAY(struct obs_display *) due_displays;
 };
 
 struct audio_monitor;
@@ -328,10 +431,15 @@ struct obs_core_audio {
 	DARRAY(struct obs_source *) render_order;
 	DARRAY(struct obs_source *) root_nodes;
 
+	os_task_pool_t *render_pool;
+	DARRAY(struct obs_source *) parallel_render_order;
+
 	uint64_t buffered_ts;
 	struct circlebuf buffered_timestamps;
 	uint64_t buffering_wait_ticks;
 	int total_buffering_ticks;
+	pthread_mutex_t mixed_channels_mutex;
+	uint64_t total_mixed_channels;
 
 	float user_volume;
 
@@ -341,6 +449,15 @@ struct obs_core_audio {
 	char *monitoring_device_id;
 };
 
+/* name -> context lookup table, protected by the mutex of the list the
+ * contexts are linked into */
+struct obs_context_name_table {
+	struct obs_context_data **buckets;
+	size_t num_buckets;
+	size_t count;
+	uint64_t next_order;
+};
+
 /* user sources, output channels, and displays */
 struct obs_core_data {
 	struct obs_source *first_source;
@@ -352,10 +469,15 @@ struct obs_core_data {
 
 	pthread_mutex_t sources_mutex;
 	pthread_mutex_t displays_mutex;
+	uint64_t display_interval_ns;
 	pthread_mutex_t outputs_mutex;
 	pthread_mutex_t encoders_mutex;
 	pthread_mutex_t services_mutex;
 	pthread_mutex_t audio_sources_mutex;
+	struct obs_context_name_table source_names;
+	struct obs_context_name_table output_names;
+	struct obs_context_name_table encoder_names;
+	struct obs_context_name_table service_names;
 	pthread_mutex_t draw_callbacks_mutex;
 	DARRAY(struct draw_callback) draw_callbacks;
 	DARRAY(struct tick_callback) tick_callbacks;
@@ -434,6 +556,11 @@ struct obs_core {
 	struct obs_core_hotkeys hotkeys;
 
 	obs_task_handler_t ui_task_handler;
+
+	int audio_render_threads;
+	int video_tick_threads;
+	char *shader_cache_path;
+	bool video_input_threads;
 };
 
 extern struct obs_core *obs;
@@ -497,6 +624,12 @@ struct obs_context_data {
 	struct obs_context_data *next;
 	struct obs_context_data **prev_next;
 
+	struct obs_context_name_table *name_table;
+	struct obs_context_data *name_next;
+	struct obs_context_data **name_prev_next;
+	uint32_t name_hash;
+	uint64_t name_order;
+
 	bool private;
 };
 
@@ -557,10 +690,21 @@ static inline bool obs_weak_ref_get_ref(struct obs_weak_ref *ref)
 /* ------------------------------------------------------------------------- */
 /* sources  */
 
+#define MAX_ASYNC_FRAMES 30
+/* frames in flight between the output side and the graphics thread */
+#define MAX_ASYNC_CACHE (MAX_ASYNC_FRAMES + 8)
+
+/* pooled async video frame, the frame must stay the first member so that
+ * obs_source_frame_destroy() frees the whole allocation */
 struct async_frame {
-	struct obs_source_frame *frame;
-	long unused_count;
+	struct obs_source_frame frame;
+	uint32_t cache_gen;
 	bool used;
+
+	/* planes owned by the source, see obs_source_output_video_external */
+	bool external;
+	obs_source_frame_release_t release;
+	void *release_param;
 };
 
 enum audio_action_type {
@@ -633,6 +777,10 @@ struct obs_source {
 	/* hint to allow sources to render more quickly */
 	bool texcoords_centered;
 
+	/* global content epoch of the last change to the video output of the
+	 * source, see obs_source_content_changed */
+	volatile long content_epoch;
+
 	/* timing (if video is present, is based upon video) */
 	volatile bool timing_set;
 	volatile uint64_t timing_adjust;
@@ -666,6 +814,7 @@ struct obs_source {
 	pthread_mutex_t audio_mutex;
 	pthread_mutex_t audio_cb_mutex;
 	DARRAY(struct audio_cb_info) audio_cb_list;
+	struct obs_source_levels *audio_levels;
 	struct obs_audio_data audio_data;
 	size_t audio_storage_size;
 	uint32_t audio_mixers;
@@ -694,9 +843,22 @@ struct obs_source {
 	bool async_unbuffered;
 	bool async_decoupled;
 	struct obs_source_frame *async_preload_frame;
-	DARRAY(struct async_frame) async_cache;
 	DARRAY(struct obs_source_frame *) async_frames;
 	pthread_mutex_t async_mutex;
+
+	/* frames travel from the threads calling obs_source_output_video() to
+	 * the graphics thread through async_queue and come back through
+	 * async_free_queue.  Output calls are serialized by
+	 * async_output_mutex, so the output side never takes async_mutex.
+	 * async_cache holds every pooled frame and grows while filters keep
+	 * frames out of circulation, it is guarded by async_cache_mutex. */
+	pthread_mutex_t async_output_mutex;
+	pthread_mutex_t async_cache_mutex;
+	DARRAY(struct async_frame *) async_cache;
+	struct spsc_queue async_queue;
+	struct spsc_queue async_free_queue;
+	uint32_t async_cache_gen;
+	volatile bool async_reset_ts;
 	uint32_t async_width;
 	uint32_t async_height;
 	uint32_t async_cache_width;
@@ -855,6 +1017,45 @@ extern void obs_source_set_texcoords_centered(obs_source_t *source,
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
 extern void obs_source_video_tick(obs_source_t *source, float seconds);
+
+/* obs_source_video_tick split in two: the state part always runs on the
+ * graphics thread, the video_tick callback of sources with
+ * OBS_SOURCE_THREADSAFE_TICK may run on a tick worker */
+extern void obs_source_video_tick_state(obs_source_t *source, float seconds);
+extern void obs_source_video_tick_callback(obs_source_t *source,
+					   float seconds);
+
+/* true if content_epoch was taken after the content epoch since, which can
+ * be compared for as long as the global epoch stays within LONG_MAX of it */
+static inline bool content_changed_since(long content_epoch, long since)
+{
+	unsigned long cur = (unsigned long)os_atomic_load_long(
+		&obs->video.content_epoch);
+	unsigned long age = cur - (unsigned long)since;
+
+	if (age > LONG_MAX)
+		return true;
+	return (unsigned long)content_epoch - (unsigned long)since - 1 < age;
+}
+
+static inline long get_content_epoch(void)
+{
+	return os_atomic_load_long(&obs->video.content_epoch);
+}
+
+/* true if the video output of the source is known not to have changed since
+ * the given content epoch, false if it changed or can change without
+ * obs_source_content_changed being called */
+extern bool obs_source_content_unchanged(obs_source_t *source, long since);
+
+/* in obs-scene.c, the same for the items of a scene */
+extern bool obs_scene_content_unchanged(obs_scene_t *scene, long since);
+
+/* in obs-video.c, records a source tick or render as a candidate for the
+ * slowest source of the frame, graphics thread only */
+extern void obs_frame_stats_add_source(struct obs_source *source,
+				       uint64_t ns);
+
 extern float obs_source_get_target_volume(obs_source_t *source,
 					  obs_source_t *target);
 
@@ -946,7 +1147,7 @@ struct obs_output {
 	pthread_t end_data_capture_thread;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
-	DARRAY(struct encoder_packet) interleaved_packets;
+	struct interleave_queue interleaved_packets;
 	int stop_code;
 
 	int reconnect_retry_sec;
@@ -1094,6 +1295,20 @@ struct obs_encoder {
 	struct circlebuf audio_input_buffer[MAX_AV_PLANES];
 	uint8_t *audio_output_buffer[MAX_AV_PLANES];
 
+	/* audio is encoded on its own thread so that encoding does not hold
+	 * up the audio thread.  receive_audio queues up the whole frames in
+	 * audio_input_buffer, audio_encode_mutex protects the buffer and the
+	 * queue statistics */
+	pthread_t audio_encode_thread;
+	bool audio_encode_thread_initialized;
+	volatile bool audio_encode_stop;
+	os_sem_t *audio_encode_sem;
+	pthread_mutex_t audio_encode_mutex;
+	size_t audio_frames_queued;
+	struct circlebuf audio_queued_ts;
+	size_t audio_max_frames_queued;
+	uint64_t audio_max_encode_lag_ns;
+
 	/* if a video encoder is paired with an audio encoder, make it start
 	 * up at the specific timestamp.  if this is the audio encoder,
 	 * wait_for_video makes it wait until it's ready to sync up with
@@ -165,12 +165,22 @@ fail:
 	return NULL;
 }
 
+static inline size_t num_interleaved(const struct obs_output *output)
+{
+	return interleave_queue_count(&output->interleaved_packets);
+}
+
+static inline struct encoder_packet *
+get_interleaved(const struct obs_output *output, size_t idx)
+{
+	return interleave_queue_get(&output->interleaved_packets, idx);
+}
+
 static inline void free_packets(struct obs_output *output)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++)
-		obs_encoder_packet_release(output->interleaved_packets.array +
-					   i);
-	da_free(output->interleaved_packets);
+	for (size_t i = 0; i < num_interleaved(output); i++)
+		obs_encoder_packet_release(get_interleaved(output, i));
+	interleave_queue_free(&output->interleaved_packets);
 }
 
 static inline void clear_audio_buffers(obs_output_t *output)
@@ -1304,7 +1314,7 @@ double last_caption_timestamp = 0;
 
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	struct encoder_packet out = *get_interleaved(output, 0);
 
 	/* do not send an interleaved packet if there's no packet of the
 	 * opposing type of a higher timestamp in the interleave buffer.
@@ -1312,7 +1322,7 @@ static inline void send_interleaved(struct obs_output *output)
 	if (!has_higher_opposing_ts(output, &out))
 		return;
 
-	da_erase(output->interleaved_packets, 0);
+	interleave_queue_pop_front(&output->interleaved_packets, 1);
 
 	if (out.type == OBS_ENCODER_VIDEO) {
 		output->total_frames++;
@@ -1378,9 +1388,8 @@ static size_t get_interleaved_start_idx(struct obs_output *output)
 	size_t video_idx = DARRAY_INVALID;
 	size_t idx = 0;
 
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
+	for (size_t i = 0; i < num_interleaved(output); i++) {
+		struct encoder_packet *packet = get_interleaved(output, i);
 		int64_t diff;
 
 		if (packet->type != OBS_ENCODER_AUDIO) {
@@ -1416,7 +1425,7 @@ static int prune_premature_packets(struct obs_output *output)
 	}
 
 	max_idx = video_idx;
-	video = &output->interleaved_packets.array[video_idx];
+	video = get_interleaved(output, video_idx);
 	duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
 
 	for (size_t i = 0; i < audio_mixes; i++) {
@@ -1430,7 +1439,7 @@ static int prune_premature_packets(struct obs_output *output)
 			return -1;
 		}
 
-		audio = &output->interleaved_packets.array[audio_idx];
+		audio = get_interleaved(output, audio_idx);
 		if (audio_idx > max_idx)
 			max_idx = audio_idx;
 
@@ -1445,12 +1454,11 @@ static int prune_premature_packets(struct obs_output *output)
 static void discard_to_idx(struct obs_output *output, size_t idx)
 {
 	for (size_t i = 0; i < idx; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
+		struct encoder_packet *packet = get_interleaved(output, i);
 		obs_encoder_packet_release(packet);
 	}
 
-	da_erase_range(output->interleaved_packets, 0, idx);
+	interleave_queue_pop_front(&output->interleaved_packets, idx);
 }
 
 #define DEBUG_STARTING_PACKETS 0
@@ -1462,9 +1470,8 @@ static bool prune_interleaved_packets(struct obs_output *output)
 
 #if DEBUG_STARTING_PACKETS == 1
 	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune_start);
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
+	for (size_t i = 0; i < num_interleaved(output); i++) {
+		struct encoder_packet *packet = get_interleaved(output, i);
 		blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
 		     packet->type == OBS_ENCODER_AUDIO ? "audio" : "video",
 		     (int)packet->track_idx, packet->dts_usec,
@@ -1490,9 +1497,8 @@ static int find_first_packet_type_idx(struct obs_output *output,
 				      enum obs_encoder_type type,
 				      size_t audio_idx)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
+	for (size_t i = 0; i < num_interleaved(output); i++) {
+		struct encoder_packet *packet = get_interleaved(output, i);
 
 		if (packet->type == type) {
 			if (type == OBS_ENCODER_AUDIO &&
@@ -1511,9 +1517,8 @@ static int find_last_packet_type_idx(struct obs_output *output,
 				     enum obs_encoder_type type,
 				     size_t audio_idx)
 {
-	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i - 1];
+	for (size_t i = num_interleaved(output); i > 0; i--) {
+		struct encoder_packet *packet = get_interleaved(output, i - 1);
 
 		if (packet->type == type) {
 			if (type == OBS_ENCODER_AUDIO &&
@@ -1533,7 +1538,7 @@ find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
 		       size_t audio_idx)
 {
 	int idx = find_first_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return (idx != -1) ? get_interleaved(output, idx) : NULL;
 }
 
 static inline struct encoder_packet *
@@ -1541,7 +1546,7 @@ find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
 		      size_t audio_idx)
 {
 	int idx = find_last_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return (idx != -1) ? get_interleaved(output, idx) : NULL;
 }
 
 static bool get_audio_and_video_packets(struct obs_output *output,
@@ -1621,56 +1626,21 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	output->highest_video_ts -= video->dts_usec;
 
 	/* apply new offsets to all existing packet DTS/PTS values */
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
+	for (size_t i = 0; i < num_interleaved(output); i++) {
+		struct encoder_packet *packet = get_interleaved(output, i);
 		apply_interleaved_packet_offset(output, packet);
 	}
 
 	return true;
 }
 
-static inline void insert_interleaved_packet(struct obs_output *output,
-					     struct encoder_packet *out)
-{
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
-
-		if (out->dts_usec == cur_packet->dts_usec &&
-		    out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
-	}
-
-	da_insert(output->interleaved_packets, idx, out);
-}
-
-static void resort_interleaved_packets(struct obs_output *output)
-{
-	DARRAY(struct encoder_packet) old_array;
-
-	old_array.da = output->interleaved_packets.da;
-	memset(&output->interleaved_packets, 0,
-	       sizeof(output->interleaved_packets));
-
-	for (size_t i = 0; i < old_array.num; i++)
-		insert_interleaved_packet(output, &old_array.array[i]);
-
-	da_free(old_array);
-}
-
 static void discard_unused_audio_packets(struct obs_output *output,
 					 int64_t dts_usec)
 {
 	size_t idx = 0;
 
-	for (; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *p =
-			&output->interleaved_packets.array[idx];
+	for (; idx < num_interleaved(output); idx++) {
+		struct encoder_packet *p = get_interleaved(output, idx);
 
 		if (p->dts_usec >= dts_usec)
 			break;
@@ -1717,7 +1687,7 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 	else
 		check_received(output, packet);
 
-	insert_interleaved_packet(output, &out);
+	interleave_queue_insert(&output->interleaved_packets, &out);
 	set_higher_ts(output, &out);
 
 	/* when both video and audio have been received, we're ready
@@ -1726,7 +1696,8 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 		if (!was_started) {
 			if (prune_interleaved_packets(output)) {
 				if (initialize_interleaved_packets(output)) {
-					resort_interleaved_packets(output);
+					interleave_queue_resort(
+						&output->interleaved_packets);
 					send_interleaved(output);
 				}
 			}
@@ -19,6 +19,7 @@
 #include "util/threading.h"
 #include "util/util_uint64.h"
 #include "graphics/math-defs.h"
+#include "media-io/audio-mixing.h"
 #include "obs-scene.h"
 #include "obs-internal.h"
 
@@ -176,6 +177,10 @@ static void scene_destroy(void *data)
 
 	remove_all_items(scene);
 
+	obs_enter_graphics();
+	gs_texrender_destroy(scene->cache);
+	obs_leave_graphics();
+
 	pthread_mutex_destroy(&scene->video_mutex);
 	pthread_mutex_destroy(&scene->audio_mutex);
 	bfree(scene);
@@ -723,21 +728,10 @@ update_transforms_and_prune_sources(obs_scene_t *scene,
 		resize_group(group_sceneitem);
 }
 
-static void scene_video_render(void *data, gs_effect_t *effect)
+static void render_items(struct obs_scene *scene)
 {
-	DARRAY(struct obs_scene_item *) remove_items;
-	struct obs_scene *scene = data;
 	struct obs_scene_item *item;
 
-	da_init(remove_items);
-
-	video_lock(scene);
-
-	if (!scene->is_group) {
-		update_transforms_and_prune_sources(scene, &remove_items.da,
-						    NULL);
-	}
-
 	gs_blend_state_push();
 	gs_reset_blend_state();
 
@@ -751,6 +745,230 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 	}
 
 	gs_blend_state_pop();
+}
+
+/* assumes video lock */
+static bool scene_items_unchanged(struct obs_scene *scene, long since)
+{
+	struct obs_scene_item *item = scene->first_item;
+
+	while (item) {
+		if (transition_active(item->show_transition) ||
+		    transition_active(item->hide_transition))
+			return false;
+		if (item->user_visible &&
+		    !obs_source_content_unchanged(item->source, since))
+			return false;
+
+		item = item->next;
+	}
+
+	return true;
+}
+
+bool obs_scene_content_unchanged(obs_scene_t *scene, long since)
+{
+	bool unchanged;
+
+	video_lock(scene);
+	unchanged = scene_items_unchanged(scene, since);
+	video_unlock(scene);
+	return unchanged;
+}
+
+/* assumes video lock */
+static inline bool scene_unchanged(struct obs_scene *scene, long since)
+{
+	long epoch = os_atomic_load_long(&scene->source->content_epoch);
+
+	return !content_changed_since(epoch, since) &&
+	       scene_items_unchanged(scene, since);
+}
+
+static bool update_cache(struct obs_scene *scene, uint32_t cx, uint32_t cy)
+{
+	struct vec4 clear_color;
+
+	if (!scene->cache)
+		scene->cache = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+	gs_texrender_reset(scene->cache);
+	if (!gs_texrender_begin(scene->cache, cx, cy))
+		return false;
+
+	vec4_zero(&clear_color);
+	gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+	gs_ortho(0.0f, (float)cx, 0.0f, (float)cy, -100.0f, 100.0f);
+
+	render_items(scene);
+
+	gs_texrender_end(scene->cache);
+	return true;
+}
+
+/* the items were rendered over a transparent texture, so the cache is
+ * premultiplied, the same as in render_item_texture */
+static void render_cache(struct obs_scene *scene)
+{
+	gs_texture_t *tex = gs_texrender_get_texture(scene->cache);
+	gs_effect_t *effect = obs->video.default_effect;
+	const bool previous = gs_set_linear_srgb(true);
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	while (gs_effect_loop(effect, "Draw"))
+		obs_source_draw(tex, 0, 0, 0, 0, 0);
+
+	gs_blend_state_pop();
+	gs_set_linear_srgb(previous);
+}
+
+static inline bool cache_size_matches(struct obs_scene *scene, uint32_t cx,
+				      uint32_t cy)
+{
+	gs_texture_t *tex = gs_texrender_get_texture(scene->cache);
+
+	return tex && gs_texture_get_width(tex) == cx &&
+	       gs_texture_get_height(tex) == cy;
+}
+
+static uint32_t scene_getwidth(void *data);
+static uint32_t scene_getheight(void *data);
+
+static inline bool close_to(float val, float target)
+{
+	return fabsf(val - target) < 0.001f;
+}
+
+/* whether a scene pixel lands exactly on a pixel of the render target, so
+ * that drawing the cached texture looks the same as rendering the items */
+static bool drawn_unscaled(void)
+{
+	struct matrix4 world, proj, m;
+	struct gs_rect viewport;
+	float x, y;
+
+	gs_matrix_get(&world);
+	gs_get_projection(&proj);
+	gs_get_viewport(&viewport);
+	matrix4_mul(&m, &world, &proj);
+
+	/* no rotation, skew or perspective */
+	if (!close_to(m.x.y, 0.0f) || !close_to(m.y.x, 0.0f) ||
+	    !close_to(m.x.w, 0.0f) || !close_to(m.y.w, 0.0f) ||
+	    !close_to(m.z.w, 0.0f) || !close_to(m.t.w, 1.0f))
+		return false;
+
+	/* one unit is one pixel of the viewport */
+	if (!close_to(m.x.x * (float)viewport.cx * 0.5f, 1.0f) ||
+	    !close_to(m.y.y * (float)viewport.cy * -0.5f, 1.0f))
+		return false;
+
+	/* and the origin is on a pixel corner */
+	x = (m.t.x + 1.0f) * (float)viewport.cx * 0.5f;
+	y = (1.0f - m.t.y) * (float)viewport.cy * 0.5f;
+	return close_to(x, roundf(x)) && close_to(y, roundf(y));
+}
+
+static inline bool inside_canvas(const struct vec3 *pos, uint32_t cx,
+				 uint32_t cy)
+{
+	return pos->x > -0.001f && pos->y > -0.001f &&
+	       pos->x < (float)cx + 0.001f && pos->y < (float)cy + 0.001f;
+}
+
+/* the cached texture clips items to the canvas, rendering them directly
+ * does not.  assumes video lock */
+static bool items_inside_canvas(struct obs_scene *scene, uint32_t cx,
+				uint32_t cy)
+{
+	struct obs_scene_item *item = scene->first_item;
+
+	for (; item; item = item->next) {
+		float item_cx = (float)calc_cx(item, item->last_width);
+		float item_cy = (float)calc_cy(item, item->last_height);
+		struct vec3 corners[4];
+
+		if (!item->user_visible)
+			continue;
+
+		vec3_set(&corners[0], 0.0f, 0.0f, 0.0f);
+		vec3_set(&corners[1], item_cx, 0.0f, 0.0f);
+		vec3_set(&corners[2], 0.0f, item_cy, 0.0f);
+		vec3_set(&corners[3], item_cx, item_cy, 0.0f);
+
+		for (size_t i = 0; i < 4; i++) {
+			vec3_transform(&corners[i], &corners[i],
+				       &item->draw_transform);
+			if (!inside_canvas(&corners[i], cx, cy))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/* A scene that did not change since its last render is rendered to a texture
+ * once and then drawn from it until anything in it changes.  Scenes that
+ * change every frame, or contain sources that can change without signaling
+ * it, keep being rendered directly so they don't pay for the extra pass.
+ * Scenes that are drawn scaled, or have items outside of their canvas, are
+ * also rendered directly, as the texture would look different.
+ *
+ * assumes video lock */
+static void render_scene(struct obs_scene *scene)
+{
+	uint32_t cx = scene_getwidth(scene);
+	uint32_t cy = scene_getheight(scene);
+	long epoch = get_content_epoch();
+
+	if (!drawn_unscaled() || !items_inside_canvas(scene, cx, cy)) {
+		scene->cache_misses++;
+		render_items(scene);
+		return;
+	}
+
+	if (scene->cache_valid && cache_size_matches(scene, cx, cy) &&
+	    scene_unchanged(scene, scene->cache_epoch)) {
+		scene->cache_hits++;
+		render_cache(scene);
+		return;
+	}
+
+	scene->cache_misses++;
+	scene->cache_valid = false;
+
+	if (scene->render_epoch_valid &&
+	    scene_unchanged(scene, scene->render_epoch) &&
+	    update_cache(scene, cx, cy)) {
+		scene->cache_valid = true;
+		scene->cache_epoch = epoch;
+		render_cache(scene);
+	} else {
+		render_items(scene);
+	}
+
+	scene->render_epoch_valid = true;
+	scene->render_epoch = epoch;
+}
+
+static void scene_video_render(void *data, gs_effect_t *effect)
+{
+	DARRAY(struct obs_scene_item *) remove_items;
+	struct obs_scene *scene = data;
+
+	da_init(remove_items);
+
+	video_lock(scene);
+
+	if (!scene->is_group) {
+		update_transforms_and_prune_sources(scene, &remove_items.da,
+						    NULL);
+		render_scene(scene);
+	} else {
+		render_items(scene);
+	}
 
 	video_unlock(scene);
 
@@ -761,6 +979,20 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+static void scene_hide(void *data)
+{
+	struct obs_scene *scene = data;
+
+	/* don't hold on to the texture of scenes that aren't shown */
+	obs_enter_graphics();
+	video_lock(scene);
+	gs_texrender_destroy(scene->cache);
+	scene->cache = NULL;
+	scene->cache_valid = false;
+	video_unlock(scene);
+	obs_leave_graphics();
+}
+
 static void set_visibility(struct obs_scene_item *item, bool vis)
 {
 	pthread_mutex_lock(&item->actions_mutex);
@@ -1136,27 +1368,16 @@ static void process_all_audio_actions(struct obs_scene_item *item,
 		;
 }
 
-static void mix_audio_with_buf(float *p_out, float *p_in, float *buf_in,
-			       size_t pos, size_t count)
+static inline void mix_audio_with_buf(float *p_out, float *p_in, float *buf_in,
+				      size_t pos, size_t count)
 {
-	register float *out = p_out;
-	register float *buf = buf_in + pos;
-	register float *in = p_in + pos;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++) * *(buf++);
+	audio_mix_add_with_gain(p_out, p_in + pos, buf_in + pos, count);
 }
 
 static inline void mix_audio(float *p_out, float *p_in, size_t pos,
 			     size_t count)
 {
-	register float *out = p_out;
-	register float *in = p_in + pos;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++);
+	audio_mix_add(p_out, p_in + pos, count);
 }
 
 static bool scene_audio_render(void *data, uint64_t *ts_out,
@@ -1287,6 +1508,7 @@ const struct obs_source_info scene_info = {
 	.audio_render = scene_audio_render,
 	.get_width = scene_getwidth,
 	.get_height = scene_getheight,
+	.hide = scene_hide,
 	.load = scene_load,
 	.save = scene_save,
 	.enum_active_sources = scene_enum_active_sources,
@@ -1539,6 +1761,21 @@ obs_source_t *obs_scene_get_source(const obs_scene_t *scene)
 	return scene ? scene->source : NULL;
 }
 
+void obs_scene_get_render_cache_stats(obs_scene_t *scene, uint64_t *hits,
+				      uint64_t *misses)
+{
+	*hits = 0;
+	*misses = 0;
+
+	if (!obs_ptr_valid(scene, "obs_scene_get_render_cache_stats"))
+		return;
+
+	video_lock(scene);
+	*hits = scene->cache_hits;
+	*misses = scene->cache_misses;
+	video_unlock(scene);
+}
+
 obs_scene_t *obs_scene_from_source(const obs_source_t *source)
 {
 	if (!source || strcmp(source->info.id, scene_info.id) != 0)
@@ -2033,6 +2270,9 @@ obs_source_t *obs_sceneitem_get_source(const obs_sceneitem_t *item)
 static void signal_parent(obs_scene_t *parent, const char *command,
 			  calldata_t *params)
 {
+	/* everything signaled to the scene can change how it looks */
+	obs_source_content_changed(parent->source);
+
 	calldata_set_ptr(params, "scene", parent);
 	signal_handler_signal(parent->source->context.signals, command, params);
 }
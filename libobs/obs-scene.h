@@ -101,4 +101,14 @@ struct obs_scene {
 	pthread_mutex_t video_mutex;
 	pthread_mutex_t audio_mutex;
 	struct obs_scene_item *first_item;
+
+	/* render of the items that is reused while nothing in the scene
+	 * changes, see render_scene */
+	gs_texrender_t *cache;
+	bool cache_valid;
+	long cache_epoch;
+	bool render_epoch_valid;
+	long render_epoch;
+	uint64_t cache_hits;
+	uint64_t cache_misses;
 };
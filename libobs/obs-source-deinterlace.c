@@ -476,6 +476,8 @@ void obs_source_set_deinterlace_mode(obs_source_t *source,
 		source->deinterlace_effect = get_effect(mode);
 		obs_leave_graphics();
 	}
+
+	obs_source_content_changed(source);
 }
 
 enum obs_deinterlace_mode
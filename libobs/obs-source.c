@@ -179,6 +179,8 @@ static bool obs_source_init(struct obs_source *source)
 	source->audio_active = true;
 	pthread_mutex_init_value(&source->filter_mutex);
 	pthread_mutex_init_value(&source->async_mutex);
+	pthread_mutex_init_value(&source->async_output_mutex);
+	pthread_mutex_init_value(&source->async_cache_mutex);
 	pthread_mutex_init_value(&source->audio_mutex);
 	pthread_mutex_init_value(&source->audio_buf_mutex);
 	pthread_mutex_init_value(&source->audio_cb_mutex);
@@ -196,6 +198,10 @@ static bool obs_source_init(struct obs_source *source)
 		return false;
 	if (pthread_mutex_init(&source->async_mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&source->async_output_mutex, NULL) != 0)
+		return false;
+	if (pthread_mutex_init(&source->async_cache_mutex, NULL) != 0)
+		return false;
 	if (pthread_mutex_init(&source->caption_cb_mutex, NULL) != 0)
 		return false;
 
@@ -203,6 +209,10 @@ static bool obs_source_init(struct obs_source *source)
 		allocate_audio_output_buffer(source);
 	if (source->info.audio_mix)
 		allocate_audio_mix_buffer(source);
+	if ((source->info.output_flags & OBS_SOURCE_ASYNC) != 0) {
+		spsc_queue_init(&source->async_queue, MAX_ASYNC_CACHE);
+		spsc_queue_init(&source->async_free_queue, MAX_ASYNC_CACHE);
+	}
 
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION) {
 		if (!obs_transition_init(source))
@@ -649,8 +659,14 @@ void obs_source_destroy(struct obs_source *source)
 	obs_hotkey_unregister(source->push_to_mute_key);
 	obs_hotkey_pair_unregister(source->mute_unmute_key);
 
-	for (i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+	for (i = 0; i < source->async_cache.num; i++) {
+		struct async_frame *af = source->async_cache.array[i];
+
+		/* the source already freed any external planes */
+		if (af->external)
+			memset(af->frame.data, 0, sizeof(af->frame.data));
+		obs_source_frame_decref(&af->frame);
+	}
 
 	gs_enter_context(obs->video.graphics);
 	if (source->async_texrender)
@@ -681,8 +697,10 @@ void obs_source_destroy(struct obs_source *source)
 	da_free(source->audio_actions);
 	da_free(source->audio_cb_list);
 	da_free(source->caption_cb_list);
-	da_free(source->async_cache);
 	da_free(source->async_frames);
+	da_free(source->async_cache);
+	spsc_queue_free(&source->async_queue);
+	spsc_queue_free(&source->async_free_queue);
 	da_free(source->filters);
 	pthread_mutex_destroy(&source->filter_mutex);
 	pthread_mutex_destroy(&source->audio_actions_mutex);
@@ -691,6 +709,8 @@ void obs_source_destroy(struct obs_source *source)
 	pthread_mutex_destroy(&source->audio_mutex);
 	pthread_mutex_destroy(&source->caption_cb_mutex);
 	pthread_mutex_destroy(&source->async_mutex);
+	pthread_mutex_destroy(&source->async_output_mutex);
+	pthread_mutex_destroy(&source->async_cache_mutex);
 	obs_data_release(source->private_settings);
 	obs_context_data_free(&source->context);
 
@@ -915,6 +935,7 @@ static void obs_source_deferred_update(obs_source_t *source)
 				    source->context.settings);
 		os_atomic_compare_swap_long(&source->defer_update_count, count,
 					    0);
+		obs_source_content_changed(source);
 	}
 }
 
@@ -1052,6 +1073,7 @@ static void show_source(obs_source_t *source)
 {
 	if (source->context.data && source->info.show)
 		source->info.show(source->context.data);
+	obs_source_content_changed(source);
 	obs_source_dosignal(source, "source_show", "show");
 }
 
@@ -1059,6 +1081,7 @@ static void hide_source(obs_source_t *source)
 {
 	if (source->context.data && source->info.hide)
 		source->info.hide(source->context.data);
+	obs_source_content_changed(source);
 	obs_source_dosignal(source, "source_hide", "hide");
 }
 
@@ -1134,11 +1157,59 @@ static inline struct obs_source_frame *get_closest_frame(obs_source_t *source,
 bool set_async_texture_size(struct obs_source *source,
 			    const struct obs_source_frame *frame);
 
+static const char *async_mutex_wait_name = "async_mutex_wait";
+
+static void drop_async_frames(obs_source_t *source)
+{
+	for (size_t i = 0; i < source->async_frames.num; i++)
+		remove_async_frame(source, source->async_frames.array[i]);
+	da_resize(source->async_frames, 0);
+}
+
+/* moves frames queued by the output thread to async_frames, must be called
+ * with async_mutex locked */
+static void receive_async_frames(obs_source_t *source)
+{
+	struct obs_source_frame *frame;
+
+	if (os_atomic_set_bool(&source->async_reset_ts, false))
+		source->last_frame_ts = 0;
+
+	while ((frame = spsc_queue_pop(&source->async_queue)) != NULL) {
+		struct async_frame *af = (struct async_frame *)frame;
+
+		/* drop frames that were queued before the frame size or
+		 * format changed */
+		if (source->async_frames.num) {
+			struct async_frame *last =
+				(struct async_frame *)source->async_frames
+					.array[source->async_frames.num - 1];
+
+			if (last->cache_gen != af->cache_gen)
+				drop_async_frames(source);
+		}
+
+		/* the graphics thread fell behind or the frames are timed in
+		 * the future, start over rather than letting the queue and
+		 * the frame pool grow */
+		if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
+			drop_async_frames(source);
+			source->last_frame_ts = 0;
+		}
+
+		da_push_back(source->async_frames, &frame);
+	}
+}
+
 static void async_tick(obs_source_t *source)
 {
 	uint64_t sys_time = obs->video.video_time;
 
+	profile_start(async_mutex_wait_name);
 	pthread_mutex_lock(&source->async_mutex);
+	profile_end(async_mutex_wait_name);
+
+	receive_async_frames(source);
 
 	if (deinterlacing_enabled(source)) {
 		deinterlace_process_last_frame(source, sys_time);
@@ -1154,18 +1225,26 @@ static void async_tick(obs_source_t *source)
 	source->last_sys_timestamp = sys_time;
 	pthread_mutex_unlock(&source->async_mutex);
 
-	if (source->cur_async_frame)
+	if (source->cur_async_frame) {
 		source->async_update_texture =
 			set_async_texture_size(source, source->cur_async_frame);
+		obs_source_content_changed(source);
+	}
 }
 
 void obs_source_video_tick(obs_source_t *source, float seconds)
 {
-	bool now_showing, now_active;
-
 	if (!obs_source_valid(source, "obs_source_video_tick"))
 		return;
 
+	obs_source_video_tick_state(source, seconds);
+	obs_source_video_tick_callback(source, seconds);
+}
+
+void obs_source_video_tick_state(obs_source_t *source, float seconds)
+{
+	bool now_showing, now_active;
+
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_tick(source, seconds);
 
@@ -1227,13 +1306,16 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 		source->active = now_active;
 	}
 
-	if (source->context.data && source->info.video_tick)
-		source->info.video_tick(source->context.data, seconds);
-
 	source->async_rendered = false;
 	source->deinterlace_rendered = false;
 }
 
+void obs_source_video_tick_callback(obs_source_t *source, float seconds)
+{
+	if (source->context.data && source->info.video_tick)
+		source->info.video_tick(source->context.data, seconds);
+}
+
 /* unless the value is 3+ hours worth of frames, this won't overflow */
 static inline uint64_t conv_frames_to_time(const size_t sample_rate,
 					   const size_t frames)
@@ -1929,18 +2011,6 @@ static const char *select_conversion_technique(enum video_format format,
 	return NULL;
 }
 
-static inline void set_eparam(gs_effect_t *effect, const char *name, float val)
-{
-	gs_eparam_t *param = gs_effect_get_param_by_name(effect, name);
-	gs_effect_set_float(param, val);
-}
-
-static inline void set_eparami(gs_effect_t *effect, const char *name, int val)
-{
-	gs_eparam_t *param = gs_effect_get_param_by_name(effect, name);
-	gs_effect_set_int(param, val);
-}
-
 static bool update_async_texrender(struct obs_source *source,
 				   const struct obs_source_frame *frame,
 				   gs_texture_t *tex[MAX_AV_PLANES],
@@ -1956,6 +2026,8 @@ static bool update_async_texrender(struct obs_source *source,
 	uint32_t cy = source->async_height;
 
 	gs_effect_t *conv = obs->video.conversion_effect;
+	const struct obs_conversion_params *params =
+		&obs->video.conversion_params;
 	const char *tech_name =
 		select_conversion_technique(frame->format, frame->full_range);
 	gs_technique_t *tech = gs_effect_get_technique(conv, tech_name);
@@ -1968,27 +2040,15 @@ static bool update_async_texrender(struct obs_source *source,
 		gs_technique_begin(tech);
 		gs_technique_begin_pass(tech, 0);
 
-		if (tex[0])
-			gs_effect_set_texture(
-				gs_effect_get_param_by_name(conv, "image"),
-				tex[0]);
-		if (tex[1])
-			gs_effect_set_texture(
-				gs_effect_get_param_by_name(conv, "image1"),
-				tex[1]);
-		if (tex[2])
-			gs_effect_set_texture(
-				gs_effect_get_param_by_name(conv, "image2"),
-				tex[2]);
-		if (tex[3])
-			gs_effect_set_texture(
-				gs_effect_get_param_by_name(conv, "image3"),
-				tex[3]);
-		set_eparam(conv, "width", (float)cx);
-		set_eparam(conv, "height", (float)cy);
-		set_eparam(conv, "width_d2", (float)cx * 0.5f);
-		set_eparam(conv, "height_d2", (float)cy * 0.5f);
-		set_eparam(conv, "width_x2_i", 0.5f / (float)cx);
+		for (size_t i = 0; i < 4; i++) {
+			if (tex[i])
+				gs_effect_set_texture(params->image[i], tex[i]);
+		}
+		gs_effect_set_float(params->width, (float)cx);
+		gs_effect_set_float(params->height, (float)cy);
+		gs_effect_set_float(params->width_d2, (float)cx * 0.5f);
+		gs_effect_set_float(params->height_d2, (float)cy * 0.5f);
+		gs_effect_set_float(params->width_x2_i, 0.5f / (float)cx);
 
 		struct vec4 vec0, vec1, vec2;
 		vec4_set(&vec0, frame->color_matrix[0], frame->color_matrix[1],
@@ -1997,20 +2057,15 @@ static bool update_async_texrender(struct obs_source *source,
 			 frame->color_matrix[6], frame->color_matrix[7]);
 		vec4_set(&vec2, frame->color_matrix[8], frame->color_matrix[9],
 			 frame->color_matrix[10], frame->color_matrix[11]);
-		gs_effect_set_vec4(
-			gs_effect_get_param_by_name(conv, "color_vec0"), &vec0);
-		gs_effect_set_vec4(
-			gs_effect_get_param_by_name(conv, "color_vec1"), &vec1);
-		gs_effect_set_vec4(
-			gs_effect_get_param_by_name(conv, "color_vec2"), &vec2);
+		gs_effect_set_vec4(params->color_vec[0], &vec0);
+		gs_effect_set_vec4(params->color_vec[1], &vec1);
+		gs_effect_set_vec4(params->color_vec[2], &vec2);
 		if (!frame->full_range) {
-			gs_eparam_t *min_param = gs_effect_get_param_by_name(
-				conv, "color_range_min");
-			gs_effect_set_val(min_param, frame->color_range_min,
+			gs_effect_set_val(params->color_range_min,
+					  frame->color_range_min,
 					  sizeof(float) * 3);
-			gs_eparam_t *max_param = gs_effect_get_param_by_name(
-				conv, "color_range_max");
-			gs_effect_set_val(max_param, frame->color_range_max,
+			gs_effect_set_val(params->color_range_max,
+					  frame->color_range_max,
 					  sizeof(float) * 3);
 		}
 
@@ -2335,13 +2390,35 @@ static inline void render_video(obs_source_t *source)
 	GS_DEBUG_MARKER_END();
 }
 
+extern THREAD_LOCAL bool is_graphics_thread;
+
+/* times what the source rendered itself, without the sources it rendered
+ * in turn, for the frame stall attribution */
+static void render_video_timed(obs_source_t *source)
+{
+	struct obs_core_video *video = &obs->video;
+	uint64_t parent_child_ns = video->render_child_ns;
+	uint64_t start = os_gettime_ns();
+	uint64_t elapsed;
+
+	video->render_child_ns = 0;
+	render_video(source);
+	elapsed = os_gettime_ns() - start;
+
+	obs_frame_stats_add_source(source, elapsed - video->render_child_ns);
+	video->render_child_ns = parent_child_ns + elapsed;
+}
+
 void obs_source_video_render(obs_source_t *source)
 {
 	if (!obs_source_valid(source, "obs_source_video_render"))
 		return;
 
 	obs_source_addref(source);
-	render_video(source);
+	if (is_graphics_thread)
+		render_video_timed(source);
+	else
+		render_video(source);
 	obs_source_release(source);
 }
 
@@ -2520,6 +2597,8 @@ void obs_source_filter_add(obs_source_t *source, obs_source_t *filter)
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_content_changed(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -2554,6 +2633,8 @@ static bool obs_source_filter_remove_refless(obs_source_t *source,
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_content_changed(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -2681,8 +2762,10 @@ void obs_source_filter_set_order(obs_source_t *source, obs_source_t *filter,
 	success = move_filter_dir(source, filter, movement);
 	pthread_mutex_unlock(&source->filter_mutex);
 
-	if (success)
+	if (success) {
+		obs_source_content_changed(source);
 		obs_source_dosignal(source, NULL, "reorder_filters");
+	}
 }
 
 obs_data_t *obs_source_get_settings(const obs_source_t *source)
@@ -2836,84 +2919,123 @@ static inline bool async_texture_changed(struct obs_source *source,
 	       source->async_cache_height != frame->height || prev != cur;
 }
 
-static inline void free_async_cache(struct obs_source *source)
+static void free_async_frame(struct obs_source *source, struct async_frame *af)
 {
-	for (size_t i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+	pthread_mutex_lock(&source->async_cache_mutex);
+	da_erase_item(source->async_cache, &af);
+	pthread_mutex_unlock(&source->async_cache_mutex);
 
-	da_resize(source->async_cache, 0);
-	da_resize(source->async_frames, 0);
-	source->cur_async_frame = NULL;
-	source->prev_async_frame = NULL;
+	obs_source_frame_decref(&af->frame);
 }
 
-#define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
-static inline struct obs_source_frame *
-cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+static inline bool is_async_cache_frame(struct obs_source *source,
+					struct obs_source_frame *frame)
 {
-	struct obs_source_frame *new_frame = NULL;
+	struct async_frame *af = (struct async_frame *)frame;
+	size_t idx;
 
-	pthread_mutex_lock(&source->async_mutex);
+	pthread_mutex_lock(&source->async_cache_mutex);
+	idx = da_find(source->async_cache, &af, 0);
+	pthread_mutex_unlock(&source->async_cache_mutex);
+
+	return idx != DARRAY_INVALID;
+}
+
+static void add_async_cache_frame(struct obs_source *source,
+				  struct async_frame *af)
+{
+	pthread_mutex_lock(&source->async_cache_mutex);
+	da_push_back(source->async_cache, &af);
+	pthread_mutex_unlock(&source->async_cache_mutex);
+}
+
+static inline void release_external_frame(struct async_frame *af)
+{
+	if (af->external) {
+		af->release(af->release_param);
+		memset(af->frame.data, 0, sizeof(af->frame.data));
+	}
+}
 
+/* starts a new cache generation when the frame size or format changes */
+static inline void update_async_cache_format(struct obs_source *source,
+					     const struct obs_source_frame *frame)
+{
 	if (async_texture_changed(source, frame)) {
-		free_async_cache(source);
+		source->async_cache_gen++;
 		source->async_cache_width = frame->width;
 		source->async_cache_height = frame->height;
 	}
 
-	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
-		bool available = false;
-		for (size_t i = 0; i < source->async_cache.num; i++) {
-			struct async_frame *af = &source->async_cache.array[i];
-			if (!af->used) {
-				available = true;
-				break;
-			}
-		}
-
-		if (!available) {
-			source->last_frame_ts = 0;
-			pthread_mutex_unlock(&source->async_mutex);
-			return NULL;
-		}
-	}
-
-	const enum video_format format = frame->format;
-	source->async_cache_format = format;
+	source->async_cache_format = frame->format;
 	source->async_cache_full_range = frame->full_range;
+}
+
+/* gets an unused frame of the current size and format from the pool, or
+ * allocates a new one.  Frames of an older size or format are freed as the
+ * graphics thread hands them back.  Must be called with async_output_mutex
+ * locked. */
+static struct async_frame *get_async_frame(struct obs_source *source,
+					   enum video_format format,
+					   uint32_t width, uint32_t height)
+{
+	struct async_frame *af;
 
-	for (size_t i = 0; i < source->async_cache.num; i++) {
-		struct async_frame *af = &source->async_cache.array[i];
-		if (!af->used) {
-			new_frame = af->frame;
-			new_frame->format = format;
-			af->used = true;
-			af->unused_count = 0;
+	while ((af = spsc_queue_pop(&source->async_free_queue)) != NULL) {
+		if (!af->external && af->cache_gen == source->async_cache_gen)
 			break;
-		}
+
+		free_async_frame(source, af);
 	}
 
-	if (!new_frame) {
-		struct async_frame new_af;
+	if (!af) {
+		af = bzalloc(sizeof(struct async_frame));
+		add_async_cache_frame(source, af);
+
+		obs_source_frame_init(&af->frame, format, width, height);
+		af->frame.refs = 1;
+		af->cache_gen = source->async_cache_gen;
+	}
 
-		new_frame = obs_source_frame_create(format, frame->width,
-						    frame->height);
-		new_af.frame = new_frame;
-		new_af.used = true;
-		new_af.unused_count = 0;
-		new_frame->refs = 1;
+	af->frame.format = format;
+	af->used = true;
+	return af;
+}
 
-		da_push_back(source->async_cache, &new_af);
+/* must be called with async_output_mutex locked */
+static inline void queue_async_frame(struct obs_source *source,
+				     struct async_frame *af)
+{
+	/* the graphics thread is not keeping up, drop the frame and resync
+	 * the timestamps once it catches up */
+	if (!spsc_queue_push(&source->async_queue, &af->frame)) {
+		release_external_frame(af);
+		free_async_frame(source, af);
+		os_atomic_set_bool(&source->async_reset_ts, true);
+		return;
 	}
 
-	os_atomic_inc_long(&new_frame->refs);
+	source->async_active = true;
+}
+
+static const char *output_video_name = "obs_source_output_video";
 
-	pthread_mutex_unlock(&source->async_mutex);
+static inline struct obs_source_frame *
+cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+{
+	static const char *copy_name = "copy_frame_data";
+	struct async_frame *af;
+
+	update_async_cache_format(source, frame);
+
+	af = get_async_frame(source, frame->format, frame->width,
+			     frame->height);
 
-	copy_frame_data(new_frame, frame);
+	profile_start(copy_name);
+	copy_frame_data(&af->frame, frame);
+	profile_end(copy_name);
 
-	return new_frame;
+	return &af->frame;
 }
 
 static void
@@ -2925,25 +3047,146 @@ obs_source_output_video_internal(obs_source_t *source,
 
 	if (!frame) {
 		source->async_active = false;
+		obs_source_content_changed(source);
 		return;
 	}
 
+	if (!source->async_queue.items)
+		return;
+
+	profile_start(output_video_name);
+	pthread_mutex_lock(&source->async_output_mutex);
+
 	struct obs_source_frame *output = cache_video(source, frame);
+	queue_async_frame(source, (struct async_frame *)output);
 
-	/* ------------------------------------------- */
-	pthread_mutex_lock(&source->async_mutex);
-	if (output) {
-		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
-			output = NULL;
-		} else {
-			da_push_back(source->async_frames, &output);
-			source->async_active = true;
-		}
+	pthread_mutex_unlock(&source->async_output_mutex);
+	profile_end(output_video_name);
+}
+
+struct obs_source_frame *obs_source_get_async_frame(obs_source_t *source,
+						    enum video_format format,
+						    uint32_t width,
+						    uint32_t height)
+{
+	struct obs_source_frame info = {0};
+	struct async_frame *af;
+
+	if (!obs_source_valid(source, "obs_source_get_async_frame"))
+		return NULL;
+	if (!source->async_queue.items)
+		return NULL;
+
+	/* the range is not known yet, it is checked again on output */
+	info.format = format;
+	info.width = width;
+	info.height = height;
+
+	pthread_mutex_lock(&source->async_output_mutex);
+	info.full_range = source->async_cache_full_range;
+	update_async_cache_format(source, &info);
+
+	af = get_async_frame(source, format, width, height);
+	pthread_mutex_unlock(&source->async_output_mutex);
+
+	return &af->frame;
+}
+
+void obs_source_output_async_frame(obs_source_t *source,
+				   struct obs_source_frame *frame)
+{
+	struct async_frame *af;
+
+	if (!obs_source_valid(source, "obs_source_output_async_frame"))
+		return;
+	if (!obs_ptr_valid(frame, "obs_source_output_async_frame"))
+		return;
+
+	/* frames that did not come from obs_source_get_async_frame belong
+	 * to the caller, copy them like obs_source_output_video does */
+	if (!is_async_cache_frame(source, frame)) {
+		obs_source_output_video(source, frame);
+		return;
 	}
+
+	af = (struct async_frame *)frame;
+
+	profile_start(output_video_name);
+
+	if (!format_is_yuv(frame->format))
+		frame->full_range = true;
+
+	pthread_mutex_lock(&source->async_output_mutex);
+	update_async_cache_format(source, frame);
+	af->cache_gen = source->async_cache_gen;
+	queue_async_frame(source, af);
+	pthread_mutex_unlock(&source->async_output_mutex);
+
+	profile_end(output_video_name);
+}
+
+void obs_source_cancel_async_frame(obs_source_t *source,
+				   struct obs_source_frame *frame)
+{
+	if (!obs_source_valid(source, "obs_source_cancel_async_frame"))
+		return;
+	if (!obs_ptr_valid(frame, "obs_source_cancel_async_frame"))
+		return;
+
+	/* hand the frame back through the free queue so that it is reused
+	 * by the next call to obs_source_get_async_frame */
+	pthread_mutex_lock(&source->async_mutex);
+	remove_async_frame(source, frame);
 	pthread_mutex_unlock(&source->async_mutex);
 }
 
+void obs_source_output_video_external(obs_source_t *source,
+				      const struct obs_source_frame *frame,
+				      obs_source_frame_release_t release,
+				      void *param)
+{
+	struct async_frame *af;
+
+	if (!obs_source_valid(source, "obs_source_output_video_external"))
+		return;
+	if (!obs_ptr_valid(frame, "obs_source_output_video_external"))
+		return;
+	if (!obs_ptr_valid(release, "obs_source_output_video_external"))
+		return;
+
+	if (!source->async_queue.items) {
+		release(param);
+		return;
+	}
+
+	profile_start(output_video_name);
+	pthread_mutex_lock(&source->async_output_mutex);
+
+	/* nothing waits on the pool for external frames, so reclaim
+	 * whatever the graphics thread has handed back here */
+	while ((af = spsc_queue_pop(&source->async_free_queue)) != NULL)
+		free_async_frame(source, af);
+
+	af = bzalloc(sizeof(struct async_frame));
+	af->frame = *frame;
+	af->frame.full_range =
+		format_is_yuv(frame->format) ? frame->full_range : true;
+	af->frame.refs = 1;
+	af->frame.prev_frame = false;
+	af->external = true;
+	af->release = release;
+	af->release_param = param;
+	af->used = true;
+	add_async_cache_frame(source, af);
+
+	update_async_cache_format(source, &af->frame);
+	af->cache_gen = source->async_cache_gen;
+	queue_async_frame(source, af);
+
+	pthread_mutex_unlock(&source->async_output_mutex);
+	profile_end(output_video_name);
+}
+
 void obs_source_output_video(obs_source_t *source,
 			     const struct obs_source_frame *frame)
 {
@@ -3439,18 +3682,29 @@ void obs_source_output_audio(obs_source_t *source,
 	pthread_mutex_unlock(&source->filter_mutex);
 }
 
+/* hands a frame back to the output thread, must be called with async_mutex
+ * locked so that there is only ever one thread pushing to the free queue */
 void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
 {
-	if (frame)
-		frame->prev_frame = false;
+	struct async_frame *af = (struct async_frame *)frame;
 
-	for (size_t i = 0; i < source->async_cache.num; i++) {
-		struct async_frame *f = &source->async_cache.array[i];
+	if (!frame)
+		return;
 
-		if (f->frame == frame) {
-			f->used = false;
-			break;
-		}
+	frame->prev_frame = false;
+
+	/* filters may hand back frames that did not come from the pool */
+	if (!is_async_cache_frame(source, frame))
+		return;
+
+	if (af->used) {
+		af->used = false;
+		release_external_frame(af);
+
+		/* more frames came back than the output side has reclaimed,
+		 * shrink the pool instead */
+		if (!spsc_queue_push(&source->async_free_queue, af))
+			free_async_frame(source, af);
 	}
 }
 
@@ -4333,6 +4587,74 @@ void obs_source_draw(gs_texture_t *texture, int x, int y, uint32_t cx,
 	gs_enable_framebuffer_srgb(previous);
 }
 
+void obs_source_content_changed(obs_source_t *source)
+{
+	long epoch;
+	long cur;
+
+	if (!obs_source_valid(source, "obs_source_content_changed"))
+		return;
+
+	/* only ever move the epoch of the source forward, a change that raced
+	 * with a newer one must not hide it */
+	epoch = os_atomic_inc_long(&obs->video.content_epoch);
+	cur = os_atomic_load_long(&source->content_epoch);
+	while ((long)((unsigned long)epoch - (unsigned long)cur) > 0) {
+		if (os_atomic_compare_exchange_long(&source->content_epoch,
+						    &cur, epoch))
+			break;
+	}
+}
+
+static inline bool content_tracked(const obs_source_t *source)
+{
+	/* sources without video never draw anything */
+	if ((source->info.output_flags & OBS_SOURCE_VIDEO) == 0)
+		return true;
+	if ((source->info.output_flags & OBS_SOURCE_ASYNC) != 0)
+		return !deinterlacing_enabled(source);
+
+	return (source->info.output_flags & OBS_SOURCE_CONTENT_TRACKING) != 0;
+}
+
+bool obs_source_content_unchanged(obs_source_t *source, long since)
+{
+	bool unchanged;
+
+	if (content_changed_since(os_atomic_load_long(&source->content_epoch),
+				  since))
+		return false;
+
+	if (source->info.type == OBS_SOURCE_TYPE_SCENE)
+		unchanged = obs_scene_content_unchanged(source->context.data,
+							since);
+	else
+		unchanged = content_tracked(source);
+
+	if (!unchanged)
+		return false;
+
+	pthread_mutex_lock(&source->filter_mutex);
+
+	for (size_t i = 0; i < source->filters.num; i++) {
+		obs_source_t *filter = source->filters.array[i];
+		long epoch = os_atomic_load_long(&filter->content_epoch);
+
+		/* disabled filters are not rendered, but turning one off
+		 * still changed the output */
+		if (filter->enabled
+			    ? !obs_source_content_unchanged(filter, since)
+			    : content_changed_since(epoch, since)) {
+			unchanged = false;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&source->filter_mutex);
+
+	return unchanged;
+}
+
 void obs_source_inc_showing(obs_source_t *source)
 {
 	if (obs_source_valid(source, "obs_source_inc_showing"))
@@ -4433,6 +4755,9 @@ void obs_source_set_enabled(obs_source_t *source, bool enabled)
 		return;
 
 	source->enabled = enabled;
+	obs_source_content_changed(source);
+	if (source->filter_parent)
+		obs_source_content_changed(source->filter_parent);
 
 	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "source", source);
@@ -4886,8 +5211,11 @@ static inline void process_audio_source_tick(obs_source_t *source,
 			mix_and_val = 1;
 		}
 
-		if ((source->audio_mixers & mix_and_val) == 0 ||
-		    (mixers & mix_and_val) == 0) {
+		/* inactive mixes are never read, so don't touch them */
+		if ((mixers & mix_and_val) == 0)
+			continue;
+
+		if ((source->audio_mixers & mix_and_val) == 0) {
 			memset(source->audio_output_buf[mix][0], 0,
 			       size * channels);
 			continue;
@@ -4903,7 +5231,7 @@ static inline void process_audio_source_tick(obs_source_t *source,
 		return;
 	}
 
-	if ((source->audio_mixers & 1) == 0 || (mixers & 1) == 0)
+	if ((source->audio_mixers & 1) == 0 && (mixers & 1) != 0)
 		memset(source->audio_output_buf[0][0], 0, size * channels);
 
 	apply_audio_volume(source, mixers, channels, sample_rate);
@@ -5363,6 +5691,8 @@ void obs_source_restore_filters(obs_source_t *source, obs_data_array_t *array)
 	da_move(source->filters, new_filters);
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_content_changed(source);
+
 	/* release filters */
 	for (size_t i = 0; i < cur_filters.num; i++) {
 		obs_source_t *filter = cur_filters.array[i];
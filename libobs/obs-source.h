@@ -196,6 +196,20 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_SRGB (1 << 15)
 
+/**
+ * Source's video_tick can be called from a worker thread, at the same time as
+ * the video_tick of other sources.  It must not touch other sources, and must
+ * use obs_enter_graphics for any graphics calls.
+ */
+#define OBS_SOURCE_THREADSAFE_TICK (1 << 16)
+
+/**
+ * Source calls obs_source_content_changed whenever its video output changes,
+ * other than through an update of its settings.  Scenes only made of such
+ * sources reuse their previous render while nothing changes.
+ */
+#define OBS_SOURCE_CONTENT_TRACKING (1 << 17)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent,
@@ -0,0 +1,254 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs.h"
+#include "obs-internal.h"
+
+static bool rung_format_valid(enum video_format format)
+{
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_NV12:
+	case VIDEO_FORMAT_I444:
+	case VIDEO_FORMAT_RGBA:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* gets the size and texture format of a plane of the converted output */
+static bool rung_plane_info(const struct obs_video_rung_info *info,
+			    size_t plane, uint32_t *width, uint32_t *height,
+			    enum gs_color_format *color_format)
+{
+	*width = info->width;
+	*height = info->height;
+	*color_format = GS_R8;
+
+	switch (info->format) {
+	case VIDEO_FORMAT_I420:
+		if (plane > 0) {
+			*width /= 2;
+			*height /= 2;
+		}
+		return plane < 3;
+	case VIDEO_FORMAT_NV12:
+		if (plane > 0) {
+			*width /= 2;
+			*height /= 2;
+			*color_format = GS_R8G8;
+		}
+		return plane < 2;
+	case VIDEO_FORMAT_I444:
+		return plane < 3;
+	default:
+		*color_format = GS_RGBA;
+		return plane < 1;
+	}
+}
+
+static bool init_rung_textures(struct obs_video_rung *rung)
+{
+	const struct obs_video_rung_info *info = &rung->info;
+	uint32_t width, height;
+	enum gs_color_format color_format;
+
+	rung->output_texture = gs_texture_create(info->width, info->height,
+						 GS_RGBA, 1, NULL,
+						 GS_RENDER_TARGET);
+	if (!rung->output_texture)
+		return false;
+
+	for (size_t c = 0; c < NUM_CHANNELS; c++) {
+		if (!rung_plane_info(info, c, &width, &height, &color_format))
+			break;
+
+		if (rung->gpu_conversion) {
+			rung->convert_textures[c] = gs_texture_create(
+				width, height, color_format, 1, NULL,
+				GS_RENDER_TARGET);
+			if (!rung->convert_textures[c])
+				return false;
+		}
+
+		for (size_t i = 0; i < NUM_TEXTURES; i++) {
+			rung->copy_surfaces[i][c] = gs_stagesurface_create(
+				width, height, color_format);
+			if (!rung->copy_surfaces[i][c])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static void free_rung(struct obs_video_rung *rung)
+{
+	video_output_close(rung->video);
+
+	obs_enter_graphics();
+
+	for (size_t c = 0; c < NUM_CHANNELS; c++) {
+		if (rung->mapped_surfaces[c])
+			gs_stagesurface_unmap(rung->mapped_surfaces[c]);
+	}
+
+	for (size_t i = 0; i < NUM_TEXTURES; i++) {
+		for (size_t c = 0; c < NUM_CHANNELS; c++)
+			gs_stagesurface_destroy(rung->copy_surfaces[i][c]);
+	}
+
+	for (size_t c = 0; c < NUM_CHANNELS; c++)
+		gs_texture_destroy(rung->convert_textures[c]);
+
+	gs_texture_destroy(rung->output_texture);
+
+	obs_leave_graphics();
+
+	circlebuf_free(&rung->vframe_info_buffer);
+	bfree(rung);
+}
+
+obs_video_rung_t *obs_video_rung_create(const struct obs_video_rung_info *info)
+{
+	struct obs_core_video *video = &obs->video;
+	struct obs_video_rung *rung;
+	struct video_output_info vi;
+	bool success;
+
+	if (!obs_ptr_valid(info, "obs_video_rung_create"))
+		return NULL;
+	if (!video->video)
+		return NULL;
+
+	if (!rung_format_valid(info->format)) {
+		blog(LOG_ERROR,
+		     "obs_video_rung_create: Unsupported format '%s'",
+		     get_video_format_name(info->format));
+		return NULL;
+	}
+
+	rung = bzalloc(sizeof(struct obs_video_rung));
+	rung->info = *info;
+	rung->info.width &= 0xFFFFFFFC;
+	rung->info.height &= 0xFFFFFFFE;
+
+	vi = *video_output_get_info(video->video);
+	vi.name = "video rung";
+	vi.format = rung->info.format;
+	vi.width = rung->info.width;
+	vi.height = rung->info.height;
+	vi.colorspace = rung->info.colorspace;
+	vi.range = rung->info.range;
+
+	if (video_output_open(&rung->video, &vi) != VIDEO_OUTPUT_SUCCESS) {
+		blog(LOG_ERROR, "obs_video_rung_create: Could not open video "
+				"output");
+		bfree(rung);
+		return NULL;
+	}
+
+	rung->gpu_conversion = obs_get_conversion_techs(
+		rung->info.format, rung->info.width, rung->conversion_techs,
+		&rung->conversion_width_i);
+	obs_get_color_matrix(rung->color_matrix, rung->info.format,
+			     rung->info.colorspace, rung->info.range);
+
+	obs_enter_graphics();
+	success = init_rung_textures(rung);
+	obs_leave_graphics();
+
+	if (!success) {
+		blog(LOG_ERROR, "obs_video_rung_create: Failed to create "
+				"textures");
+		free_rung(rung);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&video->rungs_mutex);
+	da_push_back(video->rungs, &rung);
+	pthread_mutex_unlock(&video->rungs_mutex);
+
+	blog(LOG_INFO, "Added output ladder rung %ux%u (%s)", rung->info.width,
+	     rung->info.height, get_video_format_name(rung->info.format));
+	return rung;
+}
+
+void obs_video_rung_destroy(obs_video_rung_t *rung)
+{
+	struct obs_core_video *video = &obs->video;
+
+	if (!rung)
+		return;
+
+	/* the graphics thread only uses rungs with the mutex held */
+	pthread_mutex_lock(&video->rungs_mutex);
+	da_erase_item(video->rungs, &rung);
+	pthread_mutex_unlock(&video->rungs_mutex);
+
+	free_rung(rung);
+}
+
+video_t *obs_video_rung_get_video(const obs_video_rung_t *rung)
+{
+	return rung ? rung->video : NULL;
+}
+
+void obs_video_rung_get_info(const obs_video_rung_t *rung,
+			     struct obs_video_rung_info *info)
+{
+	if (rung && info)
+		*info = rung->info;
+}
+
+uint64_t obs_video_rung_get_avg_frame_time_ns(const obs_video_rung_t *rung)
+{
+	return rung ? rung->avg_frame_time_ns : 0;
+}
+
+bool obs_video_rungs_active(void)
+{
+	struct obs_core_video *video = &obs->video;
+	bool active = false;
+
+	pthread_mutex_lock(&video->rungs_mutex);
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		if (video_output_active(video->rungs.array[i]->video)) {
+			active = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&video->rungs_mutex);
+
+	return active;
+}
+
+void obs_free_video_rungs(void)
+{
+	struct obs_core_video *video = &obs->video;
+
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+
+		blog(LOG_WARNING, "Output ladder rung %ux%u was not destroyed",
+		     rung->info.width, rung->info.height);
+		free_rung(rung);
+	}
+
+	da_free(video->rungs);
+}
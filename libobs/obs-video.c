@@ -29,9 +29,28 @@
 #include <windows.h>
 #endif
 
+static void tick_source_task(void *param, size_t idx)
+{
+	struct obs_core_video *video = &obs->video;
+	float seconds = *(float *)param;
+	uint64_t start = os_gettime_ns();
+
+	obs_source_video_tick_callback(video->parallel_tick_sources.array[idx],
+				       seconds);
+
+	video->parallel_tick_times.array[idx] = os_gettime_ns() - start;
+}
+
+static inline bool tick_parallel(const struct obs_source *source)
+{
+	return obs->video.tick_pool &&
+	       (source->info.output_flags & OBS_SOURCE_THREADSAFE_TICK) != 0;
+}
+
 static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 {
 	struct obs_core_data *data = &obs->data;
+	struct obs_core_video *video = &obs->video;
 	struct obs_source *source;
 	uint64_t delta_time;
 	float seconds;
@@ -66,22 +85,93 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 		struct obs_source *cur_source = obs_source_get_ref(source);
 		source = (struct obs_source *)source->context.next;
 
-		if (cur_source) {
+		if (!cur_source)
+			continue;
+
+		if (tick_parallel(cur_source)) {
+			/* keep the reference until the workers are done */
+			obs_source_video_tick_state(cur_source, seconds);
+			da_push_back(video->parallel_tick_sources, &cur_source);
+		} else {
+			uint64_t start = os_gettime_ns();
 			obs_source_video_tick(cur_source, seconds);
+			obs_frame_stats_add_source(cur_source,
+						   os_gettime_ns() - start);
 			obs_source_release(cur_source);
 		}
 	}
 
 	pthread_mutex_unlock(&data->sources_mutex);
 
+	/* ------------------------------------- */
+	/* call the thread-safe ticks on workers */
+
+	da_resize(video->parallel_tick_times,
+		  video->parallel_tick_sources.num);
+	os_task_pool_run(video->tick_pool, tick_source_task, &seconds,
+			 video->parallel_tick_sources.num);
+
+	for (size_t i = 0; i < video->parallel_tick_sources.num; i++) {
+		struct obs_source *cur_source =
+			video->parallel_tick_sources.array[i];
+
+		obs_frame_stats_add_source(cur_source,
+					   video->parallel_tick_times.array[i]);
+		obs_source_release(cur_source);
+	}
+	da_resize(video->parallel_tick_sources, 0);
+
 	return cur_time;
 }
 
 /* in obs-display.c */
 extern void render_display(struct obs_display *display);
 
-static inline void render_displays(void)
+/* a display that keeps missing the frame budget is still rendered at least
+ * this often, so previews never freeze entirely */
+#define DISPLAY_MAX_DEFER_NS 250000000ULL
+
+static inline uint64_t display_interval(const struct obs_display *display)
+{
+	return display->render_interval_ns ? display->render_interval_ns
+					   : obs->data.display_interval_ns;
+}
+
+static inline bool display_due(const struct obs_display *display,
+			       uint64_t now, uint64_t frame_interval)
+{
+	uint64_t interval = display_interval(display);
+
+	if (!display->enabled || !os_atomic_load_bool(&display->visible))
+		return false;
+
+	/* frame_start jitters, so allow half a frame of slack, otherwise a
+	 * display running at half the output rate would skip every third
+	 * frame instead of every second one */
+	return now - display->last_render_time + frame_interval / 2 >= interval;
+}
+
+static int cmp_display_last_render(const void *a, const void *b)
+{
+	const struct obs_display *da = *(struct obs_display *const *)a;
+	const struct obs_display *db = *(struct obs_display *const *)b;
+
+	if (da->last_render_time == db->last_render_time)
+		return 0;
+	return da->last_render_time < db->last_render_time ? -1 : 1;
+}
+
+/* Displays are rendered after the output frame and share its frame budget.
+ * Only displays that are enabled, visible and due at their own rate are
+ * considered, longest waiting first, and a display with its own rate is
+ * deferred to a later frame if its last render time would push the graphics
+ * thread past the next output frame.  Displays without a rate are rendered
+ * every output frame. */
+static inline void render_displays(uint64_t frame_start,
+				   uint64_t frame_interval)
 {
+	struct obs_core_video *video = &obs->video;
+	uint64_t deadline = frame_start + frame_interval;
 	struct obs_display *display;
 
 	if (!obs->data.valid)
@@ -92,12 +182,37 @@ static inline void render_displays(void)
 	/* render extra displays/swaps */
 	pthread_mutex_lock(&obs->data.displays_mutex);
 
+	uint64_t now = os_gettime_ns();
+
+	da_resize(video->due_displays, 0);
+
 	display = obs->data.first_display;
 	while (display) {
-		render_display(display);
+		if (display_due(display, now, frame_interval))
+			da_push_back(video->due_displays, &display);
 		display = display->next;
 	}
 
+	qsort(video->due_displays.array, video->due_displays.num,
+	      sizeof(struct obs_display *), cmp_display_last_render);
+
+	for (size_t i = 0; i < video->due_displays.num; i++) {
+		display = video->due_displays.array[i];
+
+		bool overdue = !display_interval(display) ||
+			       now - display->last_render_time >=
+				       DISPLAY_MAX_DEFER_NS;
+		if (!overdue && now + display->last_render_ns > deadline)
+			continue;
+
+		render_display(display);
+
+		uint64_t end = os_gettime_ns();
+		display->last_render_time = now;
+		display->last_render_ns = end - now;
+		now = end;
+	}
+
 	pthread_mutex_unlock(&obs->data.displays_mutex);
 
 	gs_leave_context();
@@ -158,13 +273,14 @@ static inline void render_main_texture(struct obs_core_video *video)
 }
 
 static inline gs_effect_t *
-get_scale_effect_internal(struct obs_core_video *video)
+get_scale_effect_internal(struct obs_core_video *video, uint32_t width,
+			  uint32_t height)
 {
 	/* if the dimension is under half the size of the original image,
 	 * bicubic/lanczos can't sample enough pixels to create an accurate
 	 * image, so use the bilinear low resolution effect instead */
-	if (video->output_width < (video->base_width / 2) &&
-	    video->output_height < (video->base_height / 2)) {
+	if (width < (video->base_width / 2) &&
+	    height < (video->base_height / 2)) {
 		return video->bilinear_lowres_effect;
 	}
 
@@ -199,7 +315,8 @@ static inline gs_effect_t *get_scale_effect(struct obs_core_video *video,
 	} else {
 		/* if the scale method couldn't be loaded, use either bicubic
 		 * or bilinear by default */
-		gs_effect_t *effect = get_scale_effect_internal(video);
+		gs_effect_t *effect =
+			get_scale_effect_internal(video, width, height);
 		if (!effect)
 			effect = !!video->bicubic_effect
 					 ? video->bicubic_effect
@@ -208,18 +325,20 @@ static inline gs_effect_t *get_scale_effect(struct obs_core_video *video,
 	}
 }
 
-static const char *render_output_texture_name = "render_output_texture";
-static inline gs_texture_t *render_output_texture(struct obs_core_video *video)
+/* scales the main texture to the target, returns the main texture itself if
+ * it does not need to be scaled */
+static gs_texture_t *scale_main_texture(struct obs_core_video *video,
+					gs_texture_t *target,
+					enum video_format format)
 {
 	gs_texture_t *texture = video->render_texture;
-	gs_texture_t *target = video->output_texture;
 	uint32_t width = gs_texture_get_width(target);
 	uint32_t height = gs_texture_get_height(target);
 
 	gs_effect_t *effect = get_scale_effect(video, width, height);
 	gs_technique_t *tech;
 
-	if (video->ovi.output_format == VIDEO_FORMAT_RGBA) {
+	if (format == VIDEO_FORMAT_RGBA) {
 		tech = gs_effect_get_technique(effect, "DrawAlphaDivide");
 	} else {
 		if ((effect == video->default_effect) &&
@@ -230,8 +349,6 @@ static inline gs_texture_t *render_output_texture(struct obs_core_video *video)
 		tech = gs_effect_get_technique(effect, "Draw");
 	}
 
-	profile_start(render_output_texture_name);
-
 	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
 	gs_eparam_t *bres =
 		gs_effect_get_param_by_name(effect, "base_dimension");
@@ -270,9 +387,20 @@ static inline gs_texture_t *render_output_texture(struct obs_core_video *video)
 	gs_enable_blending(true);
 	gs_enable_framebuffer_srgb(false);
 
+	return target;
+}
+
+static const char *render_output_texture_name = "render_output_texture";
+static inline gs_texture_t *render_output_texture(struct obs_core_video *video)
+{
+	gs_texture_t *texture;
+
+	profile_start(render_output_texture_name);
+	texture = scale_main_texture(video, video->output_texture,
+				     video->ovi.output_format);
 	profile_end(render_output_texture_name);
 
-	return target;
+	return texture;
 }
 
 static void render_convert_plane(gs_effect_t *effect, gs_texture_t *target,
@@ -295,60 +423,69 @@ static void render_convert_plane(gs_effect_t *effect, gs_texture_t *target,
 	gs_technique_end(tech);
 }
 
-static const char *render_convert_texture_name = "render_convert_texture";
-static void render_convert_texture(struct obs_core_video *video,
-				   gs_texture_t *texture)
+static void convert_texture(gs_texture_t *texture,
+			    gs_texture_t *const *convert_textures,
+			    const char *const *conversion_techs,
+			    const float *color_matrix, float conversion_width_i)
 {
-	profile_start(render_convert_texture_name);
-
-	gs_effect_t *effect = video->conversion_effect;
-	gs_eparam_t *color_vec0 =
-		gs_effect_get_param_by_name(effect, "color_vec0");
-	gs_eparam_t *color_vec1 =
-		gs_effect_get_param_by_name(effect, "color_vec1");
-	gs_eparam_t *color_vec2 =
-		gs_effect_get_param_by_name(effect, "color_vec2");
-	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
-	gs_eparam_t *width_i = gs_effect_get_param_by_name(effect, "width_i");
+	gs_effect_t *effect = obs->video.conversion_effect;
+	const struct obs_conversion_params *params =
+		&obs->video.conversion_params;
+	gs_eparam_t *color_vec0 = params->color_vec[0];
+	gs_eparam_t *color_vec1 = params->color_vec[1];
+	gs_eparam_t *color_vec2 = params->color_vec[2];
+	gs_eparam_t *image = params->image[0];
+	gs_eparam_t *width_i = params->width_i;
 
 	struct vec4 vec0, vec1, vec2;
-	vec4_set(&vec0, video->color_matrix[4], video->color_matrix[5],
-		 video->color_matrix[6], video->color_matrix[7]);
-	vec4_set(&vec1, video->color_matrix[0], video->color_matrix[1],
-		 video->color_matrix[2], video->color_matrix[3]);
-	vec4_set(&vec2, video->color_matrix[8], video->color_matrix[9],
-		 video->color_matrix[10], video->color_matrix[11]);
+	vec4_set(&vec0, color_matrix[4], color_matrix[5], color_matrix[6],
+		 color_matrix[7]);
+	vec4_set(&vec1, color_matrix[0], color_matrix[1], color_matrix[2],
+		 color_matrix[3]);
+	vec4_set(&vec2, color_matrix[8], color_matrix[9], color_matrix[10],
+		 color_matrix[11]);
 
 	gs_enable_blending(false);
 
-	if (video->convert_textures[0]) {
+	if (convert_textures[0]) {
 		gs_effect_set_texture(image, texture);
 		gs_effect_set_vec4(color_vec0, &vec0);
-		render_convert_plane(effect, video->convert_textures[0],
-				     video->conversion_techs[0]);
+		render_convert_plane(effect, convert_textures[0],
+				     conversion_techs[0]);
 
-		if (video->convert_textures[1]) {
+		if (convert_textures[1]) {
 			gs_effect_set_texture(image, texture);
 			gs_effect_set_vec4(color_vec1, &vec1);
-			if (!video->convert_textures[2])
+			if (!convert_textures[2])
 				gs_effect_set_vec4(color_vec2, &vec2);
-			gs_effect_set_float(width_i, video->conversion_width_i);
-			render_convert_plane(effect, video->convert_textures[1],
-					     video->conversion_techs[1]);
+			gs_effect_set_float(width_i, conversion_width_i);
+			render_convert_plane(effect, convert_textures[1],
+					     conversion_techs[1]);
 
-			if (video->convert_textures[2]) {
+			if (convert_textures[2]) {
 				gs_effect_set_texture(image, texture);
 				gs_effect_set_vec4(color_vec2, &vec2);
 				gs_effect_set_float(width_i,
-						    video->conversion_width_i);
-				render_convert_plane(
-					effect, video->convert_textures[2],
-					video->conversion_techs[2]);
+						    conversion_width_i);
+				render_convert_plane(effect,
+						     convert_textures[2],
+						     conversion_techs[2]);
 			}
 		}
 	}
 
 	gs_enable_blending(true);
+}
+
+static const char *render_convert_texture_name = "render_convert_texture";
+static void render_convert_texture(struct obs_core_video *video,
+				   gs_texture_t *texture)
+{
+	profile_start(render_convert_texture_name);
+
+	convert_texture(texture, video->convert_textures,
+			video->conversion_techs, video->color_matrix,
+			video->conversion_width_i);
 
 	video->texture_converted = true;
 
@@ -384,6 +521,66 @@ static inline void stage_output_texture(struct obs_core_video *video,
 	profile_end(stage_output_texture_name);
 }
 
+static inline void unmap_rung_surfaces(struct obs_video_rung *rung)
+{
+	for (int c = 0; c < NUM_CHANNELS; ++c) {
+		if (rung->mapped_surfaces[c]) {
+			gs_stagesurface_unmap(rung->mapped_surfaces[c]);
+			rung->mapped_surfaces[c] = NULL;
+		}
+	}
+}
+
+static void render_rung(struct obs_core_video *video,
+			struct obs_video_rung *rung, int cur_texture)
+{
+	gs_texture_t *texture = scale_main_texture(video, rung->output_texture,
+						   rung->info.format);
+
+	unmap_rung_surfaces(rung);
+
+	if (rung->gpu_conversion) {
+		convert_texture(texture, rung->convert_textures,
+				rung->conversion_techs, rung->color_matrix,
+				rung->conversion_width_i);
+
+		for (int c = 0; c < NUM_CHANNELS; c++) {
+			gs_stagesurf_t *copy =
+				rung->copy_surfaces[cur_texture][c];
+			if (copy)
+				gs_stage_texture(copy,
+						 rung->convert_textures[c]);
+		}
+	} else {
+		gs_stage_texture(rung->copy_surfaces[cur_texture][0], texture);
+	}
+
+	rung->textures_copied[cur_texture] = true;
+}
+
+static const char *render_video_rungs_name = "render_video_rungs";
+static void render_video_rungs(struct obs_core_video *video, int cur_texture)
+{
+	if (!video->rungs.num)
+		return;
+
+	profile_start(render_video_rungs_name);
+
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+		uint64_t start;
+
+		if (!rung->active)
+			continue;
+
+		start = os_gettime_ns();
+		render_rung(video, rung, cur_texture);
+		rung->frame_time_total_ns += os_gettime_ns() - start;
+	}
+
+	profile_end(render_video_rungs_name);
+}
+
 #ifdef _WIN32
 static inline bool queue_frame(struct obs_core_video *video, bool raw_active,
 			       struct obs_vframe_info *vframe_info)
@@ -509,32 +706,61 @@ static inline void render_video(struct obs_core_video *video, bool raw_active,
 			stage_output_texture(video, cur_texture);
 	}
 
+	render_video_rungs(video, cur_texture);
+
 	gs_set_render_target(NULL, NULL);
 	gs_enable_blending(true);
 
 	gs_end_scene();
 }
 
-static inline bool download_frame(struct obs_core_video *video,
-				  int prev_texture, struct video_data *frame)
+static bool map_copy_surfaces(gs_stagesurf_t *const *copy_surfaces,
+			      gs_stagesurf_t **mapped_surfaces,
+			      struct video_data *frame)
 {
-	if (!video->textures_copied[prev_texture])
-		return false;
-
 	for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
-		gs_stagesurf_t *surface =
-			video->copy_surfaces[prev_texture][channel];
+		gs_stagesurf_t *surface = copy_surfaces[channel];
 		if (surface) {
 			if (!gs_stagesurface_map(surface, &frame->data[channel],
 						 &frame->linesize[channel]))
 				return false;
 
-			video->mapped_surfaces[channel] = surface;
+			mapped_surfaces[channel] = surface;
 		}
 	}
 	return true;
 }
 
+static inline bool download_frame(struct obs_core_video *video,
+				  int prev_texture, struct video_data *frame)
+{
+	if (!video->textures_copied[prev_texture])
+		return false;
+
+	return map_copy_surfaces(video->copy_surfaces[prev_texture],
+				 video->mapped_surfaces, frame);
+}
+
+static void download_rung_frames(struct obs_core_video *video,
+				 int prev_texture)
+{
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+		uint64_t start;
+
+		rung->frame_ready = false;
+		if (!rung->active || !rung->textures_copied[prev_texture])
+			continue;
+
+		start = os_gettime_ns();
+		memset(&rung->frame, 0, sizeof(rung->frame));
+		rung->frame_ready = map_copy_surfaces(
+			rung->copy_surfaces[prev_texture],
+			rung->mapped_surfaces, &rung->frame);
+		rung->frame_time_total_ns += os_gettime_ns() - start;
+	}
+}
+
 static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
 					      uint32_t linesize_input,
 					      uint32_t linesize_output,
@@ -555,12 +781,12 @@ static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
 	return in;
 }
 
-static void set_gpu_converted_data(struct obs_core_video *video,
+static void set_gpu_converted_data(bool using_nv12_tex,
 				   struct video_frame *output,
 				   const struct video_data *input,
 				   const struct video_output_info *info)
 {
-	if (video->using_nv12_tex) {
+	if (using_nv12_tex) {
 		const uint32_t width = info->width;
 		const uint32_t height = info->height;
 
@@ -686,26 +912,81 @@ static inline void copy_rgbx_frame(struct video_frame *output,
 	}
 }
 
-static inline void output_video_data(struct obs_core_video *video,
+static inline void output_video_data(video_t *output, bool gpu_conversion,
+				     bool using_nv12_tex,
 				     struct video_data *input_frame, int count)
 {
 	const struct video_output_info *info;
 	struct video_frame output_frame;
 	bool locked;
 
-	info = video_output_get_info(video->video);
+	info = video_output_get_info(output);
 
-	locked = video_output_lock_frame(video->video, &output_frame, count,
+	locked = video_output_lock_frame(output, &output_frame, count,
 					 input_frame->timestamp);
 	if (locked) {
-		if (video->gpu_conversion) {
-			set_gpu_converted_data(video, &output_frame,
+		if (gpu_conversion) {
+			set_gpu_converted_data(using_nv12_tex, &output_frame,
 					       input_frame, info);
 		} else {
 			copy_rgbx_frame(&output_frame, input_frame, info);
 		}
 
-		video_output_unlock_frame(video->video);
+		video_output_unlock_frame(output);
+	}
+}
+
+static void output_rung_frames(struct obs_core_video *video)
+{
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+		struct obs_vframe_info vframe_info;
+		uint64_t start;
+
+		if (!rung->active)
+			continue;
+
+		if (rung->frame_ready) {
+			start = os_gettime_ns();
+			circlebuf_pop_front(&rung->vframe_info_buffer,
+					    &vframe_info, sizeof(vframe_info));
+
+			rung->frame.timestamp = vframe_info.timestamp;
+			output_video_data(rung->video, rung->gpu_conversion,
+					  false, &rung->frame,
+					  vframe_info.count);
+			rung->frame_time_total_ns += os_gettime_ns() - start;
+		}
+
+		/* averaged over a second, like obs_get_average_frame_time_ns */
+		rung->frame_time_frames++;
+		if (rung->frame_time_frames * video->video_frame_interval_ns >=
+		    1000000000ULL) {
+			rung->avg_frame_time_ns = rung->frame_time_total_ns /
+						  rung->frame_time_frames;
+			rung->frame_time_total_ns = 0;
+			rung->frame_time_frames = 0;
+		}
+	}
+}
+
+static void update_rungs_active(struct obs_core_video *video)
+{
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+
+		rung->active = video_output_active(rung->video);
+		if (rung->active && !rung->was_active) {
+			memset(rung->textures_copied, 0,
+			       sizeof(rung->textures_copied));
+			circlebuf_free(&rung->vframe_info_buffer);
+			rung->frame_time_total_ns = 0;
+			rung->frame_time_frames = 0;
+		} else if (!rung->active) {
+			rung->avg_frame_time_ns = 0;
+		}
+
+		rung->was_active = rung->active;
 	}
 }
 
@@ -738,6 +1019,135 @@ static inline void video_sleep(struct obs_core_video *video, bool raw_active,
 	if (gpu_active)
 		circlebuf_push_back(&video->vframe_info_buffer_gpu,
 				    &vframe_info, sizeof(vframe_info));
+
+	pthread_mutex_lock(&video->rungs_mutex);
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+		if (rung->active)
+			circlebuf_push_back(&rung->vframe_info_buffer,
+					    &vframe_info, sizeof(vframe_info));
+	}
+	pthread_mutex_unlock(&video->rungs_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+/* frame phase timings                                                       */
+
+static inline void end_frame_phase(struct obs_core_video *video)
+{
+	if (video->frame_phase_start) {
+		uint64_t elapsed = os_gettime_ns() - video->frame_phase_start;
+		video->frame_phase_ns[video->cur_frame_phase] += elapsed;
+		video->frame_phase_start = 0;
+	}
+}
+
+static inline void begin_frame_phase(struct obs_core_video *video,
+				     enum obs_frame_phase phase)
+{
+	end_frame_phase(video);
+
+	video->cur_frame_phase = phase;
+	video->frame_phase_start = os_gettime_ns();
+}
+
+void obs_frame_stats_add_source(struct obs_source *source, uint64_t ns)
+{
+	struct obs_core_video *video = &obs->video;
+
+	if (ns <= video->slowest_source_ns)
+		return;
+
+	obs_weak_source_release(video->slowest_source);
+	video->slowest_source = obs_source_get_weak_source(source);
+	video->slowest_source_phase = video->cur_frame_phase;
+	video->slowest_source_ns = ns;
+}
+
+static void add_frame_stall(struct obs_core_video *video,
+			    struct obs_frame_stall *stall, uint64_t timestamp,
+			    int lagged)
+{
+	obs_source_t *source;
+
+	source = obs_weak_source_get_source(video->slowest_source);
+
+	memset(stall, 0, sizeof(*stall));
+	stall->timestamp = timestamp;
+	stall->lagged_frames = (uint32_t)lagged;
+
+	for (size_t i = 0; i < OBS_FRAME_PHASE_TOTAL; i++) {
+		if (video->frame_phase_ns[i] > stall->phase_ns) {
+			stall->phase = (enum obs_frame_phase)i;
+			stall->phase_ns = video->frame_phase_ns[i];
+		}
+	}
+
+	if (source) {
+		snprintf(stall->source_name, sizeof(stall->source_name), "%s",
+			 obs_source_get_name(source));
+		stall->source_phase = video->slowest_source_phase;
+		stall->source_ns = video->slowest_source_ns;
+		obs_source_release(source);
+	}
+}
+
+static void record_frame_stats(struct obs_core_video *video,
+			       uint64_t timestamp, int lagged)
+{
+	struct obs_frame_stats *stats = &video->frame_stats;
+	struct obs_frame_stall stall;
+
+	/* the stall is filled in outside of the lock, because releasing the
+	 * source can destroy it */
+	if (lagged > 0)
+		add_frame_stall(video, &stall, timestamp, lagged);
+
+	pthread_mutex_lock(&stats->mutex);
+
+	for (size_t i = 0; i < OBS_FRAME_PHASE_COUNT; i++)
+		stats->times[i][stats->pos] = video->frame_phase_ns[i];
+	stats->pos = (stats->pos + 1) % FRAME_STATS_WINDOW;
+	if (stats->num < FRAME_STATS_WINDOW)
+		stats->num++;
+
+	if (lagged > 0) {
+		stats->stalls[stats->stall_pos] = stall;
+		stats->stall_pos = (stats->stall_pos + 1) % FRAME_STALL_HISTORY;
+		if (stats->num_stalls < FRAME_STALL_HISTORY)
+			stats->num_stalls++;
+	}
+
+	pthread_mutex_unlock(&stats->mutex);
+
+	obs_weak_source_release(video->slowest_source);
+	video->slowest_source = NULL;
+	video->slowest_source_ns = 0;
+	video->render_child_ns = 0;
+	memset(video->frame_phase_ns, 0, sizeof(video->frame_phase_ns));
+}
+
+static void log_frame_stats(void)
+{
+	struct obs_frame_phase_stats stats;
+
+	if (!obs_get_frame_phase_stats(OBS_FRAME_PHASE_TOTAL, &stats))
+		return;
+
+	blog(LOG_INFO, "Frame times over the last %" PRIu32 " frames:",
+	     stats.frames);
+
+	for (size_t i = 0; i < OBS_FRAME_PHASE_COUNT; i++) {
+		enum obs_frame_phase phase = (enum obs_frame_phase)i;
+
+		obs_get_frame_phase_stats(phase, &stats);
+		blog(LOG_INFO,
+		     "\t%-16s p50=%.3f ms, p95=%.3f ms, p99=%.3f ms, "
+		     "max=%.3f ms",
+		     obs_frame_phase_name(phase), stats.p50_ns / 1000000.0,
+		     stats.p95_ns / 1000000.0, stats.p99_ns / 1000000.0,
+		     stats.max_ns / 1000000.0);
+	}
 }
 
 static const char *output_frame_gs_context_name = "gs_context(video->graphics)";
@@ -756,9 +1166,13 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 
 	memset(&frame, 0, sizeof(struct video_data));
 
+	pthread_mutex_lock(&video->rungs_mutex);
+	update_rungs_active(video);
+
 	profile_start(output_frame_gs_context_name);
 	gs_enter_context(video->graphics);
 
+	begin_frame_phase(video, OBS_FRAME_PHASE_RENDER_VIDEO);
 	profile_start(output_frame_render_video_name);
 	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_RENDER_VIDEO,
 			      output_frame_render_video_name);
@@ -766,15 +1180,20 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 	GS_DEBUG_MARKER_END();
 	profile_end(output_frame_render_video_name);
 
+	begin_frame_phase(video, OBS_FRAME_PHASE_DOWNLOAD_FRAME);
 	if (raw_active) {
 		profile_start(output_frame_download_frame_name);
 		frame_ready = download_frame(video, prev_texture, &frame);
 		profile_end(output_frame_download_frame_name);
 	}
 
+	download_rung_frames(video, prev_texture);
+
+	begin_frame_phase(video, OBS_FRAME_PHASE_GS_FLUSH);
 	profile_start(output_frame_gs_flush_name);
 	gs_flush();
 	profile_end(output_frame_gs_flush_name);
+	end_frame_phase(video);
 
 	gs_leave_context();
 	profile_end(output_frame_gs_context_name);
@@ -786,10 +1205,15 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 
 		frame.timestamp = vframe_info.timestamp;
 		profile_start(output_frame_output_video_data_name);
-		output_video_data(video, &frame, vframe_info.count);
+		output_video_data(video->video, video->gpu_conversion,
+				  video->using_nv12_tex, &frame,
+				  vframe_info.count);
 		profile_end(output_frame_output_video_data_name);
 	}
 
+	output_rung_frames(video);
+	pthread_mutex_unlock(&video->rungs_mutex);
+
 	if (++video->cur_texture == NUM_TEXTURES)
 		video->cur_texture = 0;
 }
@@ -930,6 +1354,7 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 
 	uint64_t frame_start = os_gettime_ns();
 	uint64_t frame_time_ns;
+	uint32_t lagged_frames;
 	bool raw_active = obs->video.raw_active > 0;
 #ifdef _WIN32
 	const bool gpu_active = obs->video.gpu_encoder_active > 0;
@@ -958,12 +1383,15 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	gs_begin_frame();
 	gs_leave_context();
 
+	begin_frame_phase(&obs->video, OBS_FRAME_PHASE_TICK_SOURCES);
 	profile_start(tick_sources_name);
 	context->last_time =
 		tick_sources(obs->video.video_time, context->last_time);
 	profile_end(tick_sources_name);
 
+	begin_frame_phase(&obs->video, OBS_FRAME_PHASE_GRAPHICS_TASKS);
 	execute_graphics_tasks();
+	end_frame_phase(&obs->video);
 
 #ifdef _WIN32
 	MSG msg;
@@ -977,18 +1405,25 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	output_frame(raw_active, gpu_active);
 	profile_end(output_frame_name);
 
+	begin_frame_phase(&obs->video, OBS_FRAME_PHASE_RENDER_DISPLAYS);
 	profile_start(render_displays_name);
-	render_displays();
+	render_displays(frame_start, context->interval);
 	profile_end(render_displays_name);
+	end_frame_phase(&obs->video);
 
 	frame_time_ns = os_gettime_ns() - frame_start;
+	obs->video.frame_phase_ns[OBS_FRAME_PHASE_TOTAL] = frame_time_ns;
 
 	profile_end(context->video_thread_name);
 
 	profile_reenable_thread();
 
+	lagged_frames = obs->video.lagged_frames;
 	video_sleep(&obs->video, raw_active, gpu_active, &obs->video.video_time,
 		    context->interval);
+	lagged_frames = obs->video.lagged_frames - lagged_frames;
+
+	record_frame_stats(&obs->video, frame_start, (int)lagged_frames);
 
 	context->frame_time_total_ns += frame_time_ns;
 	context->fps_total_ns += (obs->video.video_time - context->last_time);
@@ -1053,6 +1488,8 @@ void *obs_graphics_thread(void *param)
 #endif
 		;
 
+	log_frame_stats();
+
 #ifdef _WIN32
 	uninit_winrt_state(&winrt);
 #endif
@@ -42,37 +42,43 @@ static inline void make_video_info(struct video_output_info *vi,
 	vi->cache_size = 6;
 }
 
-static inline void calc_gpu_conversion_sizes(const struct obs_video_info *ovi)
+bool obs_get_conversion_techs(enum video_format format, uint32_t width,
+			      const char **techs, float *width_i)
 {
-	struct obs_core_video *video = &obs->video;
-
-	video->conversion_needed = false;
-	video->conversion_techs[0] = NULL;
-	video->conversion_techs[1] = NULL;
-	video->conversion_techs[2] = NULL;
-	video->conversion_width_i = 0.f;
+	techs[0] = NULL;
+	techs[1] = NULL;
+	techs[2] = NULL;
+	*width_i = 0.f;
 
-	switch ((uint32_t)ovi->output_format) {
+	switch ((uint32_t)format) {
 	case VIDEO_FORMAT_I420:
-		video->conversion_needed = true;
-		video->conversion_techs[0] = "Planar_Y";
-		video->conversion_techs[1] = "Planar_U_Left";
-		video->conversion_techs[2] = "Planar_V_Left";
-		video->conversion_width_i = 1.f / (float)ovi->output_width;
-		break;
+		techs[0] = "Planar_Y";
+		techs[1] = "Planar_U_Left";
+		techs[2] = "Planar_V_Left";
+		*width_i = 1.f / (float)width;
+		return true;
 	case VIDEO_FORMAT_NV12:
-		video->conversion_needed = true;
-		video->conversion_techs[0] = "NV12_Y";
-		video->conversion_techs[1] = "NV12_UV";
-		video->conversion_width_i = 1.f / (float)ovi->output_width;
-		break;
+		techs[0] = "NV12_Y";
+		techs[1] = "NV12_UV";
+		*width_i = 1.f / (float)width;
+		return true;
 	case VIDEO_FORMAT_I444:
-		video->conversion_needed = true;
-		video->conversion_techs[0] = "Planar_Y";
-		video->conversion_techs[1] = "Planar_U";
-		video->conversion_techs[2] = "Planar_V";
-		break;
+		techs[0] = "Planar_Y";
+		techs[1] = "Planar_U";
+		techs[2] = "Planar_V";
+		return true;
 	}
+
+	return false;
+}
+
+static inline void calc_gpu_conversion_sizes(const struct obs_video_info *ovi)
+{
+	struct obs_core_video *video = &obs->video;
+
+	video->conversion_needed = obs_get_conversion_techs(
+		ovi->output_format, ovi->output_width, video->conversion_techs,
+		&video->conversion_width_i);
 }
 
 static bool obs_init_gpu_conversion(struct obs_video_info *ovi)
@@ -258,6 +264,33 @@ gs_effect_t *obs_load_effect(gs_effect_t **effect, const char *file)
 	return *effect;
 }
 
+static void get_conversion_params(struct obs_conversion_params *params,
+				  gs_effect_t *effect)
+{
+	static const char *image_names[4] = {"image", "image1", "image2",
+					     "image3"};
+	static const char *color_vec_names[3] = {"color_vec0", "color_vec1",
+						 "color_vec2"};
+
+	for (size_t i = 0; i < 4; i++)
+		params->image[i] =
+			gs_effect_get_param_by_name(effect, image_names[i]);
+	for (size_t i = 0; i < 3; i++)
+		params->color_vec[i] =
+			gs_effect_get_param_by_name(effect, color_vec_names[i]);
+
+	params->width = gs_effect_get_param_by_name(effect, "width");
+	params->height = gs_effect_get_param_by_name(effect, "height");
+	params->width_d2 = gs_effect_get_param_by_name(effect, "width_d2");
+	params->height_d2 = gs_effect_get_param_by_name(effect, "height_d2");
+	params->width_x2_i = gs_effect_get_param_by_name(effect, "width_x2_i");
+	params->width_i = gs_effect_get_param_by_name(effect, "width_i");
+	params->color_range_min =
+		gs_effect_get_param_by_name(effect, "color_range_min");
+	params->color_range_max =
+		gs_effect_get_param_by_name(effect, "color_range_max");
+}
+
 static int obs_init_graphics(struct obs_video_info *ovi)
 {
 	struct obs_core_video *video = &obs->video;
@@ -282,6 +315,9 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 
 	gs_enter_context(video->graphics);
 
+	if (obs->shader_cache_path)
+		gs_set_shader_cache_path(obs->shader_cache_path);
+
 	char *filename = obs_find_data_file("default.effect");
 	video->default_effect = gs_effect_create_from_file(filename, NULL);
 	bfree(filename);
@@ -308,6 +344,8 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 	filename = obs_find_data_file("format_conversion.effect");
 	video->conversion_effect = gs_effect_create_from_file(filename, NULL);
 	bfree(filename);
+	get_conversion_params(&video->conversion_params,
+			      video->conversion_effect);
 
 	filename = obs_find_data_file("bicubic_scale.effect");
 	video->bicubic_effect = gs_effect_create_from_file(filename, NULL);
@@ -360,15 +398,16 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 	return success ? OBS_VIDEO_SUCCESS : OBS_VIDEO_FAIL;
 }
 
-static inline void set_video_matrix(struct obs_core_video *video,
-				    struct obs_video_info *ovi)
+void obs_get_color_matrix(float *matrix, enum video_format format,
+			  enum video_colorspace colorspace,
+			  enum video_range_type range)
 {
 	struct matrix4 mat;
 	struct vec4 r_row;
 
-	if (format_is_yuv(ovi->output_format)) {
-		video_format_get_parameters(ovi->colorspace, ovi->range,
-					    (float *)&mat, NULL, NULL);
+	if (format_is_yuv(format)) {
+		video_format_get_parameters(colorspace, range, (float *)&mat,
+					    NULL, NULL);
 		matrix4_inv(&mat, &mat);
 
 		/* swap R and G */
@@ -379,7 +418,14 @@ static inline void set_video_matrix(struct obs_core_video *video,
 		matrix4_identity(&mat);
 	}
 
-	memcpy(video->color_matrix, &mat, sizeof(float) * 16);
+	memcpy(matrix, &mat, sizeof(float) * 16);
+}
+
+static inline void set_video_matrix(struct obs_core_video *video,
+				    struct obs_video_info *ovi)
+{
+	obs_get_color_matrix(video->color_matrix, ovi->output_format,
+			     ovi->colorspace, ovi->range);
 }
 
 static int obs_init_video(struct obs_video_info *ovi)
@@ -389,6 +435,7 @@ static int obs_init_video(struct obs_video_info *ovi)
 	int errorcode;
 
 	make_video_info(&vi, ovi);
+	vi.threaded_inputs = obs->video_input_threads;
 	video->base_width = ovi->base_width;
 	video->base_height = ovi->base_height;
 	video->output_width = ovi->output_width;
@@ -423,6 +470,18 @@ static int obs_init_video(struct obs_video_info *ovi)
 		return OBS_VIDEO_FAIL;
 	if (pthread_mutex_init(&video->task_mutex, NULL) < 0)
 		return OBS_VIDEO_FAIL;
+	if (pthread_mutex_init(&video->rungs_mutex, NULL) < 0)
+		return OBS_VIDEO_FAIL;
+	if (pthread_mutex_init(&video->frame_stats.mutex, NULL) < 0)
+		return OBS_VIDEO_FAIL;
+
+	if (obs->video_tick_threads > 0) {
+		video->tick_pool = os_task_pool_create(
+			"video tick", (size_t)obs->video_tick_threads);
+		if (video->tick_pool)
+			blog(LOG_INFO, "Ticking sources on %d threads",
+			     obs->video_tick_threads + 1);
+	}
 
 #ifdef __APPLE__
 	errorcode = pthread_create(&video->video_thread, NULL,
@@ -458,6 +517,14 @@ static void obs_free_video(void)
 	struct obs_core_video *video = &obs->video;
 
 	if (video->video) {
+		obs_free_video_rungs();
+
+		os_task_pool_destroy(video->tick_pool);
+		video->tick_pool = NULL;
+		da_free(video->parallel_tick_sources);
+		da_free(video->parallel_tick_times);
+		da_free(video->due_displays);
+
 		video_output_close(video->video);
 		video->video = NULL;
 
@@ -525,6 +592,16 @@ static void obs_free_video(void)
 		pthread_mutex_init_value(&video->task_mutex);
 		circlebuf_free(&video->tasks);
 
+		pthread_mutex_destroy(&video->rungs_mutex);
+		pthread_mutex_init_value(&video->rungs_mutex);
+
+		pthread_mutex_destroy(&video->frame_stats.mutex);
+		pthread_mutex_init_value(&video->frame_stats.mutex);
+		video->frame_stats.pos = 0;
+		video->frame_stats.num = 0;
+		video->frame_stats.stall_pos = 0;
+		video->frame_stats.num_stalls = 0;
+
 		video->gpu_encoder_active = 0;
 		video->cur_texture = 0;
 	}
@@ -566,15 +643,26 @@ static bool obs_init_audio(struct audio_output_info *ai)
 	int errorcode;
 
 	pthread_mutex_init_value(&audio->monitoring_mutex);
+	pthread_mutex_init_value(&audio->mixed_channels_mutex);
 
 	if (pthread_mutex_init_recursive(&audio->monitoring_mutex) != 0)
 		return false;
+	if (pthread_mutex_init(&audio->mixed_channels_mutex, NULL) != 0)
+		return false;
 
 	audio->user_volume = 1.0f;
 
 	audio->monitoring_device_name = bstrdup("Default");
 	audio->monitoring_device_id = bstrdup("default");
 
+	if (obs->audio_render_threads > 0) {
+		audio->render_pool = os_task_pool_create(
+			"audio render", (size_t)obs->audio_render_threads);
+		if (audio->render_pool)
+			blog(LOG_INFO, "Rendering audio sources on %d threads",
+			     obs->audio_render_threads + 1);
+	}
+
 	errorcode = audio_output_open(&audio->audio, ai);
 	if (errorcode == AUDIO_OUTPUT_SUCCESS)
 		return true;
@@ -602,14 +690,18 @@ static void obs_free_audio(void)
 	if (audio->audio)
 		audio_output_close(audio->audio);
 
+	os_task_pool_destroy(audio->render_pool);
+
 	circlebuf_free(&audio->buffered_timestamps);
 	da_free(audio->render_order);
 	da_free(audio->root_nodes);
+	da_free(audio->parallel_render_order);
 
 	da_free(audio->monitors);
 	bfree(audio->monitoring_device_name);
 	bfree(audio->monitoring_device_id);
 	pthread_mutex_destroy(&audio->monitoring_mutex);
+	pthread_mutex_destroy(&audio->mixed_channels_mutex);
 
 	memset(audio, 0, sizeof(struct obs_core_audio));
 }
@@ -694,6 +786,10 @@ static void obs_free_data(void)
 	pthread_mutex_destroy(&data->encoders_mutex);
 	pthread_mutex_destroy(&data->services_mutex);
 	pthread_mutex_destroy(&data->draw_callbacks_mutex);
+	bfree(data->source_names.buckets);
+	bfree(data->output_names.buckets);
+	bfree(data->encoder_names.buckets);
+	bfree(data->service_names.buckets);
 	da_free(data->draw_callbacks);
 	da_free(data->tick_callbacks);
 	obs_data_release(data->private_data);
@@ -730,6 +826,15 @@ static const char *obs_signals[] = {
 	NULL,
 };
 
+static void obs_proc_dump_profiler_timeline(void *data, calldata_t *cd)
+{
+	const char *path = calldata_string(cd, "path");
+	bool success = path && profiler_timeline_dump_json(path);
+
+	calldata_set_bool(cd, "success", success);
+	UNUSED_PARAMETER(data);
+}
+
 static inline bool obs_init_handlers(void)
 {
 	obs->signals = signal_handler_create();
@@ -740,6 +845,11 @@ static inline bool obs_init_handlers(void)
 	if (!obs->procs)
 		return false;
 
+	proc_handler_add(obs->procs,
+			 "void dump_profiler_timeline(string path, "
+			 "out bool success)",
+			 obs_proc_dump_profiler_timeline, NULL);
+
 	return signal_handler_add_array(obs->signals, obs_signals);
 }
 
@@ -838,8 +948,11 @@ static bool obs_init(const char *locale, const char *module_config_path,
 	obs = bzalloc(sizeof(struct obs_core));
 
 	pthread_mutex_init_value(&obs->audio.monitoring_mutex);
+	pthread_mutex_init_value(&obs->audio.mixed_channels_mutex);
 	pthread_mutex_init_value(&obs->video.gpu_encoder_mutex);
 	pthread_mutex_init_value(&obs->video.task_mutex);
+	pthread_mutex_init_value(&obs->video.rungs_mutex);
+	pthread_mutex_init_value(&obs->video.frame_stats.mutex);
 
 	obs->name_store_owned = !store;
 	obs->name_store = store ? store : profiler_name_store_create();
@@ -1042,6 +1155,7 @@ void obs_shutdown(void)
 		profiler_name_store_free(obs->name_store);
 
 	bfree(obs->module_config_path);
+	bfree(obs->shader_cache_path);
 	bfree(obs->locale);
 	bfree(obs);
 	obs = NULL;
@@ -1201,6 +1315,39 @@ bool obs_reset_audio(const struct obs_audio_info *oai)
 	return obs_init_audio(&ai);
 }
 
+void obs_set_audio_render_threads(int threads)
+{
+	if (!obs)
+		return;
+
+	obs->audio_render_threads = threads < 0 ? 0 : threads;
+}
+
+void obs_set_video_tick_threads(int threads)
+{
+	if (!obs)
+		return;
+
+	obs->video_tick_threads = threads < 0 ? 0 : threads;
+}
+
+void obs_set_shader_cache_path(const char *path)
+{
+	if (!obs)
+		return;
+
+	bfree(obs->shader_cache_path);
+	obs->shader_cache_path = path && *path ? bstrdup(path) : NULL;
+}
+
+void obs_set_video_input_threads(bool enable)
+{
+	if (!obs)
+		return;
+
+	obs->video_input_threads = enable;
+}
+
 bool obs_get_video_info(struct obs_video_info *ovi)
 {
 	struct obs_core_video *video = &obs->video;
@@ -1539,22 +1686,161 @@ void obs_enum_services(bool (*enum_proc)(void *, obs_service_t *), void *param)
 		 param);
 }
 
-static inline void *get_context_by_name(void *vfirst, const char *name,
+/* ------------------------------------------------------------------------- */
+/* context name tables                                                       */
+
+#define NAME_TABLE_MIN_BUCKETS 64
+
+static inline uint32_t context_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static struct obs_context_name_table *
+get_context_name_table(enum obs_obj_type type)
+{
+	switch (type) {
+	case OBS_OBJ_TYPE_SOURCE:
+		return &obs->data.source_names;
+	case OBS_OBJ_TYPE_OUTPUT:
+		return &obs->data.output_names;
+	case OBS_OBJ_TYPE_ENCODER:
+		return &obs->data.encoder_names;
+	case OBS_OBJ_TYPE_SERVICE:
+		return &obs->data.service_names;
+	case OBS_OBJ_TYPE_INVALID:
+		break;
+	}
+
+	return NULL;
+}
+
+/* buckets are kept newest first, in the order the contexts were inserted
+ * into their list, so that lookups of duplicate names return the same
+ * context as a list walk, even after renames */
+static inline void name_table_link(struct obs_context_data **bucket,
+				   struct obs_context_data *context)
+{
+	while (*bucket && (*bucket)->name_order > context->name_order)
+		bucket = &(*bucket)->name_next;
+
+	context->name_prev_next = bucket;
+	context->name_next = *bucket;
+	*bucket = context;
+	if (context->name_next)
+		context->name_next->name_prev_next = &context->name_next;
+}
+
+static void name_table_grow(struct obs_context_name_table *table)
+{
+	struct obs_context_data **old_buckets = table->buckets;
+	size_t old_num = table->num_buckets;
+	size_t new_num = old_num ? old_num * 2 : NAME_TABLE_MIN_BUCKETS;
+
+	table->buckets = bzalloc(sizeof(*table->buckets) * new_num);
+	table->num_buckets = new_num;
+
+	for (size_t i = 0; i < old_num; i++) {
+		struct obs_context_data *context = old_buckets[i];
+		struct obs_context_data **tail;
+
+		/* keep duplicate names in the same relative order, lookups
+		 * return the most recently added context like the list
+		 * walk used to */
+		while (context) {
+			struct obs_context_data *next = context->name_next;
+
+			tail = &table->buckets[context->name_hash &
+					       (new_num - 1)];
+			while (*tail)
+				tail = &(*tail)->name_next;
+
+			context->name_next = NULL;
+			context->name_prev_next = tail;
+			*tail = context;
+
+			context = next;
+		}
+	}
+
+	bfree(old_buckets);
+}
+
+/* must be called with the mutex of the context's list locked */
+static void name_table_add(struct obs_context_data *context)
+{
+	struct obs_context_name_table *table;
+
+	table = get_context_name_table(context->type);
+	if (!table)
+		return;
+
+	/* renamed contexts keep their place */
+	if (!context->name_order)
+		context->name_order = ++table->next_order;
+
+	if (context->private || !context->name)
+		return;
+
+	if (table->count >= table->num_buckets)
+		name_table_grow(table);
+
+	context->name_hash = context_name_hash(context->name);
+	context->name_table = table;
+	name_table_link(&table->buckets[context->name_hash &
+					(table->num_buckets - 1)],
+			context);
+	table->count++;
+}
+
+/* must be called with the mutex of the context's list locked */
+static void name_table_remove(struct obs_context_data *context)
+{
+	if (!context->name_table)
+		return;
+
+	*context->name_prev_next = context->name_next;
+	if (context->name_next)
+		context->name_next->name_prev_next = context->name_prev_next;
+
+	context->name_table->count--;
+	context->name_table = NULL;
+	context->name_next = NULL;
+	context->name_prev_next = NULL;
+}
+
+static inline void *get_context_by_name(struct obs_context_name_table *table,
+					const char *name,
 					pthread_mutex_t *mutex,
 					void *(*addref)(void *))
 {
-	struct obs_context_data **first = vfirst;
-	struct obs_context_data *context;
+	struct obs_context_data *context = NULL;
+	uint32_t hash;
+
+	if (!name)
+		return NULL;
+
+	hash = context_name_hash(name);
 
 	pthread_mutex_lock(mutex);
 
-	context = *first;
+	if (table->buckets)
+		context = table->buckets[hash & (table->num_buckets - 1)];
+
 	while (context) {
-		if (!context->private && strcmp(context->name, name) == 0) {
+		if (context->name_hash == hash &&
+		    strcmp(context->name, name) == 0) {
 			context = addref(context);
 			break;
 		}
-		context = context->next;
+		context = context->name_next;
 	}
 
 	pthread_mutex_unlock(mutex);
@@ -1588,28 +1874,28 @@ static inline void *obs_id_(void *data)
 
 obs_source_t *obs_get_source_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_source, name,
+	return get_context_by_name(&obs->data.source_names, name,
 				   &obs->data.sources_mutex,
 				   obs_source_addref_safe_);
 }
 
 obs_output_t *obs_get_output_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_output, name,
+	return get_context_by_name(&obs->data.output_names, name,
 				   &obs->data.outputs_mutex,
 				   obs_output_addref_safe_);
 }
 
 obs_encoder_t *obs_get_encoder_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_encoder, name,
+	return get_context_by_name(&obs->data.encoder_names, name,
 				   &obs->data.encoders_mutex,
 				   obs_encoder_addref_safe_);
 }
 
 obs_service_t *obs_get_service_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_service, name,
+	return get_context_by_name(&obs->data.service_names, name,
 				   &obs->data.services_mutex,
 				   obs_service_addref_safe_);
 }
@@ -2135,6 +2421,7 @@ void obs_context_data_insert(struct obs_context_data *context,
 	*first = context;
 	if (context->next)
 		context->next->prev_next = &context->next;
+	name_table_add(context);
 	pthread_mutex_unlock(mutex);
 }
 
@@ -2146,6 +2433,7 @@ void obs_context_data_remove(struct obs_context_data *context)
 			*context->prev_next = context->next;
 		if (context->next)
 			context->next->prev_next = context->prev_next;
+		name_table_remove(context);
 		pthread_mutex_unlock(context->mutex);
 
 		context->mutex = NULL;
@@ -2155,6 +2443,14 @@ void obs_context_data_remove(struct obs_context_data *context)
 void obs_context_data_setname(struct obs_context_data *context,
 			      const char *name)
 {
+	pthread_mutex_t *mutex = context->mutex;
+
+	/* the list mutex also guards the name table entry */
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+		name_table_remove(context);
+	}
+
 	pthread_mutex_lock(&context->rename_cache_mutex);
 
 	if (context->name)
@@ -2162,6 +2458,11 @@ void obs_context_data_setname(struct obs_context_data *context,
 	context->name = dup_name(name, context->private);
 
 	pthread_mutex_unlock(&context->rename_cache_mutex);
+
+	if (mutex) {
+		name_table_add(context);
+		pthread_mutex_unlock(mutex);
+	}
 }
 
 profiler_name_store_t *obs_get_profiler_name_store(void)
@@ -2334,12 +2635,120 @@ uint32_t obs_get_lagged_frames(void)
 	return obs->video.lagged_frames;
 }
 
+const char *obs_frame_phase_name(enum obs_frame_phase phase)
+{
+	switch (phase) {
+	case OBS_FRAME_PHASE_TICK_SOURCES:
+		return "tick_sources";
+	case OBS_FRAME_PHASE_GRAPHICS_TASKS:
+		return "graphics_tasks";
+	case OBS_FRAME_PHASE_RENDER_VIDEO:
+		return "render_video";
+	case OBS_FRAME_PHASE_DOWNLOAD_FRAME:
+		return "download_frame";
+	case OBS_FRAME_PHASE_GS_FLUSH:
+		return "gs_flush";
+	case OBS_FRAME_PHASE_RENDER_DISPLAYS:
+		return "render_displays";
+	case OBS_FRAME_PHASE_TOTAL:
+		return "total";
+	}
+
+	return "unknown";
+}
+
+static int compare_frame_times(const void *a, const void *b)
+{
+	uint64_t val_a = *(const uint64_t *)a;
+	uint64_t val_b = *(const uint64_t *)b;
+	return val_a < val_b ? -1 : (val_a > val_b ? 1 : 0);
+}
+
+static inline uint64_t get_percentile(const uint64_t *sorted, size_t num,
+				      size_t percent)
+{
+	size_t rank = (num * percent + 99) / 100;
+	return sorted[rank ? rank - 1 : 0];
+}
+
+bool obs_get_frame_phase_stats(enum obs_frame_phase phase,
+			       struct obs_frame_phase_stats *stats)
+{
+	struct obs_frame_stats *frame_stats;
+	uint64_t sorted[FRAME_STATS_WINDOW];
+	size_t num;
+
+	if (!obs || !stats || (size_t)phase >= OBS_FRAME_PHASE_COUNT)
+		return false;
+
+	frame_stats = &obs->video.frame_stats;
+
+	pthread_mutex_lock(&frame_stats->mutex);
+	num = frame_stats->num;
+	memcpy(sorted, frame_stats->times[phase], sizeof(uint64_t) * num);
+	pthread_mutex_unlock(&frame_stats->mutex);
+
+	memset(stats, 0, sizeof(*stats));
+	if (!num)
+		return false;
+
+	qsort(sorted, num, sizeof(uint64_t), compare_frame_times);
+
+	stats->frames = (uint32_t)num;
+	stats->p50_ns = get_percentile(sorted, num, 50);
+	stats->p95_ns = get_percentile(sorted, num, 95);
+	stats->p99_ns = get_percentile(sorted, num, 99);
+	stats->max_ns = sorted[num - 1];
+	return true;
+}
+
+size_t obs_get_frame_stalls(struct obs_frame_stall *stalls, size_t max_stalls)
+{
+	struct obs_frame_stats *frame_stats;
+	size_t num;
+
+	if (!obs || !stalls)
+		return 0;
+
+	frame_stats = &obs->video.frame_stats;
+
+	pthread_mutex_lock(&frame_stats->mutex);
+
+	num = frame_stats->num_stalls < max_stalls ? frame_stats->num_stalls
+						   : max_stalls;
+
+	/* stall_pos is the slot after the newest stall */
+	size_t newest = frame_stats->stall_pos + FRAME_STALL_HISTORY - 1;
+	for (size_t i = 0; i < num; i++)
+		stalls[i] = frame_stats->stalls[(newest - i) %
+						FRAME_STALL_HISTORY];
+
+	pthread_mutex_unlock(&frame_stats->mutex);
+	return num;
+}
+
+uint64_t obs_get_total_audio_mixed_channels(void)
+{
+	uint64_t total;
+
+	if (!obs || !obs->audio.audio)
+		return 0;
+
+	pthread_mutex_lock(&obs->audio.mixed_channels_mutex);
+	total = obs->audio.total_mixed_channels;
+	pthread_mutex_unlock(&obs->audio.mixed_channels_mutex);
+	return total;
+}
+
 void start_raw_video(video_t *v, const struct video_scale_info *conversion,
 		     void (*callback)(void *param, struct video_data *frame),
 		     void *param)
 {
 	struct obs_core_video *video = &obs->video;
-	os_atomic_inc_long(&video->raw_active);
+
+	/* ladder rungs are only rendered while their own video is active */
+	if (v == video->video)
+		os_atomic_inc_long(&video->raw_active);
 	video_output_connect(v, conversion, callback, param);
 }
 
@@ -2348,7 +2757,8 @@ void stop_raw_video(video_t *v,
 		    void *param)
 {
 	struct obs_core_video *video = &obs->video;
-	os_atomic_dec_long(&video->raw_active);
+	if (v == video->video)
+		os_atomic_dec_long(&video->raw_active);
 	video_output_disconnect(v, callback, param);
 }
 
@@ -2453,7 +2863,8 @@ bool obs_video_active(void)
 	struct obs_core_video *video = &obs->video;
 
 	return os_atomic_load_long(&video->raw_active) > 0 ||
-	       os_atomic_load_long(&video->gpu_encoder_active) > 0;
+	       os_atomic_load_long(&video->gpu_encoder_active) > 0 ||
+	       obs_video_rungs_active();
 }
 
 bool obs_nv12_tex_active(void)
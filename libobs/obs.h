@@ -53,6 +53,7 @@ struct obs_volmeter;
 
 typedef struct obs_display obs_display_t;
 typedef struct obs_view obs_view_t;
+typedef struct obs_video_rung obs_video_rung_t;
 typedef struct obs_source obs_source_t;
 typedef struct obs_scene obs_scene_t;
 typedef struct obs_scene_item obs_sceneitem_t;
@@ -180,6 +181,18 @@ struct obs_video_info {
 	enum obs_scale_type scale_type; /**< How to scale if scaling */
 };
 
+/**
+ * Output ladder rung, an additional output resolution/format rendered from
+ * the main texture on the GPU
+ */
+struct obs_video_rung_info {
+	uint32_t width;                   /**< Output width */
+	uint32_t height;                  /**< Output height */
+	enum video_format format;         /**< I420, NV12, I444 or RGBA */
+	enum video_colorspace colorspace; /**< YUV type (if YUV) */
+	enum video_range_type range;      /**< YUV range (if YUV) */
+};
+
 /**
  * Audio initialization structure
  */
@@ -394,6 +407,46 @@ EXPORT int obs_reset_video(struct obs_video_info *ovi);
  */
 EXPORT bool obs_reset_audio(const struct obs_audio_info *oai);
 
+/**
+ * Sets the number of worker threads used to render audio sources in parallel
+ * with the audio thread.  Sources that do not depend on other sources are
+ * rendered on the workers, scenes and transitions are then mixed on the
+ * audio thread.  0 (the default) renders everything on the audio thread.
+ *
+ * Takes effect on the next call to obs_reset_audio.
+ */
+EXPORT void obs_set_audio_render_threads(int threads);
+
+/**
+ * Sets the number of worker threads used to call the video_tick of sources
+ * with the OBS_SOURCE_THREADSAFE_TICK flag in parallel, before the frame is
+ * rendered.  Other sources are still ticked on the graphics thread.  0 (the
+ * default) ticks every source on the graphics thread.
+ *
+ * Takes effect on the next call to obs_reset_video.
+ */
+EXPORT void obs_set_video_tick_threads(int threads);
+
+/**
+ * Sets the directory used to cache compiled shader program binaries between
+ * runs, so they are not compiled and linked again on the next start.  Effect
+ * files are still parsed and converted on every start.  NULL (the default)
+ * disables the cache.
+ *
+ * Must be called before graphics are initialized by the first call to
+ * obs_reset_video.
+ */
+EXPORT void obs_set_shader_cache_path(const char *path);
+
+/**
+ * Gives each raw video output and encoder its own thread to receive frames
+ * on, instead of sharing the video output thread.  An encoder that falls
+ * behind then gets frames repeated without holding back the others.
+ *
+ * Takes effect on the next call to obs_reset_video.
+ */
+EXPORT void obs_set_video_input_threads(bool enable);
+
 /** Gets the current video settings, returns false if no video */
 EXPORT bool obs_get_video_info(struct obs_video_info *ovi);
 
@@ -772,6 +825,95 @@ EXPORT uint64_t obs_get_frame_interval_ns(void);
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+/** Phases of a frame on the graphics thread */
+enum obs_frame_phase {
+	OBS_FRAME_PHASE_TICK_SOURCES,
+	OBS_FRAME_PHASE_GRAPHICS_TASKS,
+	OBS_FRAME_PHASE_RENDER_VIDEO,
+	OBS_FRAME_PHASE_DOWNLOAD_FRAME,
+	OBS_FRAME_PHASE_GS_FLUSH,
+	OBS_FRAME_PHASE_RENDER_DISPLAYS,
+	OBS_FRAME_PHASE_TOTAL,
+};
+
+#define OBS_FRAME_PHASE_COUNT (OBS_FRAME_PHASE_TOTAL + 1)
+
+struct obs_frame_phase_stats {
+	uint32_t frames;
+	uint64_t p50_ns;
+	uint64_t p95_ns;
+	uint64_t p99_ns;
+	uint64_t max_ns;
+};
+
+/** A frame that took long enough for the following frames to be skipped */
+struct obs_frame_stall {
+	uint64_t timestamp;
+	uint32_t lagged_frames;
+
+	/** The slowest phase of the frame */
+	enum obs_frame_phase phase;
+	uint64_t phase_ns;
+
+	/** The source that took the longest to tick or render, if any */
+	char source_name[128];
+	enum obs_frame_phase source_phase;
+	uint64_t source_ns;
+};
+
+EXPORT const char *obs_frame_phase_name(enum obs_frame_phase phase);
+
+/**
+ * Gets the percentiles of the time spent in a phase over the most recent
+ * frames.  Returns false if no frame has been rendered yet.
+ */
+EXPORT bool obs_get_frame_phase_stats(enum obs_frame_phase phase,
+				      struct obs_frame_phase_stats *stats);
+
+/**
+ * Copies up to max_stalls of the most recent frame stalls, newest first,
+ * and returns the number copied.
+ */
+EXPORT size_t obs_get_frame_stalls(struct obs_frame_stall *stalls,
+				   size_t max_stalls);
+
+/**
+ * Returns the number of source channel buffers that have been mixed into
+ * active audio mixes.  Mixes that no output uses are skipped entirely.
+ */
+EXPORT uint64_t obs_get_total_audio_mixed_channels(void);
+
+/* ------------------------------------------------------------------------- */
+/* Output ladder */
+
+/**
+ * Adds an output ladder rung.  Each rung is scaled and converted from the
+ * main texture on the GPU in the same frame as the main output, and feeds
+ * its own video output.  Encoders and outputs use it through
+ * obs_encoder_set_video/obs_output_set_media with obs_video_rung_get_video.
+ *
+ * Rungs have to be destroyed before the video is reset.
+ */
+EXPORT obs_video_rung_t *
+obs_video_rung_create(const struct obs_video_rung_info *info);
+
+/**
+ * Destroys an output ladder rung.  Anything still connected to its video
+ * output has to be stopped first.
+ */
+EXPORT void obs_video_rung_destroy(obs_video_rung_t *rung);
+
+EXPORT video_t *obs_video_rung_get_video(const obs_video_rung_t *rung);
+EXPORT void obs_video_rung_get_info(const obs_video_rung_t *rung,
+				    struct obs_video_rung_info *info);
+
+/**
+ * Average time spent rendering, downloading and outputting a frame of the
+ * rung, updated every second while it is active
+ */
+EXPORT uint64_t
+obs_video_rung_get_avg_frame_time_ns(const obs_video_rung_t *rung);
+
 EXPORT bool obs_nv12_tex_active(void);
 
 EXPORT void obs_apply_private_data(obs_data_t *settings);
@@ -863,6 +1005,29 @@ EXPORT void obs_display_set_background_color(obs_display_t *display,
 EXPORT void obs_display_size(obs_display_t *display, uint32_t *width,
 			     uint32_t *height);
 
+/**
+ * Tells libobs whether the display's window can currently be seen.  Hidden
+ * (minimized or occluded) displays are not rendered.
+ */
+EXPORT void obs_display_set_visible(obs_display_t *display, bool visible);
+EXPORT bool obs_display_visible(obs_display_t *display);
+
+/**
+ * Sets the rate the display is rendered at, independent of the output frame
+ * rate.  0 uses the rate set with obs_set_display_fps.
+ */
+EXPORT void obs_display_set_fps(obs_display_t *display, double fps);
+EXPORT double obs_display_get_fps(obs_display_t *display);
+
+/**
+ * Sets the default rate displays are rendered at.  0 (the default) renders
+ * displays every output frame.  Displays are always rendered after the output
+ * frame.  Displays with a rate other than 0 are deferred to a later frame if
+ * rendering them would delay the next output frame.
+ */
+EXPORT void obs_set_display_fps(double fps);
+EXPORT double obs_get_display_fps(void);
+
 /* ------------------------------------------------------------------------- */
 /* Sources */
 
@@ -1257,6 +1422,13 @@ obs_source_draw_set_color_matrix(const struct matrix4 *color_matrix,
 EXPORT void obs_source_draw(gs_texture_t *image, int x, int y, uint32_t cx,
 			    uint32_t cy, bool flip);
 
+/**
+ * Signals that the video output of the source changed, for sources with the
+ * OBS_SOURCE_CONTENT_TRACKING flag.  Settings updates, filter changes and new
+ * async frames are signaled automatically.
+ */
+EXPORT void obs_source_content_changed(obs_source_t *source);
+
 /**
  * Outputs asynchronous video data.  Set to NULL to deactivate the texture
  *
@@ -1269,6 +1441,47 @@ EXPORT void obs_source_output_video(obs_source_t *source,
 EXPORT void obs_source_output_video2(obs_source_t *source,
 				     const struct obs_source_frame2 *frame);
 
+/**
+ * Gets an unused frame from the source's async frame pool so that video can
+ * be captured or decoded straight into it.  The frame must then either be
+ * passed to obs_source_output_async_frame or returned with
+ * obs_source_cancel_async_frame.  Returns NULL if the source is not
+ * asynchronous.
+ *
+ * The frame's planes must not be replaced, and every field other than the
+ * planes, size and format must be set by the caller before output.
+ */
+EXPORT struct obs_source_frame *
+obs_source_get_async_frame(obs_source_t *source, enum video_format format,
+			   uint32_t width, uint32_t height);
+
+/**
+ * Outputs a frame from obs_source_get_async_frame without copying it.  Any
+ * other frame is copied, as with obs_source_output_video.
+ */
+EXPORT void obs_source_output_async_frame(obs_source_t *source,
+					  struct obs_source_frame *frame);
+
+/** Returns a frame from obs_source_get_async_frame without outputting it */
+EXPORT void obs_source_cancel_async_frame(obs_source_t *source,
+					  struct obs_source_frame *frame);
+
+typedef void (*obs_source_frame_release_t)(void *param);
+
+/**
+ * Outputs asynchronous video data without copying it.  The planes of the
+ * frame must stay valid until release is called with param, which may happen
+ * on any thread.  If the frame cannot be queued, release is called before
+ * this function returns.
+ *
+ * Frames still queued when the source is destroyed are dropped without
+ * calling release.
+ */
+EXPORT void obs_source_output_video_external(obs_source_t *source,
+					     const struct obs_source_frame *frame,
+					     obs_source_frame_release_t release,
+					     void *param);
+
 EXPORT void obs_source_set_async_rotation(obs_source_t *source, long rotation);
 
 EXPORT void obs_source_output_cea708(obs_source_t *source,
@@ -1570,6 +1783,13 @@ EXPORT obs_source_t *obs_scene_get_source(const obs_scene_t *scene);
 /** Gets the scene from its source, or NULL if not a scene */
 EXPORT obs_scene_t *obs_scene_from_source(const obs_source_t *source);
 
+/**
+ * Gets how often the scene was drawn from its cached render (hits), and how
+ * often its items had to be rendered (misses).
+ */
+EXPORT void obs_scene_get_render_cache_stats(obs_scene_t *scene,
+					     uint64_t *hits, uint64_t *misses);
+
 /** Determines whether a source is within a scene */
 EXPORT obs_sceneitem_t *obs_scene_find_source(obs_scene_t *scene,
 					      const char *name);
@@ -31,3 +31,4 @@ EXPORT size_t os_process_pipe_read_err(os_process_pipe_t *pp, uint8_t *data,
 				       size_t len);
 EXPORT size_t os_process_pipe_write(os_process_pipe_t *pp, const uint8_t *data,
 				    size_t len);
+EXPORT bool os_process_pipe_flush(os_process_pipe_t *pp);
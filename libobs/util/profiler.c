@@ -1,10 +1,12 @@
 #include <inttypes.h>
 #include "profiler.h"
 
+#include "circlebuf.h"
 #include "darray.h"
 #include "dstr.h"
 #include "platform.h"
 #include "threading.h"
+#include "spsc-queue.h"
 
 #include <math.h>
 
@@ -43,11 +45,45 @@ struct profile_call {
 #ifdef TRACK_OVERHEAD
 	uint64_t overhead_end;
 #endif
-	uint64_t expected_time_between_calls;
-	DARRAY(profile_call) children;
-	profile_call *parent;
+	uint32_t parent;
+	uint32_t next; /* index after the last call of this call's subtree */
+};
+
+#define NO_CALL UINT32_MAX
+
+/* Calls of one root call, in the order they were started.  The children of
+ * a call are the calls between its own index and its 'next' index. */
+typedef struct profile_block profile_block;
+struct profile_block {
+	profile_call *calls;
+	size_t num;
+	size_t capacity;
+};
+
+/* Per thread call recording.  Blocks are handed to the merge thread through
+ * 'ready' when a root call ends and come back through 'free' once merged,
+ * so recording only allocates while the blocks grow to their working
+ * size. */
+typedef struct profile_thread profile_thread;
+struct profile_thread {
+	struct spsc_queue ready;
+	struct spsc_queue free;
+	size_t num_blocks;
+
+	profile_block *block;
+	uint32_t active;
+	size_t skipped;
+
+	uint32_t id;
+	bool timeline_named;
+
+	volatile bool exited;
 };
 
+#define PROFILE_BLOCK_CALLS 64
+#define PROFILE_MAX_BLOCKS 32
+#define PROFILE_MERGE_INTERVAL_MS 20
+
 typedef struct profile_times_table_entry profile_times_table_entry;
 struct profile_times_table_entry {
 	size_t probes;
@@ -83,7 +119,7 @@ struct profile_root_entry {
 	pthread_mutex_t *mutex;
 	const char *name;
 	profile_entry *entry;
-	profile_call *prev_call;
+	uint64_t prev_start_time;
 };
 
 static inline uint64_t diff_ns_to_usec(uint64_t prev, uint64_t next)
@@ -228,19 +264,20 @@ static profile_entry *get_child(profile_entry *parent, const char *name)
 	return init_entry(da_push_back_new(parent->children), name);
 }
 
-static void merge_call(profile_entry *entry, profile_call *call,
-		       profile_call *prev_call)
+static void merge_call(profile_entry *entry, profile_block *block,
+		       uint32_t idx, uint64_t prev_start_time)
 {
-	const size_t num = call->children.num;
-	for (size_t i = 0; i < num; i++) {
-		profile_call *child = &call->children.array[i];
-		merge_call(get_child(entry, child->name), child, NULL);
+	profile_call *call = &block->calls[idx];
+
+	for (uint32_t i = idx + 1; i < call->next; i = block->calls[i].next) {
+		profile_call *child = &block->calls[i];
+		merge_call(get_child(entry, child->name), block, i, 0);
 	}
 
-	if (entry->expected_time_between_calls != 0 && prev_call) {
+	if (entry->expected_time_between_calls != 0 && prev_start_time) {
 		migrate_old_entries(&entry->times_between_calls, true);
-		uint64_t usec = diff_ns_to_usec(prev_call->start_time,
-						call->start_time);
+		uint64_t usec =
+			diff_ns_to_usec(prev_start_time, call->start_time);
 		add_hashmap_entry(&entry->times_between_calls, usec, 1);
 	}
 
@@ -256,24 +293,66 @@ static void merge_call(profile_entry *entry, profile_call *call,
 #endif
 }
 
-static bool enabled = false;
+static volatile bool enabled = false;
 static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
 static DARRAY(profile_root_entry) root_entries;
 
-static THREAD_LOCAL profile_call *thread_context = NULL;
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(profile_thread *) threads;
+static pthread_key_t thread_key;
+static pthread_t merge_thread;
+static os_event_t *merge_stop_event = NULL;
+static os_event_t *merge_enabled_event = NULL;
+static bool merge_thread_active = false;
+
+/* profiler_free frees the context of every thread, but can only clear the
+ * thread_context of the thread calling it.  Contexts from an older
+ * generation are dropped the next time their thread uses them. */
+static volatile long generation = 0;
+
+static THREAD_LOCAL profile_thread *thread_context = NULL;
+static THREAD_LOCAL long thread_generation = 0;
 static THREAD_LOCAL bool thread_enabled = true;
 
+static uint32_t next_thread_id = 0;
+
+static void merge_pending(void);
+static void *merge_thread_loop(void *unused);
+static void timeline_add_block(profile_thread *thread, profile_block *block);
+static void timeline_free(void);
+
+static void thread_exited(void *data)
+{
+	profile_thread *thread = data;
+	os_atomic_set_bool(&thread->exited, true);
+}
+
 void profiler_start(void)
 {
 	pthread_mutex_lock(&root_mutex);
-	enabled = true;
+	if (!merge_thread_active) {
+		pthread_key_create(&thread_key, thread_exited);
+		os_event_init(&merge_stop_event, OS_EVENT_TYPE_MANUAL);
+		os_event_init(&merge_enabled_event, OS_EVENT_TYPE_MANUAL);
+		merge_thread_active = pthread_create(&merge_thread, NULL,
+						     merge_thread_loop,
+						     NULL) == 0;
+	}
+	os_atomic_set_bool(&enabled, true);
+	if (merge_thread_active)
+		os_event_signal(merge_enabled_event);
 	pthread_mutex_unlock(&root_mutex);
 }
 
 void profiler_stop(void)
 {
+	/* calls that already ended are still part of the results */
+	merge_pending();
+
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
+	os_atomic_set_bool(&enabled, false);
+	if (merge_thread_active)
+		os_event_reset(merge_enabled_event);
 	pthread_mutex_unlock(&root_mutex);
 }
 
@@ -334,35 +413,159 @@ void profile_register_root(const char *name,
 	pthread_mutex_unlock(&root_mutex);
 }
 
-static void free_call_context(profile_call *context);
-
-static void merge_context(profile_call *context)
+static void merge_block(profile_block *block)
 {
 	pthread_mutex_t *mutex = NULL;
 	profile_entry *entry = NULL;
-	profile_call *prev_call = NULL;
+	uint64_t prev_start_time = 0;
 
-	if (!lock_root()) {
-		free_call_context(context);
+	if (!block->num || !lock_root())
 		return;
-	}
 
-	profile_root_entry *r_entry = get_root_entry(context->name);
+	profile_root_entry *r_entry = get_root_entry(block->calls[0].name);
 
 	mutex = r_entry->mutex;
 	entry = r_entry->entry;
-	prev_call = r_entry->prev_call;
+	prev_start_time = r_entry->prev_start_time;
 
-	r_entry->prev_call = context;
+	r_entry->prev_start_time = block->calls[0].start_time;
 
 	pthread_mutex_lock(mutex);
 	pthread_mutex_unlock(&root_mutex);
 
-	merge_call(entry, context, prev_call);
+	merge_call(entry, block, 0, prev_start_time);
 
 	pthread_mutex_unlock(mutex);
+}
+
+static void free_block(profile_block *block)
+{
+	if (block) {
+		bfree(block->calls);
+		bfree(block);
+	}
+}
+
+static void free_thread(profile_thread *thread)
+{
+	profile_block *block;
+
+	while ((block = spsc_queue_pop(&thread->ready)) != NULL)
+		free_block(block);
+	while ((block = spsc_queue_pop(&thread->free)) != NULL)
+		free_block(block);
+	free_block(thread->block);
+
+	spsc_queue_free(&thread->ready);
+	spsc_queue_free(&thread->free);
+	bfree(thread);
+}
+
+/* callers hold threads_mutex, which makes them the only consumer of the
+ * 'ready' queues and the only producer of the 'free' queues */
+static void merge_thread_blocks(profile_thread *thread)
+{
+	profile_block *block;
+
+	while ((block = spsc_queue_pop(&thread->ready)) != NULL) {
+		timeline_add_block(thread, block);
+		merge_block(block);
+		block->num = 0;
+		spsc_queue_push(&thread->free, block);
+	}
+}
+
+static void merge_pending(void)
+{
+	pthread_mutex_lock(&threads_mutex);
+
+	for (size_t i = threads.num; i > 0; i--) {
+		profile_thread *thread = threads.array[i - 1];
+		bool exited = os_atomic_load_bool(&thread->exited);
+
+		merge_thread_blocks(thread);
+
+		if (exited) {
+			free_thread(thread);
+			da_erase(threads, i - 1);
+		}
+	}
+
+	pthread_mutex_unlock(&threads_mutex);
+}
+
+static void *merge_thread_loop(void *unused)
+{
+	os_set_thread_name("profiler: merge");
+
+	/* profiler_stop merges what is pending, so there is nothing to do
+	 * until profiling is enabled again */
+	while (os_event_wait(merge_enabled_event) == 0 &&
+	       os_event_timedwait(merge_stop_event,
+				  PROFILE_MERGE_INTERVAL_MS) == ETIMEDOUT)
+		merge_pending();
+
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+static profile_thread *create_thread_context(void)
+{
+	profile_thread *thread;
+
+	pthread_mutex_lock(&root_mutex);
+	if (!enabled) {
+		pthread_mutex_unlock(&root_mutex);
+		thread_enabled = false;
+		return NULL;
+	}
+
+	thread = bzalloc(sizeof(profile_thread));
+	spsc_queue_init(&thread->ready, PROFILE_MAX_BLOCKS);
+	spsc_queue_init(&thread->free, PROFILE_MAX_BLOCKS);
+	thread->active = NO_CALL;
+	pthread_setspecific(thread_key, thread);
+	thread_generation = generation;
+	pthread_mutex_unlock(&root_mutex);
+
+	pthread_mutex_lock(&threads_mutex);
+	thread->id = ++next_thread_id;
+	da_push_back(threads, &thread);
+	pthread_mutex_unlock(&threads_mutex);
+
+	return thread_context = thread;
+}
+
+static inline profile_thread *get_thread_context(void)
+{
+	if (thread_context &&
+	    thread_generation != os_atomic_load_long(&generation))
+		thread_context = NULL;
+
+	return thread_context;
+}
+
+static profile_block *get_free_block(profile_thread *thread)
+{
+	profile_block *block = spsc_queue_pop(&thread->free);
+	if (block)
+		return block;
+
+	if (thread->num_blocks < PROFILE_MAX_BLOCKS) {
+		block = bzalloc(sizeof(profile_block));
+		block->capacity = PROFILE_BLOCK_CALLS;
+		block->calls = bmalloc(sizeof(profile_call) * block->capacity);
+		thread->num_blocks++;
+		return block;
+	}
+
+	/* the merge thread is behind, merge on this thread instead of
+	 * dropping calls */
+	pthread_mutex_lock(&threads_mutex);
+	merge_thread_blocks(thread);
+	pthread_mutex_unlock(&threads_mutex);
 
-	free_call_context(prev_call);
+	return spsc_queue_pop(&thread->free);
 }
 
 void profile_start(const char *name)
@@ -370,25 +573,38 @@ void profile_start(const char *name)
 	if (!thread_enabled)
 		return;
 
-	profile_call new_call = {
-		.name = name,
-#ifdef TRACK_OVERHEAD
-		.overhead_start = os_gettime_ns(),
-#endif
-		.parent = thread_context,
-	};
+	profile_thread *thread = get_thread_context();
+	if (!thread && !(thread = create_thread_context()))
+		return;
+
+	if (thread->skipped) {
+		thread->skipped++;
+		return;
+	}
 
-	profile_call *call = NULL;
+	profile_block *block = thread->block;
+	if (!block && !(block = thread->block = get_free_block(thread))) {
+		thread->skipped++;
+		return;
+	}
 
-	if (new_call.parent) {
-		size_t idx = da_push_back(new_call.parent->children, &new_call);
-		call = &new_call.parent->children.array[idx];
-	} else {
-		call = bmalloc(sizeof(profile_call));
-		memcpy(call, &new_call, sizeof(profile_call));
+	if (block->num == block->capacity) {
+		block->capacity *= 2;
+		block->calls = brealloc(block->calls,
+					sizeof(profile_call) * block->capacity);
 	}
 
-	thread_context = call;
+	uint32_t idx = (uint32_t)block->num++;
+	profile_call *call = &block->calls[idx];
+
+	call->name = name;
+#ifdef TRACK_OVERHEAD
+	call->overhead_start = os_gettime_ns();
+#endif
+	call->parent = thread->active;
+	call->next = NO_CALL;
+
+	thread->active = idx;
 	call->start_time = os_gettime_ns();
 }
 
@@ -398,12 +614,20 @@ void profile_end(const char *name)
 	if (!thread_enabled)
 		return;
 
-	profile_call *call = thread_context;
-	if (!call) {
+	profile_thread *thread = get_thread_context();
+	if (thread && thread->skipped) {
+		thread->skipped--;
+		return;
+	}
+
+	if (!thread || thread->active == NO_CALL) {
 		blog(LOG_ERROR, "Called profile end with no active profile");
 		return;
 	}
 
+	profile_block *block = thread->block;
+	profile_call *call = &block->calls[thread->active];
+
 	if (!call->name)
 		call->name = name;
 
@@ -413,30 +637,41 @@ void profile_end(const char *name)
 		     "start(\"%s\"[%p]) <-> end(\"%s\"[%p])",
 		     call->name, call->name, name, name);
 
-		profile_call *parent = call->parent;
-		while (parent && parent->parent && parent->name != name)
-			parent = parent->parent;
+		uint32_t parent = call->parent;
+		while (parent != NO_CALL &&
+		       block->calls[parent].parent != NO_CALL &&
+		       block->calls[parent].name != name)
+			parent = block->calls[parent].parent;
 
-		if (!parent || parent->name != name)
+		if (parent == NO_CALL || block->calls[parent].name != name)
 			return;
 
 		while (call->name != name) {
 			profile_end(call->name);
-			call = call->parent;
+			call = &block->calls[call->parent];
 		}
 	}
 
-	thread_context = call->parent;
+	thread->active = call->parent;
 
 	call->end_time = end;
+	call->next = (uint32_t)block->num;
 #ifdef TRACK_OVERHEAD
 	call->overhead_end = os_gettime_ns();
 #endif
 
-	if (call->parent)
+	if (call->parent != NO_CALL)
+		return;
+
+	if (!os_atomic_load_bool(&enabled)) {
+		thread_enabled = false;
+		block->num = 0;
 		return;
+	}
 
-	merge_context(call);
+	/* the spsc queues hold every block of the thread, so this can't fail */
+	spsc_queue_push(&thread->ready, block);
+	thread->block = NULL;
 }
 
 static int profiler_time_entry_compare(const void *first, const void *second)
@@ -759,24 +994,6 @@ void profiler_print_time_between_calls(profiler_snapshot_t *snap)
 			   profile_print_entry_expected, snap);
 }
 
-static void free_call_children(profile_call *call)
-{
-	if (!call)
-		return;
-
-	const size_t num = call->children.num;
-	for (size_t i = 0; i < num; i++)
-		free_call_children(&call->children.array[i]);
-
-	da_free(call->children);
-}
-
-static void free_call_context(profile_call *context)
-{
-	free_call_children(context);
-	bfree(context);
-}
-
 static void free_hashmap(profile_times_table *map)
 {
 	map->size = 0;
@@ -803,11 +1020,38 @@ void profiler_free(void)
 {
 	DARRAY(profile_root_entry) old_root_entries = {0};
 
+	bool merge_thread_was_active;
+
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
+	os_atomic_set_bool(&enabled, false);
+	os_atomic_inc_long(&generation);
 	da_move(old_root_entries, root_entries);
+	merge_thread_was_active = merge_thread_active;
+	merge_thread_active = false;
 	pthread_mutex_unlock(&root_mutex);
 
+	if (merge_thread_was_active) {
+		os_event_signal(merge_stop_event);
+		os_event_signal(merge_enabled_event);
+		pthread_join(merge_thread, NULL);
+		os_event_destroy(merge_stop_event);
+		os_event_destroy(merge_enabled_event);
+		merge_stop_event = NULL;
+		merge_enabled_event = NULL;
+		pthread_key_delete(thread_key);
+	}
+
+	/* profiling threads are expected to be done at this point */
+	pthread_mutex_lock(&threads_mutex);
+	for (size_t i = 0; i < threads.num; i++)
+		free_thread(threads.array[i]);
+	da_free(threads);
+	pthread_mutex_unlock(&threads_mutex);
+
+	thread_context = NULL;
+
+	timeline_free();
+
 	for (size_t i = 0; i < old_root_entries.num; i++) {
 		profile_root_entry *entry = &old_root_entries.array[i];
 
@@ -818,17 +1062,297 @@ void profiler_free(void)
 		bfree(entry->mutex);
 		entry->mutex = NULL;
 
-		free_call_context(entry->prev_call);
-
 		free_profile_entry(entry->entry);
 		bfree(entry->entry);
 	}
 
 	da_free(old_root_entries);
 
+	/* threads_mutex is statically initialized, so it stays usable for a
+	 * later profiler_start */
 	pthread_mutex_destroy(&root_mutex);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Timeline */
+
+#define PROFILE_TIMELINE_DEFAULT_EVENTS (1 << 18)
+
+struct timeline_event {
+	const char *name;
+	uint64_t start_time;
+	uint64_t end_time;
+	uint32_t thread_id;
+};
+
+struct timeline_thread {
+	uint32_t id;
+	const char *name;
+};
+
+static pthread_mutex_t timeline_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool timeline_enabled = false;
+static struct circlebuf timeline_events;
+static size_t timeline_max_events = 0;
+static uint64_t timeline_start_time = 0;
+static DARRAY(struct timeline_thread) timeline_threads;
+
+static FILE *timeline_file = NULL;
+static char *timeline_file_path = NULL;
+static int64_t timeline_file_max_size = 0;
+
+static void write_json_string(FILE *f, const char *str)
+{
+	fputc('"', f);
+
+	for (; str && *str; str++) {
+		unsigned char ch = (unsigned char)*str;
+
+		if (ch == '"' || ch == '\\')
+			fprintf(f, "\\%c", ch);
+		else if (ch < 0x20)
+			fprintf(f, "\\u%04x", ch);
+		else
+			fputc(ch, f);
+	}
+
+	fputc('"', f);
+}
+
+static void write_thread_name(FILE *f, const struct timeline_thread *thread)
+{
+	fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+		   "\"tid\":%" PRIu32 ",\"args\":{\"name\":",
+		thread->id);
+	write_json_string(f, thread->name);
+	fputs("}}", f);
+}
+
+static inline double timeline_usec(uint64_t ts)
+{
+	return (double)(int64_t)(ts - timeline_start_time) / 1000.0;
+}
+
+static void write_event(FILE *f, const struct timeline_event *event)
+{
+	fputs("{\"name\":", f);
+	write_json_string(f, event->name);
+	fprintf(f,
+		",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f,"
+		"\"dur\":%.3f}",
+		event->thread_id, timeline_usec(event->start_time),
+		(double)(event->end_time - event->start_time) / 1000.0);
+}
+
+/* the continuous file uses the JSON array format, which doesn't need the
+ * closing bracket, so that a file is readable at any point */
+static bool timeline_open_file(void)
+{
+	timeline_file = os_fopen(timeline_file_path, "wb");
+	if (!timeline_file)
+		return false;
+
+	fputs("[\n", timeline_file);
+	for (size_t i = 0; i < timeline_threads.num; i++) {
+		write_thread_name(timeline_file, &timeline_threads.array[i]);
+		fputs(",\n", timeline_file);
+	}
+
+	return true;
+}
+
+static void timeline_close_file(void)
+{
+	if (timeline_file) {
+		fclose(timeline_file);
+		timeline_file = NULL;
+	}
+
+	bfree(timeline_file_path);
+	timeline_file_path = NULL;
+}
+
+/* keeps the previous file as <path>.1 */
+static void timeline_rotate_file(void)
+{
+	struct dstr old_path = {0};
+
+	fclose(timeline_file);
+	timeline_file = NULL;
+
+	dstr_printf(&old_path, "%s.1", timeline_file_path);
+	os_rename(timeline_file_path, old_path.array);
+	dstr_free(&old_path);
+
+	if (!timeline_open_file()) {
+		blog(LOG_WARNING, "Could not open profiler timeline file '%s'",
+		     timeline_file_path);
+		timeline_close_file();
+	}
+}
+
+static void timeline_add_block(profile_thread *thread, profile_block *block)
+{
+	if (!os_atomic_load_bool(&timeline_enabled) || !block->num)
+		return;
+
+	pthread_mutex_lock(&timeline_mutex);
+
+	/* threads are named after their first root, like
+	 * obs_graphics_thread or audio_thread */
+	if (!thread->timeline_named) {
+		struct timeline_thread *t = da_push_back_new(timeline_threads);
+		t->id = thread->id;
+		t->name = block->calls[0].name;
+		thread->timeline_named = true;
+
+		if (timeline_file) {
+			write_thread_name(timeline_file, t);
+			fputs(",\n", timeline_file);
+		}
+	}
+
+	for (size_t i = 0; i < block->num; i++) {
+		const profile_call *call = &block->calls[i];
+		struct timeline_event event = {
+			.name = call->name,
+			.start_time = call->start_time,
+			.end_time = call->end_time,
+			.thread_id = thread->id,
+		};
+
+		if (timeline_events.size ==
+		    timeline_max_events * sizeof(event))
+			circlebuf_pop_front(&timeline_events, NULL,
+					    sizeof(event));
+		circlebuf_push_back(&timeline_events, &event, sizeof(event));
+
+		if (timeline_file) {
+			write_event(timeline_file, &event);
+			fputs(",\n", timeline_file);
+		}
+	}
+
+	if (timeline_file && timeline_file_max_size &&
+	    os_ftelli64(timeline_file) >= timeline_file_max_size)
+		timeline_rotate_file();
+
+	pthread_mutex_unlock(&timeline_mutex);
+}
+
+void profiler_timeline_enable(size_t max_events)
+{
+	if (!max_events)
+		max_events = PROFILE_TIMELINE_DEFAULT_EVENTS;
+
+	pthread_mutex_lock(&timeline_mutex);
+
+	if (max_events != timeline_max_events) {
+		circlebuf_free(&timeline_events);
+		circlebuf_reserve(&timeline_events,
+				  max_events * sizeof(struct timeline_event));
+		timeline_max_events = max_events;
+	}
+
+	if (!timeline_start_time)
+		timeline_start_time = os_gettime_ns();
+
+	os_atomic_set_bool(&timeline_enabled, true);
+
+	pthread_mutex_unlock(&timeline_mutex);
+}
+
+void profiler_timeline_disable(void)
+{
+	merge_pending();
+
+	pthread_mutex_lock(&timeline_mutex);
+	os_atomic_set_bool(&timeline_enabled, false);
+	timeline_close_file();
+	pthread_mutex_unlock(&timeline_mutex);
+}
+
+bool profiler_timeline_active(void)
+{
+	return os_atomic_load_bool(&timeline_enabled);
+}
+
+bool profiler_timeline_set_file(const char *filename, size_t max_size)
+{
+	bool success = true;
+
+	pthread_mutex_lock(&timeline_mutex);
+
+	timeline_close_file();
+
+	if (filename && *filename) {
+		timeline_file_path = bstrdup(filename);
+		timeline_file_max_size = (int64_t)max_size;
+
+		if (!timeline_open_file()) {
+			timeline_close_file();
+			success = false;
+		}
+	}
+
+	pthread_mutex_unlock(&timeline_mutex);
+	return success;
+}
+
+bool profiler_timeline_dump_json(const char *filename)
+{
+	bool first = true;
+	size_t num;
+	FILE *f;
+
+	/* include calls that ended but haven't been merged yet */
+	merge_pending();
+
+	f = os_fopen(filename, "wb");
+	if (!f)
+		return false;
+
+	pthread_mutex_lock(&timeline_mutex);
+
+	num = timeline_events.size / sizeof(struct timeline_event);
+	fputs("{\"traceEvents\":[\n", f);
+
+	for (size_t i = 0; i < timeline_threads.num; i++) {
+		if (!first)
+			fputs(",\n", f);
+		write_thread_name(f, &timeline_threads.array[i]);
+		first = false;
+	}
+
+	for (size_t i = 0; i < num; i++) {
+		size_t offset = i * sizeof(struct timeline_event);
+
+		if (!first)
+			fputs(",\n", f);
+		write_event(f, circlebuf_data(&timeline_events, offset));
+		first = false;
+	}
+
+	fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+
+	pthread_mutex_unlock(&timeline_mutex);
+
+	fclose(f);
+	return true;
+}
+
+static void timeline_free(void)
+{
+	pthread_mutex_lock(&timeline_mutex);
+	os_atomic_set_bool(&timeline_enabled, false);
+	timeline_close_file();
+	circlebuf_free(&timeline_events);
+	timeline_max_events = 0;
+	timeline_start_time = 0;
+	da_free(timeline_threads);
+	pthread_mutex_unlock(&timeline_mutex);
+}
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
@@ -931,6 +1455,8 @@ profiler_snapshot_t *profile_snapshot_create(void)
 {
 	profiler_snapshot_t *snap = bzalloc(sizeof(profiler_snapshot_t));
 
+	merge_pending();
+
 	pthread_mutex_lock(&root_mutex);
 	da_reserve(snap->roots, root_entries.num);
 	for (size_t i = 0; i < root_entries.num; i++) {
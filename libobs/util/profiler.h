@@ -33,6 +33,16 @@ EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
 
 EXPORT void profiler_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* Timeline */
+
+EXPORT void profiler_timeline_enable(size_t max_events);
+EXPORT void profiler_timeline_disable(void);
+EXPORT bool profiler_timeline_active(void);
+
+EXPORT bool profiler_timeline_set_file(const char *filename, size_t max_size);
+EXPORT bool profiler_timeline_dump_json(const char *filename);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2021 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+#include "bmem.h"
+#include "threading.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Single producer, single consumer pointer queue
+ *
+ *   A fixed size lock-free ring of pointers.  One thread may push while
+ * another thread pops without any locking.  If more than one thread pushes
+ * (or pops), those threads must be serialized by the caller.
+ */
+
+struct spsc_queue {
+	void **items;
+	long mask;
+
+	volatile long head; /* next item to pop, written by the consumer */
+	volatile long tail; /* next free slot, written by the producer */
+};
+
+/** Initializes the queue so that it can hold at least capacity items */
+static inline void spsc_queue_init(struct spsc_queue *q, size_t capacity)
+{
+	long size = 2;
+
+	/* one slot always stays empty to tell a full queue from an empty one */
+	while ((size_t)size < capacity + 1)
+		size <<= 1;
+
+	q->items = (void **)bzalloc(sizeof(void *) * size);
+	q->mask = size - 1;
+	q->head = 0;
+	q->tail = 0;
+}
+
+static inline void spsc_queue_free(struct spsc_queue *q)
+{
+	bfree(q->items);
+	q->items = NULL;
+	q->mask = 0;
+	q->head = 0;
+	q->tail = 0;
+}
+
+/** Producer side, returns false if the queue is full */
+static inline bool spsc_queue_push(struct spsc_queue *q, void *item)
+{
+	long tail = os_atomic_load_long(&q->tail);
+	long next = (tail + 1) & q->mask;
+
+	if (next == os_atomic_load_long(&q->head))
+		return false;
+
+	q->items[tail] = item;
+	os_atomic_set_long(&q->tail, next);
+	return true;
+}
+
+/** Consumer side, returns NULL if the queue is empty */
+static inline void *spsc_queue_pop(struct spsc_queue *q)
+{
+	long head = os_atomic_load_long(&q->head);
+	void *item;
+
+	if (head == os_atomic_load_long(&q->tail))
+		return NULL;
+
+	item = q->items[head];
+	os_atomic_set_long(&q->head, (head + 1) & q->mask);
+	return item;
+}
+
+/** Number of queued items, only exact when called from either end */
+static inline size_t spsc_queue_size(struct spsc_queue *q)
+{
+	long head = os_atomic_load_long(&q->head);
+	long tail = os_atomic_load_long(&q->tail);
+
+	return (size_t)((tail - head) & q->mask);
+}
+
+/** Maximum number of items the queue can hold */
+static inline size_t spsc_queue_capacity(const struct spsc_queue *q)
+{
+	return (size_t)q->mask;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2021 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "task-pool.h"
+#include "threading.h"
+#include "platform.h"
+#include "bmem.h"
+#include "dstr.h"
+#include "base.h"
+
+struct task_worker {
+	struct os_task_pool *pool;
+	pthread_t thread;
+	os_sem_t *start;
+	bool initialized;
+};
+
+struct os_task_pool {
+	char *name;
+	struct task_worker *workers;
+	size_t num_workers;
+
+	/* only one loop can run on the pool at a time */
+	pthread_mutex_t run_mutex;
+	os_event_t *done_event;
+	volatile bool stop;
+
+	os_task_t task;
+	void *param;
+	long count;
+	volatile long next_idx;
+	volatile long active_workers;
+};
+
+static inline void run_tasks(struct os_task_pool *pool)
+{
+	long idx;
+
+	while ((idx = os_atomic_inc_long(&pool->next_idx) - 1) < pool->count)
+		pool->task(pool->param, (size_t)idx);
+}
+
+static void *task_worker_thread(void *data)
+{
+	struct task_worker *worker = data;
+	struct os_task_pool *pool = worker->pool;
+	struct dstr name = {0};
+
+	dstr_printf(&name, "%s: task worker", pool->name);
+	os_set_thread_name(name.array);
+	dstr_free(&name);
+
+	for (;;) {
+		if (os_sem_wait(worker->start) != 0)
+			break;
+		if (pool->stop)
+			break;
+
+		run_tasks(pool);
+
+		if (os_atomic_dec_long(&pool->active_workers) == 0)
+			os_event_signal(pool->done_event);
+	}
+
+	return NULL;
+}
+
+static void stop_workers(struct os_task_pool *pool)
+{
+	pool->stop = true;
+
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct task_worker *worker = &pool->workers[i];
+		if (worker->initialized)
+			os_sem_post(worker->start);
+	}
+
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct task_worker *worker = &pool->workers[i];
+		if (worker->initialized)
+			pthread_join(worker->thread, NULL);
+		os_sem_destroy(worker->start);
+	}
+}
+
+os_task_pool_t *os_task_pool_create(const char *name, size_t threads)
+{
+	struct os_task_pool *pool = bzalloc(sizeof(struct os_task_pool));
+
+	if (!threads) {
+		int cores = os_get_logical_cores();
+		threads = cores > 1 ? (size_t)(cores - 1) : 1;
+	}
+
+	pool->name = bstrdup(name ? name : "task pool");
+	pool->num_workers = threads;
+	pool->workers = bzalloc(sizeof(struct task_worker) * threads);
+
+	pthread_mutex_init_value(&pool->run_mutex);
+	if (pthread_mutex_init(&pool->run_mutex, NULL) != 0)
+		goto fail;
+	if (os_event_init(&pool->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	for (size_t i = 0; i < threads; i++) {
+		struct task_worker *worker = &pool->workers[i];
+		worker->pool = pool;
+
+		if (os_sem_init(&worker->start, 0) != 0)
+			goto fail;
+		if (pthread_create(&worker->thread, NULL, task_worker_thread,
+				   worker) != 0)
+			goto fail;
+
+		worker->initialized = true;
+	}
+
+	return pool;
+
+fail:
+	blog(LOG_ERROR, "os_task_pool_create: failed to create task pool '%s'",
+	     pool->name);
+	os_task_pool_destroy(pool);
+	return NULL;
+}
+
+void os_task_pool_destroy(os_task_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	stop_workers(pool);
+
+	os_event_destroy(pool->done_event);
+	pthread_mutex_destroy(&pool->run_mutex);
+	bfree(pool->workers);
+	bfree(pool->name);
+	bfree(pool);
+}
+
+size_t os_task_pool_get_threads(const os_task_pool_t *pool)
+{
+	return pool ? pool->num_workers : 0;
+}
+
+void os_task_pool_run(os_task_pool_t *pool, os_task_t task, void *param,
+		      size_t count)
+{
+	size_t wake;
+
+	if (!task || !count)
+		return;
+
+	/* not worth waking up any threads for a single task */
+	if (!pool || count == 1) {
+		for (size_t i = 0; i < count; i++)
+			task(param, i);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->run_mutex);
+
+	/* the calling thread takes one of the tasks itself */
+	wake = count - 1;
+	if (wake > pool->num_workers)
+		wake = pool->num_workers;
+
+	pool->task = task;
+	pool->param = param;
+	pool->count = (long)count;
+	os_atomic_set_long(&pool->next_idx, 0);
+	os_atomic_set_long(&pool->active_workers, (long)wake);
+
+	for (size_t i = 0; i < wake; i++)
+		os_sem_post(pool->workers[i].start);
+
+	run_tasks(pool);
+
+	if (wake)
+		os_event_wait(pool->done_event);
+
+	pthread_mutex_unlock(&pool->run_mutex);
+}
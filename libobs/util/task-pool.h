@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2021 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+
+/*
+ * Task pool
+ *
+ *   A small pool of worker threads used to run the iterations of a loop in
+ * parallel.  The thread calling os_task_pool_run() takes part in the work and
+ * only returns once every iteration has completed, so the pool behaves like a
+ * parallel "for" loop.  Iterations are handed out one at a time from a shared
+ * counter, so threads that finish early keep pulling work instead of idling
+ * while a slow iteration completes.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_task_pool;
+typedef struct os_task_pool os_task_pool_t;
+
+typedef void (*os_task_t)(void *param, size_t idx);
+
+/**
+ * Creates a task pool with the specified number of worker threads (in
+ * addition to the calling thread).  If threads is 0, the number of logical
+ * cores minus one is used.
+ */
+EXPORT os_task_pool_t *os_task_pool_create(const char *name, size_t threads);
+EXPORT void os_task_pool_destroy(os_task_pool_t *pool);
+
+/** Returns the number of worker threads of the pool */
+EXPORT size_t os_task_pool_get_threads(const os_task_pool_t *pool);
+
+/**
+ * Calls task(param, idx) for every idx in [0, count) and waits for all calls
+ * to complete.  Calls may happen in any order and on any thread.  If pool is
+ * NULL the loop simply runs on the calling thread.
+ */
+EXPORT void os_task_pool_run(os_task_pool_t *pool, os_task_t task, void *param,
+			     size_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -26,6 +26,11 @@ static inline long os_atomic_dec_long(volatile long *val)
 	return __atomic_sub_fetch(val, 1, __ATOMIC_SEQ_CST);
 }
 
+static inline long os_atomic_add_long(volatile long *val, long n)
+{
+	return __atomic_add_fetch(val, n, __ATOMIC_SEQ_CST);
+}
+
 static inline void os_atomic_store_long(volatile long *ptr, long val)
 {
 	__atomic_store_n(ptr, val, __ATOMIC_SEQ_CST);
@@ -34,6 +34,11 @@ static inline long os_atomic_dec_long(volatile long *val)
 	return _InterlockedDecrement(val);
 }
 
+static inline long os_atomic_add_long(volatile long *val, long n)
+{
+	return _InterlockedExchangeAdd(val, n) + n;
+}
+
 static inline void os_atomic_store_long(volatile long *ptr, long val)
 {
 #if defined(_M_ARM64)
@@ -0,0 +1,538 @@
+/*
+ * Copyright (c) 2021 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "ffmpeg-mux-shm.h"
+
+#define FFM_SHM_MAGIC 0x4d4d4646 /* "FFMM" */
+#define FFM_SHM_MAX_SIZE (1 << 30)
+
+/* if the reader does not make any room for this long, it is considered
+ * to be stuck or dead */
+#define FFM_SHM_STALL_TIMEOUT_MS 10000
+
+/* positions only ever increase and wrap around, so (write_pos - read_pos) is
+ * the number of queued bytes.  the two positions are kept on separate cache
+ * lines as they are written by different processes.
+ *
+ * a writer that runs out of room sets writer_waiting and sleeps until the
+ * reader signals that it made room, through a process shared condition
+ * variable in the header, or a named event on windows. */
+struct ffm_shm_header {
+	uint32_t magic;
+	uint32_t size;
+	volatile long closed;
+	volatile long reader_attached;
+	volatile long reader_waiting;
+	volatile long writer_waiting;
+	volatile long write_pos;
+	uint8_t pad1[64 - 8 - 5 * sizeof(long)];
+
+	volatile long read_pos;
+	uint8_t pad2[64 - sizeof(long)];
+
+#ifndef _WIN32
+	pthread_mutex_t space_mutex;
+	pthread_cond_t space_cond;
+#endif
+};
+
+struct ffm_shm {
+	struct ffm_shm_header *header;
+	uint8_t *data;
+	size_t map_size;
+	struct dstr name;
+	bool owner;
+#ifdef _WIN32
+	HANDLE mapping;
+	HANDLE space_event;
+#else
+	bool space_initialized;
+#endif
+};
+
+static volatile long shm_counter = 0;
+
+static inline unsigned long shm_queued(const struct ffm_shm_header *header)
+{
+	unsigned long write_pos = os_atomic_load_long(&header->write_pos);
+	unsigned long read_pos = os_atomic_load_long(&header->read_pos);
+	return write_pos - read_pos;
+}
+
+#ifdef _WIN32
+static bool map_shm(struct ffm_shm *shm, bool create)
+{
+	wchar_t *name = NULL;
+
+	os_utf8_to_wcs_ptr(shm->name.array, 0, &name);
+	if (!name)
+		return false;
+
+	if (create) {
+		shm->mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL,
+						  PAGE_READWRITE, 0,
+						  (DWORD)shm->map_size, name);
+		if (shm->mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+			CloseHandle(shm->mapping);
+			shm->mapping = NULL;
+		}
+	} else {
+		shm->mapping =
+			OpenFileMappingW(FILE_MAP_ALL_ACCESS, false, name);
+	}
+
+	if (shm->mapping) {
+		/* same name with a suffix, auto-reset so that a signal sent
+		 * before the writer waits is not lost */
+		size_t len = wcslen(name);
+		wchar_t *event_name = bmalloc((len + 7) * sizeof(wchar_t));
+
+		memcpy(event_name, name, len * sizeof(wchar_t));
+		memcpy(event_name + len, L"-space", 7 * sizeof(wchar_t));
+
+		shm->space_event =
+			create ? CreateEventW(NULL, false, false, event_name)
+			       : OpenEventW(SYNCHRONIZE | EVENT_MODIFY_STATE,
+					    false, event_name);
+		bfree(event_name);
+	}
+
+	bfree(name);
+
+	if (!shm->mapping || !shm->space_event)
+		return false;
+
+	shm->header = MapViewOfFile(shm->mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+				    create ? shm->map_size : 0);
+	if (!shm->header)
+		return false;
+
+	if (!create) {
+		MEMORY_BASIC_INFORMATION info;
+		if (!VirtualQuery(shm->header, &info, sizeof(info)))
+			return false;
+		shm->map_size = info.RegionSize;
+	}
+
+	return true;
+}
+
+static void unmap_shm(struct ffm_shm *shm)
+{
+	if (shm->header)
+		UnmapViewOfFile(shm->header);
+	if (shm->mapping)
+		CloseHandle(shm->mapping);
+	if (shm->space_event)
+		CloseHandle(shm->space_event);
+}
+
+static bool init_space_signal(struct ffm_shm *shm)
+{
+	UNUSED_PARAMETER(shm);
+	return true;
+}
+
+static void signal_space(struct ffm_shm *shm)
+{
+	SetEvent(shm->space_event);
+}
+
+static bool wait_space(struct ffm_shm *shm, unsigned long timeout_ms)
+{
+	return WaitForSingleObject(shm->space_event, timeout_ms) ==
+	       WAIT_OBJECT_0;
+}
+
+static void get_shm_name(struct dstr *name)
+{
+	dstr_printf(name, "Local\\obs-ffmpeg-mux-%lu-%ld",
+		    GetCurrentProcessId(), os_atomic_inc_long(&shm_counter));
+}
+
+#else
+static bool map_shm(struct ffm_shm *shm, bool create)
+{
+	void *ptr;
+	int fd;
+
+	if (create) {
+		fd = shm_open(shm->name.array, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd == -1)
+			return false;
+
+		if (ftruncate(fd, (off_t)shm->map_size) == -1) {
+			close(fd);
+			shm_unlink(shm->name.array);
+			return false;
+		}
+	} else {
+		struct stat st;
+
+		fd = shm_open(shm->name.array, O_RDWR, 0600);
+		if (fd == -1)
+			return false;
+
+		if (fstat(fd, &st) == -1) {
+			close(fd);
+			return false;
+		}
+
+		shm->map_size = (size_t)st.st_size;
+	}
+
+	ptr = mmap(NULL, shm->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   0);
+	close(fd);
+
+	/* the mapping keeps the memory alive, drop the name right away so
+	 * that nothing is left behind if either process crashes */
+	if (!create)
+		shm_unlink(shm->name.array);
+
+	if (ptr == MAP_FAILED) {
+		if (create)
+			shm_unlink(shm->name.array);
+		return false;
+	}
+
+	shm->header = ptr;
+	return true;
+}
+
+static void unmap_shm(struct ffm_shm *shm)
+{
+	if (shm->space_initialized) {
+		pthread_cond_destroy(&shm->header->space_cond);
+		pthread_mutex_destroy(&shm->header->space_mutex);
+	}
+	if (shm->header)
+		munmap(shm->header, shm->map_size);
+	if (shm->owner)
+		shm_unlink(shm->name.array);
+}
+
+static bool init_space_signal(struct ffm_shm *shm)
+{
+	struct ffm_shm_header *header = shm->header;
+	pthread_mutexattr_t mutex_attr;
+	pthread_condattr_t cond_attr;
+	bool success = false;
+
+	if (pthread_mutexattr_init(&mutex_attr) != 0)
+		return false;
+	if (pthread_condattr_init(&cond_attr) != 0)
+		goto free_mutex_attr;
+
+	if (pthread_mutexattr_setpshared(&mutex_attr,
+					 PTHREAD_PROCESS_SHARED) != 0 ||
+	    pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED) !=
+		    0)
+		goto free_cond_attr;
+
+	if (pthread_mutex_init(&header->space_mutex, &mutex_attr) != 0)
+		goto free_cond_attr;
+	if (pthread_cond_init(&header->space_cond, &cond_attr) != 0) {
+		pthread_mutex_destroy(&header->space_mutex);
+		goto free_cond_attr;
+	}
+
+	shm->space_initialized = true;
+	success = true;
+
+free_cond_attr:
+	pthread_condattr_destroy(&cond_attr);
+free_mutex_attr:
+	pthread_mutexattr_destroy(&mutex_attr);
+	return success;
+}
+
+/* taking the mutex orders the signal after the writer has either seen the
+ * room or started waiting, so it can't be lost */
+static void signal_space(struct ffm_shm *shm)
+{
+	pthread_mutex_lock(&shm->header->space_mutex);
+	pthread_cond_signal(&shm->header->space_cond);
+	pthread_mutex_unlock(&shm->header->space_mutex);
+}
+
+static inline bool ring_full(const struct ffm_shm *shm)
+{
+	return shm_queued(shm->header) == shm->header->size &&
+	       !os_atomic_load_long(&shm->header->closed);
+}
+
+static bool wait_space(struct ffm_shm *shm, unsigned long timeout_ms)
+{
+	struct ffm_shm_header *header = shm->header;
+	struct timespec ts;
+	int ret = 0;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += timeout_ms / 1000;
+	ts.tv_nsec += (timeout_ms % 1000) * 1000000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&header->space_mutex);
+	while (ret == 0 && ring_full(shm))
+		ret = pthread_cond_timedwait(&header->space_cond,
+					     &header->space_mutex, &ts);
+	pthread_mutex_unlock(&header->space_mutex);
+
+	return ret != ETIMEDOUT;
+}
+
+static void get_shm_name(struct dstr *name)
+{
+	dstr_printf(name, "/obs-ffmpeg-mux-%ld-%ld", (long)getpid(),
+		    os_atomic_inc_long(&shm_counter));
+}
+#endif
+
+struct ffm_shm *ffm_shm_create(size_t size)
+{
+	struct ffm_shm *shm = bzalloc(sizeof(*shm));
+	uint32_t ring_size = 4096;
+
+	while (ring_size < size && ring_size < FFM_SHM_MAX_SIZE)
+		ring_size <<= 1;
+
+	get_shm_name(&shm->name);
+	shm->owner = true;
+	shm->map_size = sizeof(struct ffm_shm_header) + ring_size;
+
+	if (!map_shm(shm, true)) {
+		ffm_shm_destroy(shm);
+		return NULL;
+	}
+
+	memset(shm->header, 0, sizeof(*shm->header));
+	shm->header->magic = FFM_SHM_MAGIC;
+	shm->header->size = ring_size;
+	shm->data = (uint8_t *)(shm->header + 1);
+
+	if (!init_space_signal(shm)) {
+		ffm_shm_destroy(shm);
+		return NULL;
+	}
+
+	return shm;
+}
+
+struct ffm_shm *ffm_shm_open(const char *name)
+{
+	struct ffm_shm *shm = bzalloc(sizeof(*shm));
+	uint32_t ring_size;
+
+	dstr_copy(&shm->name, name);
+
+	if (!map_shm(shm, false) || shm->map_size < sizeof(*shm->header))
+		goto fail;
+
+	ring_size = shm->header->size;
+
+	if (shm->header->magic != FFM_SHM_MAGIC ||
+	    (ring_size & (ring_size - 1)) != 0 ||
+	    shm->map_size < sizeof(*shm->header) + ring_size)
+		goto fail;
+
+	shm->data = (uint8_t *)(shm->header + 1);
+	os_atomic_set_long(&shm->header->reader_attached, 1);
+	return shm;
+
+fail:
+	ffm_shm_destroy(shm);
+	return NULL;
+}
+
+void ffm_shm_destroy(struct ffm_shm *shm)
+{
+	if (!shm)
+		return;
+
+	unmap_shm(shm);
+	dstr_free(&shm->name);
+	bfree(shm);
+}
+
+const char *ffm_shm_name(const struct ffm_shm *shm)
+{
+	return shm->name.array;
+}
+
+void ffm_shm_set_closed(struct ffm_shm *shm)
+{
+	os_atomic_set_long(&shm->header->closed, 1);
+	signal_space(shm);
+}
+
+bool ffm_shm_closed(const struct ffm_shm *shm)
+{
+	return os_atomic_load_long(&shm->header->closed) != 0;
+}
+
+bool ffm_shm_signal(struct ffm_shm *shm, ffm_shm_wake_t wake, void *param)
+{
+	/* until the reader has opened the ring, wake it up every time.  if it
+	 * exited because it could not open the ring, the wake up fails right
+	 * away instead of the writer waiting for room that never comes. */
+	if (!os_atomic_load_long(&shm->header->reader_attached) ||
+	    os_atomic_exchange_long(&shm->header->reader_waiting, 0))
+		return wake(param);
+	return true;
+}
+
+static void copy_in(struct ffm_shm *shm, unsigned long pos, const uint8_t *data,
+		    size_t size)
+{
+	size_t mask = shm->header->size - 1;
+	size_t offset = pos & mask;
+	size_t first = shm->header->size - offset;
+
+	if (first > size)
+		first = size;
+
+	memcpy(shm->data + offset, data, first);
+	memcpy(shm->data, data + first, size - first);
+}
+
+static void copy_out(struct ffm_shm *shm, unsigned long pos, uint8_t *data,
+		     size_t size)
+{
+	size_t mask = shm->header->size - 1;
+	size_t offset = pos & mask;
+	size_t first = shm->header->size - offset;
+
+	if (first > size)
+		first = size;
+
+	memcpy(data, shm->data + offset, first);
+	memcpy(data + first, shm->data, size - first);
+}
+
+size_t ffm_shm_write(struct ffm_shm *shm, const void *vdata, size_t size,
+		     ffm_shm_wake_t wake, void *param)
+{
+	struct ffm_shm_header *header = shm->header;
+	const uint8_t *data = vdata;
+	size_t total = size;
+
+	while (size > 0) {
+		unsigned long write_pos;
+		size_t space;
+
+		if (ffm_shm_closed(shm))
+			break;
+
+		space = header->size - shm_queued(header);
+
+		if (!space) {
+			/* the reader checks this flag after making room, so
+			 * check again after setting it, like the reader does
+			 * for data */
+			os_atomic_set_long(&header->writer_waiting, 1);
+			if (shm_queued(header) < header->size)
+				continue;
+
+			/* the reader must be awake to make room */
+			if (!ffm_shm_signal(shm, wake, param))
+				break;
+			if (!wait_space(shm, FFM_SHM_STALL_TIMEOUT_MS))
+				break;
+			continue;
+		}
+
+		if (space > size)
+			space = size;
+
+		write_pos = os_atomic_load_long(&header->write_pos);
+		copy_in(shm, write_pos, data, space);
+		os_atomic_set_long(&header->write_pos,
+				   (long)(write_pos + (unsigned long)space));
+
+		data += space;
+		size -= space;
+	}
+
+	return total - size;
+}
+
+size_t ffm_shm_read(struct ffm_shm *shm, void *vdata, size_t size,
+		    ffm_shm_wait_t wait, void *param)
+{
+	struct ffm_shm_header *header = shm->header;
+	uint8_t *data = vdata;
+	size_t total = size;
+	bool done = false;
+
+	while (size > 0) {
+		unsigned long read_pos;
+		size_t queued = shm_queued(header);
+
+		if (!queued) {
+			if (done)
+				break;
+
+			/* the writer checks this flag after publishing data,
+			 * so check again after setting it.  a wake up that
+			 * arrives after all is harmless, it just makes a later
+			 * wait return early. */
+			os_atomic_set_long(&header->reader_waiting, 1);
+			if (shm_queued(header))
+				continue;
+
+			done = !wait(param);
+			continue;
+		}
+
+		if (queued > size)
+			queued = size;
+
+		read_pos = os_atomic_load_long(&header->read_pos);
+		copy_out(shm, read_pos, data, queued);
+		os_atomic_set_long(&header->read_pos,
+				   (long)(read_pos + (unsigned long)queued));
+
+		if (os_atomic_exchange_long(&header->writer_waiting, 0))
+			signal_space(shm);
+
+		data += queued;
+		size -= queued;
+	}
+
+	return total - size;
+}
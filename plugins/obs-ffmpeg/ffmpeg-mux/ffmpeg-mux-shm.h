@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2021 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Shared memory transport between obs and ffmpeg-mux
+ *
+ *   A byte ring in shared memory that replaces the packet data going through
+ * the stdin pipe of ffmpeg-mux.  There is one writer (obs) and one reader
+ * (ffmpeg-mux).  The pipe stays open and is only used to wake up the reader
+ * when it is waiting for data, and to tell it that the writer is done by
+ * closing it.
+ */
+
+#define FFM_SHM_DEFAULT_SIZE (16 * 1024 * 1024)
+
+struct ffm_shm;
+
+/** Called by the writer to wake up a waiting reader */
+typedef bool (*ffm_shm_wake_t)(void *param);
+/** Called by the reader to wait for a wake up, false once the writer is done */
+typedef bool (*ffm_shm_wait_t)(void *param);
+
+/** Creates a new ring, size is rounded up to a power of two */
+struct ffm_shm *ffm_shm_create(size_t size);
+/** Opens a ring created by another process */
+struct ffm_shm *ffm_shm_open(const char *name);
+void ffm_shm_destroy(struct ffm_shm *shm);
+
+const char *ffm_shm_name(const struct ffm_shm *shm);
+
+/** Marks the reader as gone, the writer fails from then on */
+void ffm_shm_set_closed(struct ffm_shm *shm);
+bool ffm_shm_closed(const struct ffm_shm *shm);
+
+/**
+ * Writes all of data, waiting for the reader to make room if needed.
+ * Returns less than size if the reader is gone or stopped reading.
+ */
+size_t ffm_shm_write(struct ffm_shm *shm, const void *data, size_t size,
+		     ffm_shm_wake_t wake, void *param);
+/** Wakes up the reader if it is waiting for the data written so far */
+bool ffm_shm_signal(struct ffm_shm *shm, ffm_shm_wake_t wake, void *param);
+
+/**
+ * Reads size bytes, waiting for the writer if needed.  Returns less than
+ * size once the writer is done.
+ */
+size_t ffm_shm_read(struct ffm_shm *shm, void *data, size_t size,
+		    ffm_shm_wait_t wait, void *param);
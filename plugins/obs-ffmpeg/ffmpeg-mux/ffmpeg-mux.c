@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "ffmpeg-mux.h"
+#include "ffmpeg-mux-shm.h"
 
 #include <util/dstr.h>
 #include <libavformat/avformat.h>
@@ -42,6 +43,7 @@
 /* ------------------------------------------------------------------------- */
 
 static char *global_stream_key = "";
+static struct ffm_shm *global_shm = NULL;
 
 struct resize_buf {
 	uint8_t *buf;
@@ -93,6 +95,7 @@ struct main_params {
 	int color_range;
 	char *acodec;
 	char *muxer_settings;
+	char *shm_name;
 };
 
 struct audio_params {
@@ -349,6 +352,18 @@ static bool init_params(int *argc, char ***argv, struct main_params *params,
 
 	get_opt_str(argc, argv, &params->muxer_settings, "muxer settings");
 
+	/* optional, packet data comes through stdin if not set */
+	if (*argc) {
+		get_opt_str(argc, argv, &params->shm_name, "shared memory");
+
+		global_shm = ffm_shm_open(params->shm_name);
+		if (!global_shm) {
+			fprintf(stderr, "Failed to open shared memory '%s'\n",
+				params->shm_name);
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -517,11 +532,23 @@ static void ffmpeg_mux_header(struct ffmpeg_mux *ffm, uint8_t *data,
 	}
 }
 
+static bool wait_shm_data(void *param)
+{
+	uint8_t wake;
+
+	UNUSED_PARAMETER(param);
+	return fread(&wake, 1, 1, stdin) == 1;
+}
+
 static size_t safe_read(void *vdata, size_t size)
 {
 	uint8_t *data = vdata;
 	size_t total = size;
 
+	if (global_shm)
+		return ffm_shm_read(global_shm, vdata, size, wait_shm_data,
+				    NULL);
+
 	while (size > 0) {
 		size_t in_size = fread(data, 1, size, stdin);
 		if (in_size == 0)
@@ -856,6 +883,8 @@ int main(int argc, char *argv[])
 	ret = ffmpeg_mux_init(&ffm, argc, argv);
 	if (ret != FFM_SUCCESS) {
 		fprintf(stderr, "Couldn't initialize muxer\n");
+		if (global_shm)
+			ffm_shm_set_closed(global_shm);
 		return ret;
 	}
 
@@ -872,6 +901,11 @@ int main(int argc, char *argv[])
 	ffmpeg_mux_free(&ffm);
 	resize_buf_free(&rb);
 
+	if (global_shm) {
+		ffm_shm_set_closed(global_shm);
+		ffm_shm_destroy(global_shm);
+	}
+
 #ifdef _WIN32
 	for (int i = 0; i < argc; i++)
 		free(argv[i]);
@@ -51,12 +51,14 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	}
 
 	circlebuf_free(&stream->packets);
+	replay_store_destroy(stream->store);
+	stream->store = NULL;
 	stream->cur_size = 0;
 	stream->cur_time = 0;
 	stream->max_size = 0;
 	stream->max_time = 0;
 	stream->save_ts = 0;
-	stream->keyframes = 0;
+	replay_index_free(&stream->index);
 }
 
 static void ffmpeg_mux_destroy(void *data)
@@ -69,7 +71,7 @@ static void ffmpeg_mux_destroy(void *data)
 	da_free(stream->mux_packets);
 	circlebuf_free(&stream->packets);
 
-	os_process_pipe_destroy(stream->pipe);
+	stop_pipe(stream);
 	dstr_free(&stream->path);
 	dstr_free(&stream->printable_path);
 	dstr_free(&stream->stream_key);
@@ -272,14 +274,39 @@ static void build_command_line(struct ffmpeg_muxer *stream, struct dstr *cmd,
 
 	add_stream_key(cmd, stream);
 	add_muxer_params(cmd, stream);
+
+	if (stream->shm)
+		dstr_catf(cmd, "\"%s\" ", ffm_shm_name(stream->shm));
 }
 
 void start_pipe(struct ffmpeg_muxer *stream, const char *path)
 {
 	struct dstr cmd;
+
+	/* packet data goes through shared memory if possible, the pipe is
+	 * used as is otherwise */
+	stream->shm = ffm_shm_create(FFM_SHM_DEFAULT_SIZE);
+	if (!stream->shm)
+		warn("Failed to create shared memory, using the pipe only");
+
 	build_command_line(stream, &cmd, path);
 	stream->pipe = os_process_pipe_create(cmd.array, "w");
 	dstr_free(&cmd);
+
+	if (!stream->pipe) {
+		ffm_shm_destroy(stream->shm);
+		stream->shm = NULL;
+	}
+}
+
+int stop_pipe(struct ffmpeg_muxer *stream)
+{
+	int ret = os_process_pipe_destroy(stream->pipe);
+	stream->pipe = NULL;
+
+	ffm_shm_destroy(stream->shm);
+	stream->shm = NULL;
+	return ret;
 }
 
 static void set_file_not_readable_error(struct ffmpeg_muxer *stream,
@@ -375,8 +402,7 @@ int deactivate(struct ffmpeg_muxer *stream, int code)
 	}
 
 	if (active(stream)) {
-		ret = os_process_pipe_destroy(stream->pipe);
-		stream->pipe = NULL;
+		ret = stop_pipe(stream);
 
 		os_atomic_set_bool(&stream->active, false);
 		os_atomic_set_bool(&stream->sent_headers, false);
@@ -456,6 +482,23 @@ static void signal_failure(struct ffmpeg_muxer *stream)
 	os_atomic_set_bool(&stream->capturing, false);
 }
 
+static bool wake_mux(void *param)
+{
+	struct ffmpeg_muxer *stream = param;
+	const uint8_t wake = 0;
+
+	return os_process_pipe_write(stream->pipe, &wake, 1) == 1 &&
+	       os_process_pipe_flush(stream->pipe);
+}
+
+static size_t write_data(struct ffmpeg_muxer *stream, const uint8_t *data,
+			 size_t size)
+{
+	if (stream->shm)
+		return ffm_shm_write(stream->shm, data, size, wake_mux, stream);
+	return os_process_pipe_write(stream->pipe, data, size);
+}
+
 bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet)
 {
 	bool is_video = packet->type == OBS_ENCODER_VIDEO;
@@ -469,17 +512,22 @@ bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet)
 							: FFM_PACKET_AUDIO,
 				       .keyframe = packet->keyframe};
 
-	ret = os_process_pipe_write(stream->pipe, (const uint8_t *)&info,
-				    sizeof(info));
+	ret = write_data(stream, (const uint8_t *)&info, sizeof(info));
 	if (ret != sizeof(info)) {
-		warn("os_process_pipe_write for info structure failed");
+		warn("write_data for info structure failed");
 		signal_failure(stream);
 		return false;
 	}
 
-	ret = os_process_pipe_write(stream->pipe, packet->data, packet->size);
+	ret = write_data(stream, packet->data, packet->size);
 	if (ret != packet->size) {
-		warn("os_process_pipe_write for packet data failed");
+		warn("write_data for packet data failed");
+		signal_failure(stream);
+		return false;
+	}
+
+	if (stream->shm && !ffm_shm_signal(stream->shm, wake_mux, stream)) {
+		warn("Failed to wake up ffmpeg-mux");
 		signal_failure(stream);
 		return false;
 	}
@@ -709,6 +757,21 @@ static bool replay_buffer_start(void *data)
 	obs_data_t *s = obs_output_get_settings(stream->output);
 	stream->max_time = obs_data_get_int(s, "max_time_sec") * 1000000LL;
 	stream->max_size = obs_data_get_int(s, "max_size_mb") * (1024 * 1024);
+
+	if (obs_data_get_bool(s, "disk_buffer")) {
+		const char *dir = obs_data_get_string(s, "disk_buffer_path");
+		if (!*dir)
+			dir = obs_data_get_string(s, "directory");
+
+		stream->store = replay_store_create(dir);
+		if (stream->store)
+			info("Buffering to disk in '%s'", dir);
+		else
+			warn("Could not buffer to disk in '%s', "
+			     "buffering in memory",
+			     dir);
+	}
+
 	obs_data_release(s);
 
 	os_atomic_set_bool(&stream->active, true);
@@ -719,101 +782,101 @@ static bool replay_buffer_start(void *data)
 	return true;
 }
 
-static bool purge_front(struct ffmpeg_muxer *stream)
+/* the buffered packets are either kept in memory in stream->packets, or in
+ * the segment files of stream->store when buffering to disk */
+
+static inline size_t replay_buffer_count(struct ffmpeg_muxer *stream)
 {
-	struct encoder_packet pkt;
-	bool keyframe;
+	if (stream->store)
+		return replay_store_count(stream->store);
+	return stream->packets.size / sizeof(struct encoder_packet);
+}
 
-	if (!stream->packets.size)
-		return false;
+static inline bool replay_buffer_empty(struct ffmpeg_muxer *stream)
+{
+	return replay_buffer_count(stream) == 0;
+}
 
-	circlebuf_pop_front(&stream->packets, &pkt, sizeof(pkt));
+/* gets the packet at idx without referencing its data */
+static inline void replay_buffer_peek(struct ffmpeg_muxer *stream, size_t idx,
+				      struct encoder_packet *pkt)
+{
+	if (stream->store) {
+		replay_entry_get_packet(replay_store_get(stream->store, idx),
+					pkt);
+	} else {
+		size_t offset = idx * sizeof(*pkt);
+		memcpy(pkt, circlebuf_data(&stream->packets, offset),
+		       sizeof(*pkt));
+	}
+}
 
-	keyframe = pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe;
+static bool replay_buffer_push(struct ffmpeg_muxer *stream,
+			       struct encoder_packet *packet)
+{
+	struct encoder_packet pkt;
 
-	if (keyframe)
-		stream->keyframes--;
+	if (stream->store)
+		return replay_store_push(stream->store, packet);
 
-	if (!stream->packets.size) {
-		stream->cur_size = 0;
-		stream->cur_time = 0;
+	obs_encoder_packet_ref(&pkt, packet);
+	circlebuf_push_back(&stream->packets, &pkt, sizeof(pkt));
+	return true;
+}
+
+static void replay_buffer_pop_front(struct ffmpeg_muxer *stream)
+{
+	struct encoder_packet pkt;
+
+	if (stream->store) {
+		replay_store_pop_front(stream->store);
 	} else {
-		struct encoder_packet first;
-		circlebuf_peek_front(&stream->packets, &first, sizeof(first));
-		stream->cur_time = first.dts_usec;
-		stream->cur_size -= (int64_t)pkt.size;
+		circlebuf_pop_front(&stream->packets, &pkt, sizeof(pkt));
+		obs_encoder_packet_release(&pkt);
 	}
-
-	obs_encoder_packet_release(&pkt);
-	return keyframe;
 }
 
-static inline void purge(struct ffmpeg_muxer *stream)
+/* drops the packets up to the next keyframe */
+static bool purge(struct ffmpeg_muxer *stream)
 {
-	if (purge_front(stream)) {
-		struct encoder_packet pkt;
+	size_t count = replay_index_purge(&stream->index);
+	struct encoder_packet first;
 
-		for (;;) {
-			if (!stream->packets.size)
-				return;
-			circlebuf_peek_front(&stream->packets, &pkt,
-					     sizeof(pkt));
-			if (pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe)
-				return;
+	if (!count)
+		return false;
 
-			purge_front(stream);
-		}
-	}
+	for (size_t i = 0; i < count; i++)
+		replay_buffer_pop_front(stream);
+
+	replay_buffer_peek(stream, 0, &first);
+	stream->cur_time = first.dts_usec;
+	stream->cur_size = replay_index_size(&stream->index);
+	return true;
 }
 
 static inline void replay_buffer_purge(struct ffmpeg_muxer *stream,
 				       struct encoder_packet *pkt)
 {
 	if (stream->max_size) {
-		if (!stream->packets.size || stream->keyframes <= 2)
+		if (replay_buffer_empty(stream) ||
+		    replay_index_keyframes(&stream->index) <= 2)
 			return;
 
 		while ((stream->cur_size + (int64_t)pkt->size) >
-		       stream->max_size)
-			purge(stream);
+		       stream->max_size) {
+			if (!purge(stream))
+				break;
+		}
 	}
 
-	if (!stream->packets.size || stream->keyframes <= 2)
+	if (replay_buffer_empty(stream) ||
+	    replay_index_keyframes(&stream->index) <= 2)
 		return;
 
-	while ((pkt->dts_usec - stream->cur_time) > stream->max_time)
-		purge(stream);
-}
-
-static void insert_packet(struct darray *array, struct encoder_packet *packet,
-			  int64_t video_offset, int64_t *audio_offsets,
-			  int64_t video_dts_offset, int64_t *audio_dts_offsets)
-{
-	struct encoder_packet pkt;
-	DARRAY(struct encoder_packet) packets;
-	packets.da = *array;
-	size_t idx;
-
-	obs_encoder_packet_ref(&pkt, packet);
-
-	if (pkt.type == OBS_ENCODER_VIDEO) {
-		pkt.dts_usec -= video_offset;
-		pkt.dts -= video_dts_offset;
-		pkt.pts -= video_dts_offset;
-	} else {
-		pkt.dts_usec -= audio_offsets[pkt.track_idx];
-		pkt.dts -= audio_dts_offsets[pkt.track_idx];
-		pkt.pts -= audio_dts_offsets[pkt.track_idx];
-	}
-
-	for (idx = packets.num; idx > 0; idx--) {
-		struct encoder_packet *p = packets.array + (idx - 1);
-		if (p->dts_usec < pkt.dts_usec)
+	while ((pkt->dts_usec - stream->cur_time) > stream->max_time) {
+		if (!purge(stream))
 			break;
 	}
-
-	da_insert(packets, idx, &pkt);
-	*array = packets.da;
 }
 
 static void *replay_buffer_mux_thread(void *data)
@@ -821,6 +884,8 @@ static void *replay_buffer_mux_thread(void *data)
 	struct ffmpeg_muxer *stream = data;
 	bool error = false;
 
+	replay_order_packets(&stream->mux_packets.da);
+
 	start_pipe(stream, stream->path.array);
 
 	if (!stream->pipe) {
@@ -839,15 +904,18 @@ static void *replay_buffer_mux_thread(void *data)
 	for (size_t i = 0; i < stream->mux_packets.num; i++) {
 		struct encoder_packet *pkt = &stream->mux_packets.array[i];
 		write_packet(stream, pkt);
-		obs_encoder_packet_release(pkt);
+
+		/* packets from the disk buffer point into the segments */
+		if (!stream->mux_segments.num)
+			obs_encoder_packet_release(pkt);
 	}
 
 	info("Wrote replay buffer to '%s'", stream->path.array);
 
 error:
-	os_process_pipe_destroy(stream->pipe);
-	stream->pipe = NULL;
+	stop_pipe(stream);
 	da_free(stream->mux_packets);
+	replay_store_release_segments(&stream->mux_segments.da);
 	os_atomic_set_bool(&stream->muxing, false);
 
 	if (!error) {
@@ -862,42 +930,27 @@ error:
 
 static void replay_buffer_save(struct ffmpeg_muxer *stream)
 {
-	const size_t size = sizeof(struct encoder_packet);
-	size_t num_packets = stream->packets.size / size;
-
-	da_reserve(stream->mux_packets, num_packets);
+	/* keeps the disk buffer data mapped while it is being written */
+	if (stream->store)
+		replay_store_ref_segments(stream->store,
+					  &stream->mux_segments.da);
 
 	/* ---------------------------- */
-	/* reorder packets */
-
-	bool found_video = false;
-	bool found_audio[MAX_AUDIO_MIXES] = {0};
-	int64_t video_offset = 0;
-	int64_t video_dts_offset = 0;
-	int64_t audio_offsets[MAX_AUDIO_MIXES] = {0};
-	int64_t audio_dts_offsets[MAX_AUDIO_MIXES] = {0};
-
-	for (size_t i = 0; i < num_packets; i++) {
-		struct encoder_packet *pkt;
-		pkt = circlebuf_data(&stream->packets, i * size);
-
-		if (pkt->type == OBS_ENCODER_VIDEO) {
-			if (!found_video) {
-				video_offset = pkt->dts_usec;
-				video_dts_offset = pkt->dts;
-				found_video = true;
-			}
-		} else {
-			if (!found_audio[pkt->track_idx]) {
-				found_audio[pkt->track_idx] = true;
-				audio_offsets[pkt->track_idx] = pkt->dts_usec;
-				audio_dts_offsets[pkt->track_idx] = pkt->dts;
-			}
-		}
+	/* take the packets from the first keyframe on, the mux thread puts
+	 * them in order */
+
+	size_t start = replay_index_save_start(&stream->index);
+	size_t count = replay_buffer_count(stream);
+
+	da_resize(stream->mux_packets, count - start);
 
-		insert_packet(&stream->mux_packets.da, pkt, video_offset,
-			      audio_offsets, video_dts_offset,
-			      audio_dts_offsets);
+	for (size_t i = start; i < count; i++) {
+		struct encoder_packet *pkt =
+			&stream->mux_packets.array[i - start];
+
+		replay_buffer_peek(stream, i, pkt);
+		if (!stream->store)
+			obs_encoder_packet_ref(pkt, pkt);
 	}
 
 	/* ---------------------------- */
@@ -952,7 +1005,6 @@ static void deactivate_replay_buffer(struct ffmpeg_muxer *stream, int code)
 static void replay_buffer_data(void *data, struct encoder_packet *packet)
 {
 	struct ffmpeg_muxer *stream = data;
-	struct encoder_packet pkt;
 
 	if (!active(stream))
 		return;
@@ -970,17 +1022,19 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 		}
 	}
 
-	obs_encoder_packet_ref(&pkt, packet);
-	replay_buffer_purge(stream, &pkt);
+	replay_buffer_purge(stream, packet);
 
-	if (!stream->packets.size)
-		stream->cur_time = pkt.dts_usec;
-	stream->cur_size += pkt.size;
+	if (replay_buffer_empty(stream))
+		stream->cur_time = packet->dts_usec;
+	stream->cur_size += packet->size;
 
-	circlebuf_push_back(&stream->packets, packet, sizeof(*packet));
+	if (!replay_buffer_push(stream, packet)) {
+		warn("Failed to write to the disk buffer");
+		deactivate_replay_buffer(stream, OBS_OUTPUT_ERROR);
+		return;
+	}
 
-	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe)
-		stream->keyframes++;
+	replay_index_push(&stream->index, packet);
 
 	if (stream->save_ts && packet->sys_dts_usec >= stream->save_ts) {
 		if (os_atomic_load_bool(&stream->muxing))
@@ -1003,6 +1057,7 @@ static void replay_buffer_defaults(obs_data_t *s)
 	obs_data_set_default_string(s, "format", "%CCYY-%MM-%DD %hh-%mm-%ss");
 	obs_data_set_default_string(s, "extension", "mp4");
 	obs_data_set_default_bool(s, "allow_spaces", true);
+	obs_data_set_default_bool(s, "disk_buffer", false);
 }
 
 struct obs_output_info replay_buffer = {
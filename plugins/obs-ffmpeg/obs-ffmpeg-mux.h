@@ -10,9 +10,14 @@
 #include <util/platform.h>
 #include <util/threading.h>
 
+#include "ffmpeg-mux/ffmpeg-mux-shm.h"
+#include "obs-ffmpeg-replay-index.h"
+#include "obs-ffmpeg-replay-store.h"
+
 struct ffmpeg_muxer {
 	obs_output_t *output;
 	os_process_pipe_t *pipe;
+	struct ffm_shm *shm;
 	int64_t stop_ts;
 	uint64_t total_bytes;
 	bool sent_headers;
@@ -30,10 +35,12 @@ struct ffmpeg_muxer {
 	int64_t max_size;
 	int64_t max_time;
 	int64_t save_ts;
-	int keyframes;
+	struct replay_index index;
 	obs_hotkey_id hotkey;
 	volatile bool muxing;
 	DARRAY(struct encoder_packet) mux_packets;
+	struct replay_store *store;
+	DARRAY(struct replay_segment *) mux_segments;
 
 	/* these are accessed both by replay buffer and by HLS */
 	pthread_t mux_thread;
@@ -56,6 +63,7 @@ struct ffmpeg_muxer {
 bool stopping(struct ffmpeg_muxer *stream);
 bool active(struct ffmpeg_muxer *stream);
 void start_pipe(struct ffmpeg_muxer *stream, const char *path);
+int stop_pipe(struct ffmpeg_muxer *stream);
 bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet);
 bool send_headers(struct ffmpeg_muxer *stream);
 int deactivate(struct ffmpeg_muxer *stream, int code);
@@ -0,0 +1,161 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-ffmpeg-replay-index.h"
+
+/* audio tracks, then video */
+#define REPLAY_TRACKS (MAX_AUDIO_MIXES + 1)
+
+void replay_index_push(struct replay_index *index,
+		       const struct encoder_packet *packet)
+{
+	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe) {
+		struct replay_keyframe keyframe = {
+			.packet = index->next_packet,
+			.bytes = index->total_bytes,
+		};
+
+		circlebuf_push_back(&index->keyframes, &keyframe,
+				    sizeof(keyframe));
+	}
+
+	index->next_packet++;
+	index->total_bytes += (int64_t)packet->size;
+}
+
+size_t replay_index_purge(struct replay_index *index)
+{
+	struct replay_keyframe *keyframe;
+	size_t count;
+
+	if (!replay_index_keyframes(index))
+		return 0;
+
+	/* keep at least the keyframe the buffer starts with */
+	keyframe = circlebuf_data(&index->keyframes, 0);
+	if (keyframe->packet == index->first_packet) {
+		if (replay_index_keyframes(index) < 2)
+			return 0;
+
+		circlebuf_pop_front(&index->keyframes, NULL, sizeof(*keyframe));
+		keyframe = circlebuf_data(&index->keyframes, 0);
+	}
+
+	count = (size_t)(keyframe->packet - index->first_packet);
+	index->first_packet = keyframe->packet;
+	index->first_bytes = keyframe->bytes;
+	return count;
+}
+
+void replay_index_free(struct replay_index *index)
+{
+	circlebuf_free(&index->keyframes);
+	memset(index, 0, sizeof(*index));
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline size_t get_track(const struct encoder_packet *packet)
+{
+	return packet->type == OBS_ENCODER_VIDEO ? MAX_AUDIO_MIXES
+						 : packet->track_idx;
+}
+
+void replay_order_packets(struct darray *packets)
+{
+	DARRAY(struct encoder_packet) in;
+	DARRAY(struct encoder_packet) out;
+	size_t cur[REPLAY_TRACKS];
+	size_t last[REPLAY_TRACKS];
+	int64_t offsets[REPLAY_TRACKS] = {0};
+	int64_t dts_offsets[REPLAY_TRACKS] = {0};
+	uint32_t *next;
+
+	in.da = *packets;
+	da_init(out);
+
+	if (!in.num)
+		return;
+
+	/* link the packets of each track, the first one of each track is
+	 * where its timestamps start */
+	next = bmalloc(in.num * sizeof(*next));
+
+	for (size_t i = 0; i < REPLAY_TRACKS; i++)
+		cur[i] = last[i] = DARRAY_INVALID;
+
+	for (size_t i = 0; i < in.num; i++) {
+		struct encoder_packet *packet = &in.array[i];
+		size_t track = get_track(packet);
+
+		next[i] = UINT32_MAX;
+
+		if (track >= REPLAY_TRACKS)
+			continue;
+
+		if (cur[track] == DARRAY_INVALID) {
+			cur[track] = i;
+			offsets[track] = packet->dts_usec;
+			dts_offsets[track] = packet->dts;
+		} else {
+			next[last[track]] = (uint32_t)i;
+		}
+
+		last[track] = i;
+	}
+
+	da_reserve(out, in.num);
+
+	for (;;) {
+		size_t next_track = DARRAY_INVALID;
+		int64_t next_dts_usec = 0;
+
+		for (size_t i = 0; i < REPLAY_TRACKS; i++) {
+			int64_t dts_usec;
+
+			if (cur[i] == DARRAY_INVALID)
+				continue;
+
+			/* equal timestamps keep the buffered order */
+			dts_usec = in.array[cur[i]].dts_usec - offsets[i];
+			if (next_track == DARRAY_INVALID ||
+			    dts_usec < next_dts_usec ||
+			    (dts_usec == next_dts_usec &&
+			     cur[i] < cur[next_track])) {
+				next_track = i;
+				next_dts_usec = dts_usec;
+			}
+		}
+
+		if (next_track == DARRAY_INVALID)
+			break;
+
+		struct encoder_packet *packet = da_push_back_new(out);
+		*packet = in.array[cur[next_track]];
+		packet->dts_usec -= offsets[next_track];
+		packet->dts -= dts_offsets[next_track];
+		packet->pts -= dts_offsets[next_track];
+
+		cur[next_track] = next[cur[next_track]] == UINT32_MAX
+					  ? DARRAY_INVALID
+					  : next[cur[next_track]];
+	}
+
+	bfree(next);
+	da_free(in);
+	*packets = out.da;
+}
@@ -0,0 +1,93 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <obs.h>
+#include <util/circlebuf.h>
+#include <util/darray.h>
+
+/*
+ * Replay buffer keyframe index
+ *
+ *   Kept alongside the buffered packets.  Packets are numbered in the order
+ * they were buffered, and the index remembers the number and the total size
+ * of the buffered data in front of every video keyframe.  That way the
+ * buffer can be purged a whole GOP at a time, and a save knows where the
+ * first keyframe is.
+ */
+
+struct replay_keyframe {
+	uint64_t packet;
+	int64_t bytes;
+};
+
+struct replay_index {
+	struct circlebuf keyframes;
+	uint64_t first_packet;
+	uint64_t next_packet;
+	int64_t first_bytes;
+	int64_t total_bytes;
+};
+
+void replay_index_push(struct replay_index *index,
+		       const struct encoder_packet *packet);
+
+/**
+ * Removes the packets up to the next keyframe from the index.  Returns how
+ * many packets have to be removed from the front of the buffer, 0 if there
+ * is no keyframe to purge up to.
+ */
+size_t replay_index_purge(struct replay_index *index);
+
+void replay_index_free(struct replay_index *index);
+
+/**
+ * Puts the packets of a save into muxing order, with the timestamps of every
+ * track starting at 0.  The packets of each track are buffered in order, so
+ * they are merged rather than sorted.
+ */
+void replay_order_packets(struct darray *packets);
+
+static inline size_t replay_index_count(const struct replay_index *index)
+{
+	return (size_t)(index->next_packet - index->first_packet);
+}
+
+static inline size_t replay_index_keyframes(const struct replay_index *index)
+{
+	return index->keyframes.size / sizeof(struct replay_keyframe);
+}
+
+/** Position of the first keyframe in the buffer, where saves start */
+static inline size_t replay_index_save_start(const struct replay_index *index)
+{
+	struct replay_keyframe keyframe;
+
+	if (!replay_index_keyframes(index))
+		return 0;
+
+	circlebuf_peek_front((struct circlebuf *)&index->keyframes, &keyframe,
+			     sizeof(keyframe));
+	return (size_t)(keyframe.packet - index->first_packet);
+}
+
+/** Size of the buffered packet data */
+static inline int64_t replay_index_size(const struct replay_index *index)
+{
+	return index->total_bytes - index->first_bytes;
+}
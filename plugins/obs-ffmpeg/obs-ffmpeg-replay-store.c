@@ -0,0 +1,340 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <util/circlebuf.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "obs-ffmpeg-replay-store.h"
+
+struct replay_segment {
+	uint8_t *data;
+	size_t size;
+	size_t used;
+
+	/* index entries pointing into the segment, only used by the store */
+	size_t entries;
+
+	/* one for the store, one per save reading from it */
+	volatile long refs;
+
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+struct replay_store {
+	struct dstr dir;
+	struct circlebuf index;
+	DARRAY(struct replay_segment *) segments;
+};
+
+static volatile long segment_counter = 0;
+
+#ifdef _WIN32
+static bool map_segment(struct replay_segment *segment, const char *path)
+{
+	wchar_t *wpath = NULL;
+
+	os_utf8_to_wcs_ptr(path, 0, &wpath);
+	if (!wpath)
+		return false;
+
+	segment->file = CreateFileW(wpath, GENERIC_READ | GENERIC_WRITE, 0,
+				    NULL, CREATE_NEW,
+				    FILE_ATTRIBUTE_TEMPORARY |
+					    FILE_FLAG_DELETE_ON_CLOSE,
+				    NULL);
+	bfree(wpath);
+
+	if (segment->file == INVALID_HANDLE_VALUE) {
+		segment->file = NULL;
+		return false;
+	}
+
+	/* extends the file, which fails right away if the disk is full */
+	segment->mapping = CreateFileMappingW(
+		segment->file, NULL, PAGE_READWRITE,
+		(DWORD)((uint64_t)segment->size >> 32), (DWORD)segment->size,
+		NULL);
+	if (!segment->mapping)
+		return false;
+
+	segment->data = MapViewOfFile(segment->mapping, FILE_MAP_ALL_ACCESS, 0,
+				      0, 0);
+	return segment->data != NULL;
+}
+
+static void unmap_segment(struct replay_segment *segment)
+{
+	if (segment->data)
+		UnmapViewOfFile(segment->data);
+	if (segment->mapping)
+		CloseHandle(segment->mapping);
+	if (segment->file)
+		CloseHandle(segment->file);
+}
+
+static inline long get_pid(void)
+{
+	return (long)GetCurrentProcessId();
+}
+
+#else
+static bool reserve_file(int fd, size_t size)
+{
+#ifdef __APPLE__
+	fstore_t store = {F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)size, 0};
+
+	if (fcntl(fd, F_PREALLOCATE, &store) == -1)
+		return false;
+	return ftruncate(fd, (off_t)size) == 0;
+#else
+	return posix_fallocate(fd, 0, (off_t)size) == 0;
+#endif
+}
+
+static bool map_segment(struct replay_segment *segment, const char *path)
+{
+	void *ptr;
+	int fd;
+
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd == -1)
+		return false;
+
+	/* the mapping keeps the file alive */
+	unlink(path);
+
+	/* a sparse file would raise SIGBUS on a write once the disk is full,
+	 * so allocate all of it up front */
+	if (!reserve_file(fd, segment->size)) {
+		close(fd);
+		return false;
+	}
+
+	ptr = mmap(NULL, segment->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   0);
+	close(fd);
+
+	if (ptr == MAP_FAILED)
+		return false;
+
+	segment->data = ptr;
+	return true;
+}
+
+static void unmap_segment(struct replay_segment *segment)
+{
+	if (segment->data)
+		munmap(segment->data, segment->size);
+}
+
+static inline long get_pid(void)
+{
+	return (long)getpid();
+}
+#endif
+
+static void segment_release(struct replay_segment *segment)
+{
+	if (os_atomic_dec_long(&segment->refs) == 0) {
+		unmap_segment(segment);
+		bfree(segment);
+	}
+}
+
+static struct replay_segment *segment_create(struct replay_store *store,
+					     size_t min_size)
+{
+	struct replay_segment *segment = bzalloc(sizeof(*segment));
+	struct dstr path = {0};
+
+	segment->size = REPLAY_STORE_SEGMENT_SIZE;
+	if (segment->size < min_size)
+		segment->size = min_size;
+	segment->refs = 1;
+
+	dstr_printf(&path, "%s/obs-replay-%ld-%ld.tmp", store->dir.array,
+		    get_pid(), os_atomic_inc_long(&segment_counter));
+
+	if (!map_segment(segment, path.array)) {
+		blog(LOG_WARNING,
+		     "replay_store: Failed to map %zu bytes "
+		     "at '%s'",
+		     segment->size, path.array);
+		segment_release(segment);
+		segment = NULL;
+	}
+
+	dstr_free(&path);
+	return segment;
+}
+
+struct replay_store *replay_store_create(const char *dir)
+{
+	struct replay_store *store;
+
+	if (!dir || !*dir || os_mkdirs(dir) == MKDIR_ERROR)
+		return NULL;
+
+	store = bzalloc(sizeof(*store));
+	dstr_copy(&store->dir, dir);
+	dstr_replace(&store->dir, "\\", "/");
+	if (dstr_end(&store->dir) == '/')
+		dstr_resize(&store->dir, store->dir.len - 1);
+
+	return store;
+}
+
+void replay_store_destroy(struct replay_store *store)
+{
+	if (!store)
+		return;
+
+	for (size_t i = 0; i < store->segments.num; i++)
+		segment_release(store->segments.array[i]);
+
+	da_free(store->segments);
+	circlebuf_free(&store->index);
+	dstr_free(&store->dir);
+	bfree(store);
+}
+
+/* drops segments at the front that no entry points into anymore, the one
+ * being written to is kept */
+static void drop_unused_segments(struct replay_store *store)
+{
+	while (store->segments.num > 1 && !store->segments.array[0]->entries) {
+		segment_release(store->segments.array[0]);
+		da_erase(store->segments, 0);
+	}
+}
+
+bool replay_store_push(struct replay_store *store,
+		       const struct encoder_packet *packet)
+{
+	struct replay_segment *segment = NULL;
+	struct replay_entry entry;
+
+	if (store->segments.num)
+		segment = store->segments.array[store->segments.num - 1];
+
+	if (!segment || segment->size - segment->used < packet->size) {
+		segment = segment_create(store, packet->size);
+		if (!segment)
+			return false;
+
+		da_push_back(store->segments, &segment);
+		drop_unused_segments(store);
+	}
+
+	entry.segment = segment;
+	entry.data = segment->data + segment->used;
+	entry.dts_usec = packet->dts_usec;
+	entry.pts = packet->pts;
+	entry.dts = packet->dts;
+	entry.size = (uint32_t)packet->size;
+	entry.track_idx = (uint32_t)packet->track_idx;
+	entry.type = packet->type;
+	entry.keyframe = packet->keyframe;
+
+	memcpy(entry.data, packet->data, packet->size);
+	segment->used += packet->size;
+	segment->entries++;
+
+	circlebuf_push_back(&store->index, &entry, sizeof(entry));
+	return true;
+}
+
+void replay_store_pop_front(struct replay_store *store)
+{
+	struct replay_entry entry;
+
+	if (!store->index.size)
+		return;
+
+	circlebuf_pop_front(&store->index, &entry, sizeof(entry));
+	entry.segment->entries--;
+	drop_unused_segments(store);
+}
+
+size_t replay_store_count(const struct replay_store *store)
+{
+	return store->index.size / sizeof(struct replay_entry);
+}
+
+struct replay_entry *replay_store_get(const struct replay_store *store,
+				      size_t idx)
+{
+	return circlebuf_data((struct circlebuf *)&store->index,
+			      idx * sizeof(struct replay_entry));
+}
+
+void replay_entry_get_packet(const struct replay_entry *entry,
+			     struct encoder_packet *packet)
+{
+	memset(packet, 0, sizeof(*packet));
+	packet->data = entry->data;
+	packet->size = entry->size;
+	packet->pts = entry->pts;
+	packet->dts = entry->dts;
+	packet->dts_usec = entry->dts_usec;
+	packet->track_idx = entry->track_idx;
+	packet->type = entry->type;
+	packet->keyframe = entry->keyframe;
+}
+
+void replay_store_ref_segments(struct replay_store *store,
+			       struct darray *segments)
+{
+	DARRAY(struct replay_segment *) refs;
+	da_init(refs);
+
+	da_reserve(refs, store->segments.num);
+	for (size_t i = 0; i < store->segments.num; i++) {
+		struct replay_segment *segment = store->segments.array[i];
+
+		os_atomic_inc_long(&segment->refs);
+		da_push_back(refs, &segment);
+	}
+
+	*segments = refs.da;
+}
+
+void replay_store_release_segments(struct darray *segments)
+{
+	DARRAY(struct replay_segment *) refs;
+	refs.da = *segments;
+
+	for (size_t i = 0; i < refs.num; i++)
+		segment_release(refs.array[i]);
+
+	da_free(refs);
+	*segments = refs.da;
+}
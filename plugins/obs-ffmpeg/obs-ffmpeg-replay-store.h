@@ -0,0 +1,75 @@
+/******************************************************************************
+    Copyright (C) 2021 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <obs-module.h>
+#include <util/darray.h>
+
+/*
+ * Replay buffer storage on disk
+ *
+ *   Packet data is appended to a rolling set of memory-mapped segment files,
+ * only a small index entry per packet stays in memory.  The files are removed
+ * as soon as they are created, so nothing is left behind if obs crashes.
+ *
+ *   Entries are removed from the front, and a segment is unmapped once no
+ * entry points into it anymore and no save is still reading from it.
+ */
+
+#define REPLAY_STORE_SEGMENT_SIZE (32 * 1024 * 1024)
+
+struct replay_store;
+struct replay_segment;
+
+struct replay_entry {
+	struct replay_segment *segment;
+	uint8_t *data;
+	int64_t dts_usec;
+	int64_t pts;
+	int64_t dts;
+	uint32_t size;
+	uint32_t track_idx;
+	enum obs_encoder_type type;
+	bool keyframe;
+};
+
+/** Creates a store with its segment files in dir */
+struct replay_store *replay_store_create(const char *dir);
+void replay_store_destroy(struct replay_store *store);
+
+/** Copies the packet into the store, false if it could not be mapped */
+bool replay_store_push(struct replay_store *store,
+		       const struct encoder_packet *packet);
+void replay_store_pop_front(struct replay_store *store);
+
+size_t replay_store_count(const struct replay_store *store);
+struct replay_entry *replay_store_get(const struct replay_store *store,
+				      size_t idx);
+
+/** Sets up packet to point to the entry's data, the data is not referenced */
+void replay_entry_get_packet(const struct replay_entry *entry,
+			     struct encoder_packet *packet);
+
+/**
+ * References all segments of the store, so that their data stays mapped
+ * while a save reads it.  segments receives the segment pointers.
+ */
+void replay_store_ref_segments(struct replay_store *store,
+			       struct darray *segments);
+/** Releases and frees the segments returned by replay_store_ref_segments */
+void replay_store_release_segments(struct darray *segments);
@@ -525,7 +525,8 @@ struct obs_source_info chroma_key_filter_v2 = {
 	.id = "chroma_key_filter",
 	.version = 2,
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB |
+			OBS_SOURCE_CONTENT_TRACKING,
 	.get_name = chroma_key_name,
 	.create = chroma_key_create_v2,
 	.destroy = chroma_key_destroy_v2,
@@ -733,7 +733,8 @@ struct obs_source_info color_filter_v2 = {
 	.id = "color_filter",
 	.version = 2,
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB |
+			OBS_SOURCE_CONTENT_TRACKING,
 	.get_name = color_correction_filter_name,
 	.create = color_correction_filter_create_v2,
 	.destroy = color_correction_filter_destroy_v2,
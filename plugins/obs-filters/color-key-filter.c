@@ -471,7 +471,8 @@ struct obs_source_info color_key_filter_v2 = {
 	.id = "color_key_filter",
 	.version = 2,
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB |
+			OBS_SOURCE_CONTENT_TRACKING,
 	.get_name = color_key_name,
 	.create = color_key_create_v2,
 	.destroy = color_key_destroy_v2,
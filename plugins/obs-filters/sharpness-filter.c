@@ -134,7 +134,8 @@ struct obs_source_info sharpness_filter_v2 = {
 	.id = "sharpness_filter",
 	.version = 2,
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB |
+			OBS_SOURCE_CONTENT_TRACKING,
 	.get_name = sharpness_getname,
 	.create = sharpness_create,
 	.destroy = sharpness_destroy,
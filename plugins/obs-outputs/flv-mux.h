@@ -20,6 +20,7 @@
 #include <obs.h>
 
 #define MILLISECOND_DEN 1000
+#define FLV_BODY_PREFIX_MAX 5
 
 static int32_t get_ms_time(struct encoder_packet *packet, int64_t val)
 {
@@ -38,3 +39,7 @@ extern void flv_additional_packet_mux(struct encoder_packet *packet,
 				      int32_t dts_offset, uint8_t **output,
 				      size_t *size, bool is_header,
 				      size_t index);
+
+/** Writes the bytes that precede the packet data in an FLV tag body */
+extern size_t flv_packet_body_prefix(struct encoder_packet *packet,
+				     bool is_header, uint8_t *prefix);
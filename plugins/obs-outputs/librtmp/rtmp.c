@@ -4063,18 +4063,12 @@ RTMP_SendChunk(RTMP *r, RTMPChunk *chunk)
     return wrote;
 }
 
-int
-RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+static int
+PrepareOutPacket(RTMP *r, RTMPPacket *packet, uint32_t *last)
 {
     const RTMPPacket *prevPacket;
-    uint32_t last = 0;
-    int nSize;
-    int hSize, cSize;
-    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
-    uint32_t t;
-    char *buffer, *tbuf = NULL, *toff = NULL;
-    int nChunkSize;
-    int tlen;
+
+    *last = 0;
 
     if (packet->m_nChannel >= r->m_channelsAllocatedOut)
     {
@@ -4104,7 +4098,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         if (prevPacket->m_nTimeStamp == packet->m_nTimeStamp
                 && packet->m_headerType == RTMP_PACKET_SIZE_SMALL)
             packet->m_headerType = RTMP_PACKET_SIZE_MINIMUM;
-        last = prevPacket->m_nTimeStamp;
+        *last = prevPacket->m_nTimeStamp;
     }
 
     if (packet->m_headerType > 3)	/* sanity */
@@ -4114,6 +4108,32 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         return FALSE;
     }
 
+    return TRUE;
+}
+
+static void
+StoreOutPacket(RTMP *r, const RTMPPacket *packet)
+{
+    if (!r->m_vecChannelsOut[packet->m_nChannel])
+        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
+    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+}
+
+int
+RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+{
+    uint32_t last;
+    int nSize;
+    int hSize, cSize;
+    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    uint32_t t;
+    char *buffer, *tbuf = NULL, *toff = NULL;
+    int nChunkSize;
+    int tlen;
+
+    if (!PrepareOutPacket(r, packet, &last))
+        return FALSE;
+
     nSize = packetSize[packet->m_headerType];
     hSize = nSize;
     cSize = 0;
@@ -4274,9 +4294,215 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         }
     }
 
-    if (!r->m_vecChannelsOut[packet->m_nChannel])
-        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
-    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+    StoreOutPacket(r, packet);
+    return TRUE;
+}
+
+static int
+SendPacketSlicesCopy(RTMP *r, RTMPPacket *packet, const RTMPSlice *body,
+                     int count)
+{
+    RTMPPacket copy = *packet;
+    char *ptr;
+    int i, ret;
+
+    if (!RTMPPacket_Alloc(&copy, copy.m_nBodySize))
+        return FALSE;
+
+    ptr = copy.m_body;
+    for (i = 0; i < count; i++)
+    {
+        memcpy(ptr, body[i].data, body[i].size);
+        ptr += body[i].size;
+    }
+    r->m_nBytesCopied += copy.m_nBodySize;
+
+    ret = RTMP_SendPacket(r, &copy, FALSE);
+    RTMPPacket_Free(&copy);
+    return ret;
+}
+
+/* sends the slices, advancing them past whatever was sent */
+static int
+WriteSlices(RTMP *r, RTMPSlice *slices, int count)
+{
+    while (count > 0)
+    {
+        int nBytes;
+
+        /* the custom send function does its own buffering */
+        if (r->m_bCustomSend && r->m_customSendFunc)
+        {
+            if (!WriteN(r, slices->data, slices->size))
+                return FALSE;
+            slices++;
+            count--;
+            continue;
+        }
+
+        nBytes = RTMPSockBuf_SendSlices(&r->m_sb, slices, count);
+
+        if (nBytes < 0)
+        {
+            int sockerr = GetSockError();
+            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d (%d slices)", __FUNCTION__,
+                     sockerr, count);
+
+            if (sockerr == EINTR && !RTMP_ctrlC)
+                continue;
+
+            r->last_error_code = sockerr;
+
+            RTMP_Close(r);
+            return FALSE;
+        }
+
+        if (nBytes == 0)
+            return FALSE;
+
+        while (count > 0 && nBytes >= slices->size)
+        {
+            nBytes -= slices->size;
+            slices++;
+            count--;
+        }
+        if (nBytes > 0)
+        {
+            slices->data += nBytes;
+            slices->size -= nBytes;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Sends a media packet whose body is made of separate slices.  The chunk
+ * headers are sent alongside the slices with a single vectored write per
+ * RTMP_MAX_SEND_SLICES pieces, so the body is never copied.  Falls back to
+ * copying the body for HTTP tunnels and encrypted connections. */
+int
+RTMP_SendPacketSlices(RTMP *r, RTMPPacket *packet, const RTMPSlice *body,
+                      int count)
+{
+    RTMPSlice slices[RTMP_MAX_SEND_SLICES];
+    char hbuf[RTMP_MAX_HEADER_SIZE], cbuf[3], *hptr, *hend, c;
+    int nSize, cSize, nChunkSize, chunkLeft, num, i;
+    uint32_t last, t;
+
+    if (r->Link.protocol & RTMP_FEATURE_HTTP)
+        return SendPacketSlicesCopy(r, packet, body, count);
+#if defined(CRYPTO) && !defined(NO_SSL)
+    if (r->m_sb.sb_ssl)
+        return SendPacketSlicesCopy(r, packet, body, count);
+#endif
+#ifdef CRYPTO
+    if (r->Link.rc4keyOut)
+        return SendPacketSlicesCopy(r, packet, body, count);
+#endif
+
+    if (!PrepareOutPacket(r, packet, &last))
+        return FALSE;
+
+    nSize = packetSize[packet->m_headerType];
+    t = packet->m_nTimeStamp - last;
+    cSize = 0;
+
+    if (packet->m_nChannel > 319)
+        cSize = 2;
+    else if (packet->m_nChannel > 63)
+        cSize = 1;
+
+    hptr = hbuf;
+    hend = hbuf + sizeof(hbuf);
+    c = packet->m_headerType << 6;
+    switch (cSize)
+    {
+    case 0:
+        c |= packet->m_nChannel;
+        break;
+    case 1:
+        break;
+    case 2:
+        c |= 1;
+        break;
+    }
+    *hptr++ = c;
+    if (cSize)
+    {
+        int tmp = packet->m_nChannel - 64;
+        *hptr++ = tmp & 0xff;
+        if (cSize == 2)
+            *hptr++ = tmp >> 8;
+    }
+
+    if (nSize > 1)
+        hptr = AMF_EncodeInt24(hptr, hend, t > 0xffffff ? 0xffffff : t);
+
+    if (nSize > 4)
+    {
+        hptr = AMF_EncodeInt24(hptr, hend, packet->m_nBodySize);
+        *hptr++ = packet->m_packetType;
+    }
+
+    if (nSize > 8)
+        hptr += EncodeInt32LE(hptr, packet->m_nInfoField2);
+
+    if (nSize > 1 && t >= 0xffffff)
+        hptr = AMF_EncodeInt32(hptr, hend, t);
+
+    /* every following chunk starts with the same type 3 header */
+    memcpy(cbuf, hbuf, 1 + cSize);
+    cbuf[0] = (0xc0 | c);
+
+    slices[0].data = hbuf;
+    slices[0].size = (int)(hptr - hbuf);
+    num = 1;
+
+    nChunkSize = r->m_outChunkSize;
+    chunkLeft = nChunkSize;
+
+    for (i = 0; i < count; i++)
+    {
+        const char *data = body[i].data;
+        int size = body[i].size;
+
+        while (size > 0)
+        {
+            int n;
+
+            /* keep room for a chunk header and the data that follows */
+            if (num > RTMP_MAX_SEND_SLICES - 2)
+            {
+                if (!WriteSlices(r, slices, num))
+                    return FALSE;
+                num = 0;
+            }
+
+            if (!chunkLeft)
+            {
+                slices[num].data = cbuf;
+                slices[num].size = 1 + cSize;
+                num++;
+                chunkLeft = nChunkSize;
+            }
+
+            n = size < chunkLeft ? size : chunkLeft;
+            slices[num].data = data;
+            slices[num].size = n;
+            num++;
+
+            data += n;
+            size -= n;
+            chunkLeft -= n;
+        }
+    }
+
+    if (!WriteSlices(r, slices, num))
+        return FALSE;
+
+    /* the body isn't owned by the packet, only keep its attributes */
+    packet->m_body = NULL;
+    StoreOutPacket(r, packet);
     return TRUE;
 }
 
@@ -4509,6 +4735,50 @@ RTMPSockBuf_Send(RTMPSockBuf *sb, const char *buf, int len)
     return rc;
 }
 
+int
+RTMPSockBuf_SendSlices(RTMPSockBuf *sb, const RTMPSlice *slices, int count)
+{
+#ifdef _WIN32
+    WSABUF bufs[RTMP_MAX_SEND_SLICES];
+    DWORD sent = 0;
+#else
+    struct iovec iov[RTMP_MAX_SEND_SLICES];
+    struct msghdr msg;
+#endif
+    int i;
+
+    if (count > RTMP_MAX_SEND_SLICES)
+        count = RTMP_MAX_SEND_SLICES;
+
+#if defined(RTMP_NETSTACK_DUMP)
+    for (i = 0; i < count; i++)
+        fwrite(slices[i].data, 1, slices[i].size, netstackdump);
+#endif
+
+#ifdef _WIN32
+    for (i = 0; i < count; i++)
+    {
+        bufs[i].buf = (CHAR *)slices[i].data;
+        bufs[i].len = (ULONG)slices[i].size;
+    }
+
+    if (WSASend(sb->sb_socket, bufs, count, &sent, 0, NULL, NULL) != 0)
+        return -1;
+    return (int)sent;
+#else
+    for (i = 0; i < count; i++)
+    {
+        iov[i].iov_base = (void *)slices[i].data;
+        iov[i].iov_len = slices[i].size;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    return (int)sendmsg(sb->sb_socket, &msg, MSG_NOSIGNAL);
+#endif
+}
+
 int
 RTMPSockBuf_Close(RTMPSockBuf *sb)
 {
@@ -5351,6 +5621,7 @@ RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx)
         if (num > s2)
             num = s2;
         memcpy(enc, buf, num);
+        r->m_nBytesCopied += num;
         pkt->m_nBytesRead += num;
         s2 -= num;
         buf += num;
@@ -263,6 +263,15 @@ extern "C"
         char *m_body;
     } RTMPPacket;
 
+    /* a piece of a packet body that is sent without copying it */
+    typedef struct RTMPSlice
+    {
+        const char *data;
+        int size;
+    } RTMPSlice;
+
+#define RTMP_MAX_SEND_SLICES 64
+
     typedef struct RTMPSockBuf
     {
         SOCKET sb_socket;
@@ -451,6 +460,7 @@ extern "C"
         RTMP_LNK Link;
         int connect_time_ms;
         int last_error_code;
+        uint64_t m_nBytesCopied;	/* payload bytes copied before sending */
 
 #ifdef CRYPTO
         TLS_CTX RTMP_TLS_ctx;
@@ -492,6 +502,8 @@ extern "C"
 
     int RTMP_ReadPacket(RTMP *r, RTMPPacket *packet);
     int RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue);
+    int RTMP_SendPacketSlices(RTMP *r, RTMPPacket *packet,
+                              const RTMPSlice *body, int count);
     int RTMP_SendChunk(RTMP *r, RTMPChunk *chunk);
     int RTMP_IsConnected(RTMP *r);
     SOCKET RTMP_Socket(RTMP *r);
@@ -530,6 +542,8 @@ extern "C"
 
     int RTMPSockBuf_Fill(RTMPSockBuf *sb);
     int RTMPSockBuf_Send(RTMPSockBuf *sb, const char *buf, int len);
+    int RTMPSockBuf_SendSlices(RTMPSockBuf *sb, const RTMPSlice *slices,
+                               int count);
     int RTMPSockBuf_Close(RTMPSockBuf *sb);
 
     int RTMP_SendCreateStream(RTMP *r);
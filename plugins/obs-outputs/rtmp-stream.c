@@ -143,9 +143,17 @@ static void rtmp_stream_destroy(void *data)
 	bfree(stream);
 }
 
+static void get_bytes_copied_per_sec(void *data, calldata_t *cd)
+{
+	struct rtmp_stream *stream = data;
+	calldata_set_int(cd, "bytes_per_sec",
+			 os_atomic_load_long(&stream->bytes_copied_per_sec));
+}
+
 static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
+	proc_handler_t *ph = obs_output_get_proc_handler(output);
 	stream->output = output;
 	pthread_mutex_init_value(&stream->packets_mutex);
 
@@ -189,6 +197,10 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		goto fail;
 	}
 
+	proc_handler_add(ph,
+			 "void get_bytes_copied_per_sec(out int bytes_per_sec)",
+			 get_bytes_copied_per_sec, stream);
+
 	UNUSED_PARAMETER(settings);
 	return stream;
 
@@ -394,6 +406,7 @@ retry_send:
 
 	memcpy(stream->write_buf + stream->write_buf_len, data, len);
 	stream->write_buf_len += len;
+	stream->bytes_copied += len;
 
 	pthread_mutex_unlock(&stream->write_buf_mutex);
 
@@ -402,6 +415,70 @@ retry_send:
 	return len;
 }
 
+static void update_copy_rate(struct rtmp_stream *stream)
+{
+	uint64_t ts = os_gettime_ns();
+	uint64_t elapsed;
+
+	stream->bytes_copied += stream->rtmp.m_nBytesCopied;
+	stream->rtmp.m_nBytesCopied = 0;
+
+	if (!stream->copy_rate_start_ts) {
+		stream->copy_rate_start_ts = ts;
+		stream->copy_rate_start_bytes = stream->bytes_copied;
+		return;
+	}
+
+	elapsed = ts - stream->copy_rate_start_ts;
+	if (elapsed >= 1000000000ULL) {
+		uint64_t bytes =
+			stream->bytes_copied - stream->copy_rate_start_bytes;
+
+		os_atomic_set_long(&stream->bytes_copied_per_sec,
+				   (long)(bytes * 1000000000ULL / elapsed));
+		stream->copy_rate_start_ts = ts;
+		stream->copy_rate_start_bytes = stream->bytes_copied;
+	}
+}
+
+/* Sends a regular packet of the first track straight from the encoder
+ * packet: only the FLV body prefix and the RTMP chunk headers are built
+ * separately, the payload is handed to the socket as is. */
+static int send_packet_slices(struct rtmp_stream *stream,
+			      struct encoder_packet *packet)
+{
+	int32_t dts_offset = (int32_t)stream->start_dts_offset;
+	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
+	uint8_t prefix[FLV_BODY_PREFIX_MAX];
+	size_t prefix_size = flv_packet_body_prefix(packet, false, prefix);
+	RTMPPacket rtmp_packet = {0};
+	RTMPSlice body[2];
+
+	body[0].data = (const char *)prefix;
+	body[0].size = (int)prefix_size;
+	body[1].data = (const char *)packet->data;
+	body[1].size = (int)packet->size;
+
+	/* same timestamp layout as the FLV tag */
+	rtmp_packet.m_nTimeStamp = ((uint32_t)time_ms & 0xFFFFFF) |
+				   ((uint32_t)(time_ms >> 24) & 0x7F) << 24;
+	rtmp_packet.m_packetType = packet->type == OBS_ENCODER_VIDEO
+					   ? RTMP_PACKET_TYPE_VIDEO
+					   : RTMP_PACKET_TYPE_AUDIO;
+	rtmp_packet.m_headerType = rtmp_packet.m_nTimeStamp
+					   ? RTMP_PACKET_SIZE_MEDIUM
+					   : RTMP_PACKET_SIZE_LARGE;
+	rtmp_packet.m_nChannel = 0x04;
+	rtmp_packet.m_nInfoField2 = stream->rtmp.Link.streams[0].id;
+	rtmp_packet.m_nBodySize = (uint32_t)(prefix_size + packet->size);
+
+	if (!RTMP_SendPacketSlices(&stream->rtmp, &rtmp_packet, body, 2))
+		return -1;
+
+	/* FLV tag header and previous tag size, as counted by RTMP_Write */
+	return (int)(rtmp_packet.m_nBodySize + 15);
+}
+
 static int send_packet(struct rtmp_stream *stream,
 		       struct encoder_packet *packet, bool is_header,
 		       size_t idx)
@@ -427,6 +504,19 @@ static int send_packet(struct rtmp_stream *stream,
 		}
 	}
 
+	if (!is_header && idx == 0 && packet->data && packet->size) {
+#ifdef TEST_FRAMEDROPS
+		droptest_cap_data_rate(stream, packet->size);
+#endif
+		ret = send_packet_slices(stream, packet);
+		obs_encoder_packet_release(packet);
+
+		if (ret > 0)
+			stream->total_bytes_sent += ret;
+		update_copy_rate(stream);
+		return ret;
+	}
+
 	if (idx > 0) {
 		flv_additional_packet_mux(
 			packet, is_header ? 0 : stream->start_dts_offset, &data,
@@ -436,6 +526,8 @@ static int send_packet(struct rtmp_stream *stream,
 			       &data, &size, is_header);
 	}
 
+	stream->bytes_copied += size;
+
 #ifdef TEST_FRAMEDROPS
 	droptest_cap_data_rate(stream, size);
 #endif
@@ -449,6 +541,7 @@ static int send_packet(struct rtmp_stream *stream,
 		obs_encoder_packet_release(packet);
 
 	stream->total_bytes_sent += size;
+	update_copy_rate(stream);
 	return ret;
 }
 
@@ -573,6 +666,8 @@ static void dbr_add_frame(struct rtmp_stream *stream, struct dbr_frame *back)
 
 static void dbr_set_bitrate(struct rtmp_stream *stream);
 
+static const char *send_packet_name = "rtmp_stream_send_packet";
+
 static void *send_thread(void *data)
 {
 	struct rtmp_stream *stream = data;
@@ -609,7 +704,11 @@ static void *send_thread(void *data)
 			dbr_frame.size = packet.size;
 		}
 
-		if (send_packet(stream, &packet, false, packet.track_idx) < 0) {
+		profile_start(send_packet_name);
+		int ret = send_packet(stream, &packet, false, packet.track_idx);
+		profile_end(send_packet_name);
+
+		if (ret < 0) {
 			os_atomic_set_bool(&stream->disconnected, true);
 			break;
 		}
@@ -1056,6 +1155,10 @@ static bool init_connect(struct rtmp_stream *stream)
 	os_atomic_set_bool(&stream->encode_error, false);
 	stream->total_bytes_sent = 0;
 	stream->dropped_frames = 0;
+	stream->bytes_copied = 0;
+	stream->copy_rate_start_ts = 0;
+	stream->copy_rate_start_bytes = 0;
+	os_atomic_set_long(&stream->bytes_copied_per_sec, 0);
 	stream->min_priority = 0;
 	stream->got_first_video = false;
 
@@ -94,6 +94,12 @@ struct rtmp_stream {
 	uint64_t total_bytes_sent;
 	int dropped_frames;
 
+	/* payload bytes memcpy'd on the way to the socket */
+	uint64_t bytes_copied;
+	uint64_t copy_rate_start_ts;
+	uint64_t copy_rate_start_bytes;
+	volatile long bytes_copied_per_sec;
+
 #ifdef TEST_FRAMEDROPS
 	struct circlebuf droptest_info;
 	uint64_t droptest_last_key_check;
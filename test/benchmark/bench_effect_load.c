@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <util/bmem.h>
+#include <graphics/graphics.h>
+#include <graphics/effect.h>
+
+#define BENCH_GRAPHICS_MODULE "libobs-opengl"
+
+#define BENCH_CACHE_DIR "bench_shader_cache"
+
+static double ms_since(uint64_t start)
+{
+	return (double)(os_gettime_ns() - start) / 1000000.0;
+}
+
+static void clear_cache_dir(void)
+{
+	os_dir_t *dir = os_opendir(BENCH_CACHE_DIR);
+	struct os_dirent *ent;
+	struct dstr path = {0};
+
+	if (!dir)
+		return;
+
+	while ((ent = os_readdir(dir)) != NULL) {
+		if (ent->directory)
+			continue;
+
+		dstr_printf(&path, "%s/%s", BENCH_CACHE_DIR, ent->d_name);
+		os_unlink(path.array);
+	}
+
+	os_closedir(dir);
+	os_rmdir(BENCH_CACHE_DIR);
+	dstr_free(&path);
+}
+
+/* programs are only linked on the first draw with a shader pair, so every
+ * pass of every technique gets drawn once */
+static void draw_effect(gs_effect_t *effect)
+{
+	for (size_t i = 0; i < effect->techniques.num; i++) {
+		gs_technique_t *tech = effect->techniques.array + i;
+		size_t passes = gs_technique_begin(tech);
+
+		for (size_t j = 0; j < passes; j++) {
+			if (!gs_technique_begin_pass(tech, j))
+				continue;
+			gs_draw(GS_TRIS, 0, 3);
+			gs_technique_end_pass(tech);
+		}
+
+		gs_technique_end(tech);
+	}
+}
+
+static size_t load_effects(const char *effect_dir)
+{
+	os_dir_t *dir = os_opendir(effect_dir);
+	struct os_dirent *ent;
+	struct dstr path = {0};
+	size_t count = 0;
+
+	if (!dir)
+		return 0;
+
+	while ((ent = os_readdir(dir)) != NULL) {
+		const char *ext = os_get_path_extension(ent->d_name);
+		gs_effect_t *effect;
+
+		if (ent->directory || !ext || strcmp(ext, ".effect") != 0)
+			continue;
+
+		dstr_printf(&path, "%s/%s", effect_dir, ent->d_name);
+		effect = gs_effect_create_from_file(path.array, NULL);
+		if (!effect)
+			continue;
+
+		draw_effect(effect);
+		count++;
+	}
+
+	os_closedir(dir);
+	dstr_free(&path);
+	return count;
+}
+
+static bool run(const char *label, const char *module, const char *effect_dir,
+		const char *cache_dir)
+{
+	graphics_t *graphics = NULL;
+	gs_texture_t *target;
+	uint64_t start;
+	size_t count;
+
+	if (gs_create(&graphics, module, 0) != GS_SUCCESS) {
+		printf("could not create graphics with '%s'\n", module);
+		return false;
+	}
+
+	gs_enter_context(graphics);
+
+	target = gs_texture_create(8, 8, GS_RGBA, 1, NULL, GS_RENDER_TARGET);
+	gs_set_render_target(target, NULL);
+	gs_set_viewport(0, 0, 8, 8);
+	gs_ortho(0.0f, 8.0f, 0.0f, 8.0f, -100.0f, 100.0f);
+	gs_load_vertexbuffer(NULL);
+
+	start = os_gettime_ns();
+	gs_set_shader_cache_path(cache_dir);
+	count = load_effects(effect_dir);
+	gs_flush();
+	printf("%-9s  %9.3f ms (%d effects)\n", label, ms_since(start),
+	       (int)count);
+
+	gs_set_render_target(NULL, NULL);
+	gs_texture_destroy(target);
+	gs_leave_context();
+	gs_destroy(graphics);
+
+	return count > 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *effect_dir = argc > 1 ? argv[1] : BENCH_EFFECT_DIR;
+	const char *module = argc > 2 ? argv[2] : BENCH_GRAPHICS_MODULE;
+	bool success;
+
+	clear_cache_dir();
+
+	success = run("no cache:", module, effect_dir, NULL);
+	success = success && run("cold:", module, effect_dir, BENCH_CACHE_DIR);
+	success = success && run("warm:", module, effect_dir, BENCH_CACHE_DIR);
+
+	clear_cache_dir();
+
+	printf("%s\n", success ? "ok" : "FAILED");
+	return success ? 0 : 1;
+}
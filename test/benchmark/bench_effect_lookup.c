@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <util/platform.h>
+#include <util/bmem.h>
+#include <graphics/effect.h>
+
+#define BENCH_SOURCES 100
+#define BENCH_FRAMES 10000
+
+/* a typical filter effect, with the params the filter sets every frame
+ * towards the end of the list */
+static const char *param_names[] = {
+	"ViewProj",         "image",           "color_matrix",
+	"color_range_min",  "color_range_max", "gamma",
+	"contrast",         "brightness",      "saturation",
+	"hue_shift",        "opacity",         "color",
+	"color_add",        "color_multiply",  "base_dimension",
+	"base_dimension_i", "undistort",       "multiplier",
+	"width_i",          "height_i",
+};
+
+static const char *technique_names[] = {
+	"Draw",        "DrawAlphaDivide", "DrawMultiply",
+	"DrawTonemap", "DrawUndistort",   "DrawMatrix",
+};
+
+static const char *frame_params[] = {
+	"image",      "gamma",     "contrast", "brightness",
+	"saturation", "hue_shift", "opacity",  "color_matrix",
+};
+
+#define NUM_FRAME_PARAMS (sizeof(frame_params) / sizeof(frame_params[0]))
+
+static double ms_since(uint64_t start)
+{
+	return (double)(os_gettime_ns() - start) / 1000000.0;
+}
+
+/* only the names matter for lookups, so the effect is built directly
+ * instead of being compiled, which would need a graphics device */
+static gs_effect_t *create_effect(void)
+{
+	gs_effect_t *effect = bzalloc(sizeof(gs_effect_t));
+
+	for (size_t i = 0; i < sizeof(param_names) / sizeof(param_names[0]);
+	     i++) {
+		struct gs_effect_param *param =
+			da_push_back_new(effect->params);
+		param->name = bstrdup(param_names[i]);
+		param->name_hash = effect_hash_name(param->name);
+		param->section = EFFECT_PARAM;
+		param->effect = effect;
+	}
+
+	for (size_t i = 0;
+	     i < sizeof(technique_names) / sizeof(technique_names[0]); i++) {
+		struct gs_effect_technique *tech =
+			da_push_back_new(effect->techniques);
+		tech->name = bstrdup(technique_names[i]);
+		tech->name_hash = effect_hash_name(tech->name);
+		tech->section = EFFECT_TECHNIQUE;
+		tech->effect = effect;
+	}
+
+	return effect;
+}
+
+static void destroy_effect(gs_effect_t *effect)
+{
+	for (size_t i = 0; i < effect->params.num; i++)
+		bfree(effect->params.array[i].name);
+	for (size_t i = 0; i < effect->techniques.num; i++)
+		bfree(effect->techniques.array[i].name);
+
+	da_free(effect->params);
+	da_free(effect->techniques);
+	bfree(effect);
+}
+
+/* the previous implementation, for comparison */
+static gs_eparam_t *strcmp_get_param(const gs_effect_t *effect,
+				     const char *name)
+{
+	for (size_t i = 0; i < effect->params.num; i++) {
+		struct gs_effect_param *param = effect->params.array + i;
+		if (strcmp(param->name, name) == 0)
+			return param;
+	}
+
+	return NULL;
+}
+
+static gs_technique_t *strcmp_get_technique(const gs_effect_t *effect,
+					    const char *name)
+{
+	for (size_t i = 0; i < effect->techniques.num; i++) {
+		struct gs_effect_technique *tech = effect->techniques.array + i;
+		if (strcmp(tech->name, name) == 0)
+			return tech;
+	}
+
+	return NULL;
+}
+
+struct filter_handles {
+	gs_technique_t *tech;
+	gs_eparam_t *params[NUM_FRAME_PARAMS];
+};
+
+int main(void)
+{
+	gs_effect_t *effects[BENCH_SOURCES];
+	struct filter_handles handles[BENCH_SOURCES];
+	volatile uintptr_t sink = 0;
+	bool success = true;
+	uint64_t start;
+	double strcmp_ms, hashed_ms, cached_ms;
+
+	for (size_t i = 0; i < BENCH_SOURCES; i++) {
+		effects[i] = create_effect();
+
+		handles[i].tech = gs_effect_get_technique(effects[i], "Draw");
+		for (size_t j = 0; j < NUM_FRAME_PARAMS; j++) {
+			handles[i].params[j] = gs_effect_get_param_by_name(
+				effects[i], frame_params[j]);
+			success = success &&
+				  handles[i].params[j] ==
+					  strcmp_get_param(effects[i],
+							   frame_params[j]);
+		}
+	}
+
+	start = os_gettime_ns();
+	for (size_t f = 0; f < BENCH_FRAMES; f++) {
+		for (size_t i = 0; i < BENCH_SOURCES; i++) {
+			sink += (uintptr_t)strcmp_get_technique(effects[i],
+								"Draw");
+			for (size_t j = 0; j < NUM_FRAME_PARAMS; j++)
+				sink += (uintptr_t)strcmp_get_param(
+					effects[i], frame_params[j]);
+		}
+	}
+	strcmp_ms = ms_since(start);
+
+	start = os_gettime_ns();
+	for (size_t f = 0; f < BENCH_FRAMES; f++) {
+		for (size_t i = 0; i < BENCH_SOURCES; i++) {
+			sink += (uintptr_t)gs_effect_get_technique(effects[i],
+								   "Draw");
+			for (size_t j = 0; j < NUM_FRAME_PARAMS; j++)
+				sink += (uintptr_t)gs_effect_get_param_by_name(
+					effects[i], frame_params[j]);
+		}
+	}
+	hashed_ms = ms_since(start);
+
+	start = os_gettime_ns();
+	for (size_t f = 0; f < BENCH_FRAMES; f++) {
+		for (size_t i = 0; i < BENCH_SOURCES; i++) {
+			sink += (uintptr_t)handles[i].tech;
+			for (size_t j = 0; j < NUM_FRAME_PARAMS; j++)
+				sink += (uintptr_t)handles[i].params[j];
+		}
+	}
+	cached_ms = ms_since(start);
+
+	printf("per frame, %d sources with %d lookups each:\n",
+	       BENCH_SOURCES, (int)NUM_FRAME_PARAMS + 1);
+	printf("strcmp:    %9.3f us\n", strcmp_ms * 1000.0 / BENCH_FRAMES);
+	printf("hashed:    %9.3f us\n", hashed_ms * 1000.0 / BENCH_FRAMES);
+	printf("cached:    %9.3f us\n", cached_ms * 1000.0 / BENCH_FRAMES);
+
+	for (size_t i = 0; i < BENCH_SOURCES; i++)
+		destroy_effect(effects[i]);
+
+	printf("%s\n", success ? "ok" : "FAILED");
+	return success ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <util/platform.h>
+#include <util/threading.h>
+#include <util/bmem.h>
+
+#include "ffmpeg-mux/ffmpeg-mux.h"
+#include "ffmpeg-mux/ffmpeg-mux-shm.h"
+
+/* 60 seconds of a 4K60 recording at about 150 Mbps with 6 audio tracks */
+#define BENCH_SECONDS 60
+#define BENCH_FPS 60
+#define BENCH_KEYINT 120
+#define BENCH_VIDEO_SIZE (300 * 1024)
+#define BENCH_KEYFRAME_SIZE (2 * 1024 * 1024)
+#define BENCH_AUDIO_TRACKS 6
+#define BENCH_AUDIO_SIZE 768
+#define BENCH_AUDIO_PER_SEC 47
+
+struct transport {
+	FILE *in;
+	FILE *out;
+	struct ffm_shm *writer_shm;
+	struct ffm_shm *reader_shm;
+
+	uint64_t packets;
+	uint64_t bytes;
+	bool success;
+};
+
+static bool open_pipe(struct transport *t)
+{
+	int fds[2];
+
+#ifdef _WIN32
+	if (_pipe(fds, 65536, _O_BINARY) != 0)
+		return false;
+	t->in = _fdopen(fds[0], "rb");
+	t->out = _fdopen(fds[1], "wb");
+#else
+	if (pipe(fds) != 0)
+		return false;
+	t->in = fdopen(fds[0], "rb");
+	t->out = fdopen(fds[1], "wb");
+#endif
+	return t->in && t->out;
+}
+
+/* ------------------------------------------------------------------------- */
+/* the same calls obs-ffmpeg-mux.c and ffmpeg-mux.c make                     */
+
+static bool wake_reader(void *param)
+{
+	struct transport *t = param;
+	const uint8_t wake = 0;
+
+	return fwrite(&wake, 1, 1, t->out) == 1 && fflush(t->out) == 0;
+}
+
+static bool wait_writer(void *param)
+{
+	struct transport *t = param;
+	uint8_t wake;
+
+	return fread(&wake, 1, 1, t->in) == 1;
+}
+
+static size_t write_data(struct transport *t, const void *data, size_t size)
+{
+	if (t->writer_shm)
+		return ffm_shm_write(t->writer_shm, data, size, wake_reader, t);
+	return fwrite(data, 1, size, t->out);
+}
+
+static size_t read_data(struct transport *t, void *vdata, size_t size)
+{
+	uint8_t *data = vdata;
+	size_t total = size;
+
+	if (t->reader_shm)
+		return ffm_shm_read(t->reader_shm, data, size, wait_writer, t);
+
+	while (size > 0) {
+		size_t in_size = fread(data, 1, size, t->in);
+		if (in_size == 0)
+			return 0;
+
+		size -= in_size;
+		data += in_size;
+	}
+
+	return total;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void *reader_thread(void *data)
+{
+	struct transport *t = data;
+	struct ffm_packet_info info;
+	uint8_t *buf = bmalloc(BENCH_KEYFRAME_SIZE);
+
+	t->success = true;
+
+	while (read_data(t, &info, sizeof(info)) == sizeof(info)) {
+		uint8_t check = (uint8_t)t->packets;
+
+		if (info.size > BENCH_KEYFRAME_SIZE ||
+		    read_data(t, buf, info.size) != info.size) {
+			t->success = false;
+			break;
+		}
+
+		if (buf[0] != check || buf[info.size - 1] != check) {
+			t->success = false;
+			break;
+		}
+
+		t->packets++;
+		t->bytes += info.size;
+	}
+
+	bfree(buf);
+	return NULL;
+}
+
+static bool write_packet(struct transport *t, uint8_t *buf,
+			 struct ffm_packet_info *info, uint64_t idx)
+{
+	buf[0] = (uint8_t)idx;
+	buf[info->size - 1] = (uint8_t)idx;
+
+	if (write_data(t, info, sizeof(*info)) != sizeof(*info))
+		return false;
+	if (write_data(t, buf, info->size) != info->size)
+		return false;
+	if (t->writer_shm)
+		return ffm_shm_signal(t->writer_shm, wake_reader, t);
+	return true;
+}
+
+static bool pump_packets(struct transport *t, uint64_t *count)
+{
+	uint8_t *buf = bzalloc(BENCH_KEYFRAME_SIZE);
+	int audio_interval = BENCH_FPS * 1000 / BENCH_AUDIO_PER_SEC;
+	int audio_clock = 0;
+	uint64_t idx = 0;
+	bool success = true;
+
+	for (int frame = 0; frame < BENCH_SECONDS * BENCH_FPS && success;
+	     frame++) {
+		struct ffm_packet_info info = {0};
+		bool keyframe = frame % BENCH_KEYINT == 0;
+
+		info.pts = info.dts = frame;
+		info.type = FFM_PACKET_VIDEO;
+		info.keyframe = keyframe;
+		info.size = keyframe ? BENCH_KEYFRAME_SIZE : BENCH_VIDEO_SIZE;
+		success = write_packet(t, buf, &info, idx++);
+
+		for (audio_clock += 1000; audio_clock >= audio_interval;
+		     audio_clock -= audio_interval) {
+			for (int i = 0; i < BENCH_AUDIO_TRACKS && success;
+			     i++) {
+				info.type = FFM_PACKET_AUDIO;
+				info.index = i;
+				info.keyframe = true;
+				info.size = BENCH_AUDIO_SIZE;
+				success = write_packet(t, buf, &info, idx++);
+			}
+		}
+	}
+
+	*count = idx;
+	bfree(buf);
+	return success;
+}
+
+static bool run(const char *name, bool use_shm)
+{
+	struct transport t = {0};
+	pthread_t thread;
+	uint64_t start, count;
+	double seconds;
+	bool success;
+
+	if (!open_pipe(&t)) {
+		printf("%s: failed to create pipe\n", name);
+		return false;
+	}
+
+	if (use_shm) {
+		t.writer_shm = ffm_shm_create(FFM_SHM_DEFAULT_SIZE);
+		t.reader_shm = t.writer_shm
+				       ? ffm_shm_open(ffm_shm_name(t.writer_shm))
+				       : NULL;
+		if (!t.reader_shm) {
+			printf("%s: failed to create shared memory\n", name);
+			return false;
+		}
+	}
+
+	start = os_gettime_ns();
+	pthread_create(&thread, NULL, reader_thread, &t);
+
+	success = pump_packets(&t, &count);
+	fclose(t.out);
+	pthread_join(thread, NULL);
+
+	seconds = (double)(os_gettime_ns() - start) / 1000000000.0;
+	success = success && t.success && t.packets == count;
+
+	printf("%-6s %9.3f s  %9.1f MB/s  %9.0f packets/s\n", name, seconds,
+	       (double)t.bytes / (1024.0 * 1024.0) / seconds,
+	       (double)t.packets / seconds);
+
+	fclose(t.in);
+	ffm_shm_destroy(t.reader_shm);
+	ffm_shm_destroy(t.writer_shm);
+	return success;
+}
+
+int main(void)
+{
+	bool success = true;
+
+	success &= run("pipe", false);
+	success &= run("shm", true);
+
+	printf("%s\n", success ? "ok" : "FAILED");
+	return success ? 0 : 1;
+}
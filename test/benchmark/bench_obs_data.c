@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <util/bmem.h>
+#include <obs-data.h>
+
+#define BENCH_SOURCES 10000
+#define BENCH_FLAT_KEYS 10000
+
+static double ms_since(uint64_t start)
+{
+	return (double)(os_gettime_ns() - start) / 1000000.0;
+}
+
+/* synthetic scene collection: BENCH_SOURCES sources with a handful of
+ * settings each, plus one large flat object (like a big hotkey or
+ * transform map) */
+static char *build_collection_json(void)
+{
+	obs_data_t *root = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+	obs_data_t *flat = obs_data_create();
+	struct dstr name = {0};
+	char *json;
+
+	for (size_t i = 0; i < BENCH_SOURCES; i++) {
+		obs_data_t *source = obs_data_create();
+		obs_data_t *settings = obs_data_create();
+
+		dstr_printf(&name, "Source %d", (int)i);
+		obs_data_set_string(source, "name", name.array);
+		obs_data_set_string(source, "id", "image_source");
+		obs_data_set_int(source, "mixers", 0xFF);
+		obs_data_set_double(source, "volume", 1.0);
+		obs_data_set_bool(source, "muted", false);
+
+		obs_data_set_string(settings, "file", "/tmp/image.png");
+		obs_data_set_bool(settings, "unload", false);
+		obs_data_set_obj(source, "settings", settings);
+
+		obs_data_array_push_back(sources, source);
+		obs_data_release(settings);
+		obs_data_release(source);
+	}
+
+	/* insert in reverse order so that every insertion has to find its
+	 * position in the sorted item list */
+	for (size_t i = BENCH_FLAT_KEYS; i > 0; i--) {
+		dstr_printf(&name, "key_%05d", (int)(i - 1));
+		obs_data_set_int(flat, name.array, (long long)i);
+	}
+
+	obs_data_set_array(root, "sources", sources);
+	obs_data_set_obj(root, "flat", flat);
+	obs_data_set_string(root, "name", "Benchmark");
+
+	json = bstrdup(obs_data_get_json(root));
+
+	obs_data_release(flat);
+	obs_data_array_release(sources);
+	obs_data_release(root);
+	dstr_free(&name);
+	return json;
+}
+
+static bool verify_flat(obs_data_t *root)
+{
+	obs_data_t *flat = obs_data_get_obj(root, "flat");
+	struct dstr name = {0};
+	bool success = true;
+	size_t count = 0;
+
+	for (size_t i = 0; i < BENCH_FLAT_KEYS && success; i++) {
+		dstr_printf(&name, "key_%05d", (int)i);
+		success = obs_data_get_int(flat, name.array) == (long long)i + 1;
+	}
+
+	/* iteration order must stay sorted by name */
+	obs_data_item_t *item = obs_data_first(flat);
+	const char *prev = NULL;
+	for (; item && success; obs_data_item_next(&item)) {
+		const char *cur = obs_data_item_get_name(item);
+		if (prev && strcmp(prev, cur) >= 0)
+			success = false;
+		prev = cur;
+		count++;
+	}
+	obs_data_item_release(&item);
+
+	/* erase every other key and make sure the rest is still found */
+	for (size_t i = 0; i < BENCH_FLAT_KEYS; i += 2) {
+		dstr_printf(&name, "key_%05d", (int)i);
+		obs_data_erase(flat, name.array);
+	}
+	for (size_t i = 0; i < BENCH_FLAT_KEYS && success; i++) {
+		dstr_printf(&name, "key_%05d", (int)i);
+		success = obs_data_has_user_value(flat, name.array) ==
+			  ((i & 1) != 0);
+	}
+
+	if (count != BENCH_FLAT_KEYS)
+		success = false;
+
+	obs_data_release(flat);
+	dstr_free(&name);
+	return success;
+}
+
+int main(void)
+{
+	uint64_t start;
+	char *json;
+	char *json_out;
+	obs_data_t *root;
+	bool success;
+
+	start = os_gettime_ns();
+	json = build_collection_json();
+	printf("build:     %9.3f ms\n", ms_since(start));
+
+	start = os_gettime_ns();
+	root = obs_data_create_from_json(json);
+	printf("load:      %9.3f ms\n", ms_since(start));
+
+	start = os_gettime_ns();
+	json_out = bstrdup(obs_data_get_json(root));
+	printf("save:      %9.3f ms\n", ms_since(start));
+
+	success = strcmp(json, json_out) == 0;
+	if (!success)
+		printf("saved json does not match loaded json\n");
+
+	start = os_gettime_ns();
+	success &= verify_flat(root);
+	printf("lookups:   %9.3f ms\n", ms_since(start));
+
+	obs_data_release(root);
+	bfree(json_out);
+	bfree(json);
+
+	printf("%s\n", success ? "ok" : "FAILED");
+	return success ? 0 : 1;
+}
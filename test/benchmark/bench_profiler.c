@@ -0,0 +1,109 @@
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <util/platform.h>
+#include <util/profiler.h>
+#include <util/threading.h>
+
+#define BENCH_ROOTS 200000
+#define BENCH_MAX_THREADS 4
+
+/* start/end pairs per root, see record_root */
+#define CALLS_PER_ROOT 5
+
+static const char *root_names[BENCH_MAX_THREADS] = {
+	"bench_thread_0",
+	"bench_thread_1",
+	"bench_thread_2",
+	"bench_thread_3",
+};
+
+static const char *render_name = "render";
+static const char *source_name = "source";
+static const char *filter_name = "filter";
+static const char *output_name = "output";
+
+/* roughly the shape of a graphics thread frame */
+static inline void record_root(const char *root_name)
+{
+	profile_start(root_name);
+
+	profile_start(render_name);
+	profile_start(source_name);
+	profile_start(filter_name);
+	profile_end(filter_name);
+	profile_end(source_name);
+	profile_end(render_name);
+
+	profile_start(output_name);
+	profile_end(output_name);
+
+	profile_end(root_name);
+}
+
+static void *bench_thread(void *data)
+{
+	const char *root_name = data;
+
+	for (size_t i = 0; i < BENCH_ROOTS; i++)
+		record_root(root_name);
+
+	return NULL;
+}
+
+static double run(size_t num_threads)
+{
+	pthread_t threads[BENCH_MAX_THREADS];
+	uint64_t start = os_gettime_ns();
+	uint64_t elapsed;
+
+	for (size_t i = 0; i < num_threads; i++)
+		pthread_create(&threads[i], NULL, bench_thread,
+			       (void *)root_names[i]);
+	for (size_t i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	elapsed = os_gettime_ns() - start;
+	return (double)elapsed / (BENCH_ROOTS * CALLS_PER_ROOT * num_threads);
+}
+
+static bool count_root_calls(void *context, profiler_snapshot_entry_t *entry)
+{
+	uint64_t *calls = context;
+	*calls += profiler_snapshot_entry_overall_count(entry);
+	return true;
+}
+
+int main(void)
+{
+	profiler_snapshot_t *snap;
+	uint64_t expected = 0;
+	uint64_t calls = 0;
+
+	profiler_start();
+
+	/* a first run, so that the call tree and per-thread state exist */
+	run(1);
+	expected += BENCH_ROOTS;
+
+	printf("profile_start/profile_end pair, %d calls per root:\n",
+	       CALLS_PER_ROOT);
+
+	for (size_t threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+		double ns = run(threads);
+		expected += BENCH_ROOTS * threads;
+		printf("  %zu thread(s): %7.1f ns per pair\n", threads, ns);
+	}
+
+	/* every root has to show up in the snapshot */
+	snap = profile_snapshot_create();
+	profiler_snapshot_enumerate_roots(snap, count_root_calls, &calls);
+	profile_snapshot_free(snap);
+
+	profiler_stop();
+	profiler_free();
+
+	printf("roots merged: %" PRIu64 " of %" PRIu64 "\n", calls, expected);
+	printf("%s\n", calls == expected ? "ok" : "FAILED");
+	return calls == expected ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <util/platform.h>
+#include <util/circlebuf.h>
+#include <util/darray.h>
+
+#include "obs-ffmpeg-replay-index.h"
+
+/* a 60 fps stream with 2 second keyframe interval and 6 audio tracks */
+#define BENCH_FPS 60
+#define BENCH_KEYINT 120
+#define BENCH_AUDIO_TRACKS 6
+#define BENCH_AUDIO_PER_SEC 47
+#define BENCH_RUNS 5
+
+struct buffer {
+	struct circlebuf packets;
+	struct replay_index index;
+};
+
+static void get_packet(void *param, size_t idx, struct encoder_packet *pkt)
+{
+	struct buffer *buf = param;
+	memcpy(pkt, circlebuf_data(&buf->packets, idx * sizeof(*pkt)),
+	       sizeof(*pkt));
+}
+
+static void push_packet(struct buffer *buf, struct encoder_packet *pkt)
+{
+	circlebuf_push_back(&buf->packets, pkt, sizeof(*pkt));
+	replay_index_push(&buf->index, pkt);
+}
+
+static void fill_buffer(struct buffer *buf, int minutes)
+{
+	int64_t frame_usec = 1000000 / BENCH_FPS;
+	int64_t audio_usec = 1000000 / BENCH_AUDIO_PER_SEC;
+	int64_t audio_ts = 0;
+	int frames = minutes * 60 * BENCH_FPS;
+
+	for (int i = 0; i < frames; i++) {
+		struct encoder_packet pkt = {0};
+		int64_t ts = i * frame_usec;
+
+		pkt.type = OBS_ENCODER_VIDEO;
+		pkt.keyframe = i % BENCH_KEYINT == 0;
+		pkt.dts = pkt.pts = i;
+		pkt.dts_usec = ts;
+		pkt.size = pkt.keyframe ? 500000 : 80000;
+		push_packet(buf, &pkt);
+
+		for (; audio_ts <= ts; audio_ts += audio_usec) {
+			for (int track = 0; track < BENCH_AUDIO_TRACKS;
+			     track++) {
+				pkt.type = OBS_ENCODER_AUDIO;
+				pkt.keyframe = true;
+				pkt.track_idx = track;
+				pkt.dts = pkt.pts = audio_ts / audio_usec;
+				pkt.dts_usec = audio_ts;
+				pkt.size = 768;
+				push_packet(buf, &pkt);
+			}
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* the ordering replay_buffer_save used before the keyframe index            */
+
+static void legacy_insert_packet(struct darray *array,
+				 struct encoder_packet *packet,
+				 int64_t video_offset, int64_t *audio_offsets,
+				 int64_t video_dts_offset,
+				 int64_t *audio_dts_offsets)
+{
+	struct encoder_packet pkt = *packet;
+	DARRAY(struct encoder_packet) packets;
+	packets.da = *array;
+	size_t idx;
+
+	if (pkt.type == OBS_ENCODER_VIDEO) {
+		pkt.dts_usec -= video_offset;
+		pkt.dts -= video_dts_offset;
+		pkt.pts -= video_dts_offset;
+	} else {
+		pkt.dts_usec -= audio_offsets[pkt.track_idx];
+		pkt.dts -= audio_dts_offsets[pkt.track_idx];
+		pkt.pts -= audio_dts_offsets[pkt.track_idx];
+	}
+
+	for (idx = packets.num; idx > 0; idx--) {
+		struct encoder_packet *p = packets.array + (idx - 1);
+		if (p->dts_usec < pkt.dts_usec)
+			break;
+	}
+
+	da_insert(packets, idx, &pkt);
+	*array = packets.da;
+}
+
+static void legacy_save(struct buffer *buf, struct darray *out)
+{
+	size_t num_packets = replay_index_count(&buf->index);
+	bool found_video = false;
+	bool found_audio[MAX_AUDIO_MIXES] = {0};
+	int64_t video_offset = 0;
+	int64_t video_dts_offset = 0;
+	int64_t audio_offsets[MAX_AUDIO_MIXES] = {0};
+	int64_t audio_dts_offsets[MAX_AUDIO_MIXES] = {0};
+
+	darray_reserve(sizeof(struct encoder_packet), out, num_packets);
+
+	for (size_t i = 0; i < num_packets; i++) {
+		struct encoder_packet pkt;
+		get_packet(buf, i, &pkt);
+
+		if (pkt.type == OBS_ENCODER_VIDEO) {
+			if (!found_video) {
+				video_offset = pkt.dts_usec;
+				video_dts_offset = pkt.dts;
+				found_video = true;
+			}
+		} else if (!found_audio[pkt.track_idx]) {
+			found_audio[pkt.track_idx] = true;
+			audio_offsets[pkt.track_idx] = pkt.dts_usec;
+			audio_dts_offsets[pkt.track_idx] = pkt.dts;
+		}
+
+		legacy_insert_packet(out, &pkt, video_offset, audio_offsets,
+				     video_dts_offset, audio_dts_offsets);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool check_order(const struct darray *da, size_t expected)
+{
+	const struct encoder_packet *packets = da->array;
+
+	if (da->num != expected)
+		return false;
+
+	for (size_t i = 1; i < da->num; i++) {
+		if (packets[i].dts_usec < packets[i - 1].dts_usec)
+			return false;
+	}
+
+	return true;
+}
+
+/* what replay_buffer_save does on the output thread */
+static void take_packets(struct buffer *buf, struct darray *out)
+{
+	DARRAY(struct encoder_packet) packets;
+	size_t start = replay_index_save_start(&buf->index);
+	size_t count = replay_index_count(&buf->index);
+
+	packets.da = *out;
+	da_reserve(packets, count - start);
+
+	for (size_t i = start; i < count; i++)
+		get_packet(buf, i, &packets.array[i - start]);
+	packets.num = count - start;
+
+	*out = packets.da;
+}
+
+struct timing {
+	double legacy;
+	double take;
+	double order;
+};
+
+static inline void keep_best(double *best, double ms, int run)
+{
+	if (!run || ms < *best)
+		*best = ms;
+}
+
+static bool time_save(struct buffer *buf, struct timing *t)
+{
+	size_t count = replay_index_count(&buf->index);
+	bool success = true;
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		DARRAY(struct encoder_packet) out;
+		uint64_t start, taken;
+
+		da_init(out);
+		start = os_gettime_ns();
+		legacy_save(buf, &out.da);
+		keep_best(&t->legacy, (os_gettime_ns() - start) / 1e6, run);
+
+		success &= check_order(&out.da, count);
+		da_free(out);
+
+		start = os_gettime_ns();
+		take_packets(buf, &out.da);
+		taken = os_gettime_ns();
+		replay_order_packets(&out.da);
+
+		keep_best(&t->take, (taken - start) / 1e6, run);
+		keep_best(&t->order, (os_gettime_ns() - taken) / 1e6, run);
+
+		success &= check_order(&out.da, count);
+		da_free(out);
+	}
+
+	return success;
+}
+
+int main(void)
+{
+	const int minutes[] = {1, 5, 20};
+	bool success = true;
+
+	/* legacy and take are spent on the output thread, order on the mux
+	 * thread */
+	printf("%-8s %10s %12s %12s %12s\n", "buffer", "packets", "legacy ms",
+	       "take ms", "order ms");
+
+	for (size_t i = 0; i < sizeof(minutes) / sizeof(minutes[0]); i++) {
+		struct buffer buf = {0};
+		struct timing t = {0};
+
+		fill_buffer(&buf, minutes[i]);
+		success &= time_save(&buf, &t);
+
+		printf("%3d min  %10zu %12.2f %12.2f %12.2f\n", minutes[i],
+		       replay_index_count(&buf.index), t.legacy, t.take,
+		       t.order);
+
+		circlebuf_free(&buf.packets);
+		replay_index_free(&buf.index);
+	}
+
+	printf("%s\n", success ? "ok" : "FAILED");
+	return success ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <util/platform.h>
+#include <util/crc32.h>
+#include <util/dstr.h>
+#include <graphics/graphics.h>
+#include <graphics/vec4.h>
+
+#define BENCH_GRAPHICS_MODULE "libobs-software"
+
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 360
+#define BENCH_SOURCES 8
+#define BENCH_FRAMES 60
+
+#define SOURCE_SIZE 64
+
+static double ms_since(uint64_t start)
+{
+	return (double)(os_gettime_ns() - start) / 1000000.0;
+}
+
+static gs_effect_t *load_effect(const char *effect_dir, const char *name)
+{
+	struct dstr path = {0};
+	gs_effect_t *effect;
+
+	dstr_printf(&path, "%s/%s", effect_dir, name);
+	effect = gs_effect_create_from_file(path.array, NULL);
+	dstr_free(&path);
+	return effect;
+}
+
+static gs_texture_t *create_source(void)
+{
+	uint8_t *pixels = bmalloc(SOURCE_SIZE * SOURCE_SIZE * 4);
+	const uint8_t *data = pixels;
+	gs_texture_t *tex;
+
+	for (size_t y = 0; y < SOURCE_SIZE; y++) {
+		for (size_t x = 0; x < SOURCE_SIZE; x++) {
+			uint8_t *pixel = pixels + (y * SOURCE_SIZE + x) * 4;
+			pixel[0] = (uint8_t)(x * 4);
+			pixel[1] = (uint8_t)(y * 4);
+			pixel[2] = (uint8_t)((x ^ y) * 4);
+			pixel[3] = (uint8_t)(128 + x + y);
+		}
+	}
+
+	tex = gs_texture_create(SOURCE_SIZE, SOURCE_SIZE, GS_RGBA, 1, &data, 0);
+	bfree(pixels);
+	return tex;
+}
+
+/* a scene of overlapping, scaled and blended sources, similar to what the
+ * compositor draws every frame */
+static void render_frame(gs_effect_t *effect, gs_effect_t *solid,
+			 gs_texture_t *source, size_t frame)
+{
+	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
+	gs_eparam_t *color = gs_effect_get_param_by_name(solid, "color");
+	struct vec4 clear_color;
+	struct vec4 box_color;
+
+	vec4_set(&clear_color, 0.0f, 0.0f, 0.0f, 1.0f);
+	vec4_set(&box_color, 0.2f, 0.4f, 0.8f, 0.5f);
+
+	gs_clear(GS_CLEAR_COLOR, &clear_color, 1.0f, 0);
+
+	gs_effect_set_vec4(color, &box_color);
+	while (gs_effect_loop(solid, "Solid"))
+		gs_draw_sprite(NULL, 0, BENCH_WIDTH / 2, BENCH_HEIGHT / 2);
+
+	for (size_t i = 0; i < BENCH_SOURCES; i++) {
+		float x = (float)((frame * 3 + i * 71) % BENCH_WIDTH);
+		float y = (float)((frame * 2 + i * 43) % BENCH_HEIGHT);
+		uint32_t size = SOURCE_SIZE * (1 + (uint32_t)(i % 3));
+
+		gs_matrix_push();
+		gs_matrix_translate3f(x, y, 0.0f);
+
+		gs_effect_set_texture(image, source);
+		while (gs_effect_loop(effect, "Draw"))
+			gs_draw_sprite(source, 0, size, size);
+
+		gs_matrix_pop();
+	}
+}
+
+static bool run(const char *module, const char *effect_dir,
+		uint32_t *checksum)
+{
+	graphics_t *graphics = NULL;
+	gs_effect_t *effect, *solid;
+	gs_texture_t *target, *source;
+	gs_stagesurf_t *stage;
+	uint64_t start;
+	uint8_t *data;
+	uint32_t linesize;
+	bool success = false;
+
+	if (gs_create(&graphics, module, 0) != GS_SUCCESS) {
+		printf("could not create graphics with '%s'\n", module);
+		return false;
+	}
+
+	gs_enter_context(graphics);
+
+	effect = load_effect(effect_dir, "default.effect");
+	solid = load_effect(effect_dir, "solid.effect");
+	source = create_source();
+	target = gs_texture_create(BENCH_WIDTH, BENCH_HEIGHT, GS_RGBA, 1, NULL,
+				   GS_RENDER_TARGET);
+	stage = gs_stagesurface_create(BENCH_WIDTH, BENCH_HEIGHT, GS_RGBA);
+	if (!effect || !solid || !source || !target || !stage)
+		goto fail;
+
+	gs_set_render_target(target, NULL);
+	gs_set_viewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+	gs_ortho(0.0f, (float)BENCH_WIDTH, 0.0f, (float)BENCH_HEIGHT, -100.0f,
+		 100.0f);
+	gs_enable_blending(true);
+	gs_blend_function(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA);
+
+	start = os_gettime_ns();
+	for (size_t i = 0; i < BENCH_FRAMES; i++)
+		render_frame(effect, solid, source, i);
+	printf("%dx%d, %d sources: %9.3f ms per frame\n", BENCH_WIDTH,
+	       BENCH_HEIGHT, BENCH_SOURCES, ms_since(start) / BENCH_FRAMES);
+
+	gs_stage_texture(stage, target);
+	if (gs_stagesurface_map(stage, &data, &linesize)) {
+		*checksum = 0;
+		for (size_t y = 0; y < BENCH_HEIGHT; y++)
+			*checksum = calc_crc32(*checksum, data + y * linesize,
+					       BENCH_WIDTH * 4);
+		gs_stagesurface_unmap(stage);
+		success = true;
+	}
+
+fail:
+	gs_set_render_target(NULL, NULL);
+	gs_stagesurface_destroy(stage);
+	gs_texture_destroy(target);
+	gs_texture_destroy(source);
+	gs_effect_destroy(solid);
+	gs_effect_destroy(effect);
+	gs_leave_context();
+	gs_destroy(graphics);
+	return success;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *effect_dir = argc > 1 ? argv[1] : BENCH_EFFECT_DIR;
+	const char *module = argc > 2 ? argv[2] : BENCH_GRAPHICS_MODULE;
+	uint32_t first = 0, second = 0;
+	bool success;
+
+	/* the output of two runs has to match bit for bit */
+	success = run(module, effect_dir, &first) &&
+		  run(module, effect_dir, &second) && first == second;
+
+	printf("checksum:  %08x\n", first);
+	printf("%s\n", success ? "ok" : "FAILED");
+	return success ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-interleave.h>
+
+#define STREAM_PACKETS 5000
+#define STREAM_SEEDS 20
+
+/* the linear insert that obs_output used before the interleave queue */
+static void reference_insert(struct darray *da, struct encoder_packet *out)
+{
+	DARRAY(struct encoder_packet) packets;
+	size_t idx;
+
+	packets.da = *da;
+
+	for (idx = 0; idx < packets.num; idx++) {
+		struct encoder_packet *cur_packet = packets.array + idx;
+
+		if (out->dts_usec == cur_packet->dts_usec &&
+		    out->type == OBS_ENCODER_VIDEO) {
+			break;
+		} else if (out->dts_usec < cur_packet->dts_usec) {
+			break;
+		}
+	}
+
+	da_insert(packets, idx, out);
+	*da = packets.da;
+}
+
+static void reference_resort(struct darray *da)
+{
+	struct darray old_array = *da;
+	struct encoder_packet *old_packets = old_array.array;
+
+	memset(da, 0, sizeof(*da));
+
+	for (size_t i = 0; i < old_array.num; i++)
+		reference_insert(da, &old_packets[i]);
+
+	darray_free(&old_array);
+}
+
+static void random_packet(struct encoder_packet *packet, int64_t *clock,
+			  long long id)
+{
+	memset(packet, 0, sizeof(*packet));
+
+	/* coarse timestamps so that equal DTS values are common, plus some
+	 * out of order packets like b-frame delays or late audio tracks */
+	*clock += rand() % 3;
+	packet->dts_usec = *clock - (rand() % 8 == 0 ? rand() % 10 : 0);
+	packet->type = rand() % 3 == 0 ? OBS_ENCODER_VIDEO : OBS_ENCODER_AUDIO;
+	packet->track_idx = packet->type == OBS_ENCODER_AUDIO ? rand() % 6 : 0;
+	packet->pts = id;
+}
+
+static void assert_same_order(struct interleave_queue *q,
+			      const struct darray *reference)
+{
+	const struct encoder_packet *ref_packets = reference->array;
+
+	assert_int_equal(interleave_queue_count(q), reference->num);
+
+	for (size_t i = 0; i < reference->num; i++) {
+		struct encoder_packet *packet = interleave_queue_get(q, i);
+		assert_int_equal(packet->pts, ref_packets[i].pts);
+		assert_int_equal(packet->dts_usec, ref_packets[i].dts_usec);
+	}
+}
+
+static void interleave_random_stream_test(void **state)
+{
+	for (unsigned int seed = 1; seed <= STREAM_SEEDS; seed++) {
+		struct interleave_queue q = {0};
+		DARRAY(struct encoder_packet) reference;
+		int64_t clock = 0;
+
+		da_init(reference);
+		srand(seed);
+
+		for (long long id = 0; id < STREAM_PACKETS; id++) {
+			struct encoder_packet packet;
+
+			random_packet(&packet, &clock, id);
+			interleave_queue_insert(&q, &packet);
+			reference_insert(&reference.da, &packet);
+
+			/* sending packets pops them off the front */
+			if (rand() % 2 == 0) {
+				size_t count = 1 + rand() % 2;
+				if (count > reference.num)
+					continue;
+
+				interleave_queue_pop_front(&q, count);
+				da_erase_range(reference, 0, count);
+			}
+		}
+
+		assert_same_order(&q, &reference.da);
+
+		interleave_queue_free(&q);
+		da_free(reference);
+	}
+}
+
+static void interleave_resort_test(void **state)
+{
+	for (unsigned int seed = 1; seed <= STREAM_SEEDS; seed++) {
+		struct interleave_queue q = {0};
+		DARRAY(struct encoder_packet) reference;
+		int64_t clock = 0;
+		int64_t offsets[7];
+
+		da_init(reference);
+		srand(seed);
+
+		for (long long id = 0; id < STREAM_PACKETS / 10; id++) {
+			struct encoder_packet packet;
+
+			random_packet(&packet, &clock, id);
+			interleave_queue_insert(&q, &packet);
+			reference_insert(&reference.da, &packet);
+		}
+
+		/* drop a few packets so the queue does not start at 0 */
+		interleave_queue_pop_front(&q, 5);
+		da_erase_range(reference, 0, 5);
+
+		/* per track offsets, like the ones applied once an output has
+		 * received its first packets */
+		for (size_t i = 0; i < 7; i++)
+			offsets[i] = rand() % 20;
+
+		for (size_t i = 0; i < reference.num; i++) {
+			struct encoder_packet *a = interleave_queue_get(&q, i);
+			struct encoder_packet *b = &reference.array[i];
+			size_t track = a->type == OBS_ENCODER_VIDEO
+					       ? 6
+					       : a->track_idx;
+
+			a->dts_usec -= offsets[track];
+			b->dts_usec -= offsets[track];
+		}
+
+		interleave_queue_resort(&q);
+		reference_resort(&reference.da);
+
+		assert_same_order(&q, &reference.da);
+
+		interleave_queue_free(&q);
+		da_free(reference);
+	}
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(interleave_random_stream_test),
+		cmocka_unit_test(interleave_resort_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
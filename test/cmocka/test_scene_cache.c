@@ -0,0 +1,148 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs.h>
+#include <obs-internal.h>
+
+static const char *test_get_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return "test";
+}
+
+static void *test_create(obs_data_t *settings, obs_source_t *source)
+{
+	UNUSED_PARAMETER(settings);
+	return source;
+}
+
+static void test_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static uint32_t test_get_size(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return 64;
+}
+
+static struct obs_source_info test_source = {
+	.id = "test_content_source",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CONTENT_TRACKING,
+	.get_name = test_get_name,
+	.create = test_create,
+	.destroy = test_destroy,
+	.get_width = test_get_size,
+	.get_height = test_get_size,
+};
+
+static struct obs_source_info test_filter = {
+	.id = "test_content_filter",
+	.type = OBS_SOURCE_TYPE_FILTER,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CONTENT_TRACKING,
+	.get_name = test_get_name,
+	.create = test_create,
+	.destroy = test_destroy,
+};
+
+static struct obs_source_info test_audio_source = {
+	.id = "test_audio_source",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_AUDIO,
+	.get_name = test_get_name,
+	.create = test_create,
+	.destroy = test_destroy,
+};
+
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	if (!obs_startup("en-US", NULL, NULL))
+		return -1;
+
+	obs_register_source(&test_source);
+	obs_register_source(&test_filter);
+	obs_register_source(&test_audio_source);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_shutdown();
+	return 0;
+}
+
+/* a scene cached with a filter on must be rendered again when the filter is
+ * turned off, and the other way around */
+static void filter_toggle_test(void **state)
+{
+	obs_scene_t *scene = obs_scene_create("scene");
+	obs_source_t *source =
+		obs_source_create("test_content_source", "source", NULL, NULL);
+	obs_source_t *filter =
+		obs_source_create("test_content_filter", "filter", NULL, NULL);
+	long epoch;
+
+	UNUSED_PARAMETER(state);
+
+	obs_scene_add(scene, source);
+	obs_source_filter_add(source, filter);
+
+	epoch = get_content_epoch();
+	assert_true(obs_scene_content_unchanged(scene, epoch));
+
+	obs_source_set_enabled(filter, false);
+	assert_false(obs_scene_content_unchanged(scene, epoch));
+
+	epoch = get_content_epoch();
+	assert_true(obs_scene_content_unchanged(scene, epoch));
+
+	obs_source_set_enabled(filter, true);
+	assert_false(obs_scene_content_unchanged(scene, epoch));
+
+	obs_source_filter_remove(source, filter);
+	obs_source_release(filter);
+	obs_source_release(source);
+	obs_scene_release(scene);
+}
+
+/* audio sources draw nothing, so they must not keep a scene from being
+ * cached */
+static void audio_source_test(void **state)
+{
+	obs_scene_t *scene = obs_scene_create("audio scene");
+	obs_source_t *source =
+		obs_source_create("test_content_source", "video", NULL, NULL);
+	obs_source_t *audio =
+		obs_source_create("test_audio_source", "audio", NULL, NULL);
+	long epoch;
+
+	UNUSED_PARAMETER(state);
+
+	obs_scene_add(scene, source);
+	obs_scene_add(scene, audio);
+
+	epoch = get_content_epoch();
+	assert_true(obs_scene_content_unchanged(scene, epoch));
+
+	obs_source_release(audio);
+	obs_source_release(source);
+	obs_scene_release(scene);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(filter_toggle_test),
+		cmocka_unit_test(audio_source_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
@@ -0,0 +1,100 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/spsc-queue.h>
+
+#define THREADED_ITEMS 1000000
+
+static void spsc_queue_basic_test(void **state)
+{
+	struct spsc_queue q;
+	uintptr_t i;
+
+	spsc_queue_init(&q, 6);
+
+	assert_true(spsc_queue_capacity(&q) >= 6);
+	assert_null(spsc_queue_pop(&q));
+
+	for (i = 1; i <= spsc_queue_capacity(&q); i++)
+		assert_true(spsc_queue_push(&q, (void *)i));
+
+	assert_false(spsc_queue_push(&q, (void *)i));
+	assert_int_equal(spsc_queue_size(&q), spsc_queue_capacity(&q));
+
+	for (i = 1; i <= spsc_queue_capacity(&q); i++)
+		assert_ptr_equal(spsc_queue_pop(&q), (void *)i);
+
+	assert_null(spsc_queue_pop(&q));
+	assert_int_equal(spsc_queue_size(&q), 0);
+
+	spsc_queue_free(&q);
+}
+
+static void spsc_queue_wrap_test(void **state)
+{
+	struct spsc_queue q;
+	uintptr_t next_in = 1;
+	uintptr_t next_out = 1;
+
+	spsc_queue_init(&q, 3);
+
+	/* keep the ring partially full while the indices wrap many times */
+	for (int n = 0; n < 100; n++) {
+		assert_true(spsc_queue_push(&q, (void *)next_in++));
+		assert_true(spsc_queue_push(&q, (void *)next_in++));
+		assert_ptr_equal(spsc_queue_pop(&q), (void *)next_out++);
+		assert_ptr_equal(spsc_queue_pop(&q), (void *)next_out++);
+	}
+
+	spsc_queue_free(&q);
+}
+
+static void *producer_thread(void *data)
+{
+	struct spsc_queue *q = data;
+
+	for (uintptr_t i = 1; i <= THREADED_ITEMS; i++) {
+		while (!spsc_queue_push(q, (void *)i))
+			;
+	}
+
+	return NULL;
+}
+
+static void spsc_queue_threaded_test(void **state)
+{
+	struct spsc_queue q;
+	pthread_t thread;
+	uintptr_t expected = 1;
+
+	spsc_queue_init(&q, 64);
+
+	assert_int_equal(pthread_create(&thread, NULL, producer_thread, &q),
+			 0);
+
+	while (expected <= THREADED_ITEMS) {
+		void *item = spsc_queue_pop(&q);
+		if (item) {
+			assert_ptr_equal(item, (void *)expected);
+			expected++;
+		}
+	}
+
+	pthread_join(thread, NULL);
+	assert_null(spsc_queue_pop(&q));
+
+	spsc_queue_free(&q);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(spsc_queue_basic_test),
+		cmocka_unit_test(spsc_queue_wrap_test),
+		cmocka_unit_test(spsc_queue_threaded_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,200 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <string.h>
+#include <obs.h>
+#include <media-io/video-io.h>
+#include <media-io/video-frame.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define TEST_FRAMES 300
+
+struct test_input {
+	video_t *video;
+	uint32_t sleep_ms;
+	long disconnect_at;
+
+	volatile long frames;
+	uint64_t last_ts;
+	uint32_t last_id;
+	int timestamp_gaps;
+	int out_of_order;
+};
+
+static void receive_frame(void *param, struct video_data *frame)
+{
+	struct test_input *input = param;
+	uint64_t frame_time = video_output_get_frame_time(input->video);
+	uint32_t id;
+
+	memcpy(&id, frame->data[0], sizeof(id));
+
+	/* repeated frames carry an older frame, but always the next
+	 * timestamp */
+	if (input->frames && frame->timestamp != input->last_ts + frame_time)
+		input->timestamp_gaps++;
+	if (id < input->last_id || id > frame->timestamp / frame_time)
+		input->out_of_order++;
+
+	input->last_ts = frame->timestamp;
+	input->last_id = id;
+
+	if (input->sleep_ms)
+		os_sleep_ms(input->sleep_ms);
+
+	if (os_atomic_inc_long(&input->frames) == input->disconnect_at)
+		video_output_disconnect(input->video, receive_frame, input);
+}
+
+static void wait_for_frames(struct test_input *input, long frames)
+{
+	for (int i = 0; i < 1000; i++) {
+		if (os_atomic_load_long(&input->frames) >= frames)
+			break;
+		os_sleep_ms(10);
+	}
+}
+
+static void output_frames(video_t *video, uint32_t first, uint32_t last)
+{
+	uint64_t frame_time = video_output_get_frame_time(video);
+
+	for (uint32_t id = first; id <= last; id++) {
+		struct video_frame frame;
+
+		if (video_output_lock_frame(video, &frame, 1,
+					    id * frame_time)) {
+			memcpy(frame.data[0], &id, sizeof(id));
+			video_output_unlock_frame(video);
+		}
+		os_sleep_ms(1);
+	}
+}
+
+static void threaded_inputs_test(void **state)
+{
+	struct video_output_info info = {
+		.name = "test",
+		.format = VIDEO_FORMAT_RGBA,
+		.fps_num = 60,
+		.fps_den = 1,
+		.width = 16,
+		.height = 16,
+		.cache_size = 4,
+		.threaded_inputs = true,
+	};
+	struct video_input_stats stats;
+	video_t *video;
+
+	assert_int_equal(video_output_open(&video, &info),
+			 VIDEO_OUTPUT_SUCCESS);
+
+	struct test_input fast = {.video = video};
+	struct test_input slow = {.video = video, .sleep_ms = 2};
+	struct test_input stopping = {.video = video, .disconnect_at = 20};
+
+	assert_true(video_output_connect(video, NULL, receive_frame, &fast));
+	assert_true(video_output_connect(video, NULL, receive_frame, &slow));
+	assert_true(
+		video_output_connect(video, NULL, receive_frame, &stopping));
+
+	output_frames(video, 1, TEST_FRAMES);
+
+	wait_for_frames(&fast, TEST_FRAMES);
+	wait_for_frames(&slow, TEST_FRAMES);
+
+	/* a slow input must not hold back the others */
+	assert_int_equal(os_atomic_load_long(&fast.frames), TEST_FRAMES);
+	assert_int_equal(os_atomic_load_long(&slow.frames), TEST_FRAMES);
+	assert_int_equal(fast.timestamp_gaps, 0);
+	assert_int_equal(slow.timestamp_gaps, 0);
+	assert_int_equal(fast.out_of_order, 0);
+	assert_int_equal(slow.out_of_order, 0);
+
+	assert_true(video_output_get_input_stats(video, receive_frame, &slow,
+						 &stats));
+	assert_int_equal(stats.total_frames, TEST_FRAMES);
+	assert_true(stats.skipped_frames > 0);
+	assert_true(stats.max_lag_ns > 0);
+
+	/* disconnected itself from its own thread */
+	assert_int_equal(os_atomic_load_long(&stopping.frames), 20);
+	assert_false(video_output_get_input_stats(video, receive_frame,
+						  &stopping, &stats));
+
+	video_output_disconnect(video, receive_frame, &fast);
+	video_output_close(video);
+}
+
+/* a slow input that disconnects from its callback while it still has frames
+ * queued must give them back to the cache right away */
+static void self_disconnect_test(void **state)
+{
+	struct video_output_info info = {
+		.name = "test",
+		.format = VIDEO_FORMAT_RGBA,
+		.fps_num = 60,
+		.fps_den = 1,
+		.width = 16,
+		.height = 16,
+		.cache_size = 4,
+		.threaded_inputs = true,
+	};
+	video_t *video;
+
+	assert_int_equal(video_output_open(&video, &info),
+			 VIDEO_OUTPUT_SUCCESS);
+
+	struct test_input fast = {.video = video};
+	struct test_input stopping = {
+		.video = video, .sleep_ms = 10, .disconnect_at = 5};
+
+	assert_true(video_output_connect(video, NULL, receive_frame, &fast));
+	assert_true(
+		video_output_connect(video, NULL, receive_frame, &stopping));
+
+	output_frames(video, 1, TEST_FRAMES / 2);
+	wait_for_frames(&stopping, 5);
+
+	/* no frames repeated into the input after it disconnected */
+	assert_int_equal(os_atomic_load_long(&stopping.frames), 5);
+
+	output_frames(video, TEST_FRAMES / 2 + 1, TEST_FRAMES);
+	wait_for_frames(&fast, TEST_FRAMES);
+
+	/* the other input keeps getting new frames instead of the last cached
+	 * one */
+	assert_int_equal(fast.last_id, TEST_FRAMES);
+	assert_int_equal(fast.out_of_order, 0);
+
+	video_output_disconnect(video, receive_frame, &fast);
+	video_output_close(video);
+}
+
+/* the video threads use the profiler name store of the obs context */
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+	return obs_startup("en-US", NULL, NULL) ? 0 : -1;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_shutdown();
+	return 0;
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(threaded_inputs_test),
+		cmocka_unit_test(self_disconnect_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}